@@ -287,6 +287,82 @@ inline uint32_t MultiValueType<MultiValueType<char> >::length() const {
     return dataAddr - (const char*)data + encodeCountLen + length;
 }
 
+// reads the elements of a MultiValueType<MultiValueType<char> >, the count,
+// offset width and offset base are decoded once instead of on every
+// operator[]. walk with valid()/next()/value() or access by index.
+class MultiStringCursor
+{
+public:
+    MultiStringCursor()
+        : _offsetAddr(NULL)
+        , _dataAddr(NULL)
+        , _count(0)
+        , _offsetItemLen(0)
+        , _idx(0)
+    {}
+    explicit MultiStringCursor(const MultiValueType<MultiValueType<char> > &values)
+        : MultiStringCursor()
+    {
+        const char* data = values.getBaseAddress();
+        if (!data) {
+            return;
+        }
+        size_t countLen = 0;
+        uint32_t count = MultiValueFormatter::decodeCount(data, countLen);
+        if (count == 0 || count == MultiValueFormatter::VAR_NUM_NULL_FIELD_VALUE_COUNT) {
+            return;
+        }
+        _offsetItemLen = *(const uint8_t*)(data + countLen);
+        _offsetAddr = data + countLen + sizeof(uint8_t);
+        _dataAddr = _offsetAddr + _offsetItemLen * count;
+        _count = count;
+    }
+public:
+    uint32_t size() const {
+        return _count;
+    }
+    MultiValueType<char> operator[](uint32_t idx) const {
+        assert(idx < _count);
+        return MultiValueType<char>(getAddress(idx));
+    }
+    // data and length of element idx without building a MultiValueType<char>
+    const char* data(uint32_t idx, uint32_t &length) const {
+        const char* addr = getAddress(idx);
+        size_t countLen = 0;
+        uint32_t count = MultiValueFormatter::decodeCount(addr, countLen);
+        if (count == MultiValueFormatter::VAR_NUM_NULL_FIELD_VALUE_COUNT) {
+            length = 0;
+            return NULL;
+        }
+        length = count;
+        return addr + countLen;
+    }
+public:
+    bool valid() const {
+        return _idx < _count;
+    }
+    void next() {
+        ++_idx;
+    }
+    uint32_t index() const {
+        return _idx;
+    }
+    MultiValueType<char> value() const {
+        return (*this)[_idx];
+    }
+private:
+    const char* getAddress(uint32_t idx) const {
+        assert(idx < _count);
+        return _dataAddr + MultiValueFormatter::getOffset(_offsetAddr, _offsetItemLen, idx);
+    }
+private:
+    const char* _offsetAddr;
+    const char* _dataAddr;
+    uint32_t _count;
+    uint8_t _offsetItemLen;
+    uint32_t _idx;
+};
+
 #define MULTI_VALUE_TYPE_MACRO_HELPER(MY_MACRO)         \
     MY_MACRO(MultiValueType<bool>);                     \
     MY_MACRO(MultiValueType<int8_t>);                   \
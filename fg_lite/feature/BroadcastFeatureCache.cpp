@@ -0,0 +1,137 @@
+#include "fg_lite/feature/BroadcastFeatureCache.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, BroadcastFeatureCache);
+
+BroadcastFeatureCache::BroadcastFeatureCache(size_t memoryLimit, int64_t ttlUs)
+    : _memoryLimit(memoryLimit)
+    , _ttlUs(ttlUs)
+    , _memoryUse(0)
+    , _hitCount(0)
+    , _missCount(0)
+{
+}
+
+BroadcastFeatureCache::~BroadcastFeatureCache() {
+}
+
+static thread_local size_t threadHitCount = 0;
+static thread_local size_t threadMissCount = 0;
+
+// seed of the fingerprint, independent of the hash looked up
+static const uint64_t FINGERPRINT_SEED = 0x5bd1e995ULL;
+
+static uint64_t hashInput(const string &kind, const FeatureInput *input, uint64_t seed) {
+    FeatureHasher hasher(seed);
+    hasher.updateBinary(kind);
+    int32_t dataType = input->dataType();
+    hasher.update((const char *)&dataType, sizeof(dataType));
+    if (input->row() > 0) {
+        input->hashRow(0, hasher);
+    }
+    return hasher.finish();
+}
+
+BroadcastFeatureCache::Key BroadcastFeatureCache::makeKey(const string &kind,
+        const FeatureInput *input)
+{
+    return Key(hashInput(kind, input, FeatureHasher::DEFAULT_SEED),
+               hashInput(kind, input, FINGERPRINT_SEED));
+}
+
+shared_ptr<const void> BroadcastFeatureCache::doGet(const Key &key, const type_info &type,
+        int64_t currentTime)
+{
+    lock_guard<mutex> guard(_lock);
+    auto iter = _index.find(key.hash);
+    if (iter == _index.end()) {
+        _missCount++;
+        threadMissCount++;
+        return nullptr;
+    }
+    auto it = iter->second;
+    if (_ttlUs > 0 && it->expireTime <= currentTime) {
+        erase(it);
+        _missCount++;
+        threadMissCount++;
+        return nullptr;
+    }
+    if (it->fingerprint != key.fingerprint || *it->type != type) {
+        AUTIL_LOG(DEBUG, "entry of key[%lu] holds another value, hash collision", key.hash);
+        _missCount++;
+        threadMissCount++;
+        return nullptr;
+    }
+    _entries.splice(_entries.begin(), _entries, it);
+    _hitCount++;
+    threadHitCount++;
+    return it->value;
+}
+
+void BroadcastFeatureCache::doPut(const Key &key, const type_info &type,
+                                  shared_ptr<const void> value, size_t memoryUse,
+                                  int64_t currentTime)
+{
+    if (!value || memoryUse > _memoryLimit) {
+        AUTIL_LOG(DEBUG, "value of size[%lu] not cached, limit[%lu]",
+                  memoryUse, _memoryLimit);
+        return;
+    }
+    lock_guard<mutex> guard(_lock);
+    auto iter = _index.find(key.hash);
+    if (iter != _index.end()) {
+        erase(iter->second);
+    }
+    _entries.push_front(Entry{key.hash, key.fingerprint, &type, std::move(value), memoryUse,
+                              currentTime + _ttlUs});
+    _index[key.hash] = _entries.begin();
+    _memoryUse += memoryUse;
+    while (_memoryUse > _memoryLimit) {
+        erase(--_entries.end());
+    }
+}
+
+void BroadcastFeatureCache::erase(EntryList::iterator it) {
+    _memoryUse -= it->memoryUse;
+    _index.erase(it->key);
+    _entries.erase(it);
+}
+
+void BroadcastFeatureCache::clear() {
+    lock_guard<mutex> guard(_lock);
+    _entries.clear();
+    _index.clear();
+    _memoryUse = 0;
+}
+
+size_t BroadcastFeatureCache::size() const {
+    lock_guard<mutex> guard(_lock);
+    return _entries.size();
+}
+
+size_t BroadcastFeatureCache::getMemoryUse() const {
+    lock_guard<mutex> guard(_lock);
+    return _memoryUse;
+}
+
+size_t BroadcastFeatureCache::getHitCount() const {
+    lock_guard<mutex> guard(_lock);
+    return _hitCount;
+}
+
+size_t BroadcastFeatureCache::getMissCount() const {
+    lock_guard<mutex> guard(_lock);
+    return _missCount;
+}
+
+size_t BroadcastFeatureCache::getThreadHitCount() {
+    return threadHitCount;
+}
+
+size_t BroadcastFeatureCache::getThreadMissCount() {
+    return threadMissCount;
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef ISEARCH_FG_LITE_BROADCASTFEATURECACHE_H
+#define ISEARCH_FG_LITE_BROADCASTFEATURECACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include "autil/Log.h"
+#include "autil/TimeUtility.h"
+#include "fg_lite/feature/FeatureInput.h"
+
+namespace fg_lite {
+
+/*
+ * results computed from broadcast (row() == 1, user side) inputs, shared by
+ * the genFeatures calls of one user across item batches and ranking stages.
+ * entries are keyed by what they are plus the contents of the inputs, they
+ * expire ttl after insertion and the least recently used are evicted when the
+ * memory limit is exceeded. thread safe, values are immutable once put.
+ */
+class BroadcastFeatureCache
+{
+public:
+    // hash looked up and a second hash of what the value was computed from,
+    // entries are only returned when the fingerprint and value type match too
+    struct Key {
+        Key(uint64_t hash_, uint64_t fingerprint_ = 0)
+            : hash(hash_)
+            , fingerprint(fingerprint_)
+        {}
+        uint64_t hash;
+        uint64_t fingerprint;
+    };
+private:
+    struct Entry {
+        uint64_t key;
+        uint64_t fingerprint;
+        const std::type_info *type;
+        std::shared_ptr<const void> value;
+        size_t memoryUse;
+        int64_t expireTime;
+    };
+    typedef std::list<Entry> EntryList;
+public:
+    // ttlUs <= 0 means entries never expire
+    BroadcastFeatureCache(size_t memoryLimit, int64_t ttlUs);
+    ~BroadcastFeatureCache();
+private:
+    BroadcastFeatureCache(const BroadcastFeatureCache &);
+    BroadcastFeatureCache& operator=(const BroadcastFeatureCache &);
+public:
+    // key of the first row of input for a kind of cached value
+    static Key makeKey(const std::string &kind, const FeatureInput *input);
+
+    template <typename T>
+    std::shared_ptr<const T> get(const Key &key) {
+        return get<T>(key, autil::TimeUtility::currentTime());
+    }
+    // another value under the same hash is a miss
+    template <typename T>
+    std::shared_ptr<const T> get(const Key &key, int64_t currentTime) {
+        return std::static_pointer_cast<const T>(doGet(key, typeid(T), currentTime));
+    }
+    // memoryUse is the estimated size of value, values larger than the limit
+    // are not cached
+    template <typename T>
+    void put(const Key &key, const std::shared_ptr<const T> &value, size_t memoryUse) {
+        put<T>(key, value, memoryUse, autil::TimeUtility::currentTime());
+    }
+    template <typename T>
+    void put(const Key &key, const std::shared_ptr<const T> &value, size_t memoryUse,
+             int64_t currentTime)
+    {
+        doPut(key, typeid(T), std::static_pointer_cast<const void>(value), memoryUse,
+              currentTime);
+    }
+    void clear();
+public:
+    size_t size() const;
+    size_t getMemoryUse() const;
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+    // lookups the calling thread made in any cache, the difference around a
+    // genFeatures call is what that call hit and missed
+    static size_t getThreadHitCount();
+    static size_t getThreadMissCount();
+private:
+    std::shared_ptr<const void> doGet(const Key &key, const std::type_info &type,
+                                      int64_t currentTime);
+    void doPut(const Key &key, const std::type_info &type,
+               std::shared_ptr<const void> value, size_t memoryUse, int64_t currentTime);
+    void erase(EntryList::iterator it);
+private:
+    const size_t _memoryLimit;
+    const int64_t _ttlUs;
+    mutable std::mutex _lock;
+    // most recently used first
+    EntryList _entries;
+    std::unordered_map<uint64_t, EntryList::iterator> _index;
+    size_t _memoryUse;
+    size_t _hitCount;
+    size_t _missCount;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_BROADCASTFEATURECACHE_H
@@ -0,0 +1,444 @@
+#include "fg_lite/feature/ColumnFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "autil/MultiValueFormatter.h"
+
+using namespace std;
+using namespace autil;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, MappedColumn);
+AUTIL_LOG_SETUP(fg_lite, ColumnFileWriter);
+AUTIL_LOG_SETUP(fg_lite, FeatureChunkWriter);
+
+static size_t alignSize(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+MappedColumn::MappedColumn()
+    : _data(nullptr)
+    , _length(0)
+    , _header(nullptr)
+    , _rowOffsets(nullptr)
+{
+}
+
+MappedColumn::~MappedColumn() {
+    close();
+}
+
+void MappedColumn::close() {
+    _input.reset();
+    _strings.clear();
+    if (_data != nullptr) {
+        munmap(_data, _length);
+        _data = nullptr;
+    }
+    _header = nullptr;
+    _rowOffsets = nullptr;
+}
+
+bool MappedColumn::open(const string &path) {
+    close();
+    _path = path;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        AUTIL_LOG(ERROR, "open column[%s] failed", path.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ColumnFileHeader)) {
+        AUTIL_LOG(ERROR, "column[%s] is too short", path.c_str());
+        ::close(fd);
+        return false;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        AUTIL_LOG(ERROR, "mmap column[%s] failed", path.c_str());
+        return false;
+    }
+    _data = (char*)data;
+    _length = st.st_size;
+    madvise(_data, _length, MADV_SEQUENTIAL);
+    _header = (const ColumnFileHeader*)_data;
+    if (_header->magic != ColumnFileHeader::MAGIC) {
+        AUTIL_LOG(ERROR, "column[%s] magic mismatch", path.c_str());
+        close();
+        return false;
+    }
+    size_t pos = sizeof(ColumnFileHeader);
+    if (_header->storageType == IST_SPARSE_VALUE_OFFSET) {
+        if (_header->rowCount > (_length - pos) / sizeof(size_t)) {
+            AUTIL_LOG(ERROR, "column[%s] is truncated", path.c_str());
+            close();
+            return false;
+        }
+        _rowOffsets = (const size_t*)(_data + pos);
+        pos += alignSize(_header->rowCount * sizeof(size_t));
+        if (!checkRowOffsets()) {
+            close();
+            return false;
+        }
+    } else if (_header->storageType != IST_DENSE ||
+               (_header->colCount != 0 &&
+                _header->rowCount > _header->valueCount / _header->colCount) ||
+               _header->rowCount * _header->colCount != _header->valueCount)
+    {
+        AUTIL_LOG(ERROR, "column[%s] storage type[%u] or shape invalid",
+                  path.c_str(), _header->storageType);
+        close();
+        return false;
+    }
+    if (pos > _length) {
+        AUTIL_LOG(ERROR, "column[%s] is truncated", path.c_str());
+        close();
+        return false;
+    }
+    bool ret = false;
+    const char *values = _data + pos;
+    switch (_header->dataType) {
+#define CASE(vt)                                                        \
+    case vt:                                                            \
+        ret = createInput<InputType2Type<vt>::Type>(values);            \
+        break
+        NUMERIC_INPUT_DATA_TYPE_MACRO_HELPER(CASE);
+#undef CASE
+    case IT_STRING:
+        ret = createStringInput(values);
+        break;
+    default:
+        AUTIL_LOG(ERROR, "column[%s] data type[%u] not supported",
+                  path.c_str(), _header->dataType);
+    }
+    if (!ret) {
+        close();
+    }
+    return ret;
+}
+
+bool MappedColumn::checkRowOffsets() const {
+    size_t lastOffset = 0;
+    for (size_t i = 0; i < _header->rowCount; i++) {
+        if (_rowOffsets[i] < lastOffset || _rowOffsets[i] > _header->valueCount) {
+            AUTIL_LOG(ERROR, "column[%s] row offset[%lu] of row[%lu] decreasing or"
+                      " past value count[%lu]", _path.c_str(), _rowOffsets[i], i,
+                      (size_t)_header->valueCount);
+            return false;
+        }
+        lastOffset = _rowOffsets[i];
+    }
+    return true;
+}
+
+template <typename T>
+bool MappedColumn::createInput(const char *values) {
+    if (_header->valueCount > size_t(_data + _length - values) / sizeof(T)) {
+        AUTIL_LOG(ERROR, "column[%s] is truncated", _path.c_str());
+        return false;
+    }
+    const T *typedValues = (const T*)values;
+    if (_header->storageType == IST_DENSE) {
+        _input.reset(new FeatureInputTyped<T, DenseStorage<T>>(DenseStorage<T>(
+                                typedValues, _header->rowCount, _header->colCount)));
+    } else {
+        _input.reset(new FeatureInputTyped<T, ValueOffsetStorage<T>>(ValueOffsetStorage<T>(
+                                typedValues, _header->valueCount,
+                                _rowOffsets, _header->rowCount)));
+    }
+    return true;
+}
+
+bool MappedColumn::createStringInput(const char *values) {
+    const uint64_t *valueOffsets = (const uint64_t*)values;
+    size_t left = _data + _length - values;
+    if (_header->valueCount > left / sizeof(uint64_t) ||
+        _header->byteCount > left - alignSize(_header->valueCount * sizeof(uint64_t)))
+    {
+        AUTIL_LOG(ERROR, "column[%s] is truncated", _path.c_str());
+        return false;
+    }
+    const char *bytes = values + alignSize(_header->valueCount * sizeof(uint64_t));
+    _strings.resize(_header->valueCount);
+    for (size_t i = 0; i < _header->valueCount; i++) {
+        if (!checkStringEntry(bytes, valueOffsets[i])) {
+            return false;
+        }
+        _strings[i].init(bytes + valueOffsets[i]);
+    }
+    if (_header->storageType == IST_DENSE) {
+        _input.reset(new FeatureInputTyped<MultiChar, DenseStorage<MultiChar>>(
+                        DenseStorage<MultiChar>(_strings.data(), _header->rowCount,
+                                _header->colCount)));
+    } else {
+        _input.reset(new FeatureInputTyped<MultiChar, ValueOffsetStorage<MultiChar>>(
+                        ValueOffsetStorage<MultiChar>(_strings.data(), _header->valueCount,
+                                _rowOffsets, _header->rowCount)));
+    }
+    return true;
+}
+
+bool MappedColumn::checkStringEntry(const char *bytes, uint64_t offset) const {
+    const uint64_t byteCount = _header->byteCount;
+    if (offset >= byteCount ||
+        MultiValueFormatter::getEncodedCountFromFirstByte(bytes[offset]) > byteCount - offset)
+    {
+        AUTIL_LOG(ERROR, "column[%s] value offset[%lu] out of range",
+                  _path.c_str(), (size_t)offset);
+        return false;
+    }
+    size_t countLen = 0;
+    uint32_t count = MultiValueFormatter::decodeCount(bytes + offset, countLen);
+    if (count != MultiValueFormatter::VAR_NUM_NULL_FIELD_VALUE_COUNT &&
+        count > byteCount - offset - countLen)
+    {
+        AUTIL_LOG(ERROR, "column[%s] value at offset[%lu] of length[%u] past byte count[%lu]",
+                  _path.c_str(), (size_t)offset, count, (size_t)byteCount);
+        return false;
+    }
+    return true;
+}
+
+ColumnFileHeader ColumnFileWriter::makeHeader(InputDataType dataType,
+        InputStorageType storageType, size_t rowCount, size_t colCount, size_t valueCount)
+{
+    ColumnFileHeader header;
+    header.magic = ColumnFileHeader::MAGIC;
+    header.dataType = dataType;
+    header.storageType = storageType;
+    header.rowCount = rowCount;
+    header.colCount = colCount;
+    header.valueCount = valueCount;
+    header.byteCount = 0;
+    return header;
+}
+
+bool ColumnFileWriter::writeStrings(const string &path, const vector<string> &values,
+                                    const vector<size_t> &offsets)
+{
+    ColumnFileHeader header = offsets.empty() ?
+        makeHeader(IT_STRING, IST_DENSE, values.size(), 1, values.size()) :
+        makeHeader(IT_STRING, IST_SPARSE_VALUE_OFFSET, offsets.size(), 0, values.size());
+    vector<uint64_t> valueOffsets;
+    string bytes;
+    for (const auto &value : values) {
+        valueOffsets.push_back(bytes.size());
+        char countBuffer[4];
+        size_t countLen = MultiValueFormatter::encodeCount(
+                value.size(), countBuffer, sizeof(countBuffer));
+        bytes.append(countBuffer, countLen);
+        bytes.append(value);
+    }
+    header.byteCount = bytes.size();
+    string data((const char*)valueOffsets.data(), valueOffsets.size() * sizeof(uint64_t));
+    data.resize(alignSize(data.size()), '\0');
+    data.append(bytes);
+    return write(path, header, offsets, data.data(), data.size());
+}
+
+bool ColumnFileWriter::write(const string &path, const ColumnFileHeader &header,
+                             const vector<size_t> &offsets, const void *values, size_t length)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        AUTIL_LOG(ERROR, "open column[%s] for write failed", path.c_str());
+        return false;
+    }
+    static const char padding[8] = {0};
+    size_t offsetLength = offsets.size() * sizeof(size_t);
+    bool ret = fwrite(&header, sizeof(header), 1, file) == 1
+               && fwrite(offsets.data(), 1, offsetLength, file) == offsetLength
+               && fwrite(padding, 1, alignSize(offsetLength) - offsetLength, file)
+                  == alignSize(offsetLength) - offsetLength
+               && fwrite(values, 1, length, file) == length;
+    ret = fclose(file) == 0 && ret;
+    if (!ret) {
+        AUTIL_LOG(ERROR, "write column[%s] failed", path.c_str());
+    }
+    return ret;
+}
+
+FeatureChunkWriter::FeatureChunkWriter()
+    : _file(nullptr)
+    , _writtenBytes(0)
+{
+}
+
+FeatureChunkWriter::~FeatureChunkWriter() {
+    close();
+}
+
+bool FeatureChunkWriter::open(const string &path, size_t bufferSize) {
+    close();
+    _path = path;
+    _writtenBytes = 0;
+    _file = fopen(path.c_str(), "wb");
+    if (_file == nullptr) {
+        AUTIL_LOG(ERROR, "open output[%s] failed", path.c_str());
+        return false;
+    }
+    _buffer.resize(bufferSize);
+    setvbuf(_file, _buffer.data(), _IOFBF, _buffer.size());
+    return true;
+}
+
+bool FeatureChunkWriter::close() {
+    if (_file == nullptr) {
+        return true;
+    }
+    bool ret = fclose(_file) == 0;
+    _file = nullptr;
+    if (!ret) {
+        AUTIL_LOG(ERROR, "close output[%s] failed", _path.c_str());
+    }
+    return ret;
+}
+
+bool FeatureChunkWriter::writeData(const void *data, size_t length) {
+    _writtenBytes += length;
+    return fwrite(data, 1, length, _file) == length;
+}
+
+bool FeatureChunkWriter::writeKeys(const pool_vector<ConstString> &keys) {
+    vector<uint64_t> keyOffsets;
+    keyOffsets.reserve(keys.size());
+    uint64_t offset = 0;
+    for (const auto &key : keys) {
+        keyOffsets.push_back(offset);
+        offset += key.size();
+    }
+    if (!writeData(keyOffsets.data(), keyOffsets.size() * sizeof(uint64_t))) {
+        return false;
+    }
+    for (const auto &key : keys) {
+        if (!writeData(key.data(), key.size())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint64_t getKeyBytes(const pool_vector<ConstString> &keys) {
+    uint64_t byteCount = 0;
+    for (const auto &key : keys) {
+        byteCount += key.size();
+    }
+    return byteCount;
+}
+
+bool FeatureChunkWriter::write(const Features *features, size_t docCount) {
+    if (_file == nullptr || features == nullptr) {
+        return false;
+    }
+    FeatureChunkHeader header;
+    header.featureValueType = features->getFeatureValueType();
+    header.reserved = 0;
+    header.docCount = docCount;
+    header.byteCount = 0;
+    bool ret = false;
+    switch (features->getFeatureValueType()) {
+    case FVT_SINGLE_SPARSE: {
+        auto typed = static_cast<const SingleSparseFeatures*>(features);
+        header.valueCount = typed->_featureNames.size();
+        header.byteCount = getKeyBytes(typed->_featureNames);
+        ret = writeData(&header, sizeof(header)) && writeKeys(typed->_featureNames);
+        break;
+    }
+    case FVT_MULTI_SPARSE:
+    case FVT_WEIGHTING_SPARSE:
+    case FVT_WEIGHTING_SPARSE_FLOAT: {
+        auto typed = static_cast<const MultiSparseFeatures*>(features);
+        if (header.featureValueType == FVT_WEIGHTING_SPARSE_FLOAT) {
+            header.featureValueType = FVT_WEIGHTING_SPARSE;
+        }
+        header.valueCount = typed->_featureNames.size();
+        header.byteCount = getKeyBytes(typed->_featureNames);
+        ret = writeData(&header, sizeof(header)) && writeValuesAs<uint64_t>(typed->_offsets)
+              && writeKeys(typed->_featureNames);
+        if (ret && features->getFeatureValueType() == FVT_WEIGHTING_SPARSE) {
+            ret = writeValues(static_cast<const MultiSparseWeightingFeatures*>(
+                            features)->_featureValues);
+        } else if (ret && features->getFeatureValueType() == FVT_WEIGHTING_SPARSE_FLOAT) {
+            ret = writeValuesAs<double>(static_cast<const MultiSparseFloatWeightingFeatures*>(
+                            features)->_featureValues);
+        }
+        break;
+    }
+    case FVT_MULTI_HASHED_SPARSE: {
+        auto typed = static_cast<const MultiHashedSparseFeatures*>(features);
+        header.valueCount = typed->_featureHashes.size();
+        ret = writeData(&header, sizeof(header)) && writeValuesAs<uint64_t>(typed->_offsets)
+              && writeValues(typed->_featureHashes);
+        break;
+    }
+    case FVT_SINGLE_DENSE: {
+        auto typed = static_cast<const SingleDenseFeatures*>(features);
+        header.valueCount = typed->_featureValues.size();
+        ret = writeData(&header, sizeof(header)) && writeValues(typed->_featureValues);
+        break;
+    }
+    case FVT_MULTI_DENSE: {
+        auto typed = static_cast<const MultiDenseFeatures*>(features);
+        header.valueCount = typed->_featureValues.size();
+        ret = writeData(&header, sizeof(header)) && writeValuesAs<uint64_t>(typed->_offsets)
+              && writeValues(typed->_featureValues);
+        break;
+    }
+    case FVT_SINGLE_SPARSE_INT: {
+        auto typed = static_cast<const SingleIntegerFeatures*>(features);
+        header.valueCount = typed->_featureValues.size();
+        ret = writeData(&header, sizeof(header)) && writeValues(typed->_featureValues);
+        break;
+    }
+    case FVT_MULTI_SPARSE_INT: {
+        auto typed = static_cast<const MultiIntegerFeatures*>(features);
+        header.valueCount = typed->_featureValues.size();
+        ret = writeData(&header, sizeof(header)) && writeValuesAs<uint64_t>(typed->_offsets)
+              && writeValues(typed->_featureValues);
+        break;
+    }
+    case FVT_SINGLE_SPARSE_INT32:
+        ret = writeCompactIntegers(static_cast<const SingleInt32Features*>(features), header);
+        break;
+    case FVT_MULTI_SPARSE_INT32:
+        ret = writeCompactIntegers(static_cast<const MultiInt32Features*>(features), header);
+        break;
+    case FVT_SINGLE_SPARSE_INT16:
+        ret = writeCompactIntegers(static_cast<const SingleInt16Features*>(features), header);
+        break;
+    case FVT_MULTI_SPARSE_INT16:
+        ret = writeCompactIntegers(static_cast<const MultiInt16Features*>(features), header);
+        break;
+    default:
+        AUTIL_LOG(ERROR, "output[%s] features type[%d] not supported",
+                  _path.c_str(), int(features->getFeatureValueType()));
+        return false;
+    }
+    if (!ret) {
+        AUTIL_LOG(ERROR, "write output[%s] failed", _path.c_str());
+    }
+    return ret;
+}
+
+bool FeatureChunkWriter::writeEmpty(size_t docCount) {
+    if (_file == nullptr) {
+        return false;
+    }
+    FeatureChunkHeader header;
+    header.featureValueType = FVT_MULTI_SPARSE;
+    header.reserved = 0;
+    header.docCount = docCount;
+    header.valueCount = 0;
+    header.byteCount = 0;
+    vector<uint64_t> offsets(docCount, 0);
+    bool ret = writeData(&header, sizeof(header))
+               && writeData(offsets.data(), offsets.size() * sizeof(uint64_t));
+    if (!ret) {
+        AUTIL_LOG(ERROR, "write output[%s] failed", _path.c_str());
+    }
+    return ret;
+}
+
+}
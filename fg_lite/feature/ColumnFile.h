@@ -0,0 +1,205 @@
+#ifndef ISEARCH_FG_LITE_COLUMNFILE_H
+#define ISEARCH_FG_LITE_COLUMNFILE_H
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "autil/Log.h"
+#include "autil/MultiValueType.h"
+#include "fg_lite/feature/Feature.h"
+#include "fg_lite/feature/FeatureInput.h"
+
+namespace fg_lite {
+
+/*
+ * columnar input file, mapped straight onto a DenseStorage or a
+ * ValueOffsetStorage. the header is followed by 8 byte aligned sections:
+ *   row offsets   size_t[rowCount], IST_SPARSE_VALUE_OFFSET only
+ *   values        T[valueCount] for numeric types. for IT_STRING value
+ *                 offsets uint64[valueCount] into byteCount bytes of values
+ *                 encoded as MultiChar, count header then chars.
+ */
+struct ColumnFileHeader {
+    static const uint64_t MAGIC = 0x314c4f4347464c46ULL; // "FLFGCOL1"
+    uint64_t magic;
+    uint32_t dataType;
+    uint32_t storageType;
+    uint64_t rowCount;
+    // values per row, IST_DENSE only
+    uint64_t colCount;
+    uint64_t valueCount;
+    uint64_t byteCount;
+};
+
+class MappedColumn
+{
+public:
+    MappedColumn();
+    ~MappedColumn();
+private:
+    MappedColumn(const MappedColumn &);
+    MappedColumn& operator=(const MappedColumn &);
+public:
+    bool open(const std::string &path);
+    // view of the mapped file, valid while this column is alive
+    FeatureInput *getInput() const { return _input.get(); }
+    const ColumnFileHeader &getHeader() const { return *_header; }
+private:
+    template <typename T>
+    bool createInput(const char *values);
+    bool createStringInput(const char *values);
+    // row offsets non decreasing and within the values
+    bool checkRowOffsets() const;
+    // count header and chars of the value at offset within the bytes
+    bool checkStringEntry(const char *bytes, uint64_t offset) const;
+    void close();
+private:
+    std::string _path;
+    char *_data;
+    size_t _length;
+    const ColumnFileHeader *_header;
+    const size_t *_rowOffsets;
+    // MultiChar keeps the offset to its chars, so the views live here
+    std::vector<autil::MultiChar> _strings;
+    std::unique_ptr<FeatureInput> _input;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+// writes columns readable by MappedColumn
+class ColumnFileWriter
+{
+public:
+    // colCount values per row
+    template <typename T>
+    static bool writeDense(const std::string &path, const std::vector<T> &values,
+                           size_t colCount = 1)
+    {
+        if (colCount == 0 || values.size() % colCount != 0) {
+            return false;
+        }
+        ColumnFileHeader header = makeHeader(Type2InputType<T>::value, IST_DENSE,
+                values.size() / colCount, colCount, values.size());
+        return write(path, header, {}, values.data(), values.size() * sizeof(T));
+    }
+    // offsets are the begin of every row in values
+    template <typename T>
+    static bool writeValueOffset(const std::string &path, const std::vector<T> &values,
+                                 const std::vector<size_t> &offsets)
+    {
+        ColumnFileHeader header = makeHeader(Type2InputType<T>::value,
+                IST_SPARSE_VALUE_OFFSET, offsets.size(), 0, values.size());
+        return write(path, header, offsets, values.data(), values.size() * sizeof(T));
+    }
+    // IT_STRING column, dense with one value per row if offsets is empty
+    static bool writeStrings(const std::string &path, const std::vector<std::string> &values,
+                             const std::vector<size_t> &offsets = {});
+private:
+    static ColumnFileHeader makeHeader(InputDataType dataType, InputStorageType storageType,
+            size_t rowCount, size_t colCount, size_t valueCount);
+    static bool write(const std::string &path, const ColumnFileHeader &header,
+                      const std::vector<size_t> &offsets, const void *values, size_t length);
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+/*
+ * output of one feature, appended chunk by chunk as a FeatureChunkHeader,
+ * doc offsets uint64[docCount] for multi value types, then the values:
+ * keys as offsets uint64[valueCount] and byteCount chars, hashes as uint64,
+ * dense as float, integers as int64, and weights as double after the keys.
+ * the compact int32, int16 and float weighting types, see Feature.h, are
+ * widened to these, with their 32 bit offsets, and written as the wide types.
+ */
+struct FeatureChunkHeader {
+    uint32_t featureValueType;
+    uint32_t reserved;
+    uint64_t docCount;
+    uint64_t valueCount;
+    uint64_t byteCount;
+};
+
+class FeatureChunkWriter
+{
+public:
+    FeatureChunkWriter();
+    ~FeatureChunkWriter();
+private:
+    FeatureChunkWriter(const FeatureChunkWriter &);
+    FeatureChunkWriter& operator=(const FeatureChunkWriter &);
+public:
+    bool open(const std::string &path, size_t bufferSize = 4 << 20);
+    // features generated for docCount docs, tensor outputs are not supported
+    bool write(const Features *features, size_t docCount);
+    // docCount docs without values, e.g. for a feature that failed, so the
+    // chunks of every output still cover the same docs. written as FVT_MULTI_SPARSE
+    bool writeEmpty(size_t docCount);
+    bool close();
+    // bytes written since open
+    uint64_t getWrittenBytes() const { return _writtenBytes; }
+private:
+    bool writeKeys(const pool_vector<autil::ConstString> &keys);
+    template <typename T>
+    bool writeValues(const pool_vector<T> &values) {
+        return writeData(values.data(), values.size() * sizeof(T));
+    }
+    // values widened to the type of the file, e.g. 32 bit doc offsets to uint64
+    template <typename FileType, typename T>
+    bool writeValuesAs(const pool_vector<T> &values) {
+        return writeValuesAs<FileType>(values, std::is_same<FileType, T>());
+    }
+    template <typename FileType, typename T>
+    bool writeValuesAs(const pool_vector<T> &values, std::true_type) {
+        return writeValues(values);
+    }
+    template <typename FileType, typename T>
+    bool writeValuesAs(const pool_vector<T> &values, std::false_type) {
+        FileType converted[256];
+        for (size_t begin = 0; begin < values.size(); begin += 256) {
+            size_t count = std::min(values.size() - begin, size_t(256));
+            for (size_t i = 0; i < count; i++) {
+                converted[i] = FileType(values[begin + i]);
+            }
+            if (!writeData(converted, count * sizeof(FileType))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    // written as FVT_SINGLE_SPARSE_INT
+    template <typename T>
+    bool writeCompactIntegers(const SingleIntegerFeaturesTyped<T> *features,
+                              FeatureChunkHeader &header)
+    {
+        header.featureValueType = FVT_SINGLE_SPARSE_INT;
+        header.valueCount = features->_featureValues.size();
+        return writeData(&header, sizeof(header))
+            && writeValuesAs<int64_t>(features->_featureValues);
+    }
+    // written as FVT_MULTI_SPARSE_INT
+    template <typename T>
+    bool writeCompactIntegers(const MultiIntegerFeaturesTyped<T> *features,
+                              FeatureChunkHeader &header)
+    {
+        header.featureValueType = FVT_MULTI_SPARSE_INT;
+        header.valueCount = features->_featureValues.size();
+        return writeData(&header, sizeof(header))
+            && writeValuesAs<uint64_t>(features->_offsets)
+            && writeValuesAs<int64_t>(features->_featureValues);
+    }
+    bool writeData(const void *data, size_t length);
+private:
+    std::string _path;
+    FILE *_file;
+    std::vector<char> _buffer;
+    uint64_t _writtenBytes;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_COLUMNFILE_H
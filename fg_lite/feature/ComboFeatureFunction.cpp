@@ -1,5 +1,6 @@
 #include "fg_lite/feature/ComboFeatureFunction.h"
 #include "fg_lite/feature/FeatureFormatter.h"
+#include "fg_lite/feature/BroadcastFeatureCache.h"
 
 using namespace autil;
 using namespace std;
@@ -28,7 +29,9 @@ ComboFeatureFunction::ComboFeatureFunction(const string &name, const string &pre
 
 static bool isAllSingleValueInput(const vector<FeatureInput*> &inputs) {
     for (size_t i = 0; i < inputs.size(); i++) {
-        if (inputs[i]->storageType() != IST_DENSE) {
+        if (inputs[i]->storageType() != IST_DENSE
+            && inputs[i]->storageType() != IST_DICTIONARY)
+        {
             return false;
         }
         for (size_t r = 0; r < inputs[i]->row(); r++) {
@@ -40,152 +43,336 @@ static bool isAllSingleValueInput(const vector<FeatureInput*> &inputs) {
     return true;
 }
 
+// formatted values of a broadcast input, shared by the combos of one user
+struct FormattedBroadcastInput {
+    vector<string> values;
+    // false if some value is invalid, combo skips it so the input is kept
+    bool complete = true;
+};
+
+static const string FORMATTED_INPUT_KIND = "combo_formatted_input";
+
+// row() == 1 inputs replaced by dense string views of their cached formatted
+// values, the same text as toString() writes, so keys and hashes are unchanged.
+class BroadcastInputFormatter {
+public:
+    BroadcastInputFormatter(const vector<FeatureInput*> &inputs,
+                            BroadcastFeatureCache *cache)
+        : _inputs(inputs)
+    {
+        if (!cache) {
+            return;
+        }
+        for (size_t i = 0; i < _inputs.size(); i++) {
+            if (_inputs[i]->row() != 1) {
+                continue;
+            }
+            auto formatted = getFormatted(_inputs[i], cache);
+            if (!formatted->complete) {
+                continue;
+            }
+            typedef FeatureInputTyped<string, DenseStorage<string>> StringInput;
+            _views.emplace_back(new StringInput(DenseStorage<string>(
+                                    formatted->values.data(), 1, formatted->values.size())));
+            _inputs[i] = _views.back().get();
+            _formatted.push_back(std::move(formatted));
+        }
+    }
+public:
+    const vector<FeatureInput*> &getInputs() const {
+        return _inputs;
+    }
+private:
+    static shared_ptr<const FormattedBroadcastInput> getFormatted(
+            FeatureInput *input, BroadcastFeatureCache *cache)
+    {
+        auto key = BroadcastFeatureCache::makeKey(FORMATTED_INPUT_KIND, input);
+        auto cached = cache->get<FormattedBroadcastInput>(key);
+        if (cached) {
+            return cached;
+        }
+        auto formatted = make_shared<FormattedBroadcastInput>();
+        mem_pool::UnsafePool pool(1024);
+        FeatureFormatter::FeatureBuffer buffer{mem_pool::pool_allocator<char>(&pool)};
+        size_t memoryUse = sizeof(FormattedBroadcastInput);
+        for (size_t c = 0; c < input->col(0); c++) {
+            buffer.clear();
+            if (!input->toString(0, c, buffer, true)) {
+                formatted->complete = false;
+                break;
+            }
+            formatted->values.emplace_back(buffer.data(), buffer.size());
+            memoryUse += sizeof(string) + buffer.size();
+        }
+        cache->put<FormattedBroadcastInput>(key, formatted, memoryUse);
+        return formatted;
+    }
+private:
+    vector<FeatureInput*> _inputs;
+    vector<shared_ptr<const FormattedBroadcastInput>> _formatted;
+    vector<unique_ptr<FeatureInput>> _views;
+};
+
+// numeric dictionary inputs replaced by dictionaries of their formatted
+// values, every distinct value is formatted once instead of once per doc.
+class DictionaryInputFormatter {
+public:
+    DictionaryInputFormatter(const vector<FeatureInput*> &inputs)
+        : _inputs(inputs)
+    {
+        for (size_t i = 0; i < _inputs.size(); i++) {
+            if (_inputs[i]->storageType() != IST_DICTIONARY) {
+                continue;
+            }
+            switch (_inputs[i]->dataType()) {
+#define FORMAT_DICTIONARY_CASE(dt)                                      \
+            case dt:                                                    \
+                format<InputType2Type<dt>::Type>(i);                    \
+                break
+                NUMERIC_INPUT_DATA_TYPE_MACRO_HELPER(FORMAT_DICTIONARY_CASE);
+#undef FORMAT_DICTIONARY_CASE
+            default:
+                break;
+            }
+        }
+    }
+public:
+    const vector<FeatureInput*> &getInputs() const {
+        return _inputs;
+    }
+private:
+    template <typename T>
+    void format(size_t i) {
+        const DictionaryStorage<T> &storage =
+            _inputs[i]->typed<T, DictionaryStorage<T>>()->getStorage();
+        if (storage.dictionarySize() >= storage.numElements()) {
+            return;
+        }
+        const T *dictionary = storage.getDictionary();
+        for (size_t code = 0; code < storage.dictionarySize(); code++) {
+            // invalid values are skipped by combo, the input is kept
+            if (FeatureFormatter::isInvalidValue(dictionary[code])) {
+                return;
+            }
+        }
+        mem_pool::UnsafePool pool(1024);
+        FeatureFormatter::FeatureBuffer arena{mem_pool::pool_allocator<char>(&pool)};
+        vector<size_t> offsets;
+        FeatureFormatter::formatColumn(dictionary, storage.dictionarySize(), arena, offsets);
+        unique_ptr<vector<string>> values(new vector<string>());
+        values->reserve(storage.dictionarySize());
+        for (size_t code = 0; code < storage.dictionarySize(); code++) {
+            values->emplace_back(arena.data() + offsets[code], offsets[code + 1] - offsets[code]);
+        }
+        typedef FeatureInputTyped<string, DictionaryStorage<string>> StringInput;
+        _views.emplace_back(new StringInput(DictionaryStorage<string>(
+                                values->data(), values->size(), storage.getCodes(),
+                                storage.row(), storage.col(0))));
+        _inputs[i] = _views.back().get();
+        _formatted.push_back(std::move(values));
+    }
+private:
+    vector<FeatureInput*> _inputs;
+    vector<unique_ptr<vector<string>>> _formatted;
+    vector<unique_ptr<FeatureInput>> _views;
+};
+
 Features* ComboFeatureFunction::genFeatures(
-        const vector<FeatureInput*> &inputs,
+        const vector<FeatureInput*> &rawInputs,
         FeatureFunctionContext *context) const
 {
-    if (!checkInput(inputs)) {
+    if (!checkInput(rawInputs)) {
         AUTIL_LOG(ERROR, "input count invalid, expected[%d], actual[%d]",
-                  (int)getInputCount(), (int)inputs.size());
+                  (int)getInputCount(), (int)rawInputs.size());
         return nullptr;
     }
     size_t docCount;
-    if (!checkAndGetDocCount(inputs, docCount)) {
+    if (!checkAndGetDocCount(rawInputs, docCount)) {
         AUTIL_LOG(ERROR, "feature[%s] docCounts not equal 1 or not one user input",
                   getFeatureName().c_str());
         return nullptr;
     }
-    bool isAllSingle = isAllSingleValueInput(inputs);
-    MultiSparseFeatures *features = new MultiSparseFeatures(docCount);
-    FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-    vector<FeatureFormatter::FeatureBuffer> bufferVec;
-    for (size_t i = 0; i < docCount; i++) {
-        features->beginDocument();
-#define DO_GEN_FEATURE(Combo)                                           \
-        if (isAllSingle) {                                              \
-            genFeatureFast(inputs, i, features, combo);          \
-        } else {                                                        \
-            genFeatureNormal(inputs, i, 0,  features, combo);    \
-        }
-
-        if (_needSort) {
-            SortedCombo combo(buffer);
-            DO_GEN_FEATURE(SortedCombo)
-        } else {
-            NormalCombo combo(buffer);
-            DO_GEN_FEATURE(NormalCombo)
+    bool isAllSingle = isAllSingleValueInput(rawInputs);
+    // with a single doc every input is row() == 1, item values are not cached
+    DictionaryInputFormatter dictionaryFormatter(rawInputs);
+    BroadcastInputFormatter formatter(dictionaryFormatter.getInputs(),
+            docCount > 1 ? getBroadcastCache(context) : nullptr);
+    const vector<FeatureInput*> &inputs = formatter.getInputs();
+    if (isHashOutput()) {
+        if (getTensorBuffer(context) != nullptr) {
+            return genHashedFeatures<TensorSparseFeatures>(inputs, docCount, isAllSingle, context);
         }
-#undef DO_GEN_FEATURE
+        return genHashedFeatures<MultiHashedSparseFeatures>(inputs, docCount, isAllSingle, context);
+    }
+    typedef MultiSparseFeatures FeaturesType;
+    FeaturesType *features = createFeatures<FeaturesType>(docCount, context);
+    FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
+#define GEN_COMBO_FEATURES(Combo, ...)                                  \
+    {                                                                   \
+        ResolvedInputs<Combo, FeaturesType> resolved;                 \
+        resolveInputs(inputs, resolved);                                \
+        for (size_t i = 0; i < docCount; i++) {                         \
+            features->beginDocument();                                  \
+            Combo combo(__VA_ARGS__);                                   \
+            if (isAllSingle) {                                          \
+                genFeatureFast(resolved, i, features, combo);           \
+            } else {                                                    \
+                genFeatureNormal(resolved, i, 0, features, combo);      \
+            }                                                           \
+        }                                                               \
+    }
+
+    if (_needSort) {
+        GEN_COMBO_FEATURES(SortedCombo, buffer)
+    } else {
+        GEN_COMBO_FEATURES(NormalCombo, buffer)
     }
     return features;
 }
 
-template<typename Combo>
-void ComboFeatureFunction::genFeatureFast(
-        const std::vector<FeatureInput*> &inputs,
-        size_t id,
-        MultiSparseFeatures *features,
-        Combo &combo) const
+template<typename FeaturesType>
+Features* ComboFeatureFunction::genHashedFeatures(
+        const vector<FeatureInput*> &inputs,
+        size_t docCount,
+        bool isAllSingle,
+        FeatureFunctionContext *context) const
+{
+    FeaturesType *features = createFeatures<FeaturesType>(docCount, context);
+    autil::mem_pool::UnsafePool pool(1024);
+    FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(&pool);
+    if (_needSort) {
+        GEN_COMBO_FEATURES(SortedCombo, buffer)
+    } else {
+        GEN_COMBO_FEATURES(HashedCombo, getPrefixHasher(), inputs.size())
+    }
+#undef GEN_COMBO_FEATURES
+    return features;
+}
+
+template<typename Combo, typename FeaturesType>
+void ComboFeatureFunction::resolveInputs(
+        const vector<FeatureInput*> &inputs,
+        ResolvedInputs<Combo, FeaturesType> &resolved) const
 {
+    resolved.inputs = inputs;
+    resolved.appenders.assign(inputs.size(), nullptr);
+    resolved.collectors.assign(inputs.size(), nullptr);
     for (size_t i = 0; i < inputs.size(); i++) {
         FeatureInput *input = inputs[i];
-#define CASE(vt)                                                        \
-        case vt:                                                        \
+#define RESOLVE_INPUT_TYPED(t)                                          \
+        case t:                                                         \
         {                                                               \
-            typedef InputType2Type<vt>::Type T;                         \
-            typedef FeatureInputTyped<T, DenseStorage<T>> FeatureInputTyped; \
-            FeatureInputTyped *typedInput = static_cast<FeatureInputTyped*>(input); \
-            if (!typedInput) {                                          \
-                return;                                                 \
-            }                                                           \
-            size_t r = typedInput->row() == 1 ? 0 : id;                 \
-            if(!combo.collect(typedInput, r, 0)) {                      \
-                return;                                                 \
+            typedef InputType2Type<t>::Type T;                          \
+            if (input->storageType() == IST_DENSE) {                    \
+                resolved.appenders[i] = &ComboFeatureFunction::appendOneFeature< \
+                    T, DenseStorage<T>, Combo, FeaturesType>;           \
+                resolved.collectors[i] = &ComboFeatureFunction::collectSingleValue< \
+                    T, DenseStorage<T>, Combo>;                         \
+            } else if (input->storageType() == IST_SPARSE_MULTI_VALUE) { \
+                resolved.appenders[i] = &ComboFeatureFunction::appendOneFeature< \
+                    T, MultiValueStorage<T>, Combo, FeaturesType>;      \
+            } else if (input->storageType() == IST_DICTIONARY) {        \
+                resolved.appenders[i] = &ComboFeatureFunction::appendOneFeature< \
+                    T, DictionaryStorage<T>, Combo, FeaturesType>;      \
+                resolved.collectors[i] = &ComboFeatureFunction::collectSingleValue< \
+                    T, DictionaryStorage<T>, Combo>;                    \
+            } else {                                                    \
+                resolved.appenders[i] = &ComboFeatureFunction::appendOneFeature< \
+                    T, ValueOffsetStorage<T>, Combo, FeaturesType>;     \
             }                                                           \
         }                                                               \
         break
 
         switch(input->dataType()) {
-            INPUT_DATA_TYPE_MACRO_HELPER(CASE);
+            INPUT_DATA_TYPE_MACRO_HELPER(RESOLVE_INPUT_TYPED);
         default:
             break;
         }
-#undef CASE
-        if (i == inputs.size() - 1) {
-            auto buffer = combo.getWholeBuf();
-            features->addFeatureKey(buffer.data(), buffer.size());
+#undef RESOLVE_INPUT_TYPED
+    }
+}
+
+template <typename T, typename StorageType, typename Combo>
+bool ComboFeatureFunction::collectSingleValue(FeatureInput *input, size_t docId, Combo &combo) {
+    typedef FeatureInputTyped<T, StorageType> FeatureInputTyped;
+    FeatureInputTyped *typedInput = static_cast<FeatureInputTyped*>(input);
+    size_t r = typedInput->row() == 1 ? 0 : docId;
+    const T &value = typedInput->getRef(r, 0);
+    if (typedInput->isNull(r, 0, value)) {
+        return false;
+    }
+    return combo.collect(value, false);
+}
+
+template<typename Combo, typename FeaturesType>
+void ComboFeatureFunction::genFeatureFast(
+        const ResolvedInputs<Combo, FeaturesType> &inputs,
+        size_t id,
+        FeaturesType *features,
+        Combo &combo) const
+{
+    const size_t inputCount = inputs.inputs.size();
+    for (size_t i = 0; i < inputCount; i++) {
+        auto collector = inputs.collectors[i];
+        if (collector && !collector(inputs.inputs[i], id, combo)) {
+            return;
+        }
+        if (i == inputCount - 1) {
+            combo.addFeature(features);
         } else {
             combo.addSeparator();
         }
     }
 }
 
-template<typename Combo>
+template<typename Combo, typename FeaturesType>
 void ComboFeatureFunction::genFeatureNormal(
-        const std::vector<FeatureInput*> &inputs, size_t docId, size_t featureId,
-        MultiSparseFeatures *features,
+        const ResolvedInputs<Combo, FeaturesType> &inputs, size_t docId, size_t featureId,
+        FeaturesType *features,
         Combo &combo) const
 {
-    if (featureId >= inputs.size()) {
+    if (featureId >= inputs.appenders.size() || !inputs.appenders[featureId]) {
         return;
     }
-    FeatureInput *input = inputs[featureId];
-#define APPEND_ONE_FEATURE_TYPED(t)                                     \
-    case t:                                                             \
-    {                                                                   \
-        typedef InputType2Type<t>::Type T;                              \
-        if (input->storageType() == IST_DENSE) {                        \
-            appendOneFeature<T, DenseStorage<T>, Combo>(                \
-                    inputs, docId, featureId, features, combo);         \
-        } else if (input->storageType() == IST_SPARSE_MULTI_VALUE) {    \
-            appendOneFeature<T, MultiValueStorage<T>, Combo>(           \
-                    inputs, docId, featureId, features, combo);         \
-        } else {                                                        \
-            appendOneFeature<T, ValueOffsetStorage<T>, Combo>(          \
-                    inputs, docId, featureId, features, combo);         \
-        }                                                               \
-    }                                                                   \
-    break
-
-    switch(input->dataType()) {
-        INPUT_DATA_TYPE_MACRO_HELPER(APPEND_ONE_FEATURE_TYPED);
-    default:
-        break;
-    }
-#undef APPEND_ONE_FEATURE_TYPED
+    (this->*inputs.appenders[featureId])(inputs, docId, featureId, features, combo);
 }
 
-template <typename T, typename StorageType, typename Combo>
+template <typename T, typename StorageType, typename Combo, typename FeaturesType>
 void ComboFeatureFunction::appendOneFeature(
-        const vector<FeatureInput*> &inputs,
+        const ResolvedInputs<Combo, FeaturesType> &inputs,
         size_t docId,
         size_t featureId,
-        MultiSparseFeatures *features,
+        FeaturesType *features,
         Combo &combo) const
 {
-    FeatureInput *input = inputs[featureId];
     typedef FeatureInputTyped<T, StorageType> FeatureInputTyped;
-    FeatureInputTyped *typedInput = static_cast<FeatureInputTyped*>(input);
+    const FeatureInputTyped *typedInput =
+        static_cast<const FeatureInputTyped*>(inputs.inputs[featureId]);
     const size_t beginPos = combo.getBufferLength();
     size_t r = typedInput->row() == 1 ? 0 : docId;
+    const typename FeatureInputTyped::RowType values = typedInput->getRowView(r);
+    const size_t col = values.size();
     size_t left, right;
     if (_pruneRight[featureId]) {
         left = 0;
-        right = min(size_t(_pruneLimit[featureId]), typedInput->col(r));
+        right = min(size_t(_pruneLimit[featureId]), col);
     } else {
-        left = typedInput->col(r) - min(_pruneLimit[featureId], int(typedInput->col(r)));
-        right = typedInput->col(r);
+        left = col - min(_pruneLimit[featureId], int(col));
+        right = col;
     }
+    // with a validity the values are not compared to sentinels
+    const bool checkValidity = hasValidity(values);
     for (size_t c = left; c < right; c++) {
-        if (!combo.collect(typedInput, r, c)) {
+        if (checkValidity ? !isValidAt(values, c) || !combo.collect(values[c], false)
+            : !combo.collect(values[c]))
+        {
             continue;
         }
-        if (featureId + 1 == inputs.size()) {
-            auto buffer = combo.getWholeBuf();
-            features->addFeatureKey(buffer.data(), buffer.size()); //
+        if (featureId + 1 == inputs.appenders.size()) {
+            combo.addFeature(features);
         } else {
             combo.addSeparator();
-            genFeatureNormal<Combo>(inputs, docId, featureId+1, features, combo);
+            genFeatureNormal<Combo, FeaturesType>(inputs, docId, featureId+1, features, combo);
         }
         combo.backTrace(beginPos);
     }
@@ -25,16 +25,23 @@ private:
             : _buffer(prefix)
         {
         }
-        template<typename T, typename StorageType>
-        bool collect(FeatureInputTyped<T, StorageType>* typedInput,
-                     const size_t r, const size_t c, bool check = true)
+        template<typename T>
+        bool collect(const T &value, bool check = true)
         {
-            return typedInput->toString(r, c, _buffer, check);
+            if (check && FeatureFormatter::isInvalidValue<T>(value)) {
+                return false;
+            }
+            FeatureFormatter::fillFeatureToBuffer(value, _buffer);
+            return true;
         }
         FeatureFormatter::FeatureBuffer getWholeBuf()
         {
             return _buffer;
         }
+        template<typename FeaturesType>
+        void addFeature(FeaturesType *features) {
+            features->addFeatureKey(_buffer.data(), _buffer.size());
+        }
         void backTrace(const size_t beginPos) {
             _buffer.assign(_buffer.begin(), _buffer.begin() + beginPos);
         }
@@ -57,15 +64,15 @@ private:
             , _prefix(prefix)
         {
         }
-        template<typename T, typename StorageType>
-        bool collect(FeatureInputTyped<T, StorageType>* typedInput,
-                     const size_t r, const size_t c, bool check = true) {
+        template<typename T>
+        bool collect(const T &value, bool check = true) {
+            if (check && FeatureFormatter::isInvalidValue<T>(value)) {
+                return false;
+            }
             std::string tmp = std::string();
             auto tmpBuf = FeatureFormatter::FeatureBuffer(tmp.begin(), tmp.end(),
                     autil::mem_pool::pool_allocator<char>(&_pool));
-            if (!typedInput->toString(r, c, tmpBuf, check)) {
-                return false;
-            }
+            FeatureFormatter::fillFeatureToBuffer(value, tmpBuf);
             _bufferVec.push_back(tmpBuf);
             return true;
         }
@@ -82,6 +89,11 @@ private:
             }
             return _buffer;
         }
+        template<typename FeaturesType>
+        void addFeature(FeaturesType *features) {
+            auto buffer = getWholeBuf();
+            features->addFeatureKey(buffer.data(), buffer.size());
+        }
         void backTrace(const size_t beginPos) {
             _bufferVec.pop_back();
         }
@@ -98,6 +110,41 @@ private:
         std::vector<FeatureFormatter::FeatureBuffer> _bufferVec;
         FeatureFormatter::FeatureBuffer _prefix;
     };
+
+    // hasher state after every collected value, backTrace pops to a depth
+    class HashedCombo {
+    public:
+        HashedCombo(const FeatureHasher &prefix, size_t inputCount)
+        {
+            _states.reserve(inputCount + 1);
+            _states.push_back(prefix);
+        }
+        template<typename T>
+        bool collect(const T &value, bool check = true)
+        {
+            if (check && FeatureFormatter::isInvalidValue<T>(value)) {
+                return false;
+            }
+            _states.push_back(_states.back());
+            _states.back().updateValue(value);
+            return true;
+        }
+        template<typename FeaturesType>
+        void addFeature(FeaturesType *features) {
+            features->addFeatureHash(_states.back().finish());
+        }
+        void backTrace(const size_t beginPos) {
+            _states.resize(beginPos);
+        }
+        void addSeparator() {
+            _states.back().updateValue(MULTI_SEPARATOR);
+        }
+        size_t getBufferLength() const{
+            return _states.size();
+        }
+    private:
+        std::vector<FeatureHasher> _states;
+    };
 #undef MULTI_SEPARATOR
 
 public:
@@ -106,27 +153,61 @@ public:
     size_t getInputCount() const override {
         return _inputCount;
     }
+    bool supportHashOutput() const override {
+        return true;
+    }
+    bool supportDictionaryInput() const override {
+        return true;
+    }
 private:
-    template<typename Combo>
-    void genFeatureFast(
+    template<typename FeaturesType>
+    Features *genHashedFeatures(
             const std::vector<FeatureInput*> &inputs,
+            size_t docCount,
+            bool isAllSingle,
+            FeatureFunctionContext *context) const;
+
+    // typed accessors of the inputs, resolved once per genFeatures instead
+    // of a type switch for every doc and input
+    template<typename Combo, typename FeaturesType>
+    struct ResolvedInputs {
+        typedef void (ComboFeatureFunction::*AppendFunc)(
+                const ResolvedInputs &inputs, size_t docId, size_t featureId,
+                FeaturesType *features, Combo &combo) const;
+        typedef bool (*CollectFunc)(FeatureInput *input, size_t docId, Combo &combo);
+        std::vector<FeatureInput*> inputs;
+        std::vector<AppendFunc> appenders;
+        // only for inputs all single value, dense or dictionary
+        std::vector<CollectFunc> collectors;
+    };
+
+    template<typename Combo, typename FeaturesType>
+    void resolveInputs(const std::vector<FeatureInput*> &inputs,
+                       ResolvedInputs<Combo, FeaturesType> &resolved) const;
+
+    template<typename Combo, typename FeaturesType>
+    void genFeatureFast(
+            const ResolvedInputs<Combo, FeaturesType> &inputs,
             size_t id,
-            MultiSparseFeatures *features,
+            FeaturesType *features,
             Combo &combo) const;
 
-    template<typename Combo>
+    template<typename Combo, typename FeaturesType>
     void genFeatureNormal(
-            const std::vector<FeatureInput*> &inputs, size_t docId, size_t featureId,
-            MultiSparseFeatures *features,
+            const ResolvedInputs<Combo, FeaturesType> &inputs, size_t docId, size_t featureId,
+            FeaturesType *features,
             Combo &combo) const;
 
-    template <typename T, typename StorageType, typename Combo>
+    template <typename T, typename StorageType, typename Combo, typename FeaturesType>
     void appendOneFeature(
-            const std::vector<FeatureInput*> &inputs,
+            const ResolvedInputs<Combo, FeaturesType> &inputs,
             size_t docId,
             size_t featureId,
-            MultiSparseFeatures *features,
+            FeaturesType *features,
             Combo& combo) const;
+
+    template <typename T, typename StorageType, typename Combo>
+    static bool collectSingleValue(FeatureInput *input, size_t docId, Combo &combo);
 private:
     size_t _inputCount;
     std::vector<bool> _pruneRight;
@@ -0,0 +1,102 @@
+#include "fg_lite/feature/DocRangeSharder.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, DocRangeSharder);
+
+bool DocRangeSharder::getShardableDocCount(const vector<FeatureInput*> &inputs,
+                                           size_t &docCount)
+{
+    docCount = 0;
+    for (auto input : inputs) {
+        docCount = max(docCount, input->row());
+    }
+    for (auto input : inputs) {
+        if (input->row() > 1 && input->row() != docCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Features *DocRangeSharder::genFeatures(const FeatureFunction *function,
+                                       const vector<FeatureInput*> &inputs,
+                                       FeatureFunctionContext *context,
+                                       WorkStealingThreadPool *threadPool,
+                                       size_t shardDocCount)
+{
+    size_t docCount = 0;
+    if (shardDocCount == 0
+        || !getShardableDocCount(inputs, docCount)
+        || docCount <= shardDocCount)
+    {
+        return function->genFeatures(inputs, context);
+    }
+    size_t shardCount = (docCount + shardDocCount - 1) / shardDocCount;
+    vector<unique_ptr<FeatureInput>> slices;
+    vector<vector<FeatureInput*>> shardInputs(shardCount);
+    for (size_t i = 0; i < shardCount; i++) {
+        size_t begin = i * shardDocCount;
+        size_t end = min(begin + shardDocCount, docCount);
+        for (auto input : inputs) {
+            if (input->row() == docCount) {
+                slices.emplace_back(input->slice(begin, end));
+                shardInputs[i].push_back(slices.back().get());
+            } else {
+                shardInputs[i].push_back(input);
+            }
+        }
+    }
+    vector<Features*> shards(shardCount, nullptr);
+    {
+        TaskGroup taskGroup(threadPool);
+        for (size_t i = 0; i < shardCount; i++) {
+            taskGroup.run([function, i, &shardInputs, context, &shards]() {
+                        shards[i] = function->genFeatures(shardInputs[i], context);
+                    });
+        }
+        taskGroup.wait();
+    }
+    Features *features = mergeFeatures(shards);
+    if (features == nullptr) {
+        AUTIL_LOG(ERROR, "feature[%s] merge shard features failed",
+                  function->getFeatureName().c_str());
+    }
+    return features;
+}
+
+Features *DocRangeSharder::mergeFeatures(vector<Features*> &shards) {
+    bool valid = !shards.empty();
+    for (auto shard : shards) {
+        if (shard == nullptr
+            || shard->getFeatureValueType() != shards[0]->getFeatureValueType())
+        {
+            valid = false;
+            break;
+        }
+    }
+    if (!valid) {
+        for (auto shard : shards) {
+            delete shard;
+        }
+        shards.clear();
+        return nullptr;
+    }
+    Features *features = shards[0];
+    for (size_t i = 1; i < shards.size(); i++) {
+        if (!features->append(shards[i])) {
+            for (size_t j = i; j < shards.size(); j++) {
+                delete shards[j];
+            }
+            delete features;
+            shards.clear();
+            return nullptr;
+        }
+    }
+    shards.clear();
+    return features;
+}
+
+}
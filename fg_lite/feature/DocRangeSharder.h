@@ -0,0 +1,37 @@
+#ifndef ISEARCH_FG_LITE_DOCRANGESHARDER_H
+#define ISEARCH_FG_LITE_DOCRANGESHARDER_H
+
+#include "autil/Log.h"
+#include "fg_lite/feature/FeatureFunction.h"
+
+namespace fg_lite {
+
+class WorkStealingThreadPool;
+
+/*
+ * split one genFeatures call into doc ranges of shardDocCount, inputs with
+ * one row are broadcast to every shard. shard outputs are appended in doc
+ * order, keys are not copied.
+ */
+class DocRangeSharder
+{
+private:
+    DocRangeSharder();
+    ~DocRangeSharder() = default;
+public:
+    static Features *genFeatures(const FeatureFunction *function,
+                                 const std::vector<FeatureInput*> &inputs,
+                                 FeatureFunctionContext *context,
+                                 WorkStealingThreadPool *threadPool,
+                                 size_t shardDocCount);
+    // take ownership of shards, return nullptr if any shard is nullptr or types differ.
+    static Features *mergeFeatures(std::vector<Features*> &shards);
+    static bool getShardableDocCount(const std::vector<FeatureInput*> &inputs,
+                                     size_t &docCount);
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_DOCRANGESHARDER_H
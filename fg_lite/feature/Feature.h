@@ -1,10 +1,17 @@
 #ifndef ISEARCH_FG_LITE_FEATURE_H
 #define ISEARCH_FG_LITE_FEATURE_H
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
 #include "autil/StringUtil.h"
 #include "autil/ConstString.h"
 #include "autil/mem_pool/Pool.h"
 #include "autil/mem_pool/pool_allocator.h"
+#include "fg_lite/feature/FeatureHasher.h"
 
 namespace fg_lite {
 
@@ -13,6 +20,12 @@ using cp_alloc = autil::mem_pool::pool_allocator<char>;
 template<typename T>
 using pool_vector = std::vector<T, autil::mem_pool::pool_allocator<T>>;
 
+// doc offsets of the compact integer types, which hold at most 4G values
+typedef uint32_t CompactFeatureOffset;
+
+// the compact types hold int32 or int16 values with 32 bit offsets, or float
+// weights, every type has its own class so consumers dispatching on the type
+// read the right layout
 enum FeatureValueType {
     FVT_SINGLE_SPARSE,
     FVT_SINGLE_DENSE,
@@ -21,7 +34,14 @@ enum FeatureValueType {
     FVT_TENSOR_SPARSE,
     FVT_WEIGHTING_SPARSE,
     FVT_SINGLE_SPARSE_INT,
-    FVT_MULTI_SPARSE_INT
+    FVT_MULTI_SPARSE_INT,
+    FVT_MULTI_HASHED_SPARSE,
+    FVT_TENSOR_DENSE,
+    FVT_SINGLE_SPARSE_INT32,
+    FVT_MULTI_SPARSE_INT32,
+    FVT_WEIGHTING_SPARSE_FLOAT,
+    FVT_SINGLE_SPARSE_INT16,
+    FVT_MULTI_SPARSE_INT16
 };
 
 class Features {
@@ -34,6 +54,11 @@ public:
 public:
     FeatureValueType getFeatureValueType() const { return _type; }
     virtual size_t count() const = 0;
+    // keys or values held by all docs
+    virtual size_t valueCount() const { return count(); }
+    // concat other behind this, offsets of other are rebased.
+    // take ownership of other when success.
+    virtual bool append(Features *other) = 0;
 protected:
     void setFeatureValueType(FeatureValueType type)
     { _type = type; }
@@ -41,15 +66,37 @@ private:
     FeatureValueType _type;
 };
 
+/*
+ * pool of the values of one Features: a private one, or the request arena
+ * of the caller shared by all outputs of a request, which must outlive them.
+ */
+class FeaturesPool {
+public:
+    explicit FeaturesPool(autil::mem_pool::Pool *sharedPool)
+        : _ownPool(sharedPool == nullptr ? new autil::mem_pool::UnsafePool(1024) : nullptr)
+        , _pool(sharedPool == nullptr ? _ownPool.get() : sharedPool)
+    {
+    }
+private:
+    FeaturesPool(const FeaturesPool &);
+    FeaturesPool& operator=(const FeaturesPool &);
+public:
+    autil::mem_pool::Pool *get() const { return _pool; }
+    bool isShared() const { return _ownPool == nullptr; }
+private:
+    std::unique_ptr<autil::mem_pool::UnsafePool> _ownPool;
+    autil::mem_pool::Pool *_pool;
+};
+
 /*
  * only vector<HashKey>
  */
 class SingleSparseFeatures : public Features {
 public:
-    SingleSparseFeatures(size_t reserveSize)
+    SingleSparseFeatures(size_t reserveSize, autil::mem_pool::Pool *pool = nullptr)
         : Features(FVT_SINGLE_SPARSE)
-        , _pool(1024)
-        , _featureNames(&_pool)
+        , _pool(pool)
+        , _featureNames(_pool.get())
     {
         _featureNames.reserve(reserveSize);
     }
@@ -58,20 +105,52 @@ public:
     size_t count() const override {
         return _featureNames.size();
     }
+    size_t valueCount() const override {
+        return _featureNames.size();
+    }
     void addFeatureKey(const char *key, size_t len) {
-        _featureNames.push_back(autil::ConstString(key, len, &_pool));
+        _featureNames.push_back(autil::ConstString(key, len, _pool.get()));
+    }
+    // key already lives in getPool(), it is shared instead of copied
+    void addSharedFeatureKey(const autil::ConstString &key) {
+        _featureNames.push_back(key);
+    }
+    // key written in place: reserve room for its longest text in the pool,
+    // write it at the returned address and commit the written length
+    char *reserveFeatureKey(size_t maxLen) {
+        return (char *)_pool.get()->allocate(maxLen);
+    }
+    void commitFeatureKey(const char *key, size_t len) {
+        _featureNames.push_back(autil::ConstString(key, len));
     }
     // convert bufferVec into buffer
 
-    autil::mem_pool::UnsafePool _pool;
+    FeaturesPool _pool;
 public:
     autil::mem_pool::Pool *getPool() {
-        return &_pool;
+        return _pool.get();
     }
     const pool_vector<autil::ConstString> &getFeatures() const {
         return _featureNames;
     }
     pool_vector<autil::ConstString> _featureNames;
+public:
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != getFeatureValueType()) {
+            return false;
+        }
+        appendKeys(static_cast<SingleSparseFeatures*>(other));
+        return true;
+    }
+protected:
+    // keys still live in the pool of other, so other is adopted instead of copied
+    void appendKeys(SingleSparseFeatures *other) {
+        _featureNames.insert(_featureNames.end(), other->_featureNames.begin(),
+                             other->_featureNames.end());
+        _adoptedFeatures.emplace_back(other);
+    }
+private:
+    std::vector<std::unique_ptr<Features>> _adoptedFeatures;
 };
 
 /*
@@ -79,9 +158,9 @@ public:
  */
 class MultiSparseFeatures : public SingleSparseFeatures {
 public:
-    MultiSparseFeatures(size_t reserveSize)
-        : SingleSparseFeatures(reserveSize)
-        , _offsets(&_pool)
+    MultiSparseFeatures(size_t reserveSize, autil::mem_pool::Pool *pool = nullptr)
+        : SingleSparseFeatures(reserveSize, pool)
+        , _offsets(_pool.get())
     {
         setFeatureValueType(FVT_MULTI_SPARSE);
         _offsets.reserve(reserveSize);
@@ -94,42 +173,77 @@ public:
     void beginDocument() {
         _offsets.push_back(_featureNames.size());
     }
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != getFeatureValueType()) {
+            return false;
+        }
+        auto typed = static_cast<MultiSparseFeatures*>(other);
+        size_t base = _featureNames.size();
+        for (auto offset : typed->_offsets) {
+            _offsets.push_back(base + offset);
+        }
+        appendKeys(typed);
+        return true;
+    }
 public:
     pool_vector<size_t> _offsets;
 };
 
 
 /*
- * vector<offset> and vector<value> for both feature_name and feature_value
+ * vector<offset> and vector<value> for both feature_name and feature_value,
+ * values are double, or float for FVT_WEIGHTING_SPARSE_FLOAT which weighted
+ * lookup features write with compact_output
  */
-class MultiSparseWeightingFeatures : public MultiSparseFeatures {
+template <typename W, FeatureValueType TYPE>
+class MultiSparseWeightingFeaturesTyped : public MultiSparseFeatures {
 public:
-    MultiSparseWeightingFeatures(size_t reserveSize)
-        : MultiSparseFeatures(reserveSize)
-        , _featureValues(&_pool)
+    MultiSparseWeightingFeaturesTyped(size_t reserveSize, autil::mem_pool::Pool *pool = nullptr)
+        : MultiSparseFeatures(reserveSize, pool)
+        , _featureValues(_pool.get())
     {
-        setFeatureValueType(FVT_WEIGHTING_SPARSE);
+        setFeatureValueType(TYPE);
         _featureValues.reserve(reserveSize);
     }
-    ~MultiSparseWeightingFeatures()  = default;
+    ~MultiSparseWeightingFeaturesTyped()  = default;
 
 public:
+    // finite values out of the range of W are clamped, so every key added
+    // keeps its weight
     void addFeatureValue(double value) {
-        _featureValues.push_back(value);
+        if (sizeof(W) < sizeof(double) && std::isfinite(value)) {
+            value = std::min(std::max(value, double(std::numeric_limits<W>::lowest())),
+                             double(std::numeric_limits<W>::max()));
+        }
+        _featureValues.push_back(W(value));
+    }
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != getFeatureValueType()) {
+            return false;
+        }
+        auto typed = static_cast<MultiSparseWeightingFeaturesTyped*>(other);
+        _featureValues.insert(_featureValues.end(), typed->_featureValues.begin(),
+                              typed->_featureValues.end());
+        return MultiSparseFeatures::append(other);
     }
 public:
-    pool_vector<double> _featureValues;
+    pool_vector<W> _featureValues;
 };
 
+typedef MultiSparseWeightingFeaturesTyped<double, FVT_WEIGHTING_SPARSE> MultiSparseWeightingFeatures;
+typedef MultiSparseWeightingFeaturesTyped<float, FVT_WEIGHTING_SPARSE_FLOAT>
+    MultiSparseFloatWeightingFeatures;
+
 /*
  * only vector<float>
  */
 class SingleDenseFeatures : public Features {
 public:
-    SingleDenseFeatures(const std::string &featureName, size_t reserveSize)
+    SingleDenseFeatures(const std::string &featureName, size_t reserveSize,
+                        autil::mem_pool::Pool *pool = nullptr)
         : Features(FVT_SINGLE_DENSE)
-        , _pool(1024)
-        , _featureValues(&_pool)
+        , _pool(pool)
+        , _featureValues(_pool.get())
         , _featureName(featureName)
     {
         _featureValues.reserve(reserveSize);
@@ -149,12 +263,28 @@ public:
     size_t count() const override {
         return _featureValues.size();
     }
+    size_t valueCount() const override {
+        return _featureValues.size();
+    }
     void beginDocument() {};
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != getFeatureValueType()) {
+            return false;
+        }
+        appendValues(static_cast<SingleDenseFeatures*>(other));
+        delete other;
+        return true;
+    }
 protected:
-    autil::mem_pool::UnsafePool _pool;
+    void appendValues(const SingleDenseFeatures *other) {
+        _featureValues.insert(_featureValues.end(), other->_featureValues.begin(),
+                              other->_featureValues.end());
+    }
+protected:
+    FeaturesPool _pool;
 public:
     autil::mem_pool::Pool *getPool() {
-        return &_pool;
+        return _pool.get();
     }
     pool_vector<float> _featureValues;
     std::string _featureName;
@@ -165,9 +295,10 @@ public:
  */
 class MultiDenseFeatures : public SingleDenseFeatures {
 public:
-    MultiDenseFeatures(const std::string &featureName, size_t reserveSize)
-        : SingleDenseFeatures(featureName, reserveSize)
-        , _offsets(&_pool)
+    MultiDenseFeatures(const std::string &featureName, size_t reserveSize,
+                       autil::mem_pool::Pool *pool = nullptr)
+        : SingleDenseFeatures(featureName, reserveSize, pool)
+        , _offsets(_pool.get())
     {
         setFeatureValueType(FVT_MULTI_DENSE);
         _offsets.reserve(reserveSize);
@@ -180,6 +311,19 @@ public:
     size_t count() const override {
         return _offsets.size();
     }
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != getFeatureValueType()) {
+            return false;
+        }
+        auto typed = static_cast<MultiDenseFeatures*>(other);
+        size_t base = _featureValues.size();
+        for (auto offset : typed->_offsets) {
+            _offsets.push_back(base + offset);
+        }
+        appendValues(typed);
+        delete other;
+        return true;
+    }
 public:
     pool_vector<size_t> _offsets;
 };
@@ -191,9 +335,9 @@ void forEachSingleFeature(const pool_vector<ValueType> &values, Work &work) {
     }
 }
 
-template <typename ValueType, typename Work>
+template <typename ValueType, typename OffsetType, typename Work>
 void forEachMultiFeature(const pool_vector<ValueType> &values,
-                         const pool_vector<size_t> &offsets,
+                         const pool_vector<OffsetType> &offsets,
                          Work &work)
 {
     for (size_t i = 0; i < values.size(); ++i) {
@@ -205,71 +349,375 @@ void forEachMultiFeature(const pool_vector<ValueType> &values,
     }
 }
 
+// FeatureValueTypes and offset of the integer features of value type T.
+// the compact types take 32 bit offsets, so they hold at most 4G values
+template <typename T>
+struct IntegerFeaturesTraits;
+
+template <>
+struct IntegerFeaturesTraits<int64_t> {
+    typedef size_t OffsetType;
+    static FeatureValueType singleType() { return FVT_SINGLE_SPARSE_INT; }
+    static FeatureValueType multiType() { return FVT_MULTI_SPARSE_INT; }
+};
+
+template <>
+struct IntegerFeaturesTraits<int32_t> {
+    typedef CompactFeatureOffset OffsetType;
+    static FeatureValueType singleType() { return FVT_SINGLE_SPARSE_INT32; }
+    static FeatureValueType multiType() { return FVT_MULTI_SPARSE_INT32; }
+};
+
+template <>
+struct IntegerFeaturesTraits<int16_t> {
+    typedef CompactFeatureOffset OffsetType;
+    static FeatureValueType singleType() { return FVT_SINGLE_SPARSE_INT16; }
+    static FeatureValueType multiType() { return FVT_MULTI_SPARSE_INT16; }
+};
+
 /*
- * only vector<int64>
+ * only vector<T>, int64, or int32 and int16 for the compact types
  */
-class SingleIntegerFeatures : public Features {
+template <typename T>
+class SingleIntegerFeaturesTyped : public Features {
 public:
-    SingleIntegerFeatures(const std::string &featureName, size_t reserveSize)
-        : Features(FVT_SINGLE_SPARSE_INT)
-        , _pool(1024)
-        , _featureValues(&_pool)
+    typedef typename IntegerFeaturesTraits<T>::OffsetType OffsetType;
+public:
+    SingleIntegerFeaturesTyped(const std::string &featureName, size_t reserveSize,
+                               autil::mem_pool::Pool *pool = nullptr)
+        : Features(IntegerFeaturesTraits<T>::singleType())
+        , _pool(pool)
+        , _featureValues(_pool.get())
         , _featureName(featureName)
+        , _overflow(false)
     {
         _featureValues.reserve(reserveSize);
     }
-    ~SingleIntegerFeatures()  = default;
+    ~SingleIntegerFeaturesTyped()  = default;
 public:
     size_t count() const override {
         return _featureValues.size();
     }
-    void addFeatureValue(int64_t featureValue) {
-        _featureValues.push_back(featureValue);
+    size_t valueCount() const override {
+        return _featureValues.size();
+    }
+    // false and nothing added if featureValue does not fit T, or if the
+    // values already reach the limit of OffsetType, which sets overflow()
+    bool addFeatureValue(int64_t featureValue) {
+        T value = T(featureValue);
+        if (int64_t(value) != featureValue) {
+            return false;
+        }
+        if (_featureValues.size() >= maxValueCount()) {
+            _overflow = true;
+            return false;
+        }
+        _featureValues.push_back(value);
+        return true;
+    }
+    // values were dropped at the value limit, the features are incomplete
+    bool overflow() const { return _overflow; }
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != getFeatureValueType()) {
+            return false;
+        }
+        auto typed = static_cast<SingleIntegerFeaturesTyped*>(other);
+        if (typed->_featureValues.size() > maxValueCount() - _featureValues.size()) {
+            return false;
+        }
+        appendValues(typed);
+        delete other;
+        return true;
     }
 protected:
-    autil::mem_pool::UnsafePool _pool;
+    static size_t maxValueCount() {
+        return std::numeric_limits<OffsetType>::max();
+    }
+    void appendValues(const SingleIntegerFeaturesTyped *other) {
+        _featureValues.insert(_featureValues.end(), other->_featureValues.begin(),
+                              other->_featureValues.end());
+        _overflow = _overflow || other->_overflow;
+    }
+protected:
+    FeaturesPool _pool;
 public:
     autil::mem_pool::Pool *getPool() {
-        return &_pool;
+        return _pool.get();
     }
-    const pool_vector<int64_t> &getFeatures() const {
+    const pool_vector<T> &getFeatures() const {
         return _featureValues;
     }
-    pool_vector<int64_t> _featureValues;
+    pool_vector<T> _featureValues;
     std::string _featureName;
+private:
+    bool _overflow;
 };
 
 /*
- * vector<offset> and vector<int64>
+ * vector<offset> and vector<T>, offsets are 32 bits for the compact types
  */
-class MultiIntegerFeatures : public SingleIntegerFeatures {
+template <typename T>
+class MultiIntegerFeaturesTyped : public SingleIntegerFeaturesTyped<T> {
 public:
-    MultiIntegerFeatures(const std::string &featureName, size_t reserveSize)
-        : SingleIntegerFeatures(featureName, reserveSize)
-        , _offsets(&_pool)
+    typedef typename SingleIntegerFeaturesTyped<T>::OffsetType OffsetType;
+public:
+    MultiIntegerFeaturesTyped(const std::string &featureName, size_t reserveSize,
+                              autil::mem_pool::Pool *pool = nullptr)
+        : SingleIntegerFeaturesTyped<T>(featureName, reserveSize, pool)
+        , _offsets(this->_pool.get())
     {
-        setFeatureValueType(FVT_MULTI_SPARSE_INT);
+        this->setFeatureValueType(IntegerFeaturesTraits<T>::multiType());
         _offsets.reserve(reserveSize);
     }
-    ~MultiIntegerFeatures()  = default;
+    ~MultiIntegerFeaturesTyped()  = default;
 public:
     size_t count() const override {
         return _offsets.size();
     }
+    // addFeatureValue keeps the values within OffsetType
     void beginDocument() {
-        _offsets.push_back(_featureValues.size());
+        _offsets.push_back(OffsetType(this->_featureValues.size()));
+    }
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != this->getFeatureValueType()) {
+            return false;
+        }
+        auto typed = static_cast<MultiIntegerFeaturesTyped*>(other);
+        size_t base = this->_featureValues.size();
+        if (typed->_featureValues.size() > this->maxValueCount() - base) {
+            return false;
+        }
+        for (auto offset : typed->_offsets) {
+            _offsets.push_back(OffsetType(base + offset));
+        }
+        this->appendValues(typed);
+        delete other;
+        return true;
+    }
+public:
+    pool_vector<OffsetType> _offsets;
+};
+
+typedef SingleIntegerFeaturesTyped<int64_t> SingleIntegerFeatures;
+typedef MultiIntegerFeaturesTyped<int64_t> MultiIntegerFeatures;
+typedef SingleIntegerFeaturesTyped<int32_t> SingleInt32Features;
+typedef MultiIntegerFeaturesTyped<int32_t> MultiInt32Features;
+typedef SingleIntegerFeaturesTyped<int16_t> SingleInt16Features;
+typedef MultiIntegerFeaturesTyped<int16_t> MultiInt16Features;
+
+/*
+ * vector<offset> and vector<hash of HashKey>, see FeatureHasher
+ */
+class MultiHashedSparseFeatures : public Features {
+public:
+    MultiHashedSparseFeatures(size_t reserveSize, autil::mem_pool::Pool *pool = nullptr)
+        : Features(FVT_MULTI_HASHED_SPARSE)
+        , _pool(pool)
+        , _featureHashes(_pool.get())
+        , _offsets(_pool.get())
+    {
+        _featureHashes.reserve(reserveSize);
+        _offsets.reserve(reserveSize);
     }
+    ~MultiHashedSparseFeatures() = default;
 public:
+    size_t count() const override {
+        return _offsets.size();
+    }
+    size_t valueCount() const override {
+        return _featureHashes.size();
+    }
+    void beginDocument() {
+        _offsets.push_back(_featureHashes.size());
+    }
+    void addFeatureHash(uint64_t hash) {
+        _featureHashes.push_back(hash);
+    }
+    // same id as the key would get from a function formatting it natively
+    void addFeatureKey(const char *key, size_t len) {
+        _featureHashes.push_back(FeatureHasher::hash(key, len));
+    }
+    bool append(Features *other) override {
+        if (other->getFeatureValueType() != getFeatureValueType()) {
+            return false;
+        }
+        auto typed = static_cast<MultiHashedSparseFeatures*>(other);
+        size_t base = _featureHashes.size();
+        for (auto offset : typed->_offsets) {
+            _offsets.push_back(base + offset);
+        }
+        _featureHashes.insert(_featureHashes.end(), typed->_featureHashes.begin(),
+                              typed->_featureHashes.end());
+        delete other;
+        return true;
+    }
+protected:
+    FeaturesPool _pool;
+public:
+    autil::mem_pool::Pool *getPool() {
+        return _pool.get();
+    }
+    const pool_vector<uint64_t> &getFeatures() const {
+        return _featureHashes;
+    }
+    pool_vector<uint64_t> _featureHashes;
     pool_vector<size_t> _offsets;
 };
 
+/*
+ * output buffers owned by the caller, e.g. input tensors of the inference
+ * engine. one feature writes either CSR (rowSplits and ids) or a
+ * [rowCapacity, denseDim] float matrix into them.
+ */
+struct TensorBuffer {
+    TensorBuffer()
+        : rowSplits(nullptr)
+        , rowCapacity(0)
+        , ids(nullptr)
+        , idCapacity(0)
+        , dense(nullptr)
+        , denseDim(0)
+    {}
+    // rowCapacity + 1 entries
+    int64_t *rowSplits;
+    size_t rowCapacity;
+    uint64_t *ids;
+    size_t idCapacity;
+    // called when ids are full, make room for at least minCapacity ids keeping
+    // the written ones, or return false. should grow geometrically.
+    std::function<bool(TensorBuffer *buffer, size_t minCapacity)> growIds;
+    float *dense;
+    size_t denseDim;
+};
+
+/*
+ * CSR of hashed sparse ids written into a TensorBuffer. rows and ids not
+ * fitting are dropped but counted, the caller may size the buffer by
+ * rowCount() and idCount() and run again.
+ */
+class TensorSparseFeatures : public Features {
+public:
+    TensorSparseFeatures(TensorBuffer *buffer)
+        : Features(FVT_TENSOR_SPARSE)
+        , _buffer(buffer)
+        , _rowCount(0)
+        , _idCount(0)
+    {
+        assert(_buffer != nullptr);
+        if (_buffer->rowSplits != nullptr) {
+            _buffer->rowSplits[0] = 0;
+        }
+    }
+    ~TensorSparseFeatures() = default;
+public:
+    size_t count() const override {
+        return _rowCount;
+    }
+    size_t valueCount() const override {
+        return _idCount;
+    }
+    void beginDocument() {
+        _rowCount++;
+        updateRowSplit();
+    }
+    void addFeatureHash(uint64_t hash) {
+        if (_idCount < _buffer->idCapacity || growIds()) {
+            _buffer->ids[_idCount] = hash;
+        }
+        _idCount++;
+        updateRowSplit();
+    }
+    void addFeatureKey(const char *key, size_t len) {
+        addFeatureHash(FeatureHasher::hash(key, len));
+    }
+    // buffers are not owned, shards can not be concatenated
+    bool append(Features * /*other*/) override {
+        return false;
+    }
+    size_t rowCount() const { return _rowCount; }
+    size_t idCount() const { return _idCount; }
+    bool overflow() const {
+        return _rowCount > _buffer->rowCapacity || _idCount > _buffer->idCapacity;
+    }
+    const TensorBuffer *getBuffer() const { return _buffer; }
+private:
+    void updateRowSplit() {
+        if (_buffer->rowSplits != nullptr && _rowCount <= _buffer->rowCapacity) {
+            _buffer->rowSplits[_rowCount] = _idCount;
+        }
+    }
+    bool growIds() {
+        return _buffer->growIds && _buffer->growIds(_buffer, _idCount + 1)
+            && _idCount < _buffer->idCapacity;
+    }
+private:
+    TensorBuffer *_buffer;
+    size_t _rowCount;
+    size_t _idCount;
+};
+
+/*
+ * [rows, denseDim] float matrix written into a TensorBuffer, every row is
+ * zero padded or truncated to denseDim.
+ */
+class TensorDenseFeatures : public Features {
+public:
+    TensorDenseFeatures(TensorBuffer *buffer)
+        : Features(FVT_TENSOR_DENSE)
+        , _buffer(buffer)
+        , _rowCount(0)
+        , _col(0)
+    {
+        assert(_buffer != nullptr);
+    }
+    ~TensorDenseFeatures() = default;
+public:
+    size_t count() const override {
+        return _rowCount;
+    }
+    size_t valueCount() const override {
+        return _rowCount * _buffer->denseDim;
+    }
+    void beginDocument() {
+        _rowCount++;
+        _col = 0;
+        if (_rowCount <= _buffer->rowCapacity) {
+            std::fill_n(currentRow(), _buffer->denseDim, 0.0f);
+        }
+    }
+    void addFeatureValue(float featureValue) {
+        if (_rowCount <= _buffer->rowCapacity && _col < _buffer->denseDim) {
+            currentRow()[_col] = featureValue;
+        }
+        _col++;
+    }
+    // buffers are not owned, shards can not be concatenated
+    bool append(Features * /*other*/) override {
+        return false;
+    }
+    size_t rowCount() const { return _rowCount; }
+    bool overflow() const {
+        return _rowCount > _buffer->rowCapacity;
+    }
+    const TensorBuffer *getBuffer() const { return _buffer; }
+private:
+    float *currentRow() {
+        return _buffer->dense + (_rowCount - 1) * _buffer->denseDim;
+    }
+private:
+    TensorBuffer *_buffer;
+    size_t _rowCount;
+    size_t _col;
+};
+
 struct MultiFeatureType {};
 struct SingleFeatureType {};
 
 template<typename T, bool =
          std::is_same<T, MultiIntegerFeatures>::value ||
          std::is_same<T, MultiSparseFeatures>::value ||
-         std::is_same<T, MultiDenseFeatures>::value>
+         std::is_same<T, MultiDenseFeatures>::value ||
+         std::is_same<T, MultiHashedSparseFeatures>::value>
     struct MultiFeatureTrait {
         typedef SingleFeatureType type;
     };
@@ -44,6 +44,8 @@ SingleFeatureConfig* SingleFeatureConfig::create(
         feature.reset(new LookupFeatureConfigV2());
     } else if (type == "lookup_feature_v3") {
         feature.reset(new LookupFeatureConfigV3());
+    } else if (type == "lookup_feature_btree") {
+        feature.reset(new LookupFeatureConfigBTree());
     } else if (type == "match_feature") {
         feature.reset(new MatchFeatureConfig());
     } else if (type == "gbdt_feature") {
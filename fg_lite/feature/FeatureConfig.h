@@ -18,6 +18,8 @@ public:
         , defaultValue(0.0)
         , needPrefix(true)
         , needDiscrete(true)
+        , hashOutput(false)
+        , compactOutput(false)
     {}
     SingleFeatureConfig(const std::string &t, const std::string &featName)
         : type(t)
@@ -26,6 +28,8 @@ public:
         , featureName(featName)
         , needPrefix(true)
         , needDiscrete(true)
+        , hashOutput(false)
+        , compactOutput(false)
     {}
 public:
     void Jsonize(autil::legacy::Jsonizable::JsonWrapper& json) override {
@@ -35,6 +39,8 @@ public:
         json.Jsonize("sequence_feature_name", sequenceFeatureName, sequenceFeatureName);
         json.Jsonize("need_prefix", needPrefix, needPrefix);
         json.Jsonize("needDiscrete", needDiscrete, needDiscrete);
+        json.Jsonize("hash_output", hashOutput, hashOutput);
+        json.Jsonize("compact_output", compactOutput, compactOutput);
 
         if (FROM_JSON == json.GetMode()) {
             json.Jsonize("bucketize_boundaries", boundariesStr, boundariesStr);
@@ -66,6 +72,11 @@ public:
     std::string featureName;
     bool needPrefix;
     bool needDiscrete;
+    // sparse keys are emitted as uint64 hashes, see MultiHashedSparseFeatures
+    bool hashOutput;
+    // integer values are emitted as int32 by functions supporting it,
+    // see FeatureFunction::supportCompactOutput
+    bool compactOutput;
 private:
     std::string boundariesStr;
     std::string sequenceFeatureName;
@@ -6,6 +6,9 @@
 #include "autil/ConstString.h"
 #include "autil/mem_pool/pool_allocator.h"
 #include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
 
 namespace fg_lite {
 
@@ -52,6 +55,60 @@ public:
     static void FastUInt64ToBufferLeft(uint64_t u64, FeatureBuffer &buffer);
     static void FastInt64ToBufferLeft(int64_t i, FeatureBuffer &buffer);
 
+    // integer types fillFeatureToBuffer writes as decimal text
+    template <typename T>
+    struct IsFormattedInteger : std::integral_constant<bool, std::is_integral<T>::value
+            && !std::is_same<T, bool>::value && !std::is_same<T, char>::value> {};
+    // longest decimal text of a 64 bit integer, sign included
+    static const size_t MAX_INTEGER_LENGTH = 20;
+    // number of decimal digits of u, 1 for 0
+    static uint32_t countDigits(uint64_t u);
+    // digits of u written backwards ending before end, returns the first digit
+    static char *writeDigitsBackward(uint64_t u, char *end);
+    // text of value written at out, which must hold MAX_INTEGER_LENGTH chars,
+    // returns the written length
+    template <typename T>
+    static size_t formatInteger(T value, char *out);
+    // longest %.0f text of a double: the sign, 309 digits of DBL_MAX and
+    // the terminator snprintf writes
+    static const size_t MAX_DOUBLE_LENGTH = 312;
+    // %.0f text of value written at out, which must hold MAX_DOUBLE_LENGTH
+    // chars, returns the written length
+    static size_t formatDouble(double value, char *out);
+    // upper bound of the text fillFeatureToBuffer writes for value
+    template <typename T>
+    static size_t maxFormattedLength(const T &value);
+    // text of value as fillFeatureToBuffer writes it, at out which must hold
+    // maxFormattedLength(value) chars, returns the end of the text
+    template <typename T>
+    static char *formatTo(const T &value, char *out);
+    // values formatted back to back into arena as fillFeatureToBuffer does,
+    // value i is [offsets[i], offsets[i + 1]) of arena, offsets are reset.
+    template <typename T>
+    static void formatColumn(const T *values, size_t count,
+                             FeatureBuffer &arena, std::vector<size_t> &offsets);
+private:
+    // digit count first, the text is written at once after one resize
+    static void appendUInt64(uint64_t u, bool negative, FeatureBuffer &buffer);
+    static size_t formatUInt64(uint64_t u, bool negative, char *out);
+    template <typename T>
+    static size_t formatInteger(T value, char *out, std::true_type);
+    template <typename T>
+    static size_t formatInteger(T value, char *out, std::false_type);
+    template <typename T>
+    static size_t maxFormattedLength(const T &value, std::true_type);
+    template <typename T>
+    static size_t maxFormattedLength(const T &value, std::false_type);
+    template <typename T>
+    static char *formatTo(const T &value, char *out, std::true_type);
+    template <typename T>
+    static char *formatTo(const T &value, char *out, std::false_type);
+    template <typename T>
+    static void formatColumn(const T *values, size_t count, FeatureBuffer &arena,
+                             std::vector<size_t> &offsets, std::true_type);
+    template <typename T>
+    static void formatColumn(const T *values, size_t count, FeatureBuffer &arena,
+                             std::vector<size_t> &offsets, std::false_type);
 public:
     template <typename T>
     static bool isInvalidValue(const T &value);
@@ -197,8 +254,8 @@ template <>
 inline void FeatureFormatter::fillFeatureToBuffer(
         const double &value, FeatureBuffer &buffer)
 {
-    char formatBuffer[1024];
-    size_t ret = snprintf(formatBuffer, 1024, "%.0f", value);
+    char formatBuffer[MAX_DOUBLE_LENGTH];
+    size_t ret = formatDouble(value, formatBuffer);
     buffer.insert(buffer.end(), formatBuffer, formatBuffer+ret);
 }
 
@@ -232,138 +289,259 @@ inline void FeatureFormatter::fillFeatureToBuffer(
     buffer.insert(buffer.end(), value.begin(), value.end());
 }
 
-inline void FeatureFormatter::FastUInt32ToBufferLeft(uint32_t u, FeatureBuffer &buffer) {
-    int digits;
-    const char *ASCII_digits = NULL;
-    // The idea of this implementation is to trim the number of divides to as few
-    // as possible by using multiplication and subtraction rather than mod (%),
-    // and by outputting two digits at a time rather than one.
-    // The huge-number case is first, in the hopes that the compiler will output
-    // that case in one branch-free block of code, and only output conditional
-    // branches into it from below.
-    if (u >= 1000000000) {  // >= 1,000,000,000
-        digits = u / 100000000;  // 100,000,000
-        ASCII_digits = two_ASCII_digits[digits];
-        buffer.push_back(ASCII_digits[0]);
-        buffer.push_back(ASCII_digits[1]);
-    sublt100_000_000:
-        u -= digits * 100000000;  // 100,000,000
-    lt100_000_000:
-        digits = u / 1000000;  // 1,000,000
-        ASCII_digits = two_ASCII_digits[digits];
-        buffer.push_back(ASCII_digits[0]);
-        buffer.push_back(ASCII_digits[1]);
-    sublt1_000_000:
-        u -= digits * 1000000;  // 1,000,000
-    lt1_000_000:
-        digits = u / 10000;  // 10,000
-        ASCII_digits = two_ASCII_digits[digits];
-        buffer.push_back(ASCII_digits[0]);
-        buffer.push_back(ASCII_digits[1]);
-    sublt10_000:
-        u -= digits * 10000;  // 10,000
-    lt10_000:
-        digits = u / 100;
-        ASCII_digits = two_ASCII_digits[digits];
-        buffer.push_back(ASCII_digits[0]);
-        buffer.push_back(ASCII_digits[1]);
-    sublt100:
-        u -= digits * 100;
-    lt100:
-        digits = u;
-        ASCII_digits = two_ASCII_digits[digits];
-        buffer.push_back(ASCII_digits[0]);
-        buffer.push_back(ASCII_digits[1]);
-    done:
-        return;
+inline uint32_t FeatureFormatter::countDigits(uint64_t u) {
+    static const uint64_t powersOf10[20] = {
+        0, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+        100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+        1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+        1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+        1000000000000000000ULL, 10000000000000000000ULL
+    };
+    // floor(log10(u)) from the bit length, off by at most one
+    uint32_t t = ((64 - __builtin_clzll(u | 1)) * 1233) >> 12;
+    return t + (u >= powersOf10[t]);
+}
+
+inline char *FeatureFormatter::writeDigitsBackward(uint64_t u, char *end) {
+    // 8 digits at a time, the rest is done in 32 bits two digits at a time
+    while (u >= 100000000) {
+        uint32_t low = uint32_t(u % 100000000);
+        u /= 100000000;
+        for (int i = 0; i < 4; i++) {
+            end -= 2;
+            memcpy(end, two_ASCII_digits[low % 100], 2);
+            low /= 100;
+        }
     }
-
-    if (u < 100) {
-        digits = u;
-        if (u >= 10) goto lt100;
-        buffer.push_back('0' + digits);
-        goto done;
+    uint32_t v = uint32_t(u);
+    while (v >= 100) {
+        end -= 2;
+        memcpy(end, two_ASCII_digits[v % 100], 2);
+        v /= 100;
     }
-    if (u  <  10000) {   // 10,000
-        if (u >= 1000) goto lt10_000;
-        digits = u / 100;
-        buffer.push_back('0' + digits);
-        goto sublt100;
+    if (v >= 10) {
+        end -= 2;
+        memcpy(end, two_ASCII_digits[v], 2);
+    } else {
+        *--end = char('0' + v);
     }
-    if (u  <  1000000) {   // 1,000,000
-        if (u >= 100000) goto lt1_000_000;
-        digits = u / 10000;  //    10,000
-        buffer.push_back('0' + digits);
-        goto sublt10_000;
+    return end;
+}
+
+inline size_t FeatureFormatter::formatUInt64(uint64_t u, bool negative, char *out) {
+    size_t length = countDigits(u) + negative;
+    char *begin = writeDigitsBackward(u, out + length);
+    if (negative) {
+        begin[-1] = '-';
     }
-    if (u  <  100000000) {   // 100,000,000
-        if (u >= 10000000) goto lt100_000_000;
-        digits = u / 1000000;  //   1,000,000
-        buffer.push_back('0' + digits);
-        goto sublt1_000_000;
+    return length;
+}
+
+template <typename T>
+inline size_t FeatureFormatter::formatInteger(T value, char *out) {
+    static_assert(std::is_integral<T>::value, "integer only");
+    return formatInteger(value, out, std::is_signed<T>());
+}
+
+template <typename T>
+inline size_t FeatureFormatter::formatInteger(T value, char *out, std::true_type) {
+    return value < 0 ? formatUInt64(0 - uint64_t(value), true, out)
+        : formatUInt64(uint64_t(value), false, out);
+}
+
+template <typename T>
+inline size_t FeatureFormatter::formatInteger(T value, char *out, std::false_type) {
+    return formatUInt64(uint64_t(value), false, out);
+}
+
+inline size_t FeatureFormatter::formatDouble(double value, char *out) {
+    // %.0f rounds half to even as nearbyint does and keeps the sign of -0,
+    // below 1e19 the rounded value fits the integer path with its sign
+    double magnitude = std::fabs(std::nearbyint(value));
+    if (magnitude < 1e19) {
+        return formatUInt64(uint64_t(magnitude), std::signbit(value), out);
+    }
+    // huge, inf and nan
+    return snprintf(out, MAX_DOUBLE_LENGTH, "%.0f", value);
+}
+
+inline void FeatureFormatter::appendUInt64(uint64_t u, bool negative, FeatureBuffer &buffer) {
+    size_t size = buffer.size();
+    size_t length = countDigits(u) + negative;
+    buffer.resize(size + length);
+    char *begin = writeDigitsBackward(u, buffer.data() + size + length);
+    if (negative) {
+        begin[-1] = '-';
     }
-    // we already know that u < 1,000,000,000
-    digits = u / 100000000;   // 100,000,000
-    buffer.push_back('0' + digits);
-    goto sublt100_000_000;
+}
+
+inline void FeatureFormatter::FastUInt32ToBufferLeft(uint32_t u, FeatureBuffer &buffer) {
+    appendUInt64(u, false, buffer);
 }
 
 inline void FeatureFormatter::FastInt32ToBufferLeft(int32_t i, FeatureBuffer &buffer) {
-    uint32_t u;
-    if (i >= 0) {
-        u = i;
+    if (i < 0) {
+        appendUInt64(0 - uint32_t(i), true, buffer);
     } else {
-        buffer.push_back('-');
-        u = -i;
+        appendUInt64(uint32_t(i), false, buffer);
     }
-    FastUInt32ToBufferLeft(u, buffer);
 }
 
 inline void FeatureFormatter::FastUInt64ToBufferLeft(uint64_t u64, FeatureBuffer &buffer) {
-    int digits;
-    const char *ASCII_digits = NULL;
-
-    uint32_t u = static_cast<uint32_t>(u64);
-    if (u == u64) return FastUInt32ToBufferLeft(u, buffer);
-
-    uint64_t top_11_digits = u64 / 1000000000;
-    FastUInt64ToBufferLeft(top_11_digits, buffer);
-    u = u64 - (top_11_digits * 1000000000);
-
-    digits = u / 10000000;  // 10,000,000
-    // GOOGLE_DCHECK_LT(digits, 100);
-    ASCII_digits = two_ASCII_digits[digits];
-    buffer.push_back(ASCII_digits[0]);
-    buffer.push_back(ASCII_digits[1]);
-    u -= digits * 10000000;  // 10,000,000
-    digits = u / 100000;  // 100,000
-    ASCII_digits = two_ASCII_digits[digits];
-    buffer.push_back(ASCII_digits[0]);
-    buffer.push_back(ASCII_digits[1]);
-    u -= digits * 100000;  // 100,000
-    digits = u / 1000;  // 1,000
-    ASCII_digits = two_ASCII_digits[digits];
-    buffer.push_back(ASCII_digits[0]);
-    buffer.push_back(ASCII_digits[1]);
-    u -= digits * 1000;  // 1,000
-    digits = u / 10;
-    ASCII_digits = two_ASCII_digits[digits];
-    buffer.push_back(ASCII_digits[0]);
-    buffer.push_back(ASCII_digits[1]);
-    u -= digits * 10;
-    digits = u;
-    buffer.push_back('0' + digits);
+    appendUInt64(u64, false, buffer);
 }
 
 inline void FeatureFormatter::FastInt64ToBufferLeft(int64_t i, FeatureBuffer &buffer) {
-    uint64_t u;
-    if (i >= 0) {
-        u = i;
+    if (i < 0) {
+        appendUInt64(0 - uint64_t(i), true, buffer);
     } else {
-        buffer.push_back('-');
-        u = -i;
+        appendUInt64(uint64_t(i), false, buffer);
+    }
+}
+
+template <typename T>
+inline size_t FeatureFormatter::maxFormattedLength(const T &value) {
+    return maxFormattedLength(value, IsFormattedInteger<T>());
+}
+
+template <typename T>
+inline size_t FeatureFormatter::maxFormattedLength(const T & /*value*/, std::true_type) {
+    return MAX_INTEGER_LENGTH;
+}
+
+template <typename T>
+inline size_t FeatureFormatter::maxFormattedLength(const T &value, std::false_type) {
+    AUTIL_LOG(ERROR, "unsupported type [%s]", typeid(T).name());
+    assert(false); // do not support
+    return 0;
+}
+
+template <>
+inline size_t FeatureFormatter::maxFormattedLength(const bool & /*value*/) {
+    return 1;
+}
+
+template <>
+inline size_t FeatureFormatter::maxFormattedLength(const char & /*value*/) {
+    return 1;
+}
+
+template <>
+inline size_t FeatureFormatter::maxFormattedLength(const double &value) {
+    // below 1e18 the rounded value always takes the integer path of formatDouble
+    return std::fabs(value) < 1e18 ? MAX_INTEGER_LENGTH : MAX_DOUBLE_LENGTH;
+}
+
+template <>
+inline size_t FeatureFormatter::maxFormattedLength(const float &value) {
+    return maxFormattedLength(double(value));
+}
+
+template <>
+inline size_t FeatureFormatter::maxFormattedLength(const autil::MultiChar &value) {
+    return value.size();
+}
+
+template <>
+inline size_t FeatureFormatter::maxFormattedLength(const std::string &value) {
+    return value.size();
+}
+
+template <>
+inline size_t FeatureFormatter::maxFormattedLength(const autil::ConstString &value) {
+    return value.size();
+}
+
+template <typename T>
+inline char *FeatureFormatter::formatTo(const T &value, char *out) {
+    return formatTo(value, out, IsFormattedInteger<T>());
+}
+
+template <typename T>
+inline char *FeatureFormatter::formatTo(const T &value, char *out, std::true_type) {
+    return out + formatInteger(value, out);
+}
+
+template <typename T>
+inline char *FeatureFormatter::formatTo(const T &value, char *out, std::false_type) {
+    AUTIL_LOG(ERROR, "unsupported type [%s]", typeid(T).name());
+    assert(false); // do not support
+    return out;
+}
+
+template <>
+inline char *FeatureFormatter::formatTo(const bool &value, char *out) {
+    *out = value ? '1' : '0';
+    return out + 1;
+}
+
+template <>
+inline char *FeatureFormatter::formatTo(const char &value, char *out) {
+    *out = value;
+    return out + 1;
+}
+
+template <>
+inline char *FeatureFormatter::formatTo(const double &value, char *out) {
+    return out + formatDouble(value, out);
+}
+
+template <>
+inline char *FeatureFormatter::formatTo(const float &value, char *out) {
+    return out + formatDouble(value, out);
+}
+
+template <>
+inline char *FeatureFormatter::formatTo(const autil::MultiChar &value, char *out) {
+    memcpy(out, value.data(), value.size());
+    return out + value.size();
+}
+
+template <>
+inline char *FeatureFormatter::formatTo(const std::string &value, char *out) {
+    memcpy(out, value.data(), value.size());
+    return out + value.size();
+}
+
+template <>
+inline char *FeatureFormatter::formatTo(const autil::ConstString &value, char *out) {
+    memcpy(out, value.data(), value.size());
+    return out + value.size();
+}
+
+template <typename T>
+inline void FeatureFormatter::formatColumn(const T *values, size_t count,
+        FeatureBuffer &arena, std::vector<size_t> &offsets)
+{
+    offsets.clear();
+    offsets.reserve(count + 1);
+    offsets.push_back(arena.size());
+    formatColumn(values, count, arena, offsets, IsFormattedInteger<T>());
+}
+
+template <typename T>
+inline void FeatureFormatter::formatColumn(const T *values, size_t count,
+        FeatureBuffer &arena, std::vector<size_t> &offsets, std::true_type)
+{
+    // room for the longest values, shrunk to the written text at the end
+    size_t size = arena.size();
+    arena.resize(size + count * MAX_INTEGER_LENGTH);
+    char *data = arena.data();
+    for (size_t i = 0; i < count; i++) {
+        size += formatInteger(values[i], data + size);
+        offsets.push_back(size);
+    }
+    arena.resize(size);
+}
+
+template <typename T>
+inline void FeatureFormatter::formatColumn(const T *values, size_t count,
+        FeatureBuffer &arena, std::vector<size_t> &offsets, std::false_type)
+{
+    for (size_t i = 0; i < count; i++) {
+        fillFeatureToBuffer(values[i], arena);
+        offsets.push_back(arena.size());
     }
-    return FastUInt64ToBufferLeft(u, buffer);
 }
 
 template <typename T>
@@ -11,7 +11,10 @@ FeatureFunction::FeatureFunction(const string &featureName,
                                  const string &featurePrefix)
     : _featureName(featureName)
     , _featurePrefix(featurePrefix)
+    , _hashOutput(false)
+    , _compactOutput(false)
 {
+    _prefixHasher.update(_featurePrefix.data(), _featurePrefix.size());
 }
 
 bool FeatureFunction::checkAndGetDocCount(
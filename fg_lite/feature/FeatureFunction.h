@@ -8,11 +8,63 @@
 
 namespace fg_lite {
 
+class BroadcastFeatureCache;
+class FeatureMetrics;
+class ItemFeatureCache;
+class RequestCaptureWriter;
+class RequestTracer;
+
 #define FEATURE_SEPARATOR '_'
 
 struct FeatureFunctionContext {
 public:
-    // index partition reader.
+    FeatureFunctionContext(autil::mem_pool::Pool *pool_ = nullptr)
+        : pool(pool_)
+        , featurePool(nullptr)
+        , workerFeaturePools(nullptr)
+        , tensor(nullptr)
+        , broadcastCache(nullptr)
+        , itemCache(nullptr)
+        , itemIds(nullptr)
+        , metrics(nullptr)
+        , tracer(nullptr)
+        , capture(nullptr)
+    {}
+public:
+    // request arena owned by caller, per call scratch of all features is
+    // allocated here and freed by one pool->reset() after the request, reset
+    // keeps the chunks for the next request. features of a plan may run in
+    // parallel on one context, so it must not be an UnsafePool then.
+    autil::mem_pool::Pool *pool;
+    // request arena the output features are allocated in, owned by caller
+    // and reset only after the outputs are deleted. null gives every output
+    // its own pool. as pool, it must not be an UnsafePool when features of a
+    // plan run in parallel.
+    autil::mem_pool::Pool *featurePool;
+    // optional output arenas of the features a plan runs on a thread pool,
+    // getThreadNum() + 1 of them indexed by WorkStealingThreadPool::
+    // getWorkerIndex(). every feature task takes the arena of its thread as
+    // featurePool, so the workers do not all contend on the lock of one
+    // featurePool. owned and reset by caller like featurePool, doc range
+    // shards of a feature share its arena, so they must not be UnsafePool.
+    const std::vector<autil::mem_pool::Pool*> *workerFeaturePools;
+    // caller buffers the output of one feature is written into, set per
+    // feature. used by hash output and raw features, ignored by others.
+    TensorBuffer *tensor;
+    // results of user side inputs shared across the calls of one user,
+    // owned by caller and may be shared by concurrent requests.
+    BroadcastFeatureCache *broadcastCache;
+    // rows of item only features shared across requests and the item id of
+    // every doc, used by FeaturePlan when both are set. owned by caller.
+    ItemFeatureCache *itemCache;
+    const std::vector<uint64_t> *itemIds;
+    // per feature metrics recorded by FeaturePlan if set, owned by caller.
+    FeatureMetrics *metrics;
+    // spans of plan stages and features recorded by FeaturePlan if set,
+    // owned by caller and used by one request at a time.
+    RequestTracer *tracer;
+    // sampled requests are written here by FeaturePlan if set, owned by caller.
+    RequestCaptureWriter *capture;
 };
 
 class FeatureFunction
@@ -36,22 +88,97 @@ public:
     virtual size_t getInputCount() const = 0;
 public:
     const std::string &getFeatureName() const { return _featureName; }
+    // emit MultiHashedSparseFeatures instead of string keys
+    virtual bool supportHashOutput() const { return false; }
+    // IST_DICTIONARY inputs are read as is, otherwise FeaturePlan decodes them to dense
+    virtual bool supportDictionaryInput() const { return false; }
+    void setHashOutput(bool hashOutput) { _hashOutput = hashOutput; }
+    bool isHashOutput() const { return _hashOutput; }
+    // emit the int32 variant of integer features, only if every value fits
+    virtual bool supportCompactOutput() const { return false; }
+    void setCompactOutput(bool compactOutput) { _compactOutput = compactOutput; }
+    bool isCompactOutput() const { return _compactOutput; }
     static Features *maybeDefaultBucketize(const std::string &name, const std::vector<float> &boundaries, int count);
 protected:
     FeatureFormatter::FeatureBuffer getFeaturePrefix(autil::mem_pool::PoolBase *pool) const {
         return FeatureFormatter::FeatureBuffer(_featurePrefix.begin(), _featurePrefix.end(),
                 autil::mem_pool::pool_allocator<char>(pool));
     }
+    // request arena if the caller has one, otherwise localPool of the call.
+    // never the pool of the output features, which may be the shared
+    // featurePool and would keep the scratch as long as the outputs.
+    static autil::mem_pool::Pool *getScratchPool(FeatureFunctionContext *context,
+            autil::mem_pool::Pool *localPool)
+    {
+        if (context != nullptr && context->pool != nullptr) {
+            return context->pool;
+        }
+        return localPool;
+    }
+    // key is prefix followed by values, formatted as fillFeatureToBuffer does,
+    // written in place into the pool of features without being committed
+    template <typename... Values>
+    autil::ConstString writeFeatureKey(MultiSparseFeatures *features,
+            const Values&... values) const
+    {
+        size_t maxLength = _featurePrefix.size();
+        int lengths[] = {0, (maxLength += FeatureFormatter::maxFormattedLength(values), 0)...};
+        (void)lengths;
+        char *key = features->reserveFeatureKey(maxLength);
+        memcpy(key, _featurePrefix.data(), _featurePrefix.size());
+        char *end = key + _featurePrefix.size();
+        int unused[] = {0, (end = FeatureFormatter::formatTo(values, end), 0)...};
+        (void)unused;
+        return autil::ConstString(key, end - key);
+    }
+    template <typename... Values>
+    void addFeatureKey(MultiSparseFeatures *features, const Values&... values) const {
+        autil::ConstString key = writeFeatureKey(features, values...);
+        features->commitFeatureKey(key.data(), key.size());
+    }
+    // hashed outputs
+    template <typename FeaturesType, typename... Values>
+    void addFeatureKey(FeaturesType *features, const Values&... values) const {
+        FeatureHasher hasher(_prefixHasher);
+        int unused[] = {0, (hasher.updateValue(values), 0)...};
+        (void)unused;
+        features->addFeatureHash(hasher.finish());
+    }
+    // hasher state after the feature prefix
+    const FeatureHasher &getPrefixHasher() const { return _prefixHasher; }
+    static TensorBuffer *getTensorBuffer(FeatureFunctionContext *context) {
+        return context != nullptr ? context->tensor : nullptr;
+    }
+    static BroadcastFeatureCache *getBroadcastCache(FeatureFunctionContext *context) {
+        return context != nullptr ? context->broadcastCache : nullptr;
+    }
+    static autil::mem_pool::Pool *getFeaturePool(FeatureFunctionContext *context) {
+        return context != nullptr ? context->featurePool : nullptr;
+    }
+    template <typename FeaturesType>
+    static FeaturesType *createFeatures(size_t reserveSize, FeatureFunctionContext *context) {
+        return new FeaturesType(reserveSize, getFeaturePool(context));
+    }
     bool checkAndGetDocCount(const std::vector<FeatureInput*> &inputs,
                              size_t &docCount) const;
     bool checkInput(const std::vector<FeatureInput*> &inputs) const;
 private:
     std::string _featureName;
     std::string _featurePrefix;
+    FeatureHasher _prefixHasher;
+    bool _hashOutput;
+    bool _compactOutput;
 private:
     AUTIL_LOG_DECLARE();
 };
 
+template <>
+inline TensorSparseFeatures *FeatureFunction::createFeatures<TensorSparseFeatures>(
+        size_t /*reserveSize*/, FeatureFunctionContext *context)
+{
+    return new TensorSparseFeatures(getTensorBuffer(context));
+}
+
 }
 
 #endif //ISEARCH_FG_LITE_FEATUREFUNCTION_H
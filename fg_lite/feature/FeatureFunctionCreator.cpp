@@ -8,12 +8,14 @@
 #include "fg_lite/feature/LookupFeatureFunctionV2.h"
 #include "fg_lite/feature/LookupFeatureFunctionV3.h"
 #include "fg_lite/feature/LookupFeatureFunctionArray.h"
+#include "fg_lite/feature/LookupFeatureFunctionBTree.h"
 #include "fg_lite/feature/MatchFeatureFunction.h"
 #include "fg_lite/feature/MatchFunction.h"
 #include "fg_lite/feature/GBDTFeatureFunction.h"
 #include "fg_lite/feature/OverLapFeatureFunction.h"
 #include "fg_lite/feature/KgbMatchSemanticFeatureFunction.h"
 #include "fg_lite/feature/PreclickUrbWordFeatureFunction.h"
+#include "fg_lite/feature/HashedFeatureFunction.h"
 
 using namespace std;
 using namespace autil;
@@ -127,6 +129,13 @@ FeatureFunction *createLookupFeatureFunction(
                 lookupFeatureConfigV2.useSparse,
                 lookupFeatureConfigV2.keyType,
                 lookupFeatureConfigV2.valueType);
+    } else if (LookupFeatureFunctionVersion::BTree == version) {
+        return new LookupFeatureFunctionBTree(
+                featureConfig.getFeatureName(),
+                normalizer,
+                featureConfig.combiner,
+                featureConfig.valueDimension,
+                featureConfig.getBoundaries());
     } else { // LookupFeatureFunctionVersion::V3 == version
         return new LookupFeatureFunctionV3(
                 featureConfig.getFeatureName(),
@@ -139,6 +148,23 @@ FeatureFunction *createLookupFeatureFunction(
 
 FeatureFunction *FeatureFunctionCreator::createFeatureFunction(
         const SingleFeatureConfig *singleConfig)
+{
+    FeatureFunction *function = doCreateFeatureFunction(singleConfig);
+    if (function != nullptr && singleConfig->compactOutput && function->supportCompactOutput()) {
+        function->setCompactOutput(true);
+    }
+    if (function == nullptr || !singleConfig->hashOutput) {
+        return function;
+    }
+    if (function->supportHashOutput()) {
+        function->setHashOutput(true);
+        return function;
+    }
+    return new HashedFeatureFunction(function);
+}
+
+FeatureFunction *FeatureFunctionCreator::doCreateFeatureFunction(
+        const SingleFeatureConfig *singleConfig)
 {
     const string &type = singleConfig->type;
     if (type == "id_feature") {
@@ -14,6 +14,9 @@ private:
 public:
     static FeatureFunction *createFeatureFunction(
             const SingleFeatureConfig *featureConfig);
+private:
+    static FeatureFunction *doCreateFeatureFunction(
+            const SingleFeatureConfig *featureConfig);
 };
 }
 
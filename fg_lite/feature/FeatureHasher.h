@@ -0,0 +1,195 @@
+#ifndef ISEARCH_FG_LITE_FEATUREHASHER_H
+#define ISEARCH_FG_LITE_FEATUREHASHER_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "autil/ConstString.h"
+#include "autil/MultiValueType.h"
+#include "fg_lite/feature/FeatureFormatter.h"
+
+namespace fg_lite {
+
+/*
+ * streaming MurmurHash64A, the total length is mixed in at finish() instead of
+ * into the seed, so the state after the feature prefix can be computed once and
+ * copied for every key. updateValue() hashes the same text as
+ * FeatureFormatter::fillFeatureToBuffer writes, so the hash of a key never
+ * depends on whether it was formatted into a buffer first.
+ */
+class FeatureHasher
+{
+public:
+    static const uint64_t DEFAULT_SEED = 0x9747b28cULL;
+public:
+    explicit FeatureHasher(uint64_t seed = DEFAULT_SEED)
+        : _h(seed)
+        , _len(0)
+        , _tailLen(0)
+    {
+    }
+public:
+    void update(const char *data, size_t len) {
+        _len += len;
+        if (_tailLen > 0) {
+            size_t fill = std::min(len, 8 - _tailLen);
+            memcpy(_tail + _tailLen, data, fill);
+            _tailLen += fill;
+            data += fill;
+            len -= fill;
+            if (_tailLen < 8) {
+                return;
+            }
+            mix(load(_tail));
+            _tailLen = 0;
+        }
+        for (; len >= 8; data += 8, len -= 8) {
+            mix(load(data));
+        }
+        memcpy(_tail, data, len);
+        _tailLen = len;
+    }
+    template <typename T>
+    void updateValue(const T &value);
+    // exact bytes of the value instead of its text, for cache keys where
+    // the lossy %.0f of floats would collide
+    template <typename T>
+    void updateBinary(const T &value);
+
+    uint64_t finish() const {
+        uint64_t h = _h ^ (_len * M);
+        if (_tailLen > 0) {
+            uint64_t k = 0;
+            for (size_t i = 0; i < _tailLen; i++) {
+                k ^= uint64_t((unsigned char)_tail[i]) << (8 * i);
+            }
+            h ^= k;
+            h *= M;
+        }
+        h ^= h >> R;
+        h *= M;
+        h ^= h >> R;
+        return h;
+    }
+    static uint64_t hash(const char *data, size_t len, uint64_t seed = DEFAULT_SEED) {
+        FeatureHasher hasher(seed);
+        hasher.update(data, len);
+        return hasher.finish();
+    }
+private:
+    static uint64_t load(const char *data) {
+        uint64_t k;
+        memcpy(&k, data, sizeof(k));
+        return k;
+    }
+    void mix(uint64_t k) {
+        k *= M;
+        k ^= k >> R;
+        k *= M;
+        _h ^= k;
+        _h *= M;
+    }
+    void updateUInt64(uint64_t u, bool negative) {
+        char buffer[24];
+        char *end = buffer + sizeof(buffer);
+        char *begin = FeatureFormatter::writeDigitsBackward(u, end);
+        if (negative) {
+            *--begin = '-';
+        }
+        update(begin, end - begin);
+    }
+    template <typename T>
+    void updateInteger(T value, std::true_type) {
+        if (value < 0) {
+            updateUInt64(0 - uint64_t(value), true);
+        } else {
+            updateUInt64(uint64_t(value), false);
+        }
+    }
+    template <typename T>
+    void updateInteger(T value, std::false_type) {
+        updateUInt64(uint64_t(value), false);
+    }
+private:
+    static const uint64_t M = 0xc6a4a7935bd1e995ULL;
+    static const int R = 47;
+    uint64_t _h;
+    uint64_t _len;
+    size_t _tailLen;
+    char _tail[8];
+};
+
+template <typename T>
+inline void FeatureHasher::updateValue(const T &value) {
+    static_assert(std::is_integral<T>::value, "unsupported feature value type");
+    updateInteger(value, std::is_signed<T>());
+}
+
+template <>
+inline void FeatureHasher::updateValue(const bool &value) {
+    update(value ? "1" : "0", 1);
+}
+
+template <>
+inline void FeatureHasher::updateValue(const char &value) {
+    update(&value, 1);
+}
+
+template <>
+inline void FeatureHasher::updateValue(const double &value) {
+    char formatBuffer[FeatureFormatter::MAX_DOUBLE_LENGTH];
+    update(formatBuffer, FeatureFormatter::formatDouble(value, formatBuffer));
+}
+
+template <>
+inline void FeatureHasher::updateValue(const float &value) {
+    updateValue(double(value));
+}
+
+template <>
+inline void FeatureHasher::updateValue(const autil::MultiChar &value) {
+    update(value.data(), value.size());
+}
+
+template <>
+inline void FeatureHasher::updateValue(const std::string &value) {
+    update(value.data(), value.size());
+}
+
+template <>
+inline void FeatureHasher::updateValue(const autil::ConstString &value) {
+    update(value.data(), value.size());
+}
+
+template <typename T>
+inline void FeatureHasher::updateBinary(const T &value) {
+    static_assert(std::is_arithmetic<T>::value, "unsupported feature value type");
+    update((const char *)&value, sizeof(value));
+}
+
+template <>
+inline void FeatureHasher::updateBinary(const autil::MultiChar &value) {
+    uint64_t size = value.size();
+    update((const char *)&size, sizeof(size));
+    update(value.data(), value.size());
+}
+
+template <>
+inline void FeatureHasher::updateBinary(const std::string &value) {
+    uint64_t size = value.size();
+    update((const char *)&size, sizeof(size));
+    update(value.data(), value.size());
+}
+
+template <>
+inline void FeatureHasher::updateBinary(const autil::ConstString &value) {
+    uint64_t size = value.size();
+    update((const char *)&size, sizeof(size));
+    update(value.data(), value.size());
+}
+
+}
+
+#endif //ISEARCH_FG_LITE_FEATUREHASHER_H
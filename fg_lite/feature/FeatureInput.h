@@ -1,8 +1,13 @@
 #ifndef ISEARCH_FG_LITE_FEATUREINPUT_H
 #define ISEARCH_FG_LITE_FEATUREINPUT_H
 
+#include <algorithm>
 #include <memory>
+#include <utility>
+#include <vector>
 #include "fg_lite/feature/FeatureFormatter.h"
+#include "fg_lite/feature/FeatureHasher.h"
+#include "autil/ConstString.h"
 #include "autil/MultiValueType.h"
 
 namespace fg_lite {
@@ -111,7 +116,83 @@ TYPE_TRAITS_HELPER(IT_CSTRING, std::string);
 enum InputStorageType {
     IST_DENSE,
     IST_SPARSE_MULTI_VALUE,
-    IST_SPARSE_VALUE_OFFSET
+    IST_SPARSE_VALUE_OFFSET,
+    IST_DICTIONARY
+};
+
+// optional arrow style validity of values: bit i is set if value i is
+// valid, lsb first in 64 bit words. without bits every value is valid.
+class ValidityBitmap {
+public:
+    ValidityBitmap()
+        : _bits(nullptr)
+        , _begin(0)
+    {}
+    explicit ValidityBitmap(const uint64_t *bits, size_t begin = 0)
+        : _bits(bits)
+        , _begin(begin)
+    {}
+public:
+    bool empty() const {
+        return _bits == nullptr;
+    }
+    bool isValid(size_t id) const {
+        if (!_bits) {
+            return true;
+        }
+        size_t pos = _begin + id;
+        return (_bits[pos >> 6] >> (pos & 63)) & 1;
+    }
+    // bitmap of the values starting at id
+    ValidityBitmap offset(size_t id) const {
+        return _bits ? ValidityBitmap(_bits, _begin + id) : ValidityBitmap();
+    }
+    // fn(id) for every valid id in [0, count), null runs are skipped a word at a time
+    template <typename Fn>
+    void forEachValid(size_t count, Fn &&fn) const {
+        if (!_bits) {
+            for (size_t id = 0; id < count; id++) {
+                fn(id);
+            }
+            return;
+        }
+        forEachWord(count, [&fn](uint64_t word, size_t firstId) {
+                    while (word) {
+                        fn(firstId + __builtin_ctzll(word));
+                        word &= word - 1;
+                    }
+                });
+    }
+    size_t countValid(size_t count) const {
+        if (!_bits) {
+            return count;
+        }
+        size_t validCount = 0;
+        forEachWord(count, [&validCount](uint64_t word, size_t) {
+                    validCount += __builtin_popcountll(word);
+                });
+        return validCount;
+    }
+private:
+    // fn(word, firstId), bit i of word is the validity of firstId + i
+    template <typename Fn>
+    void forEachWord(size_t count, Fn &&fn) const {
+        size_t pos = _begin;
+        const size_t end = _begin + count;
+        while (pos < end) {
+            size_t wordEnd = std::min((pos | 63) + 1, end);
+            uint64_t word = _bits[pos >> 6] >> (pos & 63);
+            size_t width = wordEnd - pos;
+            if (width < 64) {
+                word &= (uint64_t(1) << width) - 1;
+            }
+            fn(word, pos - _begin);
+            pos = wordEnd;
+        }
+    }
+private:
+    const uint64_t *_bits;
+    size_t _begin;
 };
 
 template <typename T>
@@ -121,9 +202,10 @@ public:
         : _values(nullptr)
         , _count(0)
     {}
-    Row(const T *values, size_t count)
+    Row(const T *values, size_t count, ValidityBitmap validity = ValidityBitmap())
         : _values(values)
         , _count(count)
+        , _validity(validity)
     {}
 public:
     const T *begin() const { return _values; }
@@ -131,10 +213,13 @@ public:
     size_t size() const {
         return _count;
     }
-    T operator[](size_t id) const {
+    const T &operator[](size_t id) const {
         assert(id < _count);
         return _values[id];
     }
+    const ValidityBitmap &validity() const {
+        return _validity;
+    }
     bool operator==(const Row<T> &other) const {
         if (this == &other) {
             return true;
@@ -152,22 +237,135 @@ public:
 private:
     const T *_values;
     size_t _count;
+    ValidityBitmap _validity;
+};
+
+// validity of the values of any row type, rows without validity are all valid
+template <typename RowType>
+inline bool hasValidity(const RowType &) {
+    return false;
+}
+
+template <typename T>
+inline bool hasValidity(const Row<T> &row) {
+    return !row.validity().empty();
+}
+
+template <typename RowType>
+inline bool isValidAt(const RowType &, size_t) {
+    return true;
+}
+
+template <typename T>
+inline bool isValidAt(const Row<T> &row, size_t id) {
+    return row.validity().isValid(id);
+}
+
+// fn(id) for every valid id in [0, end) of row
+template <typename RowType, typename Fn>
+inline void forEachValid(const RowType &, size_t end, Fn &&fn) {
+    for (size_t id = 0; id < end; id++) {
+        fn(id);
+    }
+}
+
+template <typename T, typename Fn>
+inline void forEachValid(const Row<T> &row, size_t end, Fn &&fn) {
+    assert(end <= row.size());
+    row.validity().forEachValid(end, std::forward<Fn>(fn));
+}
+
+inline autil::ConstString toStringView(const autil::ConstString &value) {
+    return value;
+}
+
+inline autil::ConstString toStringView(const std::string &value) {
+    return autil::ConstString(value.data(), value.size());
+}
+
+inline autil::ConstString toStringView(const autil::MultiChar &value) {
+    return autil::ConstString(value.data(), value.size());
+}
+
+// string values of a row as ConstString, nothing is copied. a MultiString
+// is read through a MultiStringCursor, its header is decoded once per row.
+class StringRow {
+public:
+    StringRow()
+        : _strings(nullptr)
+        , _chars(nullptr)
+        , _codes(nullptr)
+        , _count(0)
+    {}
+    StringRow(const std::string *values, size_t count)
+        : StringRow()
+    {
+        _strings = values;
+        _count = count;
+    }
+    StringRow(const autil::MultiChar *values, size_t count)
+        : StringRow()
+    {
+        _chars = values;
+        _count = count;
+    }
+    // value i is values[codes[i]]
+    template <typename T>
+    StringRow(const T *values, const uint32_t *codes, size_t count)
+        : StringRow(values, count)
+    {
+        _codes = codes;
+    }
+    explicit StringRow(const autil::MultiString &values)
+        : StringRow()
+    {
+        _cursor = autil::MultiStringCursor(values);
+        _count = _cursor.size();
+    }
+public:
+    size_t size() const {
+        return _count;
+    }
+    autil::ConstString operator[](size_t id) const {
+        assert(id < _count);
+        if (_codes) {
+            id = _codes[id];
+        }
+        if (_strings) {
+            return toStringView(_strings[id]);
+        } else if (_chars) {
+            return toStringView(_chars[id]);
+        }
+        uint32_t length = 0;
+        const char *data = _cursor.data(id, length);
+        return autil::ConstString(data, length);
+    }
+private:
+    const std::string *_strings;
+    const autil::MultiChar *_chars;
+    const uint32_t *_codes;
+    autil::MultiStringCursor _cursor;
+    size_t _count;
 };
 
 template <typename T>
 class DenseStorage {
 public:
     static constexpr InputStorageType STORAGE_ENUM = IST_DENSE;
+    typedef Row<T> RowType;
 public:
     DenseStorage()
         : _values(nullptr)
         , _row(0)
         , _col(0)
     {}
-    DenseStorage(const T *values, size_t r, size_t c = 1)
+    // validity covers the r * c values
+    DenseStorage(const T *values, size_t r, size_t c = 1,
+                 ValidityBitmap validity = ValidityBitmap())
         : _values(values)
         , _row(r)
         , _col(c)
+        , _validity(validity)
     {}
 public:
     size_t row() const { return _row; }
@@ -187,21 +385,72 @@ public:
     }
     Row<T> getRow(size_t r) const {
         assert(r < row());
-        return Row<T>(_values + r * _col, _col);
+        return Row<T>(_values + r * _col, _col, _validity.offset(r * _col));
+    }
+    bool hasValidity() const {
+        return !_validity.empty();
+    }
+    bool isValid(size_t r, size_t c) const {
+        return _validity.isValid(r * _col + c);
+    }
+    RowType getRowView(size_t r) const {
+        return getRow(r);
+    }
+    // string types only
+    autil::ConstString getView(size_t r, size_t c) const {
+        return toStringView(getRef(r, c));
+    }
+    StringRow getStringRow(size_t r) const {
+        assert(r < row());
+        return StringRow(_values + r * _col, _col);
+    }
+    // visitor(r, row) for every row in [begin, end)
+    template <typename Visitor>
+    void visitRows(size_t begin, size_t end, Visitor &&visitor) const {
+        assert(begin <= end && end <= row());
+        const T *values = _values + begin * _col;
+        for (size_t r = begin; r < end; r++, values += _col) {
+            visitor(r, RowType(values, _col, _validity.offset(r * _col)));
+        }
     }
     bool supportRef() const {
         return true;
     }
+    DenseStorage<T> slice(size_t begin, size_t end) const {
+        assert(begin <= end && end <= row());
+        return DenseStorage<T>(_values + begin * _col, end - begin, _col,
+                               _validity.offset(begin * _col));
+    }
 private:
     const T *_values;
     const size_t _row;
     const size_t _col;
+    const ValidityBitmap _validity;
+};
+
+// rows of MultiValueStorage, MultiString does not support data() so its
+// rows are read by a cursor that decodes the header once
+template <typename T>
+struct MultiValueRowTraits {
+    typedef Row<T> RowType;
+    static RowType toRow(const autil::MultiValueType<T> &values) {
+        return RowType(values.data(), values.size());
+    }
+};
+
+template <>
+struct MultiValueRowTraits<autil::MultiChar> {
+    typedef autil::MultiStringCursor RowType;
+    static RowType toRow(const autil::MultiString &values) {
+        return RowType(values);
+    }
 };
 
 template <typename T>
 class MultiValueStorage {
 public:
     static constexpr InputStorageType STORAGE_ENUM = IST_SPARSE_MULTI_VALUE;
+    typedef typename MultiValueRowTraits<T>::RowType RowType;
 private:
     using ValueType = autil::MultiValueType<T>;
 public:
@@ -234,6 +483,32 @@ public:
         const ValueType &v = _values[r];
         return Row<T>(v.data(), v.size());
     }
+    RowType getRowView(size_t r) const {
+        assert(r < row());
+        return MultiValueRowTraits<T>::toRow(_values[r]);
+    }
+    bool hasValidity() const {
+        return false;
+    }
+    bool isValid(size_t /*r*/, size_t /*c*/) const {
+        return true;
+    }
+    autil::ConstString getView(size_t r, size_t c) const {
+        assert(r < row());
+        assert(c < col(r));
+        return toStringView(_values[r][c]);
+    }
+    StringRow getStringRow(size_t r) const {
+        assert(r < row());
+        return StringRow(_values[r]);
+    }
+    template <typename Visitor>
+    void visitRows(size_t begin, size_t end, Visitor &&visitor) const {
+        assert(begin <= end && end <= row());
+        for (size_t r = begin; r < end; r++) {
+            visitor(r, MultiValueRowTraits<T>::toRow(_values[r]));
+        }
+    }
     size_t numElements() const {
         size_t total = 0;
         for (size_t r = 0; r < row(); r++) {
@@ -244,6 +519,10 @@ public:
     bool supportRef() const {
         return true;
     }
+    MultiValueStorage<T> slice(size_t begin, size_t end) const {
+        assert(begin <= end && end <= row());
+        return MultiValueStorage<T>(_values + begin, end - begin);
+    }
 private:
     const ValueType *_values;
     const size_t _count;
@@ -275,6 +554,7 @@ template <typename T>
 class ValueOffsetStorage {
 public:
     static constexpr InputStorageType STORAGE_ENUM = IST_SPARSE_VALUE_OFFSET;
+    typedef Row<T> RowType;
 public:
     ValueOffsetStorage()
         : _values(nullptr)
@@ -282,21 +562,36 @@ public:
         , _valueCount(0)
         , _offsetCount(0)
     {}
+    // validity covers the valueCount values
     ValueOffsetStorage(const T *values, size_t valueCount,
-                       const size_t *offsets, size_t offsetCount)
+                       const size_t *offsets, size_t offsetCount,
+                       ValidityBitmap validity = ValidityBitmap())
         : _values(values)
         , _offsets(offsets)
         , _valueCount(valueCount)
         , _offsetCount(offsetCount)
+        , _validity(validity)
     {}
     ValueOffsetStorage(const T *values, size_t valueCount,
                        const size_t *offsets, size_t offsetCount,
-                       const std::shared_ptr<std::vector<size_t> > offsetVec)
+                       const std::shared_ptr<std::vector<size_t> > offsetVec,
+                       ValidityBitmap validity = ValidityBitmap())
         : _values(values)
         , _offsets(offsets)
         , _valueCount(valueCount)
         , _offsetCount(offsetCount)
         , _offsetVec(offsetVec)
+        , _validity(validity)
+    {}
+private:
+    ValueOffsetStorage(const ValueOffsetStorage<T> &other, size_t begin, size_t end)
+        : _values(other._values)
+        , _offsets(other._offsets + begin)
+        , _valueCount(end < other.row() ? other._offsets[end] : other._valueCount)
+        , _offsetCount(end - begin)
+        , _offsetVec(other._offsetVec)
+        , _validity(other._validity)
+        , _valueBegin(begin < other.row() ? other._offsets[begin] : _valueCount)
     {}
 public:
     size_t row() const { return _offsetCount; }
@@ -319,23 +614,179 @@ public:
         return _values[_offsets[r]+c];
     }
     size_t numElements() const {
-        return _valueCount;
+        return _valueCount - _valueBegin;
     }
     Row<T> getRow(size_t r) const {
         assert(r < row());
-        return Row<T>(_values + _offsets[r], col(r));
+        return Row<T>(_values + _offsets[r], col(r), _validity.offset(_offsets[r]));
+    }
+    bool hasValidity() const {
+        return !_validity.empty();
+    }
+    bool isValid(size_t r, size_t c) const {
+        return _validity.isValid(_offsets[r] + c);
+    }
+    RowType getRowView(size_t r) const {
+        return getRow(r);
+    }
+    autil::ConstString getView(size_t r, size_t c) const {
+        return toStringView(getRef(r, c));
+    }
+    StringRow getStringRow(size_t r) const {
+        assert(r < row());
+        return StringRow(_values + _offsets[r], col(r));
+    }
+    template <typename Visitor>
+    void visitRows(size_t begin, size_t end, Visitor &&visitor) const {
+        assert(begin <= end && end <= row());
+        for (size_t r = begin; r < end; r++) {
+            size_t offset = _offsets[r];
+            size_t next = r + 1 != row() ? _offsets[r + 1] : _valueCount;
+            visitor(r, RowType(_values + offset, next - offset, _validity.offset(offset)));
+        }
     }
     bool supportRef() const {
         return true;
     }
+    // offsets are absolute, the slice shares values and offsets with this storage
+    ValueOffsetStorage<T> slice(size_t begin, size_t end) const {
+        assert(begin <= end && end <= row());
+        return ValueOffsetStorage<T>(*this, begin, end);
+    }
 private:
     const T *_values;
     const size_t *_offsets;
     const size_t _valueCount;
     const size_t _offsetCount;
     const std::shared_ptr<std::vector<size_t> > _offsetVec; //hold to extend lifetime for offsets vector
+    const ValidityBitmap _validity;
+    const size_t _valueBegin = 0;
 };
 
+// values of one row of a DictionaryStorage, read through the codes
+template <typename T>
+class DictionaryRow {
+public:
+    DictionaryRow()
+        : _dictionary(nullptr)
+        , _codes(nullptr)
+        , _count(0)
+    {}
+    DictionaryRow(const T *dictionary, const uint32_t *codes, size_t count)
+        : _dictionary(dictionary)
+        , _codes(codes)
+        , _count(count)
+    {}
+public:
+    size_t size() const {
+        return _count;
+    }
+    const T &operator[](size_t id) const {
+        assert(id < _count);
+        return _dictionary[_codes[id]];
+    }
+    const uint32_t *codes() const {
+        return _codes;
+    }
+private:
+    const T *_dictionary;
+    const uint32_t *_codes;
+    size_t _count;
+};
+
+// low cardinality columns, value c of row r is dictionary[codes[r * col + c]].
+// functions may format, hash or look up every dictionary value once and emit
+// the results by code, see FeatureFunction::supportDictionaryInput().
+template <typename T>
+class DictionaryStorage {
+public:
+    static constexpr InputStorageType STORAGE_ENUM = IST_DICTIONARY;
+    typedef DictionaryRow<T> RowType;
+public:
+    DictionaryStorage()
+        : _dictionary(nullptr)
+        , _dictionarySize(0)
+        , _codes(nullptr)
+        , _row(0)
+        , _col(0)
+    {}
+    DictionaryStorage(const T *dictionary, size_t dictionarySize,
+                      const uint32_t *codes, size_t r, size_t c = 1)
+        : _dictionary(dictionary)
+        , _dictionarySize(dictionarySize)
+        , _codes(codes)
+        , _row(r)
+        , _col(c)
+    {}
+public:
+    size_t row() const { return _row; }
+    size_t col(size_t /* unused */) const { return _col; }
+    T get(size_t r, size_t c) const {
+        return getRef(r, c);
+    }
+    const T &getRef(size_t r, size_t c) const {
+        assert(r < row());
+        assert(c < col(r));
+        assert(_codes[r * _col + c] < _dictionarySize);
+        return _dictionary[_codes[r * _col + c]];
+    }
+    size_t numElements() const {
+        return _row * _col;
+    }
+    Row<T> getRow(size_t r) const {
+        // values of a row are not contiguous
+        assert(false);
+        return Row<T>();
+    }
+    bool hasValidity() const {
+        return false;
+    }
+    bool isValid(size_t /*r*/, size_t /*c*/) const {
+        return true;
+    }
+    RowType getRowView(size_t r) const {
+        assert(r < row());
+        return RowType(_dictionary, _codes + r * _col, _col);
+    }
+    autil::ConstString getView(size_t r, size_t c) const {
+        return toStringView(getRef(r, c));
+    }
+    StringRow getStringRow(size_t r) const {
+        assert(r < row());
+        return StringRow(_dictionary, _codes + r * _col, _col);
+    }
+    template <typename Visitor>
+    void visitRows(size_t begin, size_t end, Visitor &&visitor) const {
+        assert(begin <= end && end <= row());
+        const uint32_t *codes = _codes + begin * _col;
+        for (size_t r = begin; r < end; r++, codes += _col) {
+            visitor(r, RowType(_dictionary, codes, _col));
+        }
+    }
+    bool supportRef() const {
+        return true;
+    }
+    // the slice shares the whole dictionary
+    DictionaryStorage<T> slice(size_t begin, size_t end) const {
+        assert(begin <= end && end <= row());
+        return DictionaryStorage<T>(_dictionary, _dictionarySize,
+                                    _codes + begin * _col, end - begin, _col);
+    }
+public:
+    const T *getDictionary() const { return _dictionary; }
+    size_t dictionarySize() const { return _dictionarySize; }
+    const uint32_t *getCodes() const { return _codes; }
+private:
+    const T *_dictionary;
+    const size_t _dictionarySize;
+    const uint32_t *_codes;
+    const size_t _row;
+    const size_t _col;
+};
+
+template <typename T, typename StorageType>
+class FeatureInputTyped;
+
 class FeatureInput {
 public:
     FeatureInput(InputDataType dataType, InputStorageType storageType)
@@ -350,12 +801,24 @@ public:
     InputStorageType storageType() const {
         return _storageType;
     }
+    // the typed input resolved from dataType() and storageType() without
+    // rtti, nullptr if this input is not FeatureInputTyped<T, StorageType>
+    template <typename T, typename StorageType>
+    FeatureInputTyped<T, StorageType> *typed();
+    template <typename T, typename StorageType>
+    const FeatureInputTyped<T, StorageType> *typed() const {
+        return const_cast<FeatureInput*>(this)->typed<T, StorageType>();
+    }
 public:
     virtual size_t row() const = 0;
     virtual size_t col(size_t r) const = 0;
     virtual size_t numElements() const = 0;
     virtual bool toString(size_t r, size_t c, FeatureFormatter::FeatureBuffer &buf,
                           bool check=false) = 0;
+    // exact contents of row r, used to key cached broadcast results
+    virtual void hashRow(size_t r, FeatureHasher &hasher) const = 0;
+    // view of rows [begin, end), shares data with this input.
+    virtual FeatureInput *slice(size_t begin, size_t end) const = 0;
 private:
     InputDataType _dataType;
     InputStorageType _storageType;
@@ -377,7 +840,8 @@ struct StorageTypeTraits {
 #define STORAGE_HELPER(input_enum)                                      \
     STORAGE_TRAITS_HELPER(input_enum, IST_DENSE, DenseStorage);         \
     STORAGE_TRAITS_HELPER(input_enum, IST_SPARSE_VALUE_OFFSET, ValueOffsetStorage); \
-    STORAGE_TRAITS_HELPER(input_enum, IST_SPARSE_MULTI_VALUE, MultiValueStorage) \
+    STORAGE_TRAITS_HELPER(input_enum, IST_SPARSE_MULTI_VALUE, MultiValueStorage); \
+    STORAGE_TRAITS_HELPER(input_enum, IST_DICTIONARY, DictionaryStorage) \
 
 STORAGE_HELPER(IT_INT8);
 STORAGE_HELPER(IT_UINT8);
@@ -396,6 +860,7 @@ template <typename T, typename StorageType>
 class FeatureInputTyped : public FeatureInput {
 public:
     typedef T value_type;
+    typedef typename StorageType::RowType RowType;
 public:
     FeatureInputTyped(StorageType storage)
         : FeatureInput(Type2InputType<T>::value, StorageType::STORAGE_ENUM)
@@ -410,29 +875,177 @@ public:
     {
         if (_storage.supportRef()) {
             const T &v = getRef(r, c);
-            if (check && FeatureFormatter::isInvalidValue<T>(v)) {
+            if (check && isNull(r, c, v)) {
                 return false;
             }
             FeatureFormatter::fillFeatureToBuffer(v, buf);
         } else {
             T v = get(r, c);
-            if (check && FeatureFormatter::isInvalidValue<T>(v)) {
+            if (check && isNull(r, c, v)) {
                 return false;
             }
             FeatureFormatter::fillFeatureToBuffer(v, buf);
         }
         return true;
     }
+    // same as toString, but feeds the hasher instead of formatting
+    bool toHash(size_t r, size_t c, FeatureHasher &hasher, bool check) const {
+        if (_storage.supportRef()) {
+            const T &v = getRef(r, c);
+            if (check && isNull(r, c, v)) {
+                return false;
+            }
+            hasher.updateValue(v);
+        } else {
+            T v = get(r, c);
+            if (check && isNull(r, c, v)) {
+                return false;
+            }
+            hasher.updateValue(v);
+        }
+        return true;
+    }
+    void hashRow(size_t r, FeatureHasher &hasher) const override {
+        uint64_t count = col(r);
+        hasher.update((const char *)&count, sizeof(count));
+        for (size_t c = 0; c < count; c++) {
+            hasher.updateBinary(get(r, c));
+        }
+        if (_storage.hasValidity()) {
+            for (size_t c = 0; c < count; c++) {
+                hasher.updateBinary(uint8_t(_storage.isValid(r, c)));
+            }
+        }
+    }
+    FeatureInput *slice(size_t begin, size_t end) const override {
+        return new FeatureInputTyped<T, StorageType>(_storage.slice(begin, end));
+    }
 public:
     T get(size_t r, size_t c) const {
         return _storage.get(r, c);
     }
     const T& getRef(size_t r, size_t c) const { return _storage.getRef(r, c); }
     Row<T> getRow(size_t r) const { return _storage.getRow(r); }
+    bool hasValidity() const { return _storage.hasValidity(); }
+    bool isValid(size_t r, size_t c) const { return _storage.isValid(r, c); }
+    // null by the validity if there is one, otherwise by the sentinel value
+    bool isNull(size_t r, size_t c, const T &v) const {
+        if (_storage.hasValidity()) {
+            return !_storage.isValid(r, c);
+        }
+        return FeatureFormatter::isInvalidValue<T>(v);
+    }
+    // values of row r, indexable for every storage and type
+    RowType getRowView(size_t r) const { return _storage.getRowView(r); }
+    // string inputs only, views of the values without copying any string
+    autil::ConstString getView(size_t r, size_t c) const { return _storage.getView(r, c); }
+    StringRow getStringRow(size_t r) const { return _storage.getStringRow(r); }
+    // visitor(r, row) for every row in [begin, end), row as getRowView(r)
+    template <typename Visitor>
+    void visitRows(size_t begin, size_t end, Visitor &&visitor) const {
+        _storage.visitRows(begin, end, std::forward<Visitor>(visitor));
+    }
+    template <typename Visitor>
+    void visitRows(Visitor &&visitor) const {
+        _storage.visitRows(0, row(), std::forward<Visitor>(visitor));
+    }
+    // storage specific accessors, e.g. the dictionary of DictionaryStorage
+    const StorageType &getStorage() const { return _storage; }
 private:
     StorageType _storage;
 };
 
+template <typename T, typename StorageType>
+inline FeatureInputTyped<T, StorageType> *FeatureInput::typed() {
+    if (_dataType != Type2InputType<T>::value || _storageType != StorageType::STORAGE_ENUM) {
+        return nullptr;
+    }
+    return static_cast<FeatureInputTyped<T, StorageType>*>(this);
+}
+
+// visitor(typedInput) with the FeatureInputTyped of input, the type switch
+// runs once per input instead of once per value. false if type unknown.
+template <typename Visitor>
+inline bool visitTypedInput(FeatureInput *input, Visitor &&visitor) {
+#define VISIT_TYPED_INPUT_CASE(dt)                                      \
+    case dt: {                                                          \
+        typedef InputType2Type<dt>::Type Type;                          \
+        switch (input->storageType()) {                                 \
+        case IST_DENSE:                                                 \
+            visitor(input->typed<Type, DenseStorage<Type>>());          \
+            return true;                                                \
+        case IST_SPARSE_MULTI_VALUE:                                    \
+            visitor(input->typed<Type, MultiValueStorage<Type>>());     \
+            return true;                                                \
+        case IST_SPARSE_VALUE_OFFSET:                                   \
+            visitor(input->typed<Type, ValueOffsetStorage<Type>>());    \
+            return true;                                                \
+        case IST_DICTIONARY:                                            \
+            visitor(input->typed<Type, DictionaryStorage<Type>>());     \
+            return true;                                                \
+        }                                                               \
+        return false;                                                   \
+    }
+    switch (input->dataType()) {
+        INPUT_DATA_TYPE_MACRO_HELPER(VISIT_TYPED_INPUT_CASE);
+    default:
+        return false;
+    }
+#undef VISIT_TYPED_INPUT_CASE
+}
+
+template <typename T>
+struct DecodedValues {
+    std::vector<T> values;
+};
+
+// dense copy of a dictionary input, owns the decoded values
+template <typename T>
+class DecodedDictionaryInput : private DecodedValues<T>,
+                               public FeatureInputTyped<T, DenseStorage<T>>
+{
+public:
+    explicit DecodedDictionaryInput(const FeatureInputTyped<T, DictionaryStorage<T>> &input)
+        : DecodedValues<T>{decode(input.getStorage())}
+        , FeatureInputTyped<T, DenseStorage<T>>(DenseStorage<T>(
+                        this->values.data(), input.row(), input.row() > 0 ? input.col(0) : 0))
+    {}
+private:
+    static std::vector<T> decode(const DictionaryStorage<T> &storage) {
+        std::vector<T> values;
+        values.reserve(storage.numElements());
+        const T *dictionary = storage.getDictionary();
+        const uint32_t *codes = storage.getCodes();
+        for (size_t i = 0; i < storage.numElements(); i++) {
+            values.push_back(dictionary[codes[i]]);
+        }
+        return values;
+    }
+};
+
+// input itself if it is not dictionary encoded, otherwise a dense copy
+// owned by decoded. for functions reading values by storage type.
+inline FeatureInput *decodeDictionaryInput(FeatureInput *input,
+        std::vector<std::unique_ptr<FeatureInput>> &decoded)
+{
+    if (input->storageType() != IST_DICTIONARY) {
+        return input;
+    }
+    switch (input->dataType()) {
+#define DECODE_DICTIONARY_INPUT_CASE(dt)                                \
+    case dt: {                                                          \
+        typedef InputType2Type<dt>::Type Type;                          \
+        decoded.emplace_back(new DecodedDictionaryInput<Type>(          \
+                        *input->typed<Type, DictionaryStorage<Type>>())); \
+        return decoded.back().get();                                    \
+    }
+        INPUT_DATA_TYPE_MACRO_HELPER(DECODE_DICTIONARY_INPUT_CASE);
+#undef DECODE_DICTIONARY_INPUT_CASE
+    default:
+        return input;
+    }
+}
+
 template <InputDataType DT, InputStorageType ST>
 struct DTST2InputType {
     typedef typename InputType2Type<DT>::Type DataType;
@@ -0,0 +1,90 @@
+#include "fg_lite/feature/FeatureMetrics.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, FeatureMetrics);
+
+uint64_t FeatureMetricsSnapshot::getLatencyPercentile(double percentile) const {
+    if (callCount == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(percentile / 100 * callCount + 0.5);
+    rank = max(rank, (uint64_t)1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < latencyHistogram.size(); i++) {
+        seen += latencyHistogram[i];
+        if (seen >= rank) {
+            return FeatureMetrics::getBucketUpperBound(i);
+        }
+    }
+    return FeatureMetrics::getBucketUpperBound(FeatureMetrics::BUCKET_COUNT - 1);
+}
+
+FeatureMetrics::FeatureMetrics(const vector<string> &featureNames, size_t shardCount)
+    : _featureNames(featureNames)
+{
+    _shards.resize(max(shardCount, (size_t)1));
+    for (auto &shard : _shards) {
+        shard.reset(new FeatureCounters[_featureNames.size()]);
+    }
+    reset();
+}
+
+FeatureMetrics::~FeatureMetrics() {
+}
+
+uint64_t FeatureMetrics::getBucketUpperBound(size_t bucket) {
+    if (bucket < SUB_BUCKET_COUNT) {
+        return bucket;
+    }
+    size_t shift = bucket / SUB_BUCKET_COUNT - 1;
+    uint64_t lower = (uint64_t)(SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+FeatureMetrics::FeatureCounters *FeatureMetrics::getShard() {
+    // threads are spread over shards in the order they first record
+    static atomic<size_t> nextThread(0);
+    thread_local size_t threadIdx = nextThread.fetch_add(1, memory_order_relaxed);
+    return _shards[threadIdx % _shards.size()].get();
+}
+
+void FeatureMetrics::snapshot(vector<FeatureMetricsSnapshot> &snapshots) const {
+    snapshots.clear();
+    snapshots.resize(_featureNames.size());
+    for (size_t i = 0; i < _featureNames.size(); i++) {
+        FeatureMetricsSnapshot &snapshot = snapshots[i];
+        snapshot.featureName = _featureNames[i];
+        snapshot.latencyHistogram.assign(BUCKET_COUNT, 0);
+        for (const auto &shard : _shards) {
+            const FeatureCounters &counters = shard[i];
+            snapshot.callCount += counters.callCount.load(memory_order_relaxed);
+            snapshot.docCount += counters.docCount.load(memory_order_relaxed);
+            snapshot.valueCount += counters.valueCount.load(memory_order_relaxed);
+            snapshot.poolBytes += counters.poolBytes.load(memory_order_relaxed);
+            snapshot.latencyNs += counters.latencyNs.load(memory_order_relaxed);
+            for (size_t j = 0; j < BUCKET_COUNT; j++) {
+                snapshot.latencyHistogram[j] += counters.latencyHistogram[j].load(memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void FeatureMetrics::reset() {
+    for (auto &shard : _shards) {
+        for (size_t i = 0; i < _featureNames.size(); i++) {
+            FeatureCounters &counters = shard[i];
+            counters.callCount.store(0, memory_order_relaxed);
+            counters.docCount.store(0, memory_order_relaxed);
+            counters.valueCount.store(0, memory_order_relaxed);
+            counters.poolBytes.store(0, memory_order_relaxed);
+            counters.latencyNs.store(0, memory_order_relaxed);
+            for (auto &count : counters.latencyHistogram) {
+                count.store(0, memory_order_relaxed);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+#ifndef ISEARCH_FG_LITE_FEATUREMETRICS_H
+#define ISEARCH_FG_LITE_FEATUREMETRICS_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "autil/Log.h"
+
+namespace fg_lite {
+
+struct FeatureMetricsSnapshot {
+    std::string featureName;
+    uint64_t callCount = 0;
+    uint64_t docCount = 0;
+    // keys or values generated, see Features::valueCount
+    uint64_t valueCount = 0;
+    // scratch and output pool bytes of serial runs, see FeaturePlan
+    uint64_t poolBytes = 0;
+    uint64_t latencyNs = 0;
+    // calls per latency bucket, see FeatureMetrics::getBucketUpperBound
+    std::vector<uint64_t> latencyHistogram;
+public:
+    // upper bound of the bucket holding the percentile in [0, 100], 0 if
+    // never called
+    uint64_t getLatencyPercentile(double percentile) const;
+    double getDocsPerSecond() const {
+        return latencyNs > 0 ? docCount * 1e9 / latencyNs : 0;
+    }
+};
+
+/*
+ * runtime metrics of the features of a plan, recorded by FeaturePlan when
+ * context->metrics is set. latencies go into log linear buckets of 1/8
+ * relative width, like HdrHistogram with one significant digit. every
+ * thread records into one of shardCount shards with relaxed atomics and
+ * snapshot() sums them up, so recording never takes a lock.
+ */
+class FeatureMetrics
+{
+public:
+    static const size_t SUB_BUCKET_BITS = 3;
+    static const size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    // latencies from 2^MAX_EXPONENT ns (about 4.5 minutes) on share the last bucket
+    static const size_t MAX_EXPONENT = 38;
+    static const size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+private:
+    struct FeatureCounters {
+        std::atomic<uint64_t> callCount;
+        std::atomic<uint64_t> docCount;
+        std::atomic<uint64_t> valueCount;
+        std::atomic<uint64_t> poolBytes;
+        std::atomic<uint64_t> latencyNs;
+        std::atomic<uint64_t> latencyHistogram[BUCKET_COUNT];
+    };
+public:
+    // featureNames in feature order of the plan
+    explicit FeatureMetrics(const std::vector<std::string> &featureNames,
+                            size_t shardCount = 8);
+    ~FeatureMetrics();
+private:
+    FeatureMetrics(const FeatureMetrics &);
+    FeatureMetrics& operator=(const FeatureMetrics &);
+public:
+    void record(size_t featureIdx, uint64_t latencyNs, uint64_t docCount,
+                uint64_t valueCount, uint64_t poolBytes);
+    // one snapshot per feature, in feature order
+    void snapshot(std::vector<FeatureMetricsSnapshot> &snapshots) const;
+    // counts recorded concurrently may be lost
+    void reset();
+public:
+    size_t getFeatureCount() const { return _featureNames.size(); }
+    static size_t getBucket(uint64_t latencyNs);
+    static uint64_t getBucketUpperBound(size_t bucket);
+private:
+    FeatureCounters *getShard();
+private:
+    std::vector<std::string> _featureNames;
+    std::vector<std::unique_ptr<FeatureCounters[]>> _shards;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+inline size_t FeatureMetrics::getBucket(uint64_t latencyNs) {
+    if (latencyNs < SUB_BUCKET_COUNT) {
+        return latencyNs;
+    }
+    size_t exponent = 63 - __builtin_clzll(latencyNs);
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    size_t subBucket = (latencyNs >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + subBucket;
+}
+
+inline void FeatureMetrics::record(size_t featureIdx, uint64_t latencyNs, uint64_t docCount,
+                                   uint64_t valueCount, uint64_t poolBytes)
+{
+    if (featureIdx >= _featureNames.size()) {
+        return;
+    }
+    FeatureCounters &counters = getShard()[featureIdx];
+    counters.callCount.fetch_add(1, std::memory_order_relaxed);
+    counters.docCount.fetch_add(docCount, std::memory_order_relaxed);
+    counters.valueCount.fetch_add(valueCount, std::memory_order_relaxed);
+    counters.poolBytes.fetch_add(poolBytes, std::memory_order_relaxed);
+    counters.latencyNs.fetch_add(latencyNs, std::memory_order_relaxed);
+    counters.latencyHistogram[getBucket(latencyNs)].fetch_add(1, std::memory_order_relaxed);
+}
+
+}
+
+#endif //ISEARCH_FG_LITE_FEATUREMETRICS_H
@@ -0,0 +1,570 @@
+#include "fg_lite/feature/FeaturePlan.h"
+#include <atomic>
+#include "fg_lite/feature/FeatureConfig.h"
+#include "fg_lite/feature/BroadcastFeatureCache.h"
+#include "autil/CommonMacros.h"
+#include "autil/TimeUtility.h"
+#include "fg_lite/feature/FeatureFunctionCreator.h"
+#include "fg_lite/feature/FeatureMetrics.h"
+#include "fg_lite/feature/DocRangeSharder.h"
+#include "fg_lite/feature/ItemFeatureCache.h"
+#include "fg_lite/feature/RequestCapture.h"
+#include "fg_lite/feature/RequestTracer.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, FeaturePlan);
+
+static atomic<uint64_t> nextPlanId(0);
+static const size_t CHUNK_POOL_SIZE = 1024 * 1024;
+
+FeaturePlan::FeaturePlan()
+    : _shardDocCount(0)
+    , _planId(nextPlanId.fetch_add(1, memory_order_relaxed))
+{
+}
+
+FeaturePlan::~FeaturePlan() {
+    clear();
+}
+
+void FeaturePlan::clear() {
+    for (auto &node : _nodes) {
+        delete node.function;
+    }
+    _nodes.clear();
+    _inputNames.clear();
+    _inputSlots.clear();
+}
+
+// inputs of the config in the order the function reads them. configs may
+// declare inputs the function does not take, those are dropped here
+static vector<string> getFunctionInputNames(const SingleFeatureConfig &config,
+        const FeatureFunction &function)
+{
+    vector<string> inputNames;
+    for (const auto &keyAndExpr : config.getDependInputsWithKeys()) {
+        inputNames.push_back(keyAndExpr.second);
+    }
+    if (config.type == "lookup_feature") {
+        // optimized lookup reads the values of the key from the map input only
+        const auto &lookupConfig = static_cast<const LookupFeatureConfig&>(config);
+        if (lookupConfig.isOptimized && inputNames.size() > function.getInputCount()) {
+            inputNames.resize(function.getInputCount());
+        }
+    }
+    return inputNames;
+}
+
+bool FeaturePlan::init(const FeatureConfig &featureConfig) {
+    clear();
+    for (const auto singleConfig : featureConfig._featureConfigs) {
+        FeatureFunction *function =
+            FeatureFunctionCreator::createFeatureFunction(singleConfig);
+        if (function == nullptr) {
+            AUTIL_LOG(ERROR, "create feature function[%s] failed",
+                      singleConfig->getFeatureName().c_str());
+            clear();
+            return false;
+        }
+        vector<string> inputNames = getFunctionInputNames(*singleConfig, *function);
+        string configJson = autil::legacy::ToJsonString(*singleConfig);
+        uint64_t fingerprint = FeatureHasher::hash(configJson.data(), configJson.size());
+        if (!addFeature(function, inputNames, fingerprint)) {
+            clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FeaturePlan::addFeature(FeatureFunction *function,
+                             const vector<string> &inputNames)
+{
+    return addFeature(function, inputNames, _planId);
+}
+
+bool FeaturePlan::addFeature(FeatureFunction *function,
+                             const vector<string> &inputNames,
+                             uint64_t configFingerprint)
+{
+    if (function == nullptr) {
+        return false;
+    }
+    if (inputNames.size() != function->getInputCount()) {
+        AUTIL_LOG(ERROR, "feature[%s] expect %lu inputs, but got %lu",
+                  function->getFeatureName().c_str(),
+                  function->getInputCount(), inputNames.size());
+        delete function;
+        return false;
+    }
+    FeatureNode node;
+    node.function = function;
+    for (const auto &inputName : inputNames) {
+        node.inputSlots.push_back(addInput(inputName));
+    }
+    node.scope = classifyInputs(inputNames);
+    node.cacheKey = ItemFeatureCache::makeFeatureKey(function->getFeatureName(), configFingerprint);
+    _nodes.push_back(node);
+    return true;
+}
+
+static FeaturePlan::FeatureScope getInputScope(const string &inputName) {
+    size_t pos = inputName.find(':');
+    if (pos == string::npos) {
+        return FeaturePlan::FS_CROSS;
+    }
+    string side = inputName.substr(0, pos);
+    if (side == "item") {
+        return FeaturePlan::FS_ITEM;
+    } else if (side == "user" || side == "query" || side == "context") {
+        return FeaturePlan::FS_USER;
+    }
+    return FeaturePlan::FS_CROSS;
+}
+
+// output arena of the thread running a feature task, see
+// FeatureFunctionContext::workerFeaturePools
+static autil::mem_pool::Pool *getWorkerFeaturePool(const FeatureFunctionContext &context,
+        const WorkStealingThreadPool *threadPool)
+{
+    const vector<autil::mem_pool::Pool*> *pools = context.workerFeaturePools;
+    if (pools == nullptr) {
+        return context.featurePool;
+    }
+    size_t idx = threadPool->getWorkerIndex();
+    return idx < pools->size() ? (*pools)[idx] : context.featurePool;
+}
+
+static RequestTracer *getTracer(const FeatureFunctionContext *context) {
+    return context != nullptr ? context->tracer : nullptr;
+}
+
+FeaturePlan::FeatureScope FeaturePlan::classifyInputs(const vector<string> &inputNames) {
+    if (inputNames.empty()) {
+        return FS_CROSS;
+    }
+    FeatureScope scope = getInputScope(inputNames[0]);
+    for (size_t i = 1; i < inputNames.size(); i++) {
+        if (getInputScope(inputNames[i]) != scope) {
+            return FS_CROSS;
+        }
+    }
+    return scope;
+}
+
+size_t FeaturePlan::addInput(const string &inputName) {
+    auto it = _inputSlots.find(inputName);
+    if (it != _inputSlots.end()) {
+        return it->second;
+    }
+    size_t slot = _inputNames.size();
+    _inputNames.push_back(inputName);
+    _inputSlots[inputName] = slot;
+    return slot;
+}
+
+vector<string> FeaturePlan::getFeatureNames() const {
+    vector<string> featureNames;
+    for (const auto &node : _nodes) {
+        featureNames.push_back(node.function->getFeatureName());
+    }
+    return featureNames;
+}
+
+int32_t FeaturePlan::getInputSlot(const string &inputName) const {
+    auto it = _inputSlots.find(inputName);
+    if (it == _inputSlots.end()) {
+        return -1;
+    }
+    return (int32_t)it->second;
+}
+
+bool FeaturePlan::resolveInputs(const NamedInputs &namedInputs,
+                                vector<FeatureInput*> &slotInputs) const
+{
+    slotInputs.assign(_inputNames.size(), nullptr);
+    for (size_t i = 0; i < _inputNames.size(); i++) {
+        auto it = namedInputs.find(_inputNames[i]);
+        if (it == namedInputs.end() || it->second == nullptr) {
+            AUTIL_LOG(ERROR, "input[%s] not found", _inputNames[i].c_str());
+            return false;
+        }
+        slotInputs[i] = it->second;
+    }
+    return true;
+}
+
+Features *FeaturePlan::genFeature(size_t featureIdx,
+                                  const vector<FeatureInput*> &slotInputs,
+                                  FeatureFunctionContext *context,
+                                  WorkStealingThreadPool *threadPool) const
+{
+    if (unlikely(context != nullptr &&
+                 (context->metrics != nullptr || context->tracer != nullptr)))
+    {
+        return genMeasuredFeature(featureIdx, slotInputs, context, threadPool);
+    }
+    return doGenFeature(_nodes[featureIdx], slotInputs, context, threadPool);
+}
+
+static size_t getUsedPoolBytes(const FeatureFunctionContext *context) {
+    size_t bytes = context->pool != nullptr ? context->pool->getUsedBytes() : 0;
+    if (context->featurePool != nullptr && context->featurePool != context->pool) {
+        bytes += context->featurePool->getUsedBytes();
+    }
+    return bytes;
+}
+
+Features *FeaturePlan::genMeasuredFeature(size_t featureIdx,
+        const vector<FeatureInput*> &slotInputs,
+        FeatureFunctionContext *context,
+        WorkStealingThreadPool *threadPool) const
+{
+    const FeatureNode &node = _nodes[featureIdx];
+    size_t docCount = 0;
+    for (size_t slot : node.inputSlots) {
+        docCount = max(docCount, slotInputs[slot]->row());
+    }
+    size_t valueCount = 0;
+    TraceSpan span(context->tracer, node.function->getFeatureName().c_str(), "feature");
+    span.setArg(0, "docs", docCount);
+    // the pools are shared by the features of a parallel run
+    const bool measurePool = threadPool == nullptr;
+    size_t beginBytes = measurePool ? getUsedPoolBytes(context) : 0;
+    // counted per thread, doc shards run by other workers are not included
+    const bool traceCache = context->tracer != nullptr && context->broadcastCache != nullptr;
+    size_t beginHits = traceCache ? BroadcastFeatureCache::getThreadHitCount() : 0;
+    size_t beginMisses = traceCache ? BroadcastFeatureCache::getThreadMissCount() : 0;
+    int64_t beginTime = autil::TimeUtility::currentTimeInNanoSeconds();
+    Features *features = doGenFeature(node, slotInputs, context, threadPool);
+    int64_t latencyNs = autil::TimeUtility::currentTimeInNanoSeconds() - beginTime;
+    size_t endBytes = measurePool ? getUsedPoolBytes(context) : 0;
+    if (features != nullptr) {
+        valueCount = features->valueCount();
+    }
+    span.setArg(1, "values", valueCount);
+    if (traceCache) {
+        span.setArg(2, "cacheHits", BroadcastFeatureCache::getThreadHitCount() - beginHits);
+        span.setArg(3, "cacheMisses",
+                    BroadcastFeatureCache::getThreadMissCount() - beginMisses);
+    }
+    if (context->metrics != nullptr) {
+        context->metrics->record(featureIdx, max(latencyNs, (int64_t)0), docCount, valueCount,
+                                 endBytes > beginBytes ? endBytes - beginBytes : 0);
+    }
+    return features;
+}
+
+Features *FeaturePlan::doGenFeature(const FeatureNode &node,
+                                    const vector<FeatureInput*> &slotInputs,
+                                    FeatureFunctionContext *context,
+                                    WorkStealingThreadPool *threadPool) const
+{
+    vector<FeatureInput*> inputs(node.inputSlots.size());
+    vector<unique_ptr<FeatureInput>> decodedInputs;
+    const bool supportDictionary = node.function->supportDictionaryInput();
+    for (size_t i = 0; i < inputs.size(); i++) {
+        inputs[i] = slotInputs[node.inputSlots[i]];
+        if (!supportDictionary) {
+            inputs[i] = decodeDictionaryInput(inputs[i], decodedInputs);
+        }
+    }
+    Features *features = nullptr;
+    if (node.scope == FS_ITEM && context != nullptr && context->itemCache != nullptr &&
+        context->itemIds != nullptr && context->tensor == nullptr)
+    {
+        features = genCachedItemFeature(node, inputs, context);
+    } else if (_shardDocCount > 0 && threadPool != nullptr &&
+        (context == nullptr || context->tensor == nullptr))
+    {
+        features = DocRangeSharder::genFeatures(node.function, inputs, context,
+                threadPool, _shardDocCount);
+    } else {
+        features = node.function->genFeatures(inputs, context);
+    }
+    if (features == nullptr) {
+        AUTIL_LOG(DEBUG, "feature[%s] gen features failed",
+                  node.function->getFeatureName().c_str());
+    }
+    return features;
+}
+
+Features *FeaturePlan::genCachedItemFeature(const FeatureNode &node,
+        const vector<FeatureInput*> &inputs,
+        FeatureFunctionContext *context) const
+{
+    const vector<uint64_t> &itemIds = *context->itemIds;
+    size_t docCount = itemIds.size();
+    for (auto input : inputs) {
+        if (input->row() != docCount) {
+            AUTIL_LOG(DEBUG, "feature[%s] input row[%lu] not equal item count[%lu]",
+                      node.function->getFeatureName().c_str(), input->row(), docCount);
+            return node.function->genFeatures(inputs, context);
+        }
+    }
+    if (docCount == 0) {
+        return node.function->genFeatures(inputs, context);
+    }
+    TraceSpan span(context->tracer, "itemCache", "cache");
+    vector<shared_ptr<const CachedFeatureRow>> rows(docCount);
+    size_t missCount = 0;
+    for (size_t i = 0; i < docCount; i++) {
+        rows[i] = context->itemCache->get(node.cacheKey, itemIds[i]);
+        if (!rows[i]) {
+            missCount++;
+        }
+    }
+    span.setArg(0, "hits", docCount - missCount);
+    span.setArg(1, "misses", missCount);
+    if (missCount * 2 > docCount) {
+        // mostly cold, generate all docs at once and keep the missed rows
+        Features *features = node.function->genFeatures(inputs, context);
+        if (features != nullptr) {
+            cacheItemRows(node, features, 0, docCount, context, rows);
+        }
+        return features;
+    }
+    // generate every run of missed docs on slices of the inputs
+    for (size_t begin = 0; begin < docCount; ) {
+        if (rows[begin]) {
+            begin++;
+            continue;
+        }
+        size_t end = begin + 1;
+        while (end < docCount && !rows[end]) {
+            end++;
+        }
+        vector<unique_ptr<FeatureInput>> slices;
+        vector<FeatureInput*> sliceInputs;
+        for (auto input : inputs) {
+            slices.emplace_back(input->slice(begin, end));
+            sliceInputs.push_back(slices.back().get());
+        }
+        unique_ptr<Features> features(node.function->genFeatures(sliceInputs, context));
+        if (!features || !cacheItemRows(node, features.get(), begin, end, context, rows)) {
+            return node.function->genFeatures(inputs, context);
+        }
+        begin = end;
+    }
+    FeatureValueType type = rows[0]->type;
+    unique_ptr<Features> features(ItemFeatureCache::createFeatures(
+                    type, node.function->getFeatureName(), docCount, context->featurePool));
+    for (size_t i = 0; i < docCount; i++) {
+        if (rows[i]->type != type) {
+            return node.function->genFeatures(inputs, context);
+        }
+        ItemFeatureCache::appendRow(*rows[i], features.get());
+    }
+    return features.release();
+}
+
+bool FeaturePlan::cacheItemRows(const FeatureNode &node, Features *features,
+                                size_t begin, size_t end, FeatureFunctionContext *context,
+                                vector<shared_ptr<const CachedFeatureRow>> &rows) const
+{
+    const vector<uint64_t> &itemIds = *context->itemIds;
+    for (size_t i = begin; i < end; i++) {
+        if (rows[i]) {
+            continue;
+        }
+        auto row = make_shared<CachedFeatureRow>();
+        if (!ItemFeatureCache::extractRow(features, i - begin, end - begin, *row)) {
+            return false;
+        }
+        row->featureKey = node.cacheKey;
+        row->itemId = itemIds[i];
+        context->itemCache->put(row);
+        rows[i] = row;
+    }
+    return true;
+}
+
+void FeaturePlan::captureRequest(const vector<FeatureInput*> &slotInputs,
+                                 FeatureFunctionContext *context) const
+{
+    if (unlikely(context != nullptr && context->capture != nullptr)) {
+        context->capture->sample(_inputNames, slotInputs);
+    }
+}
+
+bool FeaturePlan::genFeatures(const vector<FeatureInput*> &slotInputs,
+                              FeatureFunctionContext *context,
+                              vector<Features*> &outputs) const
+{
+    if (slotInputs.size() != _inputNames.size()) {
+        AUTIL_LOG(ERROR, "expect %lu inputs, but got %lu",
+                  _inputNames.size(), slotInputs.size());
+        return false;
+    }
+    TraceSpan span(getTracer(context), "genFeatures", "plan");
+    captureRequest(slotInputs, context);
+    outputs.assign(_nodes.size(), nullptr);
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        outputs[i] = genFeature(i, slotInputs, context);
+    }
+    return true;
+}
+
+bool FeaturePlan::genFeatures(const vector<FeatureInput*> &slotInputs,
+                              FeatureFunctionContext *context,
+                              vector<Features*> &outputs,
+                              WorkStealingThreadPool *threadPool) const
+{
+    if (threadPool == nullptr) {
+        return genFeatures(slotInputs, context, outputs);
+    }
+    if (slotInputs.size() != _inputNames.size()) {
+        AUTIL_LOG(ERROR, "expect %lu inputs, but got %lu",
+                  _inputNames.size(), slotInputs.size());
+        return false;
+    }
+    TraceSpan span(getTracer(context), "genFeatures", "plan");
+    captureRequest(slotInputs, context);
+    outputs.assign(_nodes.size(), nullptr);
+    TaskGroup taskGroup(threadPool);
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        taskGroup.run([this, i, &slotInputs, context, &outputs, threadPool]() {
+                    if (context == nullptr || context->workerFeaturePools == nullptr) {
+                        outputs[i] = genFeature(i, slotInputs, context, threadPool);
+                        return;
+                    }
+                    FeatureFunctionContext taskContext = *context;
+                    taskContext.featurePool = getWorkerFeaturePool(*context, threadPool);
+                    outputs[i] = genFeature(i, slotInputs, &taskContext, threadPool);
+                });
+    }
+    taskGroup.wait();
+    return true;
+}
+
+bool FeaturePlan::genFeatures(const vector<FeatureInput*> &slotInputs,
+                              FeatureFunctionContext *context,
+                              const vector<TensorBuffer*> &tensors,
+                              vector<Features*> &outputs,
+                              WorkStealingThreadPool *threadPool) const
+{
+    if (slotInputs.size() != _inputNames.size() || tensors.size() != _nodes.size()) {
+        AUTIL_LOG(ERROR, "expect %lu inputs and %lu tensors, but got %lu and %lu",
+                  _inputNames.size(), _nodes.size(), slotInputs.size(), tensors.size());
+        return false;
+    }
+    TraceSpan span(getTracer(context), "genFeatures", "plan");
+    captureRequest(slotInputs, context);
+    vector<FeatureFunctionContext> contexts(_nodes.size(),
+            context != nullptr ? *context : FeatureFunctionContext());
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        contexts[i].tensor = tensors[i];
+    }
+    outputs.assign(_nodes.size(), nullptr);
+    if (threadPool == nullptr) {
+        for (size_t i = 0; i < _nodes.size(); i++) {
+            outputs[i] = genFeature(i, slotInputs, &contexts[i]);
+        }
+        return true;
+    }
+    TaskGroup taskGroup(threadPool);
+    for (size_t i = 0; i < _nodes.size(); i++) {
+        taskGroup.run([this, i, &slotInputs, &contexts, &outputs, threadPool]() {
+                    contexts[i].featurePool = getWorkerFeaturePool(contexts[i], threadPool);
+                    outputs[i] = genFeature(i, slotInputs, &contexts[i], threadPool);
+                });
+    }
+    taskGroup.wait();
+    return true;
+}
+
+bool FeaturePlan::genFeaturesChunked(const vector<FeatureInput*> &slotInputs,
+                                     FeatureFunctionContext *context,
+                                     size_t chunkDocCount,
+                                     const ChunkConsumer &consumer,
+                                     WorkStealingThreadPool *threadPool) const
+{
+    if (slotInputs.size() != _inputNames.size() || chunkDocCount == 0) {
+        AUTIL_LOG(ERROR, "expect %lu inputs and chunk doc count > 0, but got %lu and %lu",
+                  _inputNames.size(), slotInputs.size(), chunkDocCount);
+        return false;
+    }
+    size_t docCount = 0;
+    for (auto input : slotInputs) {
+        docCount = max(docCount, input->row());
+    }
+    for (size_t i = 0; i < slotInputs.size(); i++) {
+        size_t row = slotInputs[i]->row();
+        if (row != 1 && row != docCount) {
+            AUTIL_LOG(ERROR, "input[%s] row[%lu] not equal 1 or doc count[%lu]",
+                      _inputNames[i].c_str(), row, docCount);
+            return false;
+        }
+    }
+    captureRequest(slotInputs, context);
+    FeatureFunctionContext chunkContext = context != nullptr ? *context : FeatureFunctionContext();
+    chunkContext.capture = nullptr;
+    // outputs of a chunk go to an arena of this call reset after the chunk,
+    // so the arenas of the caller do not grow with every chunk
+    autil::mem_pool::Pool chunkPool(CHUNK_POOL_SIZE);
+    if (chunkContext.featurePool != nullptr || chunkContext.workerFeaturePools != nullptr) {
+        chunkContext.featurePool = &chunkPool;
+        chunkContext.workerFeaturePools = nullptr;
+    }
+    const vector<uint64_t> *itemIds = chunkContext.itemIds;
+    if (itemIds != nullptr && itemIds->size() != docCount) {
+        AUTIL_LOG(WARN, "item id count[%lu] not equal doc count[%lu], ignored",
+                  itemIds->size(), docCount);
+        itemIds = nullptr;
+        chunkContext.itemIds = nullptr;
+    }
+    vector<uint64_t> chunkItemIds;
+    vector<Features*> outputs;
+    for (size_t begin = 0; begin < docCount; begin += chunkDocCount) {
+        size_t end = min(docCount, begin + chunkDocCount);
+        vector<unique_ptr<FeatureInput>> slices;
+        vector<FeatureInput*> chunkInputs = slotInputs;
+        if (end - begin < docCount) {
+            for (auto &input : chunkInputs) {
+                if (input->row() == docCount) {
+                    slices.emplace_back(input->slice(begin, end));
+                    input = slices.back().get();
+                }
+            }
+            if (itemIds != nullptr) {
+                chunkItemIds.assign(itemIds->begin() + begin, itemIds->begin() + end);
+                chunkContext.itemIds = &chunkItemIds;
+            }
+        }
+        TraceSpan span(chunkContext.tracer, "chunk", "plan");
+        span.setArg(0, "beginDoc", begin);
+        span.setArg(1, "docs", end - begin);
+        genFeatures(chunkInputs, &chunkContext, outputs, threadPool);
+        bool goOn = consumer(begin, outputs);
+        clearFeatures(outputs);
+        chunkPool.reset();
+        if (!goOn) {
+            AUTIL_LOG(INFO, "stopped by consumer at doc[%lu]", begin);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FeaturePlan::genFeatures(const NamedInputs &namedInputs,
+                              FeatureFunctionContext *context,
+                              vector<Features*> &outputs) const
+{
+    vector<FeatureInput*> slotInputs;
+    if (!resolveInputs(namedInputs, slotInputs)) {
+        return false;
+    }
+    return genFeatures(slotInputs, context, outputs);
+}
+
+void FeaturePlan::clearFeatures(vector<Features*> &outputs) {
+    for (auto features : outputs) {
+        delete features;
+    }
+    outputs.clear();
+}
+
+}
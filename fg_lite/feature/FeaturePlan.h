@@ -0,0 +1,161 @@
+#ifndef ISEARCH_FG_LITE_FEATUREPLAN_H
+#define ISEARCH_FG_LITE_FEATUREPLAN_H
+
+#include <functional>
+#include <unordered_map>
+#include "autil/Log.h"
+#include "fg_lite/feature/FeatureFunction.h"
+
+namespace fg_lite {
+
+class FeatureConfig;
+class WorkStealingThreadPool;
+struct CachedFeatureRow;
+
+/*
+ * owns all FeatureFunctions of a config, every distinct input expression
+ * is resolved to one input slot shared by all features depending on it.
+ */
+class FeaturePlan
+{
+public:
+    typedef std::unordered_map<std::string, FeatureInput*> NamedInputs;
+    // called with the first doc of a chunk and its outputs in feature order,
+    // return false to stop. outputs left in the vector are freed after it.
+    typedef std::function<bool(size_t beginDoc, std::vector<Features*> &outputs)> ChunkConsumer;
+    // side of the inputs a feature depends on, from the "user:", "item:"
+    // prefix of input names. query and context inputs count as user side.
+    enum FeatureScope {
+        FS_USER,
+        FS_ITEM,
+        FS_CROSS
+    };
+private:
+    struct FeatureNode {
+        FeatureFunction *function;
+        std::vector<size_t> inputSlots;
+        FeatureScope scope;
+        uint64_t cacheKey;
+    };
+public:
+    FeaturePlan();
+    ~FeaturePlan();
+private:
+    FeaturePlan(const FeaturePlan &);
+    FeaturePlan& operator=(const FeaturePlan &);
+public:
+    bool init(const FeatureConfig &featureConfig);
+    // take ownership of function. its item cache rows are only shared with
+    // this plan, features added by init share them by their config.
+    bool addFeature(FeatureFunction *function,
+                    const std::vector<std::string> &inputNames);
+public:
+    // slotInputs is indexed by input slot, outputs are in feature order,
+    // nullptr for features failed to generate. caller owns the outputs.
+    bool genFeatures(const std::vector<FeatureInput*> &slotInputs,
+                     FeatureFunctionContext *context,
+                     std::vector<Features*> &outputs) const;
+    bool genFeatures(const NamedInputs &namedInputs,
+                     FeatureFunctionContext *context,
+                     std::vector<Features*> &outputs) const;
+    // one task per feature, the calling thread joins and helps the pool,
+    // outputs keep the feature order. run serially if threadPool is nullptr.
+    // outputs go to context->workerFeaturePools if set, see FeatureFunctionContext.
+    bool genFeatures(const std::vector<FeatureInput*> &slotInputs,
+                     FeatureFunctionContext *context,
+                     std::vector<Features*> &outputs,
+                     WorkStealingThreadPool *threadPool) const;
+    // output of feature i is written into tensors[i] if it is not nullptr,
+    // see TensorBuffer. such features are not sharded.
+    bool genFeatures(const std::vector<FeatureInput*> &slotInputs,
+                     FeatureFunctionContext *context,
+                     const std::vector<TensorBuffer*> &tensors,
+                     std::vector<Features*> &outputs,
+                     WorkStealingThreadPool *threadPool = nullptr) const;
+    // docs are generated in chunks of chunkDocCount rows and every chunk is
+    // handed to consumer, so the outputs held at once stay bounded. inputs of
+    // one row are broadcast to every chunk, context->itemIds is sliced too.
+    // context->pool is not reset between chunks, consumer may reset it. if
+    // context->featurePool or workerFeaturePools is set, the outputs of every
+    // chunk are allocated in one arena of the call instead, which is reset
+    // after consumer returns, so consumer must not keep them.
+    bool genFeaturesChunked(const std::vector<FeatureInput*> &slotInputs,
+                            FeatureFunctionContext *context,
+                            size_t chunkDocCount,
+                            const ChunkConsumer &consumer,
+                            WorkStealingThreadPool *threadPool = nullptr) const;
+    // features over more than shardDocCount docs are split into doc range
+    // shards on threadPool, see DocRangeSharder. item only features take
+    // cached rows from context->itemCache instead, see ItemFeatureCache.
+    // recorded into context->metrics and context->tracer if set, see
+    // FeatureMetrics and RequestTracer.
+    Features *genFeature(size_t featureIdx,
+                         const std::vector<FeatureInput*> &slotInputs,
+                         FeatureFunctionContext *context,
+                         WorkStealingThreadPool *threadPool = nullptr) const;
+    bool resolveInputs(const NamedInputs &namedInputs,
+                       std::vector<FeatureInput*> &slotInputs) const;
+public:
+    size_t getFeatureCount() const { return _nodes.size(); }
+    const FeatureFunction *getFeatureFunction(size_t featureIdx) const {
+        return _nodes[featureIdx].function;
+    }
+    std::vector<std::string> getFeatureNames() const;
+    const std::vector<size_t> &getFeatureInputSlots(size_t featureIdx) const {
+        return _nodes[featureIdx].inputSlots;
+    }
+    FeatureScope getFeatureScope(size_t featureIdx) const {
+        return _nodes[featureIdx].scope;
+    }
+    static FeatureScope classifyInputs(const std::vector<std::string> &inputNames);
+    size_t getInputCount() const { return _inputNames.size(); }
+    const std::vector<std::string> &getInputNames() const { return _inputNames; }
+    // return -1 if input not exist
+    int32_t getInputSlot(const std::string &inputName) const;
+    // 0 means no sharding
+    void setShardDocCount(size_t shardDocCount) { _shardDocCount = shardDocCount; }
+    size_t getShardDocCount() const { return _shardDocCount; }
+    static void clearFeatures(std::vector<Features*> &outputs);
+private:
+    // configFingerprint goes into the item cache key of the feature
+    bool addFeature(FeatureFunction *function,
+                    const std::vector<std::string> &inputNames,
+                    uint64_t configFingerprint);
+    size_t addInput(const std::string &inputName);
+    // inputs of sampled requests go to context->capture, see RequestCaptureWriter
+    void captureRequest(const std::vector<FeatureInput*> &slotInputs,
+                        FeatureFunctionContext *context) const;
+    Features *doGenFeature(const FeatureNode &node,
+                           const std::vector<FeatureInput*> &slotInputs,
+                           FeatureFunctionContext *context,
+                           WorkStealingThreadPool *threadPool) const;
+    // pool bytes are those taken from context->pool and context->featurePool
+    // meanwhile. they are only recorded on the serial path, where no other
+    // feature allocates from the shared pools, and are 0 in parallel runs.
+    // outputs in their own pools (no featurePool) are not counted
+    Features *genMeasuredFeature(size_t featureIdx,
+                                 const std::vector<FeatureInput*> &slotInputs,
+                                 FeatureFunctionContext *context,
+                                 WorkStealingThreadPool *threadPool) const;
+    Features *genCachedItemFeature(const FeatureNode &node,
+                                   const std::vector<FeatureInput*> &inputs,
+                                   FeatureFunctionContext *context) const;
+    // put docs [begin, end) of items, generated as features, into the cache
+    bool cacheItemRows(const FeatureNode &node, Features *features,
+                       size_t begin, size_t end, FeatureFunctionContext *context,
+                       std::vector<std::shared_ptr<const CachedFeatureRow>> &rows) const;
+    void clear();
+private:
+    std::vector<FeatureNode> _nodes;
+    std::vector<std::string> _inputNames;
+    std::unordered_map<std::string, size_t> _inputSlots;
+    size_t _shardDocCount;
+    // unique in the process, fingerprint of features added without a config
+    uint64_t _planId;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_FEATUREPLAN_H
@@ -0,0 +1,72 @@
+#include "fg_lite/feature/HashedFeatureFunction.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, HashedFeatureFunction);
+
+HashedFeatureFunction::HashedFeatureFunction(FeatureFunction *function)
+    : FeatureFunction(function->getFeatureName())
+    , _function(function)
+{
+    setHashOutput(true);
+    setCompactOutput(function->isCompactOutput());
+}
+
+HashedFeatureFunction::~HashedFeatureFunction() {
+    delete _function;
+}
+
+Features *HashedFeatureFunction::genFeatures(const vector<FeatureInput*> &inputs,
+        FeatureFunctionContext *context) const
+{
+    Features *features = _function->genFeatures(inputs, context);
+    if (getTensorBuffer(context) != nullptr) {
+        return hashFeatures<TensorSparseFeatures>(features, context);
+    }
+    return hashFeatures<MultiHashedSparseFeatures>(features, context);
+}
+
+Features *HashedFeatureFunction::hashFeatures(Features *features) {
+    return hashFeatures<MultiHashedSparseFeatures>(features, nullptr);
+}
+
+template <typename FeaturesType>
+Features *HashedFeatureFunction::hashFeatures(Features *features,
+        FeatureFunctionContext *context)
+{
+    if (features == nullptr) {
+        return nullptr;
+    }
+    if (features->getFeatureValueType() == FVT_MULTI_SPARSE) {
+        auto typed = static_cast<MultiSparseFeatures*>(features);
+        const auto &keys = typed->_featureNames;
+        const auto &offsets = typed->_offsets;
+        auto hashed = createFeatures<FeaturesType>(offsets.size(), context);
+        for (size_t i = 0; i < offsets.size(); i++) {
+            hashed->beginDocument();
+            size_t end = i + 1 < offsets.size() ? offsets[i + 1] : keys.size();
+            for (size_t j = offsets[i]; j < end; j++) {
+                hashed->addFeatureKey(keys[j].data(), keys[j].size());
+            }
+        }
+        delete features;
+        return hashed;
+    }
+    if (features->getFeatureValueType() == FVT_SINGLE_SPARSE) {
+        auto typed = static_cast<SingleSparseFeatures*>(features);
+        const auto &keys = typed->_featureNames;
+        auto hashed = createFeatures<FeaturesType>(keys.size(), context);
+        for (const auto &key : keys) {
+            hashed->beginDocument();
+            hashed->addFeatureKey(key.data(), key.size());
+        }
+        delete features;
+        return hashed;
+    }
+    AUTIL_LOG(DEBUG, "feature value type[%d] has no string keys, not hashed",
+              (int)features->getFeatureValueType());
+    return features;
+}
+
+}
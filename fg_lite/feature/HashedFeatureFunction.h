@@ -0,0 +1,50 @@
+#ifndef ISEARCH_FG_LITE_HASHEDFEATUREFUNCTION_H
+#define ISEARCH_FG_LITE_HASHEDFEATUREFUNCTION_H
+
+#include "autil/Log.h"
+#include "fg_lite/feature/FeatureFunction.h"
+
+namespace fg_lite {
+
+/*
+ * hash output for functions that only format string keys, sparse keys of the
+ * wrapped function are hashed into MultiHashedSparseFeatures, or the tensor of
+ * the context if any, other outputs are passed through. ids equal the ones of
+ * functions hashing natively.
+ */
+class HashedFeatureFunction : public FeatureFunction
+{
+public:
+    // take ownership of function
+    HashedFeatureFunction(FeatureFunction *function);
+    ~HashedFeatureFunction();
+private:
+    HashedFeatureFunction(const HashedFeatureFunction &);
+    HashedFeatureFunction& operator=(const HashedFeatureFunction &);
+public:
+    Features *genFeatures(const std::vector<FeatureInput*> &inputs,
+                          FeatureFunctionContext *context) const override;
+    size_t getInputCount() const override {
+        return _function->getInputCount();
+    }
+    bool supportDictionaryInput() const override {
+        return _function->supportDictionaryInput();
+    }
+    bool supportCompactOutput() const override {
+        return _function->supportCompactOutput();
+    }
+public:
+    // take ownership of features
+    static Features *hashFeatures(Features *features);
+private:
+    template <typename FeaturesType>
+    static Features *hashFeatures(Features *features, FeatureFunctionContext *context);
+private:
+    FeatureFunction *_function;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_HASHEDFEATUREFUNCTION_H
@@ -27,58 +27,117 @@ Features *IdFeatureFunction::genFeatures(const vector<FeatureInput*> &inputs,
         return nullptr;
     }
     FeatureInput *input = inputs[0];
-#define CASE(t)                                                         \
-    case t: {                                                           \
-        typedef InputType2Type<t>::Type Type;                           \
-        if (input->storageType() == IST_DENSE) {                        \
-            return genFeatures<Type, DenseStorage<Type>>(input);        \
-        } else if (input->storageType() == IST_SPARSE_MULTI_VALUE) {    \
-            return genFeatures<Type, MultiValueStorage<Type>>(input);   \
-        } else {                                                        \
-            return genFeatures<Type, ValueOffsetStorage<Type>>(input);  \
-        }                                                               \
-    }                                                                   \
-        break
-    switch (input->dataType()) {
-        INPUT_DATA_TYPE_MACRO_HELPER(CASE);
-    default:
+    Features *features = nullptr;
+    bool supported = visitTypedInput(input, [&](auto *typedInput) {
+                features = this->genFeatures(typedInput, context);
+            });
+    if (!supported) {
         AUTIL_LOG(ERROR, "IdFeature[%s] input type[%d] not support",
                   getFeatureName().c_str(), input->dataType());
-        return nullptr;
     }
-#undef CASE
-};
+    return features;
+}
 
-template <typename T, typename StorageType>
-Features *IdFeatureFunction::genFeatures(FeatureInput *input) const {
-    typedef FeatureInputTyped<T, StorageType> FeatureInputTyped;
-    FeatureInputTyped *typedInput = dynamic_cast<FeatureInputTyped*>(input);
-    if (!typedInput) {
-        return nullptr;
+template <typename TypedFeatureInput>
+Features *IdFeatureFunction::genFeatures(TypedFeatureInput *input,
+        FeatureFunctionContext *context) const
+{
+    if (!isHashOutput()) {
+        return genFeaturesTyped<TypedFeatureInput, MultiSparseFeatures>(input, context);
     }
+    if (getTensorBuffer(context) != nullptr) {
+        return genFeaturesTyped<TypedFeatureInput, TensorSparseFeatures>(input, context);
+    }
+    return genFeaturesTyped<TypedFeatureInput, MultiHashedSparseFeatures>(input, context);
+}
 
-    MultiSparseFeatures *features = new MultiSparseFeatures(typedInput->row());
-#define GEN_FEATURES(fun)                               \
-    for (size_t i = 0; i < typedInput->row(); i++) {    \
-        features->beginDocument();                      \
-        fun(typedInput, features, i);                   \
-    }                                                   \
+template <typename TypedFeatureInput, typename FeaturesType>
+Features *IdFeatureFunction::genFeaturesTyped(TypedFeatureInput *input,
+        FeatureFunctionContext *context) const
+{
+    FeaturesType *features = createFeatures<FeaturesType>(input->row(), context);
+    input->visitRows([&](size_t, const typename TypedFeatureInput::RowType &values) {
+                features->beginDocument();
+                genSimpleFeatures(values, features);
+            });
+    return features;
+}
 
-    GEN_FEATURES(genSimpleFeatures);
+template <typename T>
+Features *IdFeatureFunction::genFeatures(FeatureInputTyped<T, DictionaryStorage<T>> *input,
+        FeatureFunctionContext *context) const
+{
+    auto hashKey = [this](const T &value) { return hashDictionaryKey(value); };
+    if (!isHashOutput()) {
+        MultiSparseFeatures *features = createFeatures<MultiSparseFeatures>(input->row(), context);
+        return genDictionaryFeatures(input, features, [this, features](const T &value) {
+                    return writeFeatureKey(features, value);
+                });
+    }
+    if (getTensorBuffer(context) != nullptr) {
+        return genDictionaryFeatures(input,
+                createFeatures<TensorSparseFeatures>(input->row(), context), hashKey);
+    }
+    return genDictionaryFeatures(input,
+            createFeatures<MultiHashedSparseFeatures>(input->row(), context), hashKey);
+}
 
+// every dictionary value is checked and formatted or hashed once, rows emit by code
+template <typename T, typename FeaturesType, typename MakeKey>
+Features *IdFeatureFunction::genDictionaryFeatures(
+        const FeatureInputTyped<T, DictionaryStorage<T>> *input,
+        FeaturesType *features, const MakeKey &makeKey) const
+{
+    typedef decltype(makeKey(std::declval<const T&>())) KeyType;
+    const DictionaryStorage<T> &storage = input->getStorage();
+    const T *dictionary = storage.getDictionary();
+    vector<KeyType> keys(storage.dictionarySize());
+    vector<uint8_t> valid(storage.dictionarySize());
+    for (size_t i = 0; i < keys.size(); i++) {
+        valid[i] = !FeatureFormatter::isInvalidValue(dictionary[i]) && !isInvalid(dictionary[i]);
+        if (valid[i]) {
+            keys[i] = makeKey(dictionary[i]);
+        }
+    }
+    input->visitRows([&](size_t, const DictionaryRow<T> &values) {
+                features->beginDocument();
+                size_t count = min(size_t(values.size()), size_t(_pruneTo));
+                const uint32_t *codes = values.codes();
+                for (size_t j = 0; j < count; j++) {
+                    if (valid[codes[j]]) {
+                        addDictionaryKey(features, keys[codes[j]]);
+                    }
+                }
+            });
     return features;
 }
 
-template <typename TypedFeatureInput>
-void IdFeatureFunction::genSimpleFeatures(TypedFeatureInput *input, MultiSparseFeatures *features, int row) const {
-    for (size_t j = 0; j < min(input->col(row), size_t(_pruneTo)); j++) {
-        auto value = input->get(row, j);
+template <typename T>
+uint64_t IdFeatureFunction::hashDictionaryKey(const T &value) const {
+    FeatureHasher hasher(getPrefixHasher());
+    hasher.updateValue(value);
+    return hasher.finish();
+}
+
+template <typename RowType, typename FeaturesType>
+void IdFeatureFunction::genSimpleFeatures(const RowType &values, FeaturesType *features) const {
+    size_t count = min(size_t(values.size()), size_t(_pruneTo));
+    if (hasValidity(values)) {
+        // nulls come from the validity, values are not compared to sentinels
+        forEachValid(values, count, [&](size_t j) {
+                    const auto &value = values[j];
+                    if (!isInvalid(value)) {
+                        addFeatureKey(features, value);
+                    }
+                });
+        return;
+    }
+    for (size_t j = 0; j < count; j++) {
+        const auto &value = values[j];
         if (FeatureFormatter::isInvalidValue(value) || isInvalid(value)) {
             continue;
         }
-        FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-        FeatureFormatter::fillFeatureToBuffer(value, buffer);
-        features->addFeatureKey(buffer.data(), buffer.size());
+        addFeatureKey(features, value);
     }
 }
 
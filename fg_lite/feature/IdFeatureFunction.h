@@ -22,12 +22,36 @@ public:
     size_t getInputCount() const override {
         return 1;
     }
+    bool supportHashOutput() const override {
+        return true;
+    }
+    bool supportDictionaryInput() const override {
+        return true;
+    }
 private:
-    template <typename T, typename StorageTtype>
-    Features *genFeatures(FeatureInput *input) const;
-
     template <typename TypedFeatureInput>
-    void genSimpleFeatures(TypedFeatureInput *input, MultiSparseFeatures *features, int row) const;
+    Features *genFeatures(TypedFeatureInput *input, FeatureFunctionContext *context) const;
+    template <typename T>
+    Features *genFeatures(FeatureInputTyped<T, DictionaryStorage<T>> *input,
+                          FeatureFunctionContext *context) const;
+    // makeKey formats a dictionary value into the pool of features or hashes it
+    template <typename T, typename FeaturesType, typename MakeKey>
+    Features *genDictionaryFeatures(const FeatureInputTyped<T, DictionaryStorage<T>> *input,
+                                    FeaturesType *features, const MakeKey &makeKey) const;
+    template <typename T>
+    uint64_t hashDictionaryKey(const T &value) const;
+    static void addDictionaryKey(MultiSparseFeatures *features, const autil::ConstString &key) {
+        features->addSharedFeatureKey(key);
+    }
+    template <typename FeaturesType>
+    static void addDictionaryKey(FeaturesType *features, uint64_t key) {
+        features->addFeatureHash(key);
+    }
+    template <typename TypedFeatureInput, typename FeaturesType>
+    Features *genFeaturesTyped(TypedFeatureInput *input, FeatureFunctionContext *context) const;
+
+    template <typename RowType, typename FeaturesType>
+    void genSimpleFeatures(const RowType &values, FeaturesType *features) const;
     template <typename TypedFeatureInput>
     void genRankFeatures(TypedFeatureInput *input, MultiSparseFeatures *features, int row) const;
     template <typename TypedFeatureInput>
@@ -0,0 +1,266 @@
+#include "fg_lite/feature/ItemFeatureCache.h"
+#include "fg_lite/feature/BroadcastFeatureCache.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, ItemFeatureCache);
+
+size_t CachedFeatureRow::getMemoryUse() const {
+    size_t memoryUse = sizeof(*this) + hashes.size() * sizeof(uint64_t)
+                       + values.size() * sizeof(float) + integers.size() * sizeof(int64_t);
+    for (const auto &key : keys) {
+        memoryUse += sizeof(key) + key.size();
+    }
+    return memoryUse;
+}
+
+ItemFeatureCache::ItemFeatureCache(size_t memoryLimit, int64_t ttlUs, size_t shardCount)
+    : _collisionCount(0)
+{
+    shardCount = max(shardCount, (size_t)1);
+    for (size_t i = 0; i < shardCount; i++) {
+        _shards.emplace_back(new BroadcastFeatureCache(memoryLimit / shardCount, ttlUs));
+    }
+}
+
+ItemFeatureCache::~ItemFeatureCache() {
+}
+
+uint64_t ItemFeatureCache::makeFeatureKey(const string &featureName, uint64_t configFingerprint) {
+    FeatureHasher hasher;
+    hasher.update(featureName.data(), featureName.size());
+    hasher.updateBinary(configFingerprint);
+    return hasher.finish();
+}
+
+uint64_t ItemFeatureCache::makeKey(uint64_t featureKey, uint64_t itemId) {
+    FeatureHasher hasher;
+    hasher.updateBinary(featureKey);
+    hasher.updateBinary(itemId);
+    return hasher.finish();
+}
+
+shared_ptr<const CachedFeatureRow> ItemFeatureCache::get(uint64_t featureKey, uint64_t itemId) {
+    uint64_t key = makeKey(featureKey, itemId);
+    auto row = getShard(key)->get<CachedFeatureRow>(key);
+    if (row && (row->featureKey != featureKey || row->itemId != itemId)) {
+        AUTIL_LOG(DEBUG, "row of item[%lu] found for item[%lu], hash collision",
+                  row->itemId, itemId);
+        _collisionCount.fetch_add(1, memory_order_relaxed);
+        return nullptr;
+    }
+    return row;
+}
+
+void ItemFeatureCache::put(const shared_ptr<const CachedFeatureRow> &row) {
+    uint64_t key = makeKey(row->featureKey, row->itemId);
+    getShard(key)->put<CachedFeatureRow>(key, row, row->getMemoryUse());
+}
+
+void ItemFeatureCache::clear() {
+    for (auto &shard : _shards) {
+        shard->clear();
+    }
+}
+
+template <typename T, typename ValueType, typename RowValueType>
+static void copyRow(const T *features, const pool_vector<ValueType> &values,
+                    size_t docId, vector<RowValueType> &row)
+{
+    size_t begin = features->_offsets[docId];
+    size_t end = docId + 1 < features->_offsets.size() ?
+                 features->_offsets[docId + 1] : values.size();
+    row.assign(values.begin() + begin, values.begin() + end);
+}
+
+bool ItemFeatureCache::extractRow(Features *features, size_t docId, size_t docCount,
+                                  CachedFeatureRow &row)
+{
+    row.type = features->getFeatureValueType();
+    switch (row.type) {
+    case FVT_MULTI_SPARSE: {
+        auto typed = static_cast<MultiSparseFeatures*>(features);
+        if (typed->count() != docCount) {
+            return false;
+        }
+        size_t begin = typed->_offsets[docId];
+        size_t end = docId + 1 < docCount ?
+                     typed->_offsets[docId + 1] : typed->_featureNames.size();
+        row.keys.clear();
+        for (size_t i = begin; i < end; i++) {
+            const auto &key = typed->_featureNames[i];
+            row.keys.emplace_back(key.data(), key.size());
+        }
+        return true;
+    }
+    case FVT_MULTI_HASHED_SPARSE: {
+        auto typed = static_cast<MultiHashedSparseFeatures*>(features);
+        if (typed->count() != docCount) {
+            return false;
+        }
+        copyRow(typed, typed->_featureHashes, docId, row.hashes);
+        return true;
+    }
+    case FVT_MULTI_DENSE: {
+        auto typed = static_cast<MultiDenseFeatures*>(features);
+        if (typed->count() != docCount) {
+            return false;
+        }
+        copyRow(typed, typed->_featureValues, docId, row.values);
+        return true;
+    }
+    case FVT_MULTI_SPARSE_INT: {
+        auto typed = static_cast<MultiIntegerFeatures*>(features);
+        if (typed->count() != docCount) {
+            return false;
+        }
+        copyRow(typed, typed->_featureValues, docId, row.integers);
+        return true;
+    }
+    case FVT_MULTI_SPARSE_INT32: {
+        auto typed = static_cast<MultiInt32Features*>(features);
+        if (typed->count() != docCount) {
+            return false;
+        }
+        copyRow(typed, typed->_featureValues, docId, row.integers);
+        return true;
+    }
+    case FVT_MULTI_SPARSE_INT16: {
+        auto typed = static_cast<MultiInt16Features*>(features);
+        if (typed->count() != docCount) {
+            return false;
+        }
+        copyRow(typed, typed->_featureValues, docId, row.integers);
+        return true;
+    }
+    case FVT_SINGLE_DENSE: {
+        // dense inputs of dimension d give d values per doc
+        auto typed = static_cast<SingleDenseFeatures*>(features);
+        if (docCount == 0 || typed->count() % docCount != 0) {
+            return false;
+        }
+        size_t dim = typed->count() / docCount;
+        auto begin = typed->_featureValues.begin() + docId * dim;
+        row.values.assign(begin, begin + dim);
+        return true;
+    }
+    default:
+        AUTIL_LOG(DEBUG, "features of type[%d] not cached", int(row.type));
+        return false;
+    }
+}
+
+Features *ItemFeatureCache::createFeatures(FeatureValueType type,
+        const string &featureName, size_t reserveSize, autil::mem_pool::Pool *pool)
+{
+    switch (type) {
+    case FVT_MULTI_SPARSE:
+        return new MultiSparseFeatures(reserveSize, pool);
+    case FVT_MULTI_HASHED_SPARSE:
+        return new MultiHashedSparseFeatures(reserveSize, pool);
+    case FVT_MULTI_DENSE:
+        return new MultiDenseFeatures(featureName, reserveSize, pool);
+    case FVT_MULTI_SPARSE_INT:
+        return new MultiIntegerFeatures(featureName, reserveSize, pool);
+    case FVT_MULTI_SPARSE_INT32:
+        return new MultiInt32Features(featureName, reserveSize, pool);
+    case FVT_MULTI_SPARSE_INT16:
+        return new MultiInt16Features(featureName, reserveSize, pool);
+    case FVT_SINGLE_DENSE:
+        return new SingleDenseFeatures(featureName, reserveSize, pool);
+    default:
+        return nullptr;
+    }
+}
+
+// extracted from values of T, so they fit
+template <typename T>
+static void appendIntegerRow(const CachedFeatureRow &row, MultiIntegerFeaturesTyped<T> *features) {
+    features->beginDocument();
+    for (int64_t value : row.integers) {
+        features->addFeatureValue(value);
+    }
+}
+
+void ItemFeatureCache::appendRow(const CachedFeatureRow &row, Features *features) {
+    switch (row.type) {
+    case FVT_MULTI_SPARSE: {
+        auto typed = static_cast<MultiSparseFeatures*>(features);
+        typed->beginDocument();
+        for (const auto &key : row.keys) {
+            typed->addFeatureKey(key.data(), key.size());
+        }
+        break;
+    }
+    case FVT_MULTI_HASHED_SPARSE: {
+        auto typed = static_cast<MultiHashedSparseFeatures*>(features);
+        typed->beginDocument();
+        typed->_featureHashes.insert(typed->_featureHashes.end(),
+                row.hashes.begin(), row.hashes.end());
+        break;
+    }
+    case FVT_MULTI_DENSE: {
+        auto typed = static_cast<MultiDenseFeatures*>(features);
+        typed->beginDocument();
+        typed->_featureValues.insert(typed->_featureValues.end(),
+                row.values.begin(), row.values.end());
+        break;
+    }
+    case FVT_MULTI_SPARSE_INT: {
+        auto typed = static_cast<MultiIntegerFeatures*>(features);
+        typed->beginDocument();
+        typed->_featureValues.insert(typed->_featureValues.end(),
+                row.integers.begin(), row.integers.end());
+        break;
+    }
+    case FVT_MULTI_SPARSE_INT32:
+        appendIntegerRow(row, static_cast<MultiInt32Features*>(features));
+        break;
+    case FVT_MULTI_SPARSE_INT16:
+        appendIntegerRow(row, static_cast<MultiInt16Features*>(features));
+        break;
+    case FVT_SINGLE_DENSE: {
+        auto typed = static_cast<SingleDenseFeatures*>(features);
+        typed->_featureValues.insert(typed->_featureValues.end(),
+                row.values.begin(), row.values.end());
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+size_t ItemFeatureCache::size() const {
+    size_t size = 0;
+    for (const auto &shard : _shards) {
+        size += shard->size();
+    }
+    return size;
+}
+
+size_t ItemFeatureCache::getMemoryUse() const {
+    size_t memoryUse = 0;
+    for (const auto &shard : _shards) {
+        memoryUse += shard->getMemoryUse();
+    }
+    return memoryUse;
+}
+
+size_t ItemFeatureCache::getHitCount() const {
+    size_t hitCount = 0;
+    for (const auto &shard : _shards) {
+        hitCount += shard->getHitCount();
+    }
+    return hitCount - _collisionCount.load(memory_order_relaxed);
+}
+
+size_t ItemFeatureCache::getMissCount() const {
+    size_t missCount = 0;
+    for (const auto &shard : _shards) {
+        missCount += shard->getMissCount();
+    }
+    return missCount + _collisionCount.load(memory_order_relaxed);
+}
+
+}
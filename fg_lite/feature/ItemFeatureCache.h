@@ -0,0 +1,85 @@
+#ifndef ISEARCH_FG_LITE_ITEMFEATURECACHE_H
+#define ISEARCH_FG_LITE_ITEMFEATURECACHE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "autil/Log.h"
+#include "fg_lite/feature/Feature.h"
+
+namespace fg_lite {
+
+class BroadcastFeatureCache;
+
+// one doc of a Features, copied out so it outlives the Features.
+// only the vector matching type is used, int32 and int16 values are kept as int64.
+// featureKey and itemId tell the row apart from others of the same hash.
+struct CachedFeatureRow {
+    uint64_t featureKey = 0;
+    uint64_t itemId = 0;
+    FeatureValueType type;
+    std::vector<std::string> keys;
+    std::vector<uint64_t> hashes;
+    std::vector<float> values;
+    std::vector<int64_t> integers;
+public:
+    size_t getMemoryUse() const;
+};
+
+/*
+ * rows of item only features shared across requests, keyed by feature name,
+ * config fingerprint and item id. items are spread over shards by key, every
+ * shard is an LRU (see BroadcastFeatureCache) with its own lock and an equal
+ * part of the memory limit, so hot items of concurrent requests rarely contend.
+ * rows are found by the hash of their key, a row of another key under the
+ * same hash is a miss.
+ */
+class ItemFeatureCache
+{
+public:
+    // ttlUs <= 0 means rows never expire
+    ItemFeatureCache(size_t memoryLimit, int64_t ttlUs, size_t shardCount = 16);
+    ~ItemFeatureCache();
+private:
+    ItemFeatureCache(const ItemFeatureCache &);
+    ItemFeatureCache& operator=(const ItemFeatureCache &);
+public:
+    // configFingerprint tells apart features of the same name built from
+    // different configs, so plans of several configs may share one cache
+    static uint64_t makeFeatureKey(const std::string &featureName, uint64_t configFingerprint);
+    std::shared_ptr<const CachedFeatureRow> get(uint64_t featureKey, uint64_t itemId);
+    // keyed by row->featureKey and row->itemId
+    void put(const std::shared_ptr<const CachedFeatureRow> &row);
+    void clear();
+public:
+    // copy doc docId of features generated for docCount docs, return false
+    // if the type of features can not be split into docs
+    static bool extractRow(Features *features, size_t docId, size_t docCount,
+                           CachedFeatureRow &row);
+    static Features *createFeatures(FeatureValueType type, const std::string &featureName,
+                                    size_t reserveSize,
+                                    autil::mem_pool::Pool *pool = nullptr);
+    // features must be created by createFeatures with the type of row
+    static void appendRow(const CachedFeatureRow &row, Features *features);
+public:
+    size_t size() const;
+    size_t getMemoryUse() const;
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+private:
+    BroadcastFeatureCache *getShard(uint64_t key) const {
+        return _shards[key % _shards.size()].get();
+    }
+    static uint64_t makeKey(uint64_t featureKey, uint64_t itemId);
+private:
+    std::vector<std::unique_ptr<BroadcastFeatureCache>> _shards;
+    // hits of the shards which turned out to be rows of another key
+    std::atomic<size_t> _collisionCount;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_ITEMFEATURECACHE_H
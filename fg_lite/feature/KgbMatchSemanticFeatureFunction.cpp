@@ -59,7 +59,7 @@ Features *KgbMatchSemanticFeatureFunction::genFeatures(const std::vector<Feature
                         qTermListInput->storageType(), iTermListInput->storageType()); \
                 return nullptr; \
             } \
-            return MatchSemanticTyped(dynamic_cast<const FeatureInputTyped<QT, DenseStorage<QT>>*>(qTermListInput), \
+            return MatchSemanticTyped(context, dynamic_cast<const FeatureInputTyped<QT, DenseStorage<QT>>*>(qTermListInput), \
                     dynamic_cast<const FeatureInputTyped<IQT, DenseStorage<IQT>>*>(iTermListInput), \
                     dynamic_cast<const FeatureInputTyped<IQT, DenseStorage<IQT>>*>(otherInput)); \
         } else if (qTermListInput->storageType() == IST_SPARSE_MULTI_VALUE) { \
@@ -68,7 +68,7 @@ Features *KgbMatchSemanticFeatureFunction::genFeatures(const std::vector<Feature
                         qTermListInput->storageType(), iTermListInput->storageType()); \
                 return nullptr; \
             } \
-            return MatchSemanticTyped(dynamic_cast<const FeatureInputTyped<QT, MultiValueStorage<QT>>*>(qTermListInput), \
+            return MatchSemanticTyped(context, dynamic_cast<const FeatureInputTyped<QT, MultiValueStorage<QT>>*>(qTermListInput), \
                     dynamic_cast<const FeatureInputTyped<IQT, MultiValueStorage<IQT>>*>(iTermListInput), \
                     dynamic_cast<const FeatureInputTyped<IQT, MultiValueStorage<IQT>>*>(otherInput)); \
         } else { \
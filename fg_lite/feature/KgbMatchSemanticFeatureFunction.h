@@ -71,6 +71,8 @@ typedef std::vector<uint64_t> ULongList;
 typedef std::vector<std::string> StrList;
 typedef std::vector<uint64_t> TermList;
 typedef std::vector<uint32_t> IdList;
+typedef pool_vector<uint64_t> PoolTermList;
+typedef pool_vector<uint32_t> PoolIdList;
 
 class KgbMatchSemanticFeatureFunction : public FeatureFunction {
 public:
@@ -91,9 +93,25 @@ public:
     // 实际上两个TermType最终都必须是UINT64!
     template<typename QTermType, typename ITermType, template<typename> class StorageType>
     Features* MatchSemanticTyped(
+            FeatureFunctionContext *context,
             const FeatureInputTyped<QTermType, StorageType<QTermType>> *qTermList,
             const FeatureInputTyped<ITermType, StorageType<ITermType>> *iTermList,
             const FeatureInputTyped<ITermType, StorageType<ITermType>> *otherList = nullptr) const {
+        if (isHashOutput()) {
+            if (getTensorBuffer(context) != nullptr) {
+                return MatchSemanticTyped<TensorSparseFeatures>(context, qTermList, iTermList, otherList);
+            }
+            return MatchSemanticTyped<MultiHashedSparseFeatures>(context, qTermList, iTermList, otherList);
+        }
+        return MatchSemanticTyped<MultiSparseFeatures>(context, qTermList, iTermList, otherList);
+    }
+
+    template<typename FeaturesType, typename QTermType, typename ITermType, template<typename> class StorageType>
+    Features* MatchSemanticTyped(
+            FeatureFunctionContext *context,
+            const FeatureInputTyped<QTermType, StorageType<QTermType>> *qTermList,
+            const FeatureInputTyped<ITermType, StorageType<ITermType>> *iTermList,
+            const FeatureInputTyped<ITermType, StorageType<ITermType>> *otherList) const {
         if (qTermList == nullptr || iTermList == nullptr) {
             AUTIL_LOG(ERROR, "qTermList(%p) or iTermList(%p) is nullptr", qTermList, iTermList);
             return nullptr;
@@ -103,24 +121,37 @@ public:
             AUTIL_LOG(ERROR, "the row count of qTermList must be 1");
             return nullptr;
         }
+        size_t itermRows = iTermList->row();
+        auto features = createFeatures<FeaturesType>(itermRows, context);
+        autil::mem_pool::UnsafePool localPool(1024);
+        auto pool = getScratchPool(context, &localPool);
+        autil::mem_pool::pool_allocator<uint64_t> termAlloc(pool);
+        autil::mem_pool::pool_allocator<PoolTermList> tableAlloc(pool);
+
         size_t qterms = qTermList->col(0);
-        ULongList query_term_list(qterms);
+        PoolTermList query_term_list(qterms, 0, termAlloc);
         for (size_t i = 0; i < qterms; ++i) {
             uint64_t curTerm = 0;
             ConvertToUint64(qTermList->get(0, i), curTerm);
             query_term_list[i] = curTerm;
         }
 
-        ULongList matched_term_list;
-        ULongList unmatched_term_list;
-        TermList matched_term_list_table[CLASS_MAX_SIZE];
-        TermList unmatched_term_list_table[CLASS_MAX_SIZE];
+        PoolTermList matched_term_list(termAlloc);
+        PoolTermList unmatched_term_list(termAlloc);
+        matched_term_list.reserve(qterms);
+        unmatched_term_list.reserve(qterms);
+        pool_vector<PoolTermList> matched_term_list_table(
+                CLASS_MAX_SIZE, PoolTermList(termAlloc), tableAlloc);
+        pool_vector<PoolTermList> unmatched_term_list_table(
+                CLASS_MAX_SIZE, PoolTermList(termAlloc), tableAlloc);
         FgLiteBytes terms_bytes;
 
-        size_t itermRows = iTermList->row();
-        std::vector<StrList> otherIds;
-        auto features = new MultiSparseFeatures(itermRows);
-        NestedUIntVector item_term_list(CLASS_MAX_SIZE);
+        // ids of doc i are otherIds[otherOffsets[i], otherOffsets[i + 1])
+        pool_vector<autil::ConstString> otherIds{autil::mem_pool::pool_allocator<autil::ConstString>(pool)};
+        pool_vector<size_t> otherOffsets{autil::mem_pool::pool_allocator<size_t>(pool)};
+        autil::mem_pool::pool_allocator<uint32_t> idAlloc(pool);
+        pool_vector<PoolIdList> item_term_list(CLASS_MAX_SIZE, PoolIdList(idAlloc),
+                autil::mem_pool::pool_allocator<PoolIdList>(pool));
         if (_needCombo) {
             if (otherList == nullptr) {
                 AUTIL_LOG(ERROR, "otherList(%p) is nullptr when _needCombo is true", otherList);
@@ -133,13 +164,13 @@ public:
                 return nullptr;
             }
             
-            std::string curStrId = "";
-            otherIds.resize(itermRows);
+            otherOffsets.reserve(itermRows + 1);
+            otherOffsets.push_back(0);
             for (size_t i = 0; i < itermRows; ++i) {
                 for (size_t j = 0; j < otherList->col(i); ++j) {
-                    ConvertToString(otherList->get(i, j), curStrId);
-                    otherIds[i].push_back(curStrId);
+                    otherIds.push_back(ConvertToConstString(otherList->get(i, j), pool));
                 }
+                otherOffsets.push_back(otherIds.size());
             }
         }
         // get term list from item data:
@@ -147,8 +178,9 @@ public:
             int hitResult = 0;
             features->beginDocument();
 
-            item_term_list.clear();
-            item_term_list.resize(CLASS_MAX_SIZE);
+            for (auto& val: item_term_list) {
+                val.clear();
+            }
             for (size_t j = 0; j < iTermList->col(i); ++j) {
                 uint64_t curTerm = 0; 
                 ConvertToUint64(iTermList->get(i, j), curTerm);
@@ -183,32 +215,24 @@ public:
                 }
             }
 
+            size_t otherBegin = _needCombo ? otherOffsets[i] : 0;
+            size_t otherEnd = _needCombo ? otherOffsets[i + 1] : 0;
             if (_needHitRet) {
                 int match_size = matched_term_list_table[CLASS_BRAND].size();
                 int unmatch_size = unmatched_term_list_table[CLASS_BRAND].size();
                 hitResult = (match_size != 0) ? 0 : (unmatch_size != 0 ? 1 : 2);
                 if (_needCombo) {
                     if (_comboRight) {
-                        for (auto& otherId: otherIds[i]) {
-                            FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                            FeatureFormatter::fillFeatureToBuffer(hitResult, buffer);
-                            FeatureFormatter::fillFeatureToBuffer(kComboSplitToken, buffer);
-                            FeatureFormatter::fillFeatureToBuffer(otherId, buffer);
-                            features->addFeatureKey(buffer.data(), buffer.size());
+                        for (size_t k = otherBegin; k < otherEnd; ++k) {
+                            addFeatureKey(features, hitResult, kComboSplitToken, otherIds[k]);
                         }
                     } else {
-                        for (auto& otherId: otherIds[i]) {
-                            FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                            FeatureFormatter::fillFeatureToBuffer(otherId, buffer);
-                            FeatureFormatter::fillFeatureToBuffer(kComboSplitToken, buffer);
-                            FeatureFormatter::fillFeatureToBuffer(hitResult, buffer);
-                            features->addFeatureKey(buffer.data(), buffer.size());
+                        for (size_t k = otherBegin; k < otherEnd; ++k) {
+                            addFeatureKey(features, otherIds[k], kComboSplitToken, hitResult);
                         }
                     }
                 } else {
-                    FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                    FeatureFormatter::fillFeatureToBuffer(hitResult, buffer);
-                    features->addFeatureKey(buffer.data(), buffer.size());
+                    addFeatureKey(features, hitResult);
                 }
                 // 不需要再走其他逻辑了！
                 continue;
@@ -220,51 +244,31 @@ public:
                 }
                 if (_needCombo) {
                     if (_comboRight) {
-                        for (auto& otherId: otherIds[i]) {
-                            FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                            FeatureFormatter::fillFeatureToBuffer(terms_bytes.GetStr(), buffer);
-                            FeatureFormatter::fillFeatureToBuffer(kComboSplitToken, buffer);
-                            FeatureFormatter::fillFeatureToBuffer(otherId, buffer);
-                            features->addFeatureKey(buffer.data(), buffer.size());
+                        for (size_t k = otherBegin; k < otherEnd; ++k) {
+                            addFeatureKey(features, terms_bytes.GetStr(), kComboSplitToken, otherIds[k]);
                         }
                     } else {
-                        for (auto& otherId: otherIds[i]) {
-                            FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                            FeatureFormatter::fillFeatureToBuffer(otherId, buffer);
-                            FeatureFormatter::fillFeatureToBuffer(kComboSplitToken, buffer);
-                            FeatureFormatter::fillFeatureToBuffer(terms_bytes.GetStr(), buffer);
-                            features->addFeatureKey(buffer.data(), buffer.size());
+                        for (size_t k = otherBegin; k < otherEnd; ++k) {
+                            addFeatureKey(features, otherIds[k], kComboSplitToken, terms_bytes.GetStr());
                         }
                     }
                 } else {
-                    FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                    FeatureFormatter::fillFeatureToBuffer(terms_bytes.GetStr(), buffer);
-                    features->addFeatureKey(buffer.data(), buffer.size());
+                    addFeatureKey(features, terms_bytes.GetStr());
                 }
             } else {
                 for (auto& val: (_match ?  matched_term_list : unmatched_term_list)) {
                     if (_needCombo) {
                         if (_comboRight) {
-                            for (auto& otherId: otherIds[i]) {
-                                FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                                FeatureFormatter::fillFeatureToBuffer(val, buffer);
-                                FeatureFormatter::fillFeatureToBuffer(kComboSplitToken, buffer);
-                                FeatureFormatter::fillFeatureToBuffer(otherId, buffer);
-                                features->addFeatureKey(buffer.data(), buffer.size());
+                            for (size_t k = otherBegin; k < otherEnd; ++k) {
+                                addFeatureKey(features, val, kComboSplitToken, otherIds[k]);
                             }
                         } else {
-                            for (auto& otherId: otherIds[i]) {
-                                FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                                FeatureFormatter::fillFeatureToBuffer(otherId, buffer);
-                                FeatureFormatter::fillFeatureToBuffer(kComboSplitToken, buffer);
-                                FeatureFormatter::fillFeatureToBuffer(val, buffer);
-                                features->addFeatureKey(buffer.data(), buffer.size());
+                            for (size_t k = otherBegin; k < otherEnd; ++k) {
+                                addFeatureKey(features, otherIds[k], kComboSplitToken, val);
                             }
                         }
                     } else {
-                        FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                        FeatureFormatter::fillFeatureToBuffer(val, buffer);
-                        features->addFeatureKey(buffer.data(), buffer.size());
+                        addFeatureKey(features, val);
                     }
                 }
             }
@@ -279,6 +283,9 @@ public:
         }
         return 2;
     }
+    bool supportHashOutput() const override {
+        return true;
+    }
 
 private:
     inline uint64_t GetTermIndex(uint64_t value) const {
@@ -302,6 +309,14 @@ private:
         return false;
     }
 
+    // copy into pool, the result lives as long as the request scratch.
+    template<typename T>
+    inline autil::ConstString ConvertToConstString(const T& val, autil::mem_pool::PoolBase *pool) const {
+        std::string result;
+        ConvertToString(val, result);
+        return autil::ConstString(result, pool);
+    }
+
 private:
     bool _match;
     bool _asBytes;
@@ -338,6 +353,20 @@ inline bool KgbMatchSemanticFeatureFunction::ConvertToUint64(const autil::MultiC
     return autil::StringUtil::fromString<uint64_t>(std::string(value.data(), value.size()), result);
 }
 
+template<>
+inline autil::ConstString KgbMatchSemanticFeatureFunction::ConvertToConstString(
+        const autil::MultiChar &value, autil::mem_pool::PoolBase *pool) const
+{
+    return autil::ConstString(value.data(), value.size(), pool);
+}
+
+template<>
+inline autil::ConstString KgbMatchSemanticFeatureFunction::ConvertToConstString(
+        const std::string &value, autil::mem_pool::PoolBase *pool) const
+{
+    return autil::ConstString(value, pool);
+}
+
 template<>
 inline bool KgbMatchSemanticFeatureFunction::ConvertToString(const autil::MultiChar &value, std::string& result) const {
     result = std::string(value.data(), value.size());
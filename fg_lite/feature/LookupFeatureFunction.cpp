@@ -83,9 +83,10 @@ public:
     bool _needKey;
 };
 
+template<typename FeaturesT>
 class SparseWeightingFeatureWriter {
 public:
-    typedef MultiSparseWeightingFeatures FeaturesType;
+    typedef FeaturesT FeaturesType;
 public:
     SparseWeightingFeatureWriter(FeaturesType *f, const WriterArgs &args)
         : features(f)
@@ -259,8 +260,11 @@ Features *LookupFeatureFunction::genFeatures(
         return nullptr;
     }
     if (_needDiscrete) {
-        if (_needWeighting) {
-            return genFeatureTemplate<SparseWeightingFeatureWriter>(
+        if (_needWeighting && isCompactOutput()) {
+            return genFeatureTemplate<SparseWeightingFeatureWriter<MultiSparseFloatWeightingFeatures>>(
+                    mapInput, keyInput, context);
+        } else if (_needWeighting) {
+            return genFeatureTemplate<SparseWeightingFeatureWriter<MultiSparseWeightingFeatures>>(
                     mapInput, keyInput, context);
         }
         return genFeatureTemplate<SparseFeatureWriter>(mapInput, keyInput, context);
@@ -433,28 +437,19 @@ bool LookupFeatureFunction::collectValues(
         CollectFun func) const
 {
     assert(rowId < input->row());
-    if (input->dataType() == IT_CSTRING && input->storageType() == IST_DENSE) {
-        typedef FeatureInputTyped<string, DenseStorage<string>> FeatureInputTyped;
-        FeatureInputTyped *typedInput = static_cast<FeatureInputTyped*>(input);
-        for (size_t c = 0; c < typedInput->col(rowId); c++) {
-            const string &value = typedInput->get(rowId, c);
-            ConstString cs(value.data(), value.size());
-            func(cs);
-        }
-    } else if (input->dataType() == IT_STRING
-               && input->storageType() == IST_SPARSE_MULTI_VALUE)
-    {
-        typedef FeatureInputTyped<MultiChar, MultiValueStorage<MultiChar>> FeatureInputTyped;
-        FeatureInputTyped *typedInput = static_cast<FeatureInputTyped*>(input);
-        for (size_t c = 0; c < typedInput->col(rowId); c++) {
-            MultiChar value = typedInput->get(rowId, c);
-            ConstString cs(value.data(), value.size());
-            func(cs);
-        }
+    StringRow values;
+    if (auto typedInput = input->typed<string, DenseStorage<string>>()) {
+        values = typedInput->getStringRow(rowId);
+    } else if (auto typedInput = input->typed<MultiChar, MultiValueStorage<MultiChar>>()) {
+        values = typedInput->getStringRow(rowId);
     } else {
         AUTIL_LOG(WARN, "type unexpected");
         return false;
     }
+    for (size_t c = 0; c < values.size(); c++) {
+        ConstString cs = values[c];
+        func(cs);
+    }
     return true;
 }
 
@@ -64,6 +64,10 @@ public:
         }
         return 2;
     }
+    // weights are float instead of double
+    bool supportCompactOutput() const override {
+        return _needDiscrete && _needWeighting && !_isOptimized;
+    }
 private:
     template <class FeatureWriter>
     Features *genFeatureTemplate(
@@ -123,7 +123,7 @@ Features *LookupFeatureFunctionArray::genFeatures(const std::vector<FeatureInput
         typedef InputType2Type<t>::Type TV;                                                                 \
         if (mapValueInput->storageType() == IST_DENSE) {                                                    \
             if (keyInput->storageType() == IST_DENSE) {                                                     \
-                return lookupAllTyped(dynamic_cast<const FeatureInputTyped<T, DenseStorage<T>>*>(keyInput), \
+                return lookupAllTyped(context, dynamic_cast<const FeatureInputTyped<T, DenseStorage<T>>*>(keyInput), \
                         dynamic_cast<const FeatureInputTyped<TK, DenseStorage<TK>>*>(mapKeyInput),          \
                         dynamic_cast<const FeatureInputTyped<TV, DenseStorage<TV>>*>(mapValueInput),        \
                         dynamic_cast<const FeatureInputTyped<TV, DenseStorage<TV>>*>(pvTime),               \
@@ -133,7 +133,7 @@ Features *LookupFeatureFunctionArray::genFeatures(const std::vector<FeatureInput
                         dynamic_cast<const FeatureInputTyped<TV, DenseStorage<TV>>*>(urbTimes2),             \
                         dynamic_cast<const FeatureInputTyped<TV, DenseStorage<TV>>*>(otherInput));            \
             } else if (keyInput->storageType() == IST_SPARSE_MULTI_VALUE) {                                 \
-                return lookupAllTyped(dynamic_cast<const FeatureInputTyped<T, MultiValueStorage<T>>*>(keyInput), \
+                return lookupAllTyped(context, dynamic_cast<const FeatureInputTyped<T, MultiValueStorage<T>>*>(keyInput), \
                         dynamic_cast<const FeatureInputTyped<TK, DenseStorage<TK>>*>(mapKeyInput),          \
                         dynamic_cast<const FeatureInputTyped<TV, DenseStorage<TV>>*>(mapValueInput),        \
                         dynamic_cast<const FeatureInputTyped<TV, DenseStorage<TV>>*>(pvTime),               \
@@ -148,7 +148,7 @@ Features *LookupFeatureFunctionArray::genFeatures(const std::vector<FeatureInput
             }                                                                                               \
         } else if (mapValueInput->storageType() == IST_SPARSE_MULTI_VALUE) {                                \
             if (keyInput->storageType() == IST_DENSE) {                                                     \
-                return lookupAllTyped(dynamic_cast<const FeatureInputTyped<T, DenseStorage<T>>*>(keyInput), \
+                return lookupAllTyped(context, dynamic_cast<const FeatureInputTyped<T, DenseStorage<T>>*>(keyInput), \
                         dynamic_cast<const FeatureInputTyped<TK, MultiValueStorage<TK>>*>(mapKeyInput),     \
                         dynamic_cast<const FeatureInputTyped<TV, MultiValueStorage<TV>>*>(mapValueInput),   \
                         dynamic_cast<const FeatureInputTyped<TV, MultiValueStorage<TV>>*>(pvTime),          \
@@ -158,7 +158,7 @@ Features *LookupFeatureFunctionArray::genFeatures(const std::vector<FeatureInput
                         dynamic_cast<const FeatureInputTyped<TV, MultiValueStorage<TV>>*>(urbTimes2),       \
                         dynamic_cast<const FeatureInputTyped<TV, MultiValueStorage<TV>>*>(otherInput));     \
             } else if (keyInput->storageType() == IST_SPARSE_MULTI_VALUE) {                                 \
-                return lookupAllTyped(dynamic_cast<const FeatureInputTyped<T, MultiValueStorage<T>>*>(keyInput), \
+                return lookupAllTyped(context, dynamic_cast<const FeatureInputTyped<T, MultiValueStorage<T>>*>(keyInput), \
                         dynamic_cast<const FeatureInputTyped<TK, MultiValueStorage<TK>>*>(mapKeyInput),     \
                         dynamic_cast<const FeatureInputTyped<TV, MultiValueStorage<TV>>*>(mapValueInput),   \
                         dynamic_cast<const FeatureInputTyped<TV, MultiValueStorage<TV>>*>(pvTime),          \
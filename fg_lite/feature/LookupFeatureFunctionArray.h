@@ -52,6 +52,7 @@ private:
     // key and other params may have different StorageType!
     template<typename KeyType, typename MapKeyType, template<typename> class KStorageType, template<typename> class StorageType, typename MapValueType>
     Features* lookupAllTyped(
+            FeatureFunctionContext *context,
             const FeatureInputTyped<KeyType, KStorageType<KeyType>> *key,
             const FeatureInputTyped<MapKeyType, StorageType<MapKeyType>> *mapKey,
             const FeatureInputTyped<MapValueType, StorageType<MapValueType>> *mapValue,
@@ -65,6 +66,7 @@ private:
     template <typename KeyType, typename MapKeyType, template <typename> class KStorageType,
               template <typename> class StorageType, typename MapValueType, typename FeaturesType>
     void fillFeatureValue(
+        FeatureFunctionContext *context,
         const FeatureInputTyped<KeyType, KStorageType<KeyType>> *key,
         const FeatureInputTyped<MapKeyType, StorageType<MapKeyType>> *mapKey,
         const FeatureInputTyped<MapValueType, StorageType<MapValueType>> *mapValue,
@@ -4,6 +4,7 @@
 #include "fg_lite/feature/AnyConvert.h"
 #include "fg_lite/feature/Normalizer.h"
 #include <cmath>
+#include <limits>
 #include <algorithm>
 
 using namespace std;
@@ -48,6 +49,7 @@ auto TimeDiffNormal = [] (float val, float now) {
 template<typename KeyType, typename MapKeyType,
     template<typename> class KStorageType, template<typename> class StorageType, typename MapValueType>
 Features *LookupFeatureFunctionArray::lookupAllTyped(
+        FeatureFunctionContext *context,
         const FeatureInputTyped<KeyType, KStorageType<KeyType>> *key,
         const FeatureInputTyped<MapKeyType, StorageType<MapKeyType>> *mapKey,
         const FeatureInputTyped<MapValueType, StorageType<MapValueType>> *mapValue,
@@ -65,7 +67,9 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
     using KeyCon = Str2ConstStr<KeyType>;
     using ActualKeyType = typename KeyCon::type;
 #define CONSTRUCT_PAIRLIST2()                                                  \
-    PairValueList<ActualKeyType, MapValueType> lookupPairList(pair_alloc<ActualKeyType, MapValueType>(features->getPool())); \
+    autil::mem_pool::UnsafePool localPool(1024);                               \
+    auto scratchPool = getScratchPool(context, &localPool);                     \
+    PairValueList<ActualKeyType, MapValueType> lookupPairList{pair_alloc<ActualKeyType, MapValueType>(scratchPool)}; \
     double nowtm = 0.0f;                                                       \
     FloatValueConvertor::convertToDouble(pvtime->get(0, 0), nowtm);            \
     for (size_t i = 0; i < min(mapKey->row(), mapValue->row()); i++) {         \
@@ -77,7 +81,7 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
                     continue;                                                  \
                 }                                                              \
             }                                                                  \
-            auto newKey = anyconvert<MapKeyType, ActualKeyType>(mapKey->get(i, j), features->getPool()); \
+            auto newKey = anyconvert<MapKeyType, ActualKeyType>(mapKey->get(i, j), scratchPool); \
             lookupPairList.push_back({newKey, {mapValue->get(i, j), urbtime->get(i, j)}});               \
         }                                                                      \
     }                                                                          \
@@ -86,7 +90,7 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
             { return l.first < r.first; };                                     \
     std::sort(lookupPairList.begin(), lookupPairList.end(),                    \
             cmp_function);                                                     \
-    PairValueList<ActualKeyType, MapValueType> lookupPairList2(pair_alloc<ActualKeyType, MapValueType>(features->getPool())); \
+    PairValueList<ActualKeyType, MapValueType> lookupPairList2{pair_alloc<ActualKeyType, MapValueType>(scratchPool)}; \
     for (size_t i = 0; i < min(map2Key->row(), map2Value->row()); i++) {       \
         for (size_t j = 0; j < min(map2Key->col(i), map2Value->col(i)); j++) { \
             if (pvtime != nullptr && urbtime2 != nullptr) {                    \
@@ -96,7 +100,7 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
                     continue;                                                  \
                 }                                                              \
             }                                                                  \
-            auto newKey = anyconvert<MapKeyType, ActualKeyType>(map2Key->get(i, j), features->getPool()); \
+            auto newKey = anyconvert<MapKeyType, ActualKeyType>(map2Key->get(i, j), scratchPool); \
             lookupPairList2.push_back({newKey, {mapValue->get(i, j), urbtime2->get(i, j)}});              \
         }                                                                      \
     }                                                                          \
@@ -105,7 +109,9 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
 
 
 #define CONSTRUCT_PAIRLIST()                                                   \
-    PairValueList<ActualKeyType, MapValueType> lookupPairList(pair_alloc<ActualKeyType, MapValueType>(features->getPool())); \
+    autil::mem_pool::UnsafePool localPool(1024);                               \
+    auto scratchPool = getScratchPool(context, &localPool);                     \
+    PairValueList<ActualKeyType, MapValueType> lookupPairList{pair_alloc<ActualKeyType, MapValueType>(scratchPool)}; \
     double nowtm = 0.0f;                                                       \
     FloatValueConvertor::convertToDouble(pvtime->get(0, 0), nowtm);            \
     for (size_t i = 0; i < min(mapKey->row(), mapValue->row()); i++) {         \
@@ -117,7 +123,7 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
                     continue;                                                  \
                 }                                                              \
             }                                                                  \
-            auto newKey = anyconvert<MapKeyType, ActualKeyType>(mapKey->get(i, j), features->getPool()); \
+            auto newKey = anyconvert<MapKeyType, ActualKeyType>(mapKey->get(i, j), scratchPool); \
             lookupPairList.push_back({newKey, {mapValue->get(i, j), urbtime->get(i, j)}});               \
         }                                                                      \
     }                                                                          \
@@ -321,21 +327,21 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
                             if (_combiner2Type == CombinerType::COUNT) {
                                 valueRet += matchCount;
                             } else if (_combiner2Type == CombinerType::GAP_MIN || _combiner2Type == CombinerType::GAP_MAX) {
-                                std::vector<double> tmdiffs(matchCount, 0.0f);
-                                int idx = 0;
-                                for (auto it = itR.first; it != itR.second; ++it, ++idx) {
+                                double minDiff = std::numeric_limits<double>::max();
+                                double maxDiff = std::numeric_limits<double>::lowest();
+                                for (auto it = itR.first; it != itR.second; ++it) {
                                     double urbtm = 0.0f;
                                     FloatValueConvertor::convertToDouble(it->second.second, urbtm);
-                                    tmdiffs[idx] = nowtm - urbtm;
+                                    minDiff = std::min(minDiff, nowtm - urbtm);
+                                    maxDiff = std::max(maxDiff, nowtm - urbtm);
                                 }
-                                auto minmax_it = std::minmax_element(tmdiffs.begin(), tmdiffs.end());
                                 if (_combiner2Type == CombinerType::GAP_MIN) {
-                                    if (*(minmax_it.first) < valueRet) {
-                                        valueRet = *(minmax_it.first);
+                                    if (minDiff < valueRet) {
+                                        valueRet = minDiff;
                                     }
                                 } else {
-                                    if (*(minmax_it.second) > valueRet) {
-                                        valueRet = *(minmax_it.second);
+                                    if (maxDiff > valueRet) {
+                                        valueRet = maxDiff;
                                     }
                                 }
                             }
@@ -388,21 +394,21 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
                             if (_combiner2Type == CombinerType::COUNT) {
                                 valueRet += matchCount;
                             } else if (_combiner2Type == CombinerType::GAP_MIN || _combiner2Type == CombinerType::GAP_MAX) {
-                                std::vector<double> tmdiffs(matchCount, 0.0f);
-                                int idx = 0;
-                                for (auto it = itR.first; it != itR.second; ++it, ++idx) {
+                                double minDiff = std::numeric_limits<double>::max();
+                                double maxDiff = std::numeric_limits<double>::lowest();
+                                for (auto it = itR.first; it != itR.second; ++it) {
                                     double urbtm = 0.0f;
                                     FloatValueConvertor::convertToDouble(it->second.second, urbtm);
-                                    tmdiffs[idx] = nowtm - urbtm;
+                                    minDiff = std::min(minDiff, nowtm - urbtm);
+                                    maxDiff = std::max(maxDiff, nowtm - urbtm);
                                 }
-                                auto minmax_it = std::minmax_element(tmdiffs.begin(), tmdiffs.end());
                                 if (_combiner2Type == CombinerType::GAP_MIN) {
-                                    if (*(minmax_it.first) < valueRet) {
-                                        valueRet = *(minmax_it.first);
+                                    if (minDiff < valueRet) {
+                                        valueRet = minDiff;
                                     }
                                 } else {
-                                    if (*(minmax_it.second) > valueRet) {
-                                        valueRet = *(minmax_it.second);
+                                    if (maxDiff > valueRet) {
+                                        valueRet = maxDiff;
                                     }
                                 }
                             }
@@ -435,10 +441,12 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
 
 #undef CONSTRUCT_PAIRLIST
 #define CONSTRUCT_MAP()                                                                                             \
-    MapWrapper<ActualKeyType, MapValueType> lookupMap(map_alloc<ActualKeyType, MapValueType>(features->getPool())); \
+    autil::mem_pool::UnsafePool localPool(1024);                                                                   \
+    auto scratchPool = getScratchPool(context, &localPool);                                                         \
+    MapWrapper<ActualKeyType, MapValueType> lookupMap{map_alloc<ActualKeyType, MapValueType>(scratchPool)}; \
      for (size_t i = 0; i < min(mapKey->row(), mapValue->row()); i++) {                                             \
          for (size_t j = 0; j < min(mapKey->col(i), mapValue->col(i)); j++) {                                       \
-             auto newKey = anyconvert<MapKeyType, ActualKeyType>(mapKey->get(i, j), features->getPool());           \
+             auto newKey = anyconvert<MapKeyType, ActualKeyType>(mapKey->get(i, j), scratchPool);           \
             lookupMap[newKey] = mapValue->get(i, j);                                                                \
          }                                                                                                          \
     }
@@ -466,11 +474,11 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
         return features;
     } else if (!_boundaries.empty()) {
         auto *features = new SingleIntegerFeatures(getFeatureName(), key->row());
-        fillFeatureValue<KeyType, MapKeyType, KStorageType, StorageType, MapValueType, SingleIntegerFeatures>(key, mapKey, mapValue, features);
+        fillFeatureValue<KeyType, MapKeyType, KStorageType, StorageType, MapValueType, SingleIntegerFeatures>(context, key, mapKey, mapValue, features);
         return features;
     } else {
         auto *features = new SingleDenseFeatures(getFeatureName(), key->row());
-        fillFeatureValue<KeyType, MapKeyType, KStorageType, StorageType, MapValueType, SingleDenseFeatures>(key, mapKey, mapValue, features);
+        fillFeatureValue<KeyType, MapKeyType, KStorageType, StorageType, MapValueType, SingleDenseFeatures>(context, key, mapKey, mapValue, features);
         return features;
     }
 }
@@ -479,6 +487,7 @@ Features *LookupFeatureFunctionArray::lookupAllTyped(
 template <typename KeyType, typename MapKeyType, template <typename> class KStorageType,
           template <typename> class StorageType, typename MapValueType, typename FeaturesType>
 void LookupFeatureFunctionArray::fillFeatureValue(
+    FeatureFunctionContext *context,
     const FeatureInputTyped<KeyType, KStorageType<KeyType>> *key,
     const FeatureInputTyped<MapKeyType, StorageType<MapKeyType>> *mapKey,
     const FeatureInputTyped<MapValueType, StorageType<MapValueType>> *mapValue,
@@ -505,6 +514,7 @@ void LookupFeatureFunctionArray::fillFeatureValue(
 
 #define LOOKUP_ARRAY_IMPL(KeyType, MapKeyType, KStorageType, StorageType, MapValueType)      \
     template Features *LookupFeatureFunctionArray::lookupAllTyped(                           \
+        FeatureFunctionContext *context,                                                     \
         const FeatureInputTyped<KeyType, KStorageType<KeyType>> *key,                        \
         const FeatureInputTyped<MapKeyType, StorageType<MapKeyType>> *mapKey,                \
         const FeatureInputTyped<MapValueType, StorageType<MapValueType>> *mapValue,          \
@@ -63,10 +63,12 @@ private:
     template<typename KeyType>
     std::vector<KeyType> genKeyFromUserInput(FeatureInput *userInput) const {
         std::vector<KeyType> keys;
-        auto typedInput = dynamic_cast<FeatureInputTyped<std::string, DenseStorage<std::string>>*> (userInput);
+        auto typedInput = userInput->typed<std::string, DenseStorage<std::string>>();
         if (typedInput) {
-            for (size_t i = 0; i < typedInput->col(0); i++) {
-                auto value = typedInput->get(0, i);
+            StringRow values = typedInput->getStringRow(0);
+            keys.reserve(values.size());
+            for (size_t i = 0; i < values.size(); i++) {
+                autil::ConstString value = values[i];
                 keys.push_back(autil::MurmurHash::MurmurHash64A(value.data(), value.size(), 0));
             }
         }
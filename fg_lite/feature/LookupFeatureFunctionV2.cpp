@@ -49,7 +49,7 @@ Features *LookupFeatureFunctionV2::genFeatures(
         return nullptr;
     }
 
-    if (itemInput->storageType() != IST_DENSE
+    if ((itemInput->storageType() != IST_DENSE && itemInput->storageType() != IST_DICTIONARY)
         || itemInput->dataType() != IT_STRING)
     {
         AUTIL_LOG(ERROR,
@@ -61,8 +61,9 @@ Features *LookupFeatureFunctionV2::genFeatures(
     }
 
     typedef FeatureInputTyped<MultiChar, DenseStorage<MultiChar>> FeatureInputTyped;
-    FeatureInputTyped *typedItemInput = dynamic_cast<FeatureInputTyped*>(itemInput);
-    if (!typedItemInput) {
+    FeatureInputTyped *typedItemInput = itemInput->typed<MultiChar, DenseStorage<MultiChar>>();
+    auto dictionaryInput = itemInput->typed<MultiChar, DictionaryStorage<MultiChar>>();
+    if (!typedItemInput && !dictionaryInput) {
         AUTIL_LOG(ERROR, "parse item input failed");
         return nullptr;
     }
@@ -75,6 +76,22 @@ Features *LookupFeatureFunctionV2::genFeatures(
     }
 
     sort(keys.begin(), keys.end());
+    if (dictionaryInput) {
+        // every distinct map is matched once, docs copy the result of their code
+        const DictionaryStorage<MultiChar> &storage = dictionaryInput->getStorage();
+        FeatureInputTyped distinctInput(DenseStorage<MultiChar>(
+                        storage.getDictionary(), storage.dictionarySize()));
+        unique_ptr<Features> distinct(genFeatures(keys, &distinctInput));
+        return expandByCodes(distinct.get(), storage);
+    }
+    return genFeatures(keys, typedItemInput);
+}
+
+Features *LookupFeatureFunctionV2::genFeatures(
+        const vector<uint64_t> &keys,
+        FeatureInputTyped<MultiChar, DenseStorage<MultiChar>> *typedItemInput) const
+{
+    // keys must be sorted
     if (_dimension == 1) {
         if (_boundaries.empty()) {
             auto features = new SingleDenseFeatures(getFeatureName(), typedItemInput->row());
@@ -108,6 +125,52 @@ Features *LookupFeatureFunctionV2::genFeatures(
     }
 }
 
+template <typename FeatureT>
+static void copyValuesByCodes(const FeatureT *distinct, const DictionaryStorage<MultiChar> &storage,
+                              FeatureT *features)
+{
+    const uint32_t *codes = storage.getCodes();
+    for (size_t r = 0; r < storage.row(); r++) {
+        features->_featureValues.push_back(distinct->_featureValues[codes[r * storage.col(r)]]);
+    }
+}
+
+Features *LookupFeatureFunctionV2::expandByCodes(const Features *distinct,
+        const DictionaryStorage<MultiChar> &storage) const
+{
+    switch (distinct->getFeatureValueType()) {
+    case FVT_SINGLE_DENSE: {
+        auto features = new SingleDenseFeatures(getFeatureName(), storage.row());
+        copyValuesByCodes(static_cast<const SingleDenseFeatures*>(distinct), storage, features);
+        return features;
+    }
+    case FVT_SINGLE_SPARSE_INT: {
+        auto features = new SingleIntegerFeatures(getFeatureName(), storage.row());
+        copyValuesByCodes(static_cast<const SingleIntegerFeatures*>(distinct), storage, features);
+        return features;
+    }
+    case FVT_MULTI_DENSE: {
+        auto typedDistinct = static_cast<const MultiDenseFeatures*>(distinct);
+        MultiDenseFeatures *features = new MultiDenseFeatures(
+                getFeatureName(), storage.row() * _dimension);
+        features->_featureValues.resize(storage.row() * _dimension);
+        const uint32_t *codes = storage.getCodes();
+        for (size_t r = 0; r < storage.row(); r++) {
+            features->_offsets.push_back(r * _dimension);
+            const float *values = typedDistinct->_featureValues.data()
+                                  + codes[r * storage.col(r)] * _dimension;
+            std::copy(values, values + _dimension,
+                      features->_featureValues.begin() + r * _dimension);
+        }
+        return features;
+    }
+    default:
+        AUTIL_LOG(ERROR, "feature[%s] type[%d] not supported for dictionary input",
+                  getFeatureName().c_str(), distinct->getFeatureValueType());
+        return nullptr;
+    }
+}
+
 template<CombinerType type, typename FeatureT>
 void LookupFeatureFunctionV2::generate(const vector<uint64_t> *keys,
                                        FeatureInputTyped<MultiChar, DenseStorage<MultiChar>> *input,
@@ -150,19 +213,16 @@ void LookupFeatureFunctionV2::generateMultiDense(const vector<uint64_t> *keys,
 
 vector<uint64_t> LookupFeatureFunctionV2::genKey(FeatureInput *userInput) const {
     vector<uint64_t> keys;
-    auto typedInput = dynamic_cast<FeatureInputTyped<string, DenseStorage<string>>*>(userInput);
-    if (typedInput) {
-        for (size_t i = 0; i < typedInput->col(0); i++) {
-            const auto value = typedInput->get(0, i);
-            keys.push_back(MurmurHash::MurmurHash64A(value.data(), value.size(), 0));
-        }
+    StringRow values;
+    if (auto typedInput = userInput->typed<string, DenseStorage<string>>()) {
+        values = typedInput->getStringRow(0);
+    } else if (auto typedInput = userInput->typed<MultiChar, MultiValueStorage<MultiChar>>()) {
+        values = typedInput->getStringRow(0);
     }
-    auto typedInput1 = dynamic_cast<FeatureInputTyped<MultiChar, MultiValueStorage<MultiChar>>*>(userInput);
-    if (typedInput1) {
-        for (size_t i = 0; i < typedInput1->col(0); i++) {
-            auto value = typedInput1->get(0, i);
-            keys.push_back(MurmurHash::MurmurHash64A(value.data(), value.size(), 0));
-        }
+    keys.reserve(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        ConstString value = values[i];
+        keys.push_back(MurmurHash::MurmurHash64A(value.data(), value.size(), 0));
     }
     return keys;
 }
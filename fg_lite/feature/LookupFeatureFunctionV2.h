@@ -34,8 +34,16 @@ public:
     size_t getInputCount() const override {
         return 2;
     }
+    bool supportDictionaryInput() const override {
+        return true;
+    }
 private:
     std::vector<uint64_t> genKey(FeatureInput *userInput) const;
+    Features *genFeatures(const std::vector<uint64_t> &keys,
+                          FeatureInputTyped<autil::MultiChar, DenseStorage<autil::MultiChar>> *input) const;
+    // features of the docs of a dictionary input from those of its dictionary
+    Features *expandByCodes(const Features *distinct,
+                            const DictionaryStorage<autil::MultiChar> &storage) const;
     template<CombinerType type, typename FeatureT>
     void generate(const std::vector<uint64_t> *keys,
                   FeatureInputTyped<autil::MultiChar, DenseStorage<autil::MultiChar>> *input,
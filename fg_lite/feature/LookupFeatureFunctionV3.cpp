@@ -101,10 +101,11 @@ void LookupFeatureFunctionV3::generate(const vector<uint64_t> *keys,
 }
 
 #define GEN_KEY_ON_INPUT(input, str, storage)                                       \
-auto input = dynamic_cast<const FeatureInputTyped<str, storage<str>>*>(userInput);  \
+auto input = userInput->typed<str, storage<str>>();                                 \
 if (input) {                                                                        \
-    for (size_t i = 0; i < input->col(0); i++) {                                    \
-        auto value = input->get(0, i);                                              \
+    StringRow values = input->getStringRow(0);                                      \
+    for (size_t i = 0; i < values.size(); i++) {                                    \
+        ConstString value = values[i];                                              \
         keys.push_back(MurmurHash::MurmurHash64A(value.data(), value.size(), 0));   \
     }                                                                               \
 }
@@ -1,11 +1,24 @@
 #include "fg_lite/feature/MatchFeatureFunction.h"
 #include "fg_lite/feature/FeatureFormatter.h"
+#include "fg_lite/feature/BroadcastFeatureCache.h"
 
 using namespace std;
 using namespace autil;
 
 namespace fg_lite {
 
+// parsed user info with the text it points into, shared through the
+// broadcast cache by the match features of one user
+struct CachedUserMatchInfo {
+    CachedUserMatchInfo(const char *data, size_t size)
+        : userInfo(data, size)
+    {}
+    std::string userInfo;
+    UserMatchInfo matchInfo;
+};
+
+static const string USER_MATCH_INFO_KIND = "match_user_info";
+
 class UserIterator {
 public:
     UserIterator()
@@ -19,19 +32,22 @@ public:
     }
 private:
     template<typename StringType, typename StorageType>
-    bool constructUser(FeatureInput *input) {
-        auto typedInput = dynamic_cast<FeatureInputTyped<StringType, StorageType>*>(input);
+    bool constructUser(FeatureInput *input, BroadcastFeatureCache *cache) {
+        auto typedInput = input->typed<StringType, StorageType>();
         if (!typedInput) {
             AUTIL_LOG(WARN, "user input type error %s", typeid(*input).name());
             return false;
         }
         size_t row = typedInput->row();
+        if (1 == row && cache && typedInput->col(0) >= 1) {
+            ConstString str = typedInput->getView(0, 0);
+            return constructCachedUser(input, str.data(), str.size(), cache);
+        }
         for (size_t i = 0; i < row; i++) {
             if (typedInput->col(i) < 1) {
                 continue;
             }
-            const StringType str = typedInput->get(i, 0);
-            ConstString userInfo(str.data(), str.size());
+            ConstString userInfo = typedInput->getView(i, 0);
             if (!_users[i].parseUserInfo(userInfo) && 1 == row) {
                 AUTIL_LOG(DEBUG, "user info[%s] is invalid", userInfo.c_str());
                 return false;
@@ -39,8 +55,27 @@ private:
         }
         return true;
     }
+    bool constructCachedUser(FeatureInput *input, const char *data, size_t size,
+                             BroadcastFeatureCache *cache)
+    {
+        auto key = BroadcastFeatureCache::makeKey(USER_MATCH_INFO_KIND, input);
+        _cachedUser = cache->get<CachedUserMatchInfo>(key);
+        if (_cachedUser) {
+            return true;
+        }
+        auto cachedUser = make_shared<CachedUserMatchInfo>(data, size);
+        if (!cachedUser->matchInfo.parseUserInfo(cachedUser->userInfo)) {
+            AUTIL_LOG(DEBUG, "user info[%s] is invalid", cachedUser->userInfo.c_str());
+            return false;
+        }
+        size_t memoryUse = sizeof(CachedUserMatchInfo) + cachedUser->userInfo.size()
+                           + cachedUser->matchInfo.getMemoryUse();
+        cache->put<CachedUserMatchInfo>(key, cachedUser, memoryUse);
+        _cachedUser = cachedUser;
+        return true;
+    }
 public:
-    bool construct(FeatureInput *input) {
+    bool construct(FeatureInput *input, BroadcastFeatureCache *cache) {
         _row = input->row();
         if (broadcast()) {
             _users = &_user;
@@ -48,12 +83,12 @@ public:
             _users = new UserMatchInfo[_row];
         }
         if (IT_CSTRING == input->dataType()) { // online predict
-            return constructUser<string, DenseStorage<string>>(input);
+            return constructUser<string, DenseStorage<string>>(input, cache);
         } else if (IT_STRING == input->dataType()) { // offline train
             if (IST_SPARSE_MULTI_VALUE == input->storageType()) {
-                return constructUser<MultiChar, MultiValueStorage<MultiChar>>(input);
+                return constructUser<MultiChar, MultiValueStorage<MultiChar>>(input, cache);
             } else {
-                return constructUser<MultiChar, DenseStorage<MultiChar>>(input);
+                return constructUser<MultiChar, DenseStorage<MultiChar>>(input, cache);
             }
         } else {
             AUTIL_LOG(DEBUG, "match feature not support user input type %d",
@@ -65,7 +100,9 @@ public:
         return _row <= 1;
     }
     const UserMatchInfo &get(size_t id) const {
-        if (broadcast()) {
+        if (_cachedUser) {
+            return _cachedUser->matchInfo;
+        } else if (broadcast()) {
             return _user;
         } else {
             assert(id < _row);
@@ -76,6 +113,7 @@ private:
     size_t _row;
     UserMatchInfo _user;
     UserMatchInfo *_users;
+    std::shared_ptr<const CachedUserMatchInfo> _cachedUser;
     AUTIL_LOG_DECLARE();
 };
 
@@ -91,7 +129,6 @@ MatchFeatureFunction::MatchFeatureFunction(
     , _wildCardCategory(wildCardCategory)
     , _wildCardItem(wildCardItem)
 {
-    assert(!(_wildCardCategory && _wildCardItem));
 }
 
 Features *MatchFeatureFunction::genFeatures(
@@ -140,33 +177,38 @@ Features *MatchFeatureFunction::genFeatures(
     }
 
     size_t userRow = userInput->row();
+    if (!itemInput && !categoryInput) {
+        // both ALL, every user row is a doc
+        docCount = max(userRow, docCount);
+    }
     if (userRow > 1 && userRow != docCount) {
         AUTIL_LOG(ERROR, "match feature[%s] row for user not equal doc count or 1",
                   getFeatureName().c_str());
         return nullptr;
     }
     UserIterator userIterator;
-    if (!userIterator.construct(userInput)) {
+    if (!userIterator.construct(userInput, getBroadcastCache(context))) {
         return nullptr;
     }
 
     if (_matcher->isSparseFeature()) {
         if(_matcher->needWeighting()) {
             MultiSparseWeightingFeatures *features =
-                new MultiSparseWeightingFeatures(docCount);
-            genMatchFeatures<MultiSparseWeightingFeatures>(itemInput,
+                createFeatures<MultiSparseWeightingFeatures>(docCount, context);
+            genMatchFeatures<MultiSparseWeightingFeatures>(docCount, itemInput,
                     categoryInput, userIterator, features);
             return features;
         } else {
-            MultiSparseFeatures *features = new MultiSparseFeatures(docCount);
-            genMatchFeatures<MultiSparseFeatures>(itemInput,
+            MultiSparseFeatures *features = createFeatures<MultiSparseFeatures>(docCount, context);
+            genMatchFeatures<MultiSparseFeatures>(docCount, itemInput,
                     categoryInput, userIterator, features);
             return features;
         }
     } else {
         MultiDenseFeatures *features = new MultiDenseFeatures(
-                getFeatureName(), docCount);
-        genMatchFeatures<MultiDenseFeatures>(itemInput, categoryInput, userIterator, features);
+                getFeatureName(), docCount, getFeaturePool(context));
+        genMatchFeatures<MultiDenseFeatures>(docCount, itemInput, categoryInput,
+                userIterator, features);
         return features;
     }
 }
@@ -205,13 +247,12 @@ private:
 
 template <typename FeatureType>
 void MatchFeatureFunction::genMatchFeatures(
+        size_t docCount,
         FeatureInput *itemInput,
         FeatureInput *categoryInput,
         UserIterator &userIterator,
         FeatureType *features) const
 {
-    size_t docCount = itemInput != nullptr ? itemInput->row() : categoryInput->row();
-
     FeatureFormatter::FeatureBuffer itemBuffer(cp_alloc(features->getPool()));
     FeatureFormatter::FeatureBuffer categoryBuffer(cp_alloc(features->getPool()));
 
@@ -25,12 +25,14 @@ private:
 public:
     Features *genFeatures(const std::vector<FeatureInput*> &inputs,
                           FeatureFunctionContext *context) const override;
+    // user, then item and category unless they are ALL
     size_t getInputCount() const override {
-        return _wildCardCategory || _wildCardItem ? 2 : 3;
+        return 1 + (_wildCardItem ? 0 : 1) + (_wildCardCategory ? 0 : 1);
     }
 private:
     template <typename FeatureType>
-    void genMatchFeatures(FeatureInput *itemInput,
+    void genMatchFeatures(size_t docCount,
+                          FeatureInput *itemInput,
                           FeatureInput *categoryInput,
                           UserIterator &userIterator,
                           FeatureType *features) const;
@@ -120,10 +120,24 @@ inline void addFeatureMayBucketize(SingleDenseFeatures *features, const std::vec
     features->addFeatureValue(value);
 }
 
+inline void addFeatureMayBucketize(TensorDenseFeatures *features, const std::vector<float> &boundaries, float value) {
+    features->addFeatureValue(value);
+}
+
 inline void addFeatureMayBucketize(SingleIntegerFeatures *features, const std::vector<float> &boundaries, float value) {
     features->addFeatureValue(bucketize(value, boundaries));
 }
 
+// only for boundaries of at most INT32_MAX or INT16_MAX values, ids past
+// the value limit of the compact types are dropped and set overflow()
+inline void addFeatureMayBucketize(SingleInt32Features *features, const std::vector<float> &boundaries, float value) {
+    features->addFeatureValue(bucketize(value, boundaries));
+}
+
+inline void addFeatureMayBucketize(SingleInt16Features *features, const std::vector<float> &boundaries, float value) {
+    features->addFeatureValue(bucketize(value, boundaries));
+}
+
 }
 
 #endif //ISEARCH_FG_LITE_NORMALIZER_H
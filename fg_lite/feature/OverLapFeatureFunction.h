@@ -46,9 +46,9 @@ private:
                std::vector<autil::ConstString> &values) const
     {
         values.clear();
-        for(size_t j = 0; j < input->col(i); ++j){
-            const DataType value = input->get(i, j);
-            values.push_back(autil::ConstString(value.data(), value.size()));
+        StringRow row = input->getStringRow(i);
+        for (size_t j = 0; j < row.size(); ++j) {
+            values.push_back(row[j]);
         }
         Row<autil::ConstString> inputRow(values.data(), values.size());
         return inputRow;
@@ -47,7 +47,7 @@ Features* PreclickUrbWordFeatureFunction::genFeatures(const std::vector<fg_lite:
             if (matchInput->storageType() == IST_DENSE) { \
                 return genMatchFeatureTyped( \
                         dynamic_cast<const FeatureInputTyped<ET, DenseStorage<ET>>*>(expressionInput), \
-                        dynamic_cast<const FeatureInputTyped<MT, DenseStorage<MT>>*>(matchInput)); \
+                        dynamic_cast<const FeatureInputTyped<MT, DenseStorage<MT>>*>(matchInput), context); \
             } else{ \
                 AUTIL_LOG(ERROR, "PreclickUrbWordFeature expression and match input storage type not match"); \
                 return nullptr; \
@@ -60,7 +60,7 @@ Features* PreclickUrbWordFeatureFunction::genFeatures(const std::vector<fg_lite:
             } else if (matchInput->storageType() == IST_SPARSE_MULTI_VALUE) { \
                 return genMatchFeatureTyped( \
                         dynamic_cast<const FeatureInputTyped<ET, MultiValueStorage<ET>>*>(expressionInput), \
-                        dynamic_cast<const FeatureInputTyped<MT, MultiValueStorage<MT>>*>(matchInput)); \
+                        dynamic_cast<const FeatureInputTyped<MT, MultiValueStorage<MT>>*>(matchInput), context); \
             } else{ \
                 AUTIL_LOG(ERROR, "PreclickUrbWordFeature expression and match input storage type not match"); \
                 return nullptr; \
@@ -75,7 +75,7 @@ Features* PreclickUrbWordFeatureFunction::genFeatures(const std::vector<fg_lite:
             } else{ \
                 return genMatchFeatureTyped( \
                         dynamic_cast<const FeatureInputTyped<ET, ValueOffsetStorage<ET>>*>(expressionInput), \
-                        dynamic_cast<const FeatureInputTyped<MT, ValueOffsetStorage<MT>>*>(matchInput)); \
+                        dynamic_cast<const FeatureInputTyped<MT, ValueOffsetStorage<MT>>*>(matchInput), context); \
             } \
         } \
     } \
@@ -110,13 +110,13 @@ Features* PreclickUrbWordFeatureFunction::genFeatures(const std::vector<fg_lite:
         typedef InputType2Type<T>::Type Type; \
         if (expressionInput->storageType() == IST_DENSE) { \
             return genTopFeatureTyped( \
-                    dynamic_cast<const FeatureInputTyped<Type, DenseStorage<Type>>*>(expressionInput)); \
+                    dynamic_cast<const FeatureInputTyped<Type, DenseStorage<Type>>*>(expressionInput), context); \
         } else if (expressionInput->storageType() == IST_SPARSE_MULTI_VALUE) { \
             return genTopFeatureTyped( \
-                    dynamic_cast<const FeatureInputTyped<Type, MultiValueStorage<Type>>*>(expressionInput)); \
+                    dynamic_cast<const FeatureInputTyped<Type, MultiValueStorage<Type>>*>(expressionInput), context); \
         } else { \
             return genTopFeatureTyped( \
-                    dynamic_cast<const FeatureInputTyped<Type, ValueOffsetStorage<Type>>*>(expressionInput)); \
+                    dynamic_cast<const FeatureInputTyped<Type, ValueOffsetStorage<Type>>*>(expressionInput), context); \
         } \
     } \
     break;
@@ -132,4 +132,23 @@ Features* PreclickUrbWordFeatureFunction::genFeatures(const std::vector<fg_lite:
 #undef FOR_TOP_ITEMTYPE
 }
 
+void PreclickUrbWordFeatureFunction::splitTerms(const ConstString &text, const string &delim,
+                                                TermViewList &terms)
+{
+    size_t n = 0, old = 0;
+    while (n != string::npos) {
+        n = text.find(delim, n);
+        if (n != string::npos) {
+            if (n != old) {
+                terms.push_back(text.subString(old, n - old));
+            }
+            n += delim.length();
+            old = n;
+        }
+    }
+    if (old < text.size()) {
+        terms.push_back(text.subString(old, text.size() - old));
+    }
+}
+
 }
@@ -3,6 +3,7 @@
 
 #include "autil/Log.h"
 #include "autil/StringUtil.h"
+#include "autil/MurmurHash.h"
 #include "fg_lite/feature/FeatureFunction.h"
 #include "fg_lite/feature/FeatureFormatter.h"
 #include "fg_lite/feature/Base64.h"
@@ -46,22 +47,97 @@ public:
     }
 
 private:
+    typedef std::pair<const autil::ConstString, int> TermCount;
+    struct TermHasher {
+        size_t operator()(const autil::ConstString &term) const {
+            return autil::MurmurHash::MurmurHash64A(term.data(), term.size(), 0);
+        }
+    };
+    typedef std::unordered_map<autil::ConstString, int, TermHasher, std::equal_to<autil::ConstString>,
+                               autil::mem_pool::pool_allocator<TermCount>> TermCountMap;
+    typedef std::unordered_set<autil::ConstString, TermHasher, std::equal_to<autil::ConstString>,
+                               autil::mem_pool::pool_allocator<autil::ConstString>> TermSet;
+    typedef pool_vector<autil::ConstString> TermViewList;
+    typedef pool_vector<TermCount *> TermCountList;
+
+    // same as StringUtil::split ignoring empty terms, terms point into text.
+    static void splitTerms(const autil::ConstString &text, const std::string &delim,
+                           TermViewList &terms);
+    // terms of one value in pool, split by item delim and take value of kv.
+    template <typename T>
+    bool getTerms(const T &value, Base64 &base64, autil::mem_pool::PoolBase *pool,
+                  TermViewList &terms, TermViewList &kvList) const {
+        autil::ConstString text;
+        if (_need_decode) {
+            std::string urb(value.data(), value.size());
+            std::string content;
+            if (base64.Decode(&content, urb) < 0) {
+                AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s base64 decode failed", urb.c_str());
+                return false;
+            }
+            text = autil::ConstString(content, pool);
+        } else {
+            text = autil::ConstString(value.data(), value.size(), pool);
+        }
+        terms.clear();
+        splitTerms(text, _delim_item, terms);
+        if (!_need_split_kv) {
+            return true;
+        }
+        for (auto &term : terms) {
+            kvList.clear();
+            splitTerms(term, _delim_kv, kvList);
+            if (kvList.size() != 2) {
+                AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s is not valid kv", term.toString().c_str());
+                return false;
+            }
+            term = kvList[1];
+        }
+        return true;
+    }
+    // keys are copied with a trailing '\0' for comparePairUintKey.
+    static void countTerms(const TermViewList &terms, autil::mem_pool::PoolBase *pool,
+                           TermCountMap &termCountMap) {
+        for (const auto &term : terms) {
+            auto it = termCountMap.find(term);
+            if (termCountMap.end() == it) {
+                termCountMap.emplace(autil::ConstString(term, pool), 1);
+            } else {
+                (it->second)++;
+            }
+        }
+    }
+    void sortTermCounts(TermCountMap &termCountMap, TermCountList &termCountList) const {
+        for (auto it = termCountMap.begin(); it != termCountMap.end(); ++it) {
+            if (it->second > LEAST_WORD_NUM) {
+                termCountList.push_back(&(*it));
+            }
+        }
+        if (_uint64_expression) {
+            std::sort(termCountList.begin(), termCountList.end(), comparePairUintKey);
+        } else {
+            std::sort(termCountList.begin(), termCountList.end(), comparePair);
+        }
+    }
+
     template <typename ETermType, template<typename> class StorageType>
     Features * genTopFeatureTyped(
-            const FeatureInputTyped<ETermType, StorageType<ETermType>> * expressionInput) const {
+            const FeatureInputTyped<ETermType, StorageType<ETermType>> * expressionInput,
+            FeatureFunctionContext *context) const {
         {
             if (!expressionInput) {
                 return nullptr;
             }
 
+            MultiSparseFeatures *features = createFeatures<MultiSparseFeatures>(expressionInput->row(), context);
+            autil::mem_pool::UnsafePool localPool(1024);
+            auto pool = getScratchPool(context, &localPool);
             Base64 base64;
-            std::unordered_map<std::string, int> urbMap;
-            std::unordered_map<std::string, int>::iterator it;
-            std::vector<std::pair<const std::string, int> *> urbPairList;
-            vector<string> urbList;
-            vector<string> kvList;
+            TermCountMap urbMap{autil::mem_pool::pool_allocator<TermCount>(pool)};
+            TermCountList urbPairList{autil::mem_pool::pool_allocator<TermCount *>(pool)};
+            TermViewList urbList{autil::mem_pool::pool_allocator<autil::ConstString>(pool)};
+            TermViewList kvList{autil::mem_pool::pool_allocator<autil::ConstString>(pool)};
 
-            MultiSparseFeatures *features = new MultiSparseFeatures(expressionInput->row());
             size_t rows = expressionInput->row();
             for (size_t i = 0; i < rows; i++) {
                 features->beginDocument();
@@ -71,56 +147,19 @@ private:
                 int colLimit = cols < PRECLICK_ITEM_NUM ? cols : PRECLICK_ITEM_NUM;
                 for (int j = 0; j < colLimit; j++) {
                     ETermType value = expressionInput->get(i, j);
-                    std::string urb(value.data(), value.size());
-
-                    if (_need_decode) {
-                        std::string content;
-                        if (base64.Decode(&content, urb) < 0) {
-                            AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s base64 decode failed", urb.c_str());
-                            return nullptr;
-                        }
-                        urbList = StringUtil::split(content, _delim_item);
-                    } else {
-                        urbList = StringUtil::split(urb, _delim_item);
-                    }
-
-                    for (auto& urbElement : urbList) {
-                        if (_need_split_kv) {
-                            kvList = StringUtil::split(urbElement, _delim_kv);
-                            if (kvList.size() != 2) {
-                                AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s is not valid kv", urbElement.c_str());
-                                return nullptr;
-                            }
-                            urbElement = kvList[1];
-                        }
-
-                        it = urbMap.find(urbElement);
-                        if (urbMap.cend() == it) {
-                            urbMap.emplace(urbElement, 1);
-                        } else {
-                            (it->second)++;
-                        }
+                    if (!getTerms(value, base64, pool, urbList, kvList)) {
+                        delete features;
+                        return nullptr;
                     }
+                    countTerms(urbList, pool, urbMap);
                 }
 
                 urbPairList.clear();
-                urbPairList.reserve(urbList.size());
-                for (auto it = urbMap.begin(); it != urbMap.end(); ++it) {
-                    if (it->second > LEAST_WORD_NUM) {
-                        urbPairList.push_back(&(*it));
-                    }
-                }
-                if (_uint64_expression) {
-                    std::sort(urbPairList.begin(), urbPairList.end(), comparePairUintKey);
-                } else {
-                    std::sort(urbPairList.begin(), urbPairList.end(), comparePair);
-                }
+                sortTermCounts(urbMap, urbPairList);
 
                 size_t outputSize = PRECLICK_WORD_NUM < urbPairList.size() ? PRECLICK_WORD_NUM : urbPairList.size();
                 for (size_t cnt = 0; cnt < outputSize; cnt++) {
-                    FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                    FeatureFormatter::fillFeatureToBuffer(urbPairList[cnt]->first, buffer);
-                    features->addFeatureKey(buffer.data(), buffer.size());
+                    addFeatureKey(features, urbPairList[cnt]->first);
                 }
             }
             return features;
@@ -130,7 +169,8 @@ private:
     template <typename ETermType, typename MTermType, template<typename> class StorageType>
     Features *genMatchFeatureTyped(
             const FeatureInputTyped<ETermType, StorageType<ETermType>> *expressionInput,
-            const FeatureInputTyped<MTermType, StorageType<MTermType>> *matchInput) const {
+            const FeatureInputTyped<MTermType, StorageType<MTermType>> *matchInput,
+            FeatureFunctionContext *context) const {
         {
             if (!expressionInput || !matchInput) {
                 return nullptr;
@@ -142,73 +182,40 @@ private:
                 return nullptr;
             }
 
+            int matchRow = matchInput->row();
+            MultiSparseFeatures *features = createFeatures<MultiSparseFeatures>(matchRow, context);
+            autil::mem_pool::UnsafePool localPool(1024);
+            auto pool = getScratchPool(context, &localPool);
             Base64 base64;
-            std::vector<std::string> termList;
-            std::vector<std::string> kvList;
+            TermViewList termList{autil::mem_pool::pool_allocator<autil::ConstString>(pool)};
+            TermViewList kvList{autil::mem_pool::pool_allocator<autil::ConstString>(pool)};
+            // iteration order decides the output order, keep it as std::string set.
             std::unordered_set<std::string> rawExpressionSet;
-            std::unordered_map<std::string, int> expTermMap;
-            std::unordered_map<std::string, int>::iterator it;
-            std::vector<std::pair<const std::string, int> *> expTermPairList;
+            TermCountMap expTermMap{autil::mem_pool::pool_allocator<TermCount>(pool)};
+            TermCountList expTermPairList{autil::mem_pool::pool_allocator<TermCount *>(pool)};
 
             // generate splitted match words, urb word-count pairs
             int expCols = expressionInput->col(0);
             int colLimit = expCols < PRECLICK_ITEM_NUM ? expCols : PRECLICK_ITEM_NUM;
             for (int j = 0; j < colLimit; j++) {
                 ETermType value = expressionInput->get(0, j);
-                std::string expStr(value.data(), value.size());
 
                 // jump over split and decode
                 if (_raw_expression) {
-                    rawExpressionSet.insert(expStr);
+                    rawExpressionSet.insert(std::string(value.data(), value.size()));
                     continue;
                 }
 
-                if (_need_decode) {
-                    std::string content;
-                    if (base64.Decode(&content, expStr) < 0) {
-                        AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s base64 decode failed", expStr.c_str());
-                        return nullptr;
-                    }
-                    termList = StringUtil::split(content, _delim_item);
-                } else {
-                    termList = StringUtil::split(expStr, _delim_item);
-                }
-
-                for (auto& element : termList) {
-                    if (_need_split_kv) {
-                        kvList = StringUtil::split(element, _delim_kv);
-                        if (kvList.size() != 2) {
-                            AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s is not valid kv", element.c_str());
-                            return nullptr;
-                        }
-                        element = kvList[1];
-                    }
-
-                    it = expTermMap.find(element);
-                    if (expTermMap.cend() == it) {
-                        expTermMap.emplace(element, 1);
-                    } else {
-                        (it->second)++;
-                    }
+                if (!getTerms(value, base64, pool, termList, kvList)) {
+                    delete features;
+                    return nullptr;
                 }
+                countTerms(termList, pool, expTermMap);
             }
-
-            expTermPairList.reserve(termList.size());
-            for (auto it = expTermMap.begin(); it != expTermMap.end(); ++it) {
-                if (it->second > LEAST_WORD_NUM) {
-                    expTermPairList.push_back(&(*it));
-                }
-            }
-            if (_uint64_expression) {
-                std::sort(expTermPairList.begin(), expTermPairList.end(), comparePairUintKey);
-            } else {
-                std::sort(expTermPairList.begin(), expTermPairList.end(), comparePair);
-            }
+            sortTermCounts(expTermMap, expTermPairList);
 
             // for all match (ad), get matched term
-            int matchRow = matchInput->row();
-            MultiSparseFeatures *features = new MultiSparseFeatures(matchRow);
-            std::unordered_set<std::string> matchTermSet;
+            TermSet matchTermSet{autil::mem_pool::pool_allocator<autil::ConstString>(pool)};
             for (int i = 0; i < matchRow; i++) {
                 features->beginDocument();
 
@@ -216,41 +223,20 @@ private:
                 matchTermSet.clear();
                 for (int j = 0; j < matchCol; j++) {
                     MTermType value = matchInput->get(i, j);
-                    std::string ad(value.data(), value.size());
-
-                    if (_need_decode) {
-                        std::string content;
-                        if (base64.Decode(&content, ad) < 0) {
-                            AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s base64 decode failed", ad.c_str());
-                            return nullptr;
-                        }
-                        termList = StringUtil::split(content, _delim_item);
-                    } else {
-                        termList = StringUtil::split(ad, _delim_item);
-                    }
-
-                    for (auto& matchElement : termList) {
-                        if (_need_split_kv) {
-                            kvList = StringUtil::split(matchElement, _delim_kv);
-                            if (kvList.size() != 2) {
-                                AUTIL_LOG(ERROR, "PreclickUrbWordFeature input %s is not valid kv", matchElement.c_str());
-                                return nullptr;
-                            }
-                            matchElement = kvList[1];
-                        }
-                        matchTermSet.insert(matchElement);
+                    if (!getTerms(value, base64, pool, termList, kvList)) {
+                        delete features;
+                        return nullptr;
                     }
+                    matchTermSet.insert(termList.begin(), termList.end());
                 }
 
                 int hit = 0;
                 if (_raw_expression) {
-                    for (auto rawExpTerm : rawExpressionSet) {
-                        if (matchTermSet.find(rawExpTerm) != matchTermSet.end()) {
+                    for (const auto &rawExpTerm : rawExpressionSet) {
+                        if (matchTermSet.find(autil::ConstString(rawExpTerm)) != matchTermSet.end()) {
                             hit++;
                             if (!_output_count) {
-                                FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                                FeatureFormatter::fillFeatureToBuffer(rawExpTerm, buffer);
-                                features->addFeatureKey(buffer.data(), buffer.size());
+                                addFeatureKey(features, rawExpTerm);
                             }
                         }
                     }
@@ -260,9 +246,7 @@ private:
                         if (matchTermSet.find(expTerm->first) != matchTermSet.end()) {
                             hit++;
                             if (!_output_count) {
-                                FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                                FeatureFormatter::fillFeatureToBuffer(expTerm->first, buffer);
-                                features->addFeatureKey(buffer.data(), buffer.size());
+                                addFeatureKey(features, expTerm->first);
                             }
                             if (hit >= MATCHED_WORD_NUM) {
                                 break;
@@ -272,9 +256,7 @@ private:
                 }
 
                 if (_output_count) {
-                    FeatureFormatter::FeatureBuffer buffer = getFeaturePrefix(features->getPool());
-                    FeatureFormatter::fillFeatureToBuffer(hit, buffer);
-                    features->addFeatureKey(buffer.data(), buffer.size());
+                    addFeatureKey(features, hit);
                 }
             }
 
@@ -291,18 +273,18 @@ private:
     bool _raw_expression;
     bool _uint64_expression;
 
-    static bool comparePair(const std::pair<const std::string, int> *elem1 , const std::pair<const std::string, int> *elem2) {
+    static bool comparePair(const TermCount *elem1 , const TermCount *elem2) {
         return (elem1->second != elem2->second) ? (elem1->second > elem2->second) : (elem1->first < elem2->first);
     }
 
-    static bool comparePairUintKey(const std::pair<const std::string, int> *elem1 , const std::pair<const std::string, int> *elem2) {
+    static bool comparePairUintKey(const TermCount *elem1 , const TermCount *elem2) {
         uint64_t elem_key1 = 0l;
         uint64_t elem_key2 = 0l;
 
-        if (StringUtil::strToUInt64(elem1->first.c_str(), elem_key1) && StringUtil::strToUInt64(elem2->first.c_str(), elem_key2)) {
+        if (StringUtil::strToUInt64(elem1->first.data(), elem_key1) && StringUtil::strToUInt64(elem2->first.data(), elem_key2)) {
             return (elem1->second != elem2->second) ? (elem1->second > elem2->second) : (elem_key1 < elem_key2);
         } else {
-            AUTIL_LOG(ERROR, "PreclickUrbWordFeature prase expression wordcount key %s, %s to uint64 failed.", elem1->first.c_str(), elem2->first.c_str());
+            AUTIL_LOG(ERROR, "PreclickUrbWordFeature prase expression wordcount key %s, %s to uint64 failed.", elem1->first.data(), elem2->first.data());
             return 0;
         }
     }
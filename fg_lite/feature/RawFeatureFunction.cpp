@@ -18,115 +18,81 @@ Features *RawFeatureFunction::genFeatures(
     if (input->row() == 0) {
         return nullptr;
     }
-    if (input->storageType() == IST_DENSE && input->col(0) == 1) {
+    TensorBuffer *tensor = getTensorBuffer(context);
+    if (tensor != nullptr && _boundaries.empty()) {
+        return genFeatures(input, make_unique<TensorDenseFeatures>(tensor));
+    }
+    autil::mem_pool::Pool *pool = getFeaturePool(context);
+    if ((input->storageType() == IST_DENSE || input->storageType() == IST_DICTIONARY)
+        && input->col(0) == 1)
+    {
         if (_boundaries.empty()) {
-            return genDenseFeatures<SingleDenseFeatures>(input);
+            return genFeatures(input, make_unique<SingleDenseFeatures>(getFeatureName(), input->row(), pool));
+        } else if (isCompactOutput() && fitInt16()) {
+            return genFeatures(input, make_unique<SingleInt16Features>(getFeatureName(), input->row(), pool));
+        } else if (isCompactOutput()) {
+            return genFeatures(input, make_unique<SingleInt32Features>(getFeatureName(), input->row(), pool));
         } else {
-            return genDenseFeatures<SingleIntegerFeatures>(input);
+            return genFeatures(input, make_unique<SingleIntegerFeatures>(getFeatureName(), input->row(), pool));
         }
     } else {
         if (_boundaries.empty()) {
-            return genSparseFeatures<MultiDenseFeatures>(input);
+            return genFeatures(input, make_unique<MultiDenseFeatures>(getFeatureName(), input->row(), pool));
+        } else if (isCompactOutput() && fitInt16()) {
+            return genFeatures(input, make_unique<MultiInt16Features>(getFeatureName(), input->row(), pool));
+        } else if (isCompactOutput()) {
+            return genFeatures(input, make_unique<MultiInt32Features>(getFeatureName(), input->row(), pool));
         } else {
-            return genSparseFeatures<MultiIntegerFeatures>(input);
+            return genFeatures(input, make_unique<MultiIntegerFeatures>(getFeatureName(), input->row(), pool));
         }
     }
 }
 
-template <typename T, typename FeatureType, typename StorageType>
+template <typename TypedFeatureInput, typename FeatureType>
 void RawFeatureFunction::genFeaturesTyped(
-        FeatureInput *input,
+        const TypedFeatureInput *input,
         FeatureType *features) const
 {
-    typedef FeatureInputTyped<T, StorageType> FeatureInputTyped;
-    FeatureInputTyped *typedInput = dynamic_cast<FeatureInputTyped*>(input);
-    for (size_t i = 0; i < typedInput->row(); i++) {
-        appendSparseOffset(features);
-        for (size_t j = 0; j < typedInput->col(i); j++) {
-            T value = typedInput->get(i, j);
-            float floatValue = 0.0f;
-            FloatValueConvertor::convertToFloat(value, floatValue);
-            if (std::isnan(floatValue)) {
-                floatValue = 0.0f;
-            }
-            floatValue = _normalizer.normalize(floatValue);
-            addFeatureMayBucketize(features, _boundaries, floatValue);
-        }
-        if (!_boundaries.empty()) {
-            for (int j = typedInput->col(i); j < _valueDimension; j++) {
-                addFeatureMayBucketize(features, _boundaries, 0);
-            }
-        }
-    }
+    input->visitRows([&](size_t, const typename TypedFeatureInput::RowType &values) {
+                appendSparseOffset(features);
+                const bool checkValidity = hasValidity(values);
+                for (size_t j = 0; j < values.size(); j++) {
+                    float floatValue = 0.0f;
+                    // null values are taken as 0 like nan
+                    if (!checkValidity || isValidAt(values, j)) {
+                        FloatValueConvertor::convertToFloat(values[j], floatValue);
+                    }
+                    if (std::isnan(floatValue)) {
+                        floatValue = 0.0f;
+                    }
+                    floatValue = _normalizer.normalize(floatValue);
+                    addFeatureMayBucketize(features, _boundaries, floatValue);
+                }
+                if (!_boundaries.empty()) {
+                    for (int j = values.size(); j < _valueDimension; j++) {
+                        addFeatureMayBucketize(features, _boundaries, 0);
+                    }
+                }
+            });
 }
 
 template<typename FeatureType>
-Features *RawFeatureFunction::genDenseFeatures(FeatureInput *input) const {
-    auto features = make_unique<FeatureType>(getFeatureName(), input->row());
-
-#define CASE(t)                                                         \
-    case t: {                                                           \
-        typedef InputType2Type<t>::Type Type;                           \
-        genFeaturesTyped<Type, FeatureType, DenseStorage<Type> >(input, features.get()); \
-    }                                                                   \
-        break
-    switch (input->dataType()) {
-        CASE(IT_INT8);
-        CASE(IT_UINT8);
-        CASE(IT_INT16);
-        CASE(IT_UINT16);
-        CASE(IT_INT32);
-        CASE(IT_UINT32);
-        CASE(IT_INT64);
-        CASE(IT_UINT64);
-        CASE(IT_FLOAT);
-        CASE(IT_DOUBLE);
-        CASE(IT_STRING);
-        CASE(IT_CSTRING);
-    default:
+Features *RawFeatureFunction::genFeatures(FeatureInput *input,
+        unique_ptr<FeatureType> features) const
+{
+    bool supported = visitTypedInput(input, [&](const auto *typedInput) {
+                this->genFeaturesTyped(typedInput, features.get());
+            });
+    if (!supported) {
         AUTIL_LOG(ERROR, "RawFeature[%s] input type[%d] not support",
                   getFeatureName().c_str(), input->dataType());
         return nullptr;
     }
-#undef CASE
-    return features.release();
-}
-
-template<typename FeatureType>
-Features *RawFeatureFunction::genSparseFeatures(FeatureInput *input) const {
-    auto features = make_unique<FeatureType>(getFeatureName(), input->row());
-
-#define CASE(t)                                                         \
-    case t: {                                                           \
-        typedef InputType2Type<t>::Type Type;                           \
-        if (input->storageType() == IST_SPARSE_MULTI_VALUE) {           \
-            genFeaturesTyped<Type, FeatureType, MultiValueStorage<Type> >(input, features.get()); \
-        } else if (input->storageType() == IST_DENSE) {                              \
-            genFeaturesTyped<Type, FeatureType, DenseStorage<Type> >(input, features.get()); \
-        } else {                                                        \
-            genFeaturesTyped<Type, FeatureType, ValueOffsetStorage<Type> >(input, features.get()); \
-        }                                                               \
-    }                                                                   \
-        break
-    switch (input->dataType()) {
-        CASE(IT_INT8);
-        CASE(IT_UINT8);
-        CASE(IT_INT16);
-        CASE(IT_UINT16);
-        CASE(IT_INT32);
-        CASE(IT_UINT32);
-        CASE(IT_INT64);
-        CASE(IT_UINT64);
-        CASE(IT_FLOAT);
-        CASE(IT_DOUBLE);
-        CASE(IT_STRING);
-        CASE(IT_CSTRING);
-    default:
-        AUTIL_LOG(ERROR, "RawFeature[%s] input type[%d] not support",
-                  getFeatureName().c_str(), input->dataType());
+    if (hasOverflow(features.get())) {
+        AUTIL_LOG(ERROR, "RawFeature[%s] values exceed the limit of compact output",
+                  getFeatureName().c_str());
         return nullptr;
     }
-#undef CASE
     return features.release();
 }
 
@@ -136,12 +102,27 @@ void RawFeatureFunction::appendSparseOffset(Features *features) {
 
 template<>
 void RawFeatureFunction::appendSparseOffset<MultiDenseFeatures>(MultiDenseFeatures *features) {
-    features->_offsets.push_back(features->_featureValues.size());
+    features->beginDocument();
 }
 
 template<>
 void RawFeatureFunction::appendSparseOffset<MultiIntegerFeatures>(MultiIntegerFeatures *features) {
-    features->_offsets.push_back(features->_featureValues.size());
+    features->beginDocument();
+}
+
+template<>
+void RawFeatureFunction::appendSparseOffset<MultiInt32Features>(MultiInt32Features *features) {
+    features->beginDocument();
+}
+
+template<>
+void RawFeatureFunction::appendSparseOffset<MultiInt16Features>(MultiInt16Features *features) {
+    features->beginDocument();
+}
+
+template<>
+void RawFeatureFunction::appendSparseOffset<TensorDenseFeatures>(TensorDenseFeatures *features) {
+    features->beginDocument();
 }
 
 }
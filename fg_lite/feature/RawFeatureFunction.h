@@ -28,17 +28,35 @@ public:
     size_t getInputCount() const override {
         return 1;
     }
+    bool supportDictionaryInput() const override {
+        return true;
+    }
+    // bucket ids are at most the boundary count, they are int16 if that fits
+    // and int32 otherwise
+    bool supportCompactOutput() const override {
+        return !_boundaries.empty() &&
+            _boundaries.size() <= size_t(std::numeric_limits<int32_t>::max());
+    }
 private:
     template<typename FeatureType>
-    Features *genDenseFeatures(FeatureInput *input) const;
-    template<typename FeatureType>
-    Features *genSparseFeatures(FeatureInput *input) const;
-    template <typename T, typename FeatureType, typename StorageType>
-    void genFeaturesTyped(FeatureInput *input, FeatureType *features) const;
+    Features *genFeatures(FeatureInput *input, std::unique_ptr<FeatureType> features) const;
+    template <typename TypedFeatureInput, typename FeatureType>
+    void genFeaturesTyped(const TypedFeatureInput *input, FeatureType *features) const;
     void addFeature(SingleDenseFeatures *features, float value) const;
     void addFeature(SingleIntegerFeatures *features, float value) const;
     template<typename Features>
     static void appendSparseOffset(Features *features);
+    // the compact types drop values past their 4G value limit
+    static bool hasOverflow(const Features * /*features*/) {
+        return false;
+    }
+    template<typename T>
+    static bool hasOverflow(const SingleIntegerFeaturesTyped<T> *features) {
+        return features->overflow();
+    }
+    bool fitInt16() const {
+        return _boundaries.size() <= size_t(std::numeric_limits<int16_t>::max());
+    }
 private:
     Normalizer _normalizer;
     std::vector<float> _boundaries;
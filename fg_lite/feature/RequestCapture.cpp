@@ -0,0 +1,596 @@
+#include "fg_lite/feature/RequestCapture.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "autil/MultiValueCreator.h"
+
+using namespace std;
+using namespace autil;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, RequestCaptureWriter);
+AUTIL_LOG_SETUP(fg_lite, CapturedRequest);
+AUTIL_LOG_SETUP(fg_lite, RequestCaptureReader);
+
+template <typename T>
+static void appendValue(const T &value, string &out) {
+    out.append((const char*)&value, sizeof(T));
+}
+
+static void appendString(const char *data, size_t length, string &out) {
+    appendValue((uint32_t)length, out);
+    out.append(data, length);
+}
+
+static void appendValue(const MultiChar &value, string &out) {
+    appendString(value.data(), value.size(), out);
+}
+
+static void appendValue(const string &value, string &out) {
+    appendString(value.data(), value.size(), out);
+}
+
+template <typename T, typename StorageType>
+static bool encodeTyped(const FeatureInput *input, string &out) {
+    auto typedInput = dynamic_cast<const FeatureInputTyped<T, StorageType>*>(input);
+    if (typedInput == nullptr) {
+        return false;
+    }
+    size_t row = typedInput->row();
+    appendValue((uint64_t)row, out);
+    if (StorageType::STORAGE_ENUM == IST_DENSE) {
+        appendValue((uint64_t)(row > 0 ? typedInput->col(0) : 0), out);
+    } else {
+        for (size_t r = 0; r < row; r++) {
+            appendValue((uint32_t)typedInput->col(r), out);
+        }
+    }
+    appendValue((uint8_t)typedInput->hasValidity(), out);
+    if (typedInput->hasValidity()) {
+        vector<uint64_t> bits;
+        size_t id = 0;
+        for (size_t r = 0; r < row; r++) {
+            for (size_t c = 0; c < typedInput->col(r); c++, id++) {
+                if ((id & 63) == 0) {
+                    bits.push_back(0);
+                }
+                bits.back() |= uint64_t(typedInput->isValid(r, c)) << (id & 63);
+            }
+        }
+        out.append((const char*)bits.data(), bits.size() * sizeof(uint64_t));
+    }
+    for (size_t r = 0; r < row; r++) {
+        for (size_t c = 0; c < typedInput->col(r); c++) {
+            appendValue(typedInput->get(r, c), out);
+        }
+    }
+    return true;
+}
+
+// the whole dictionary and the codes of the rows, values are not expanded
+template <typename T>
+static bool encodeDictionary(const FeatureInput *input, string &out) {
+    auto typedInput = dynamic_cast<const FeatureInputTyped<T, DictionaryStorage<T>>*>(input);
+    if (typedInput == nullptr) {
+        return false;
+    }
+    const DictionaryStorage<T> &storage = typedInput->getStorage();
+    size_t row = storage.row();
+    size_t col = row > 0 ? storage.col(0) : 0;
+    appendValue((uint64_t)row, out);
+    appendValue((uint64_t)col, out);
+    appendValue((uint64_t)storage.dictionarySize(), out);
+    out.append((const char*)storage.getCodes(), row * col * sizeof(uint32_t));
+    appendValue((uint8_t)0, out);
+    for (size_t i = 0; i < storage.dictionarySize(); i++) {
+        appendValue(storage.getDictionary()[i], out);
+    }
+    return true;
+}
+
+template <typename T>
+static bool encodeInput(const FeatureInput *input, string &out) {
+    switch (input->storageType()) {
+    case IST_DENSE:
+        return encodeTyped<T, DenseStorage<T>>(input, out);
+    case IST_SPARSE_MULTI_VALUE:
+        return encodeTyped<T, MultiValueStorage<T>>(input, out);
+    case IST_SPARSE_VALUE_OFFSET:
+        return encodeTyped<T, ValueOffsetStorage<T>>(input, out);
+    case IST_DICTIONARY:
+        return encodeDictionary<T>(input, out);
+    default:
+        return false;
+    }
+}
+
+template <>
+bool encodeInput<string>(const FeatureInput *input, string &out) {
+    switch (input->storageType()) {
+    case IST_DENSE:
+        return encodeTyped<string, DenseStorage<string>>(input, out);
+    case IST_SPARSE_VALUE_OFFSET:
+        return encodeTyped<string, ValueOffsetStorage<string>>(input, out);
+    case IST_DICTIONARY:
+        return encodeDictionary<string>(input, out);
+    default:
+        return false;
+    }
+}
+
+RequestCaptureWriter::RequestCaptureWriter(size_t sampleInterval, size_t maxRequestCount)
+    : _file(nullptr)
+    , _sampleInterval(max(sampleInterval, (size_t)1))
+    , _maxRequestCount(maxRequestCount)
+    , _requestCount(0)
+    , _writtenCount(0)
+{
+}
+
+RequestCaptureWriter::~RequestCaptureWriter() {
+    close();
+}
+
+bool RequestCaptureWriter::open(const string &path, const string &configJson) {
+    close();
+    _path = path;
+    _file = fopen(path.c_str(), "wb");
+    if (_file == nullptr) {
+        AUTIL_LOG(ERROR, "open capture[%s] for write failed", path.c_str());
+        return false;
+    }
+    RequestCaptureHeader header;
+    header.magic = RequestCaptureHeader::MAGIC;
+    header.configLength = configJson.size();
+    if (fwrite(&header, sizeof(header), 1, _file) != 1 ||
+        fwrite(configJson.data(), 1, configJson.size(), _file) != configJson.size())
+    {
+        AUTIL_LOG(ERROR, "write capture[%s] header failed", path.c_str());
+        close();
+        return false;
+    }
+    _requestCount.store(0, memory_order_relaxed);
+    _writtenCount.store(0, memory_order_relaxed);
+    return true;
+}
+
+bool RequestCaptureWriter::close() {
+    lock_guard<mutex> guard(_lock);
+    if (_file == nullptr) {
+        return true;
+    }
+    bool ret = fclose(_file) == 0;
+    _file = nullptr;
+    if (!ret) {
+        AUTIL_LOG(ERROR, "close capture[%s] failed", _path.c_str());
+    }
+    return ret;
+}
+
+bool RequestCaptureWriter::sample(const vector<string> &inputNames,
+                                  const vector<FeatureInput*> &inputs)
+{
+    size_t requestIdx = _requestCount.fetch_add(1, memory_order_relaxed);
+    if (requestIdx % _sampleInterval != 0 ||
+        _writtenCount.load(memory_order_relaxed) >= _maxRequestCount)
+    {
+        return false;
+    }
+    return write(inputNames, inputs);
+}
+
+bool RequestCaptureWriter::write(const vector<string> &inputNames,
+                                 const vector<FeatureInput*> &inputs)
+{
+    string record;
+    if (!encode(inputNames, inputs, record)) {
+        return false;
+    }
+    uint64_t length = record.size();
+    lock_guard<mutex> guard(_lock);
+    if (_file == nullptr || _writtenCount.load(memory_order_relaxed) >= _maxRequestCount) {
+        return false;
+    }
+    if (fwrite(&length, sizeof(length), 1, _file) != 1 ||
+        fwrite(record.data(), 1, record.size(), _file) != record.size())
+    {
+        AUTIL_LOG(ERROR, "write capture[%s] failed", _path.c_str());
+        return false;
+    }
+    _writtenCount.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+bool RequestCaptureWriter::encode(const vector<string> &inputNames,
+                                  const vector<FeatureInput*> &inputs,
+                                  string &record)
+{
+    record.clear();
+    if (inputNames.size() != inputs.size()) {
+        AUTIL_LOG(ERROR, "expect %lu inputs, but got %lu", inputNames.size(), inputs.size());
+        return false;
+    }
+    appendValue((uint32_t)inputs.size(), record);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const FeatureInput *input = inputs[i];
+        appendValue(inputNames[i], record);
+        if (input == nullptr) {
+            AUTIL_LOG(ERROR, "input[%s] is null", inputNames[i].c_str());
+            return false;
+        }
+        appendValue((uint32_t)input->dataType(), record);
+        appendValue((uint32_t)input->storageType(), record);
+        bool ret = false;
+        switch (input->dataType()) {
+#define CASE(vt)                                                        \
+        case vt:                                                        \
+            ret = encodeInput<InputType2Type<vt>::Type>(input, record); \
+            break
+            INPUT_DATA_TYPE_MACRO_HELPER(CASE);
+#undef CASE
+        default:
+            break;
+        }
+        if (!ret) {
+            AUTIL_LOG(ERROR, "input[%s] data type[%d] storage type[%d] not supported",
+                      inputNames[i].c_str(), input->dataType(), input->storageType());
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+class RecordDecoder
+{
+public:
+    RecordDecoder(const char *data, size_t length)
+        : _cur(data)
+        , _end(data + length)
+    {}
+public:
+    template <typename T>
+    bool read(T &value) {
+        if ((size_t)(_end - _cur) < sizeof(T)) {
+            return false;
+        }
+        memcpy(&value, _cur, sizeof(T));
+        _cur += sizeof(T);
+        return true;
+    }
+    bool readString(const char *&data, uint32_t &length) {
+        if (!read(length) || (size_t)(_end - _cur) < length) {
+            return false;
+        }
+        data = _cur;
+        _cur += length;
+        return true;
+    }
+    bool read(string &value) {
+        const char *data = nullptr;
+        uint32_t length = 0;
+        if (!readString(data, length)) {
+            return false;
+        }
+        value.assign(data, length);
+        return true;
+    }
+    // MultiChar is built in pool
+    bool read(MultiChar &value, mem_pool::Pool *pool) {
+        const char *data = nullptr;
+        uint32_t length = 0;
+        if (!readString(data, length)) {
+            return false;
+        }
+        value.init(MultiValueCreator::createMultiValueBuffer(data, length, pool));
+        return true;
+    }
+    template <typename T>
+    bool read(T &value, mem_pool::Pool *) {
+        return read(value);
+    }
+    bool eof() const { return _cur == _end; }
+    size_t left() const { return _end - _cur; }
+private:
+    const char *_cur;
+    const char *_end;
+};
+
+}
+
+// bytes a value takes at least in a record, strings are length prefixed
+template <typename T>
+struct EncodedSize {
+    static const size_t value = sizeof(T);
+};
+template <>
+struct EncodedSize<string> {
+    static const size_t value = sizeof(uint32_t);
+};
+template <>
+struct EncodedSize<MultiChar> {
+    static const size_t value = sizeof(uint32_t);
+};
+
+// row * colCount values, false if they can not fit in the record
+static bool getValueCount(const RecordDecoder &decoder, uint64_t row, uint64_t colCount,
+                          size_t &valueCount)
+{
+    if (colCount != 0 && row > decoder.left() / colCount) {
+        return false;
+    }
+    valueCount = row * colCount;
+    return true;
+}
+
+template <typename T>
+static bool readValues(RecordDecoder &decoder, size_t count, mem_pool::Pool *pool,
+                       vector<T> &values)
+{
+    // checked before sizing values, a corrupt count fails instead of allocating
+    if (count > decoder.left() / EncodedSize<T>::value) {
+        return false;
+    }
+    values.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        if (!decoder.read(values[i], pool)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+static bool createMultiValues(const vector<T> &values, const vector<uint32_t> &cols,
+                              mem_pool::Pool *pool, vector<MultiValueType<T>> &multiValues)
+{
+    size_t begin = 0;
+    for (uint32_t col : cols) {
+        vector<T> rowValues(values.begin() + begin, values.begin() + begin + col);
+        multiValues.emplace_back(MultiValueCreator::createMultiValueBuffer(rowValues, pool));
+        begin += col;
+    }
+    return true;
+}
+
+static bool createMultiValues(const vector<MultiChar> &values, const vector<uint32_t> &cols,
+                              mem_pool::Pool *pool, vector<MultiString> &multiValues)
+{
+    size_t begin = 0;
+    for (uint32_t col : cols) {
+        vector<string> rowValues;
+        for (size_t i = begin; i < begin + col; i++) {
+            rowValues.emplace_back(values[i].data(), values[i].size());
+        }
+        MultiString multiString;
+        multiString.init(MultiValueCreator::createMultiStringBuffer(rowValues, pool));
+        multiValues.push_back(multiString);
+        begin += col;
+    }
+    return true;
+}
+
+static bool createMultiValues(const vector<string> &, const vector<uint32_t> &,
+                              mem_pool::Pool *, vector<MultiValueType<string>> &)
+{
+    return false;
+}
+
+CapturedRequest::CapturedRequest() {
+}
+
+CapturedRequest::~CapturedRequest() {
+    clear();
+}
+
+void CapturedRequest::clear() {
+    for (auto input : _inputs) {
+        delete input;
+    }
+    _inputs.clear();
+    _inputNames.clear();
+    _buffers.clear();
+    _pool.reset();
+}
+
+CapturedRequest::NamedInputs CapturedRequest::getNamedInputs() const {
+    NamedInputs namedInputs;
+    for (size_t i = 0; i < _inputs.size(); i++) {
+        namedInputs[_inputNames[i]] = _inputs[i];
+    }
+    return namedInputs;
+}
+
+size_t CapturedRequest::getDocCount() const {
+    size_t docCount = 0;
+    for (auto input : _inputs) {
+        docCount = max(docCount, input->row());
+    }
+    return docCount;
+}
+
+bool CapturedRequest::decode(const char *data, size_t length) {
+    clear();
+    RecordDecoder decoder(data, length);
+    uint32_t inputCount = 0;
+    if (!decoder.read(inputCount)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < inputCount; i++) {
+        string name;
+        uint32_t dataType = 0;
+        uint32_t storageType = 0;
+        uint64_t row = 0;
+        if (!decoder.read(name) || !decoder.read(dataType) ||
+            !decoder.read(storageType) || !decoder.read(row))
+        {
+            AUTIL_LOG(ERROR, "input[%u] header is truncated", i);
+            return false;
+        }
+        uint64_t colCount = 0;
+        vector<uint32_t> cols;
+        size_t valueCount = 0;
+        vector<uint32_t> *codes = nullptr;
+        if (storageType == IST_DENSE) {
+            if (!decoder.read(colCount) || !getValueCount(decoder, row, colCount, valueCount)) {
+                return false;
+            }
+        } else if (storageType == IST_DICTIONARY) {
+            uint64_t dictionarySize = 0;
+            size_t codeCount = 0;
+            codes = createBuffer<uint32_t>();
+            if (!decoder.read(colCount) || !decoder.read(dictionarySize) ||
+                !getValueCount(decoder, row, colCount, codeCount) ||
+                !readValues(decoder, codeCount, &_pool, *codes))
+            {
+                return false;
+            }
+            for (uint32_t code : *codes) {
+                if (code >= dictionarySize) {
+                    AUTIL_LOG(ERROR, "input[%s] code[%u] out of dictionary[%lu]",
+                              name.c_str(), code, dictionarySize);
+                    return false;
+                }
+            }
+            valueCount = dictionarySize;
+        } else {
+            if (row > decoder.left() / sizeof(uint32_t)) {
+                AUTIL_LOG(ERROR, "input[%s] row[%lu] is truncated", name.c_str(), row);
+                return false;
+            }
+            cols.resize(row);
+            for (auto &col : cols) {
+                if (!decoder.read(col)) {
+                    return false;
+                }
+                valueCount += col;
+            }
+        }
+        uint8_t hasValidity = 0;
+        if (!decoder.read(hasValidity)) {
+            return false;
+        }
+        ValidityBitmap validity;
+        if (hasValidity) {
+            vector<uint64_t> *bits = createBuffer<uint64_t>();
+            if (storageType == IST_SPARSE_MULTI_VALUE || storageType == IST_DICTIONARY ||
+                !readValues(decoder, (valueCount + 63) / 64, &_pool, *bits))
+            {
+                AUTIL_LOG(ERROR, "input[%s] validity is invalid", name.c_str());
+                return false;
+            }
+            validity = ValidityBitmap(bits->data());
+        }
+        FeatureInput *input = nullptr;
+        switch (dataType) {
+#define CASE(vt)                                                        \
+        case vt: {                                                      \
+            typedef InputType2Type<vt>::Type T;                         \
+            vector<T> *values = createBuffer<T>();                      \
+            if (!readValues(decoder, valueCount, &_pool, *values)) {    \
+                break;                                                  \
+            }                                                           \
+            if (storageType == IST_DENSE) {                             \
+                input = new FeatureInputTyped<T, DenseStorage<T>>(DenseStorage<T>( \
+                                values->data(), row, colCount, validity)); \
+            } else if (storageType == IST_SPARSE_VALUE_OFFSET) {        \
+                vector<size_t> *offsets = createBuffer<size_t>();       \
+                size_t offset = 0;                                      \
+                for (uint32_t col : cols) {                             \
+                    offsets->push_back(offset);                         \
+                    offset += col;                                      \
+                }                                                       \
+                input = new FeatureInputTyped<T, ValueOffsetStorage<T>>(ValueOffsetStorage<T>( \
+                                values->data(), values->size(), offsets->data(), row, \
+                                validity));                             \
+            } else if (storageType == IST_DICTIONARY) {                 \
+                input = new FeatureInputTyped<T, DictionaryStorage<T>>(DictionaryStorage<T>( \
+                                values->data(), values->size(), codes->data(), row, colCount)); \
+            } else if (storageType == IST_SPARSE_MULTI_VALUE) {         \
+                auto multiValues = createBuffer<MultiValueType<T>>();   \
+                if (createMultiValues(*values, cols, &_pool, *multiValues)) { \
+                    input = new FeatureInputTyped<T, MultiValueStorage<T>>(MultiValueStorage<T>( \
+                                    multiValues->data(), row));         \
+                }                                                       \
+            }                                                           \
+            break;                                                      \
+        }
+            INPUT_DATA_TYPE_MACRO_HELPER(CASE);
+#undef CASE
+        default:
+            break;
+        }
+        if (input == nullptr) {
+            AUTIL_LOG(ERROR, "decode input[%s] data type[%u] storage type[%u] failed",
+                      name.c_str(), dataType, storageType);
+            return false;
+        }
+        _inputNames.push_back(name);
+        _inputs.push_back(input);
+    }
+    if (!decoder.eof()) {
+        AUTIL_LOG(ERROR, "unexpected bytes after %u inputs", inputCount);
+        return false;
+    }
+    return true;
+}
+
+RequestCaptureReader::RequestCaptureReader()
+    : _pos(0)
+{
+}
+
+RequestCaptureReader::~RequestCaptureReader() {
+}
+
+bool RequestCaptureReader::open(const string &path) {
+    _path = path;
+    _data.clear();
+    _config.clear();
+    _pos = 0;
+    ifstream in(path.c_str(), ios::binary);
+    if (!in) {
+        AUTIL_LOG(ERROR, "open capture[%s] failed", path.c_str());
+        return false;
+    }
+    stringstream content;
+    content << in.rdbuf();
+    _data = content.str();
+    RequestCaptureHeader header;
+    if (_data.size() < sizeof(header)) {
+        AUTIL_LOG(ERROR, "capture[%s] is too short", path.c_str());
+        return false;
+    }
+    memcpy(&header, _data.data(), sizeof(header));
+    if (header.magic != RequestCaptureHeader::MAGIC ||
+        header.configLength > _data.size() - sizeof(header))
+    {
+        AUTIL_LOG(ERROR, "capture[%s] header is invalid", path.c_str());
+        return false;
+    }
+    _config = _data.substr(sizeof(header), header.configLength);
+    _pos = sizeof(header) + header.configLength;
+    return true;
+}
+
+bool RequestCaptureReader::next(CapturedRequest &request) {
+    uint64_t length = 0;
+    if (_pos + sizeof(length) > _data.size()) {
+        return false;
+    }
+    memcpy(&length, _data.data() + _pos, sizeof(length));
+    if (length > _data.size() - _pos - sizeof(length)) {
+        AUTIL_LOG(ERROR, "capture[%s] record at[%lu] is truncated", _path.c_str(), _pos);
+        return false;
+    }
+    const char *record = _data.data() + _pos + sizeof(length);
+    if (!request.decode(record, length)) {
+        AUTIL_LOG(ERROR, "capture[%s] record at[%lu] is broken", _path.c_str(), _pos);
+        return false;
+    }
+    _pos += sizeof(length) + length;
+    return true;
+}
+
+}
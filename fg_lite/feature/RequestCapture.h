@@ -0,0 +1,137 @@
+#ifndef ISEARCH_FG_LITE_REQUESTCAPTURE_H
+#define ISEARCH_FG_LITE_REQUESTCAPTURE_H
+
+#include <atomic>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "autil/Log.h"
+#include "autil/mem_pool/Pool.h"
+#include "fg_lite/feature/FeatureInput.h"
+
+namespace fg_lite {
+
+/*
+ * captured requests for replay. the file starts with the header and the
+ * feature config JSON, then one record per request:
+ *   uint64 record length, uint32 input count, then every input as
+ *   uint32 name length, name, uint32 data type, uint32 storage type,
+ *   uint64 row count, uint64 col count for IST_DENSE or uint32 col[row]
+ *   otherwise, uint8 has validity and if set the validity bitmap of the
+ *   values in 64 bit words, then the values row by row: numerics as they
+ *   are, strings as uint32 length and chars.
+ * IST_DICTIONARY inputs are written as uint64 row count, uint64 col count,
+ *   uint64 dictionary size, uint32 code[row * col], a zero validity byte
+ *   and the dictionary values.
+ * IT_CSTRING inputs in IST_SPARSE_MULTI_VALUE storage are not supported.
+ */
+struct RequestCaptureHeader {
+    static const uint64_t MAGIC = 0x3150414347464c46ULL; // "FLFGCAP1"
+    uint64_t magic;
+    uint64_t configLength;
+};
+
+class RequestCaptureWriter
+{
+public:
+    // every sampleInterval-th request is written, up to maxRequestCount
+    RequestCaptureWriter(size_t sampleInterval = 1,
+                         size_t maxRequestCount = std::numeric_limits<size_t>::max());
+    ~RequestCaptureWriter();
+private:
+    RequestCaptureWriter(const RequestCaptureWriter &);
+    RequestCaptureWriter& operator=(const RequestCaptureWriter &);
+public:
+    // configJson is the FeatureConfig the plan is built from, for replay
+    bool open(const std::string &path, const std::string &configJson);
+    // count one request and write it if sampled, return true if written.
+    // thread safe, called by FeaturePlan for context->capture.
+    bool sample(const std::vector<std::string> &inputNames,
+                const std::vector<FeatureInput*> &inputs);
+    // thread safe
+    bool write(const std::vector<std::string> &inputNames,
+               const std::vector<FeatureInput*> &inputs);
+    bool close();
+    size_t getWrittenCount() const { return _writtenCount.load(std::memory_order_relaxed); }
+    static bool encode(const std::vector<std::string> &inputNames,
+                       const std::vector<FeatureInput*> &inputs,
+                       std::string &record);
+private:
+    std::string _path;
+    FILE *_file;
+    std::mutex _lock;
+    size_t _sampleInterval;
+    size_t _maxRequestCount;
+    std::atomic<size_t> _requestCount;
+    std::atomic<size_t> _writtenCount;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+// inputs of one captured request, they own their values
+class CapturedRequest
+{
+public:
+    typedef std::unordered_map<std::string, FeatureInput*> NamedInputs;
+public:
+    CapturedRequest();
+    ~CapturedRequest();
+private:
+    CapturedRequest(const CapturedRequest &);
+    CapturedRequest& operator=(const CapturedRequest &);
+public:
+    bool decode(const char *data, size_t length);
+    const std::vector<std::string> &getInputNames() const { return _inputNames; }
+    const std::vector<FeatureInput*> &getInputs() const { return _inputs; }
+    NamedInputs getNamedInputs() const;
+    // max row of the inputs
+    size_t getDocCount() const;
+private:
+    template <typename T>
+    std::vector<T> *createBuffer() {
+        auto buffer = std::make_shared<std::vector<T>>();
+        _buffers.push_back(buffer);
+        return buffer.get();
+    }
+    void clear();
+private:
+    autil::mem_pool::Pool _pool;
+    std::vector<std::string> _inputNames;
+    std::vector<FeatureInput*> _inputs;
+    std::vector<std::shared_ptr<void>> _buffers;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+class RequestCaptureReader
+{
+public:
+    RequestCaptureReader();
+    ~RequestCaptureReader();
+private:
+    RequestCaptureReader(const RequestCaptureReader &);
+    RequestCaptureReader& operator=(const RequestCaptureReader &);
+public:
+    bool open(const std::string &path);
+    const std::string &getConfig() const { return _config; }
+    // false at the end of file or on a broken record, a broken record is
+    // not skipped
+    bool next(CapturedRequest &request);
+    // all records are read
+    bool eof() const { return _pos == _data.size(); }
+private:
+    std::string _path;
+    std::string _data;
+    std::string _config;
+    size_t _pos;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_REQUESTCAPTURE_H
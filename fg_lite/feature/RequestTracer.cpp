@@ -0,0 +1,164 @@
+#include <cstdio>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "fg_lite/feature/RequestTracer.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, RequestTracer);
+
+RequestTracer::RequestTracer(size_t capacity)
+    : _mask(0)
+    , _next(0)
+{
+    size_t slotCount = 1;
+    while (slotCount < capacity) {
+        slotCount <<= 1;
+    }
+    _mask = slotCount - 1;
+    _slots.reset(new Slot[slotCount]);
+    reset();
+}
+
+RequestTracer::~RequestTracer() {
+}
+
+void RequestTracer::reset() {
+    for (size_t i = 0; i <= _mask; i++) {
+        _slots[i].sequence.store(0, memory_order_relaxed);
+    }
+    _next.store(0, memory_order_relaxed);
+    _baseTimeNs = autil::TimeUtility::currentTimeInNanoSeconds();
+}
+
+uint32_t RequestTracer::getThreadId() {
+    thread_local uint32_t threadId = (uint32_t)syscall(SYS_gettid);
+    return threadId;
+}
+
+void RequestTracer::getEvents(vector<TraceEvent> &events) const {
+    events.clear();
+    uint64_t next = _next.load(memory_order_acquire);
+    uint64_t begin = next > _mask + 1 ? next - _mask - 1 : 0;
+    for (uint64_t pos = begin; pos < next; pos++) {
+        const Slot &slot = _slots[pos & _mask];
+        uint64_t sequence = slot.sequence.load(memory_order_acquire);
+        if (sequence != 2 * pos + 2) {
+            continue;
+        }
+        TraceEvent event = slot.event;
+        atomic_thread_fence(memory_order_acquire);
+        if (slot.sequence.load(memory_order_relaxed) != sequence) {
+            continue;
+        }
+        events.push_back(event);
+    }
+}
+
+size_t RequestTracer::getDroppedCount() const {
+    uint64_t next = _next.load(memory_order_relaxed);
+    return next > _mask + 1 ? next - _mask - 1 : 0;
+}
+
+int64_t RequestTracer::getDurationNs() const {
+    vector<TraceEvent> events;
+    getEvents(events);
+    if (events.empty()) {
+        return 0;
+    }
+    int64_t begin = events[0].beginNs;
+    int64_t end = events[0].beginNs + events[0].durationNs;
+    for (const auto &event : events) {
+        begin = min(begin, event.beginNs);
+        end = max(end, event.beginNs + event.durationNs);
+    }
+    return end - begin;
+}
+
+static void appendJsonString(const char *str, string &json) {
+    json += '"';
+    for (const char *p = str != nullptr ? str : ""; *p != '\0'; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            json += buf;
+        } else {
+            json += c;
+        }
+    }
+    json += '"';
+}
+
+static void appendMicroSeconds(int64_t ns, string &json) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", ns / 1000.0);
+    json += buf;
+}
+
+void RequestTracer::toChromeTrace(string &json) const {
+    vector<TraceEvent> events;
+    getEvents(events);
+    uint32_t pid = (uint32_t)getpid();
+    json = "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+        const TraceEvent &event = events[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += "{\"name\":";
+        appendJsonString(event.name, json);
+        json += ",\"cat\":";
+        appendJsonString(event.category, json);
+        json += ",\"ph\":\"X\",\"ts\":";
+        appendMicroSeconds(event.beginNs - _baseTimeNs, json);
+        json += ",\"dur\":";
+        appendMicroSeconds(event.durationNs, json);
+        json += ",\"pid\":" + to_string(pid) + ",\"tid\":" + to_string(event.threadId);
+        json += ",\"args\":{";
+        bool first = true;
+        for (size_t j = 0; j < TraceEvent::MAX_ARG_COUNT; j++) {
+            if (event.argNames[j] == nullptr) {
+                continue;
+            }
+            if (!first) {
+                json += ',';
+            }
+            first = false;
+            appendJsonString(event.argNames[j], json);
+            json += ':' + to_string(event.argValues[j]);
+        }
+        json += "}}";
+    }
+    json += "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":";
+    json += to_string(getDroppedCount()) + "}}\n";
+}
+
+bool RequestTracer::dump(const string &path) const {
+    string json;
+    toChromeTrace(json);
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        AUTIL_LOG(ERROR, "open trace file[%s] failed", path.c_str());
+        return false;
+    }
+    bool ret = fwrite(json.data(), 1, json.size(), file) == json.size();
+    ret = fclose(file) == 0 && ret;
+    if (!ret) {
+        AUTIL_LOG(ERROR, "write trace file[%s] failed", path.c_str());
+    }
+    return ret;
+}
+
+bool RequestTracer::dumpIfSlow(int64_t slowThresholdUs, const string &path) const {
+    int64_t durationNs = getDurationNs();
+    if (durationNs == 0 || durationNs < slowThresholdUs * 1000) {
+        return false;
+    }
+    AUTIL_LOG(INFO, "request took %ld us, dump trace to [%s]", durationNs / 1000, path.c_str());
+    return dump(path);
+}
+
+}
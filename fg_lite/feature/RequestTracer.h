@@ -0,0 +1,130 @@
+#ifndef ISEARCH_FG_LITE_REQUESTTRACER_H
+#define ISEARCH_FG_LITE_REQUESTTRACER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "autil/Log.h"
+#include "autil/TimeUtility.h"
+
+namespace fg_lite {
+
+struct TraceEvent {
+    static const size_t MAX_ARG_COUNT = 4;
+    // names are not copied, they must outlive the tracer. feature names of
+    // the plan and string literals do.
+    const char *name = nullptr;
+    const char *category = nullptr;
+    int64_t beginNs = 0;
+    int64_t durationNs = 0;
+    uint32_t threadId = 0;
+    const char *argNames[MAX_ARG_COUNT] = {nullptr, nullptr, nullptr, nullptr};
+    int64_t argValues[MAX_ARG_COUNT] = {0, 0, 0, 0};
+};
+
+/*
+ * spans of one request, recorded by FeaturePlan when context->tracer is set:
+ * plan stages, every feature and the item cache lookups with their hits and
+ * misses, the broadcast cache lookups of a feature are args of its span.
+ * events go into a ring buffer of fixed capacity, a writer claims a slot by
+ * one atomic increment and publishes it by a sequence number, so recording
+ * never takes a lock. the oldest events are overwritten when the ring is
+ * full. toChromeTrace() writes the trace_event JSON which chrome://tracing
+ * and Perfetto load, one track per thread.
+ */
+class RequestTracer
+{
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        TraceEvent event;
+    };
+public:
+    // capacity is rounded up to a power of 2
+    explicit RequestTracer(size_t capacity = 4096);
+    ~RequestTracer();
+private:
+    RequestTracer(const RequestTracer &);
+    RequestTracer& operator=(const RequestTracer &);
+public:
+    void record(const TraceEvent &event);
+    // published events in record order, events still being written are skipped
+    void getEvents(std::vector<TraceEvent> &events) const;
+    // events overwritten since the tracer was created or reset
+    size_t getDroppedCount() const;
+    // from the first begin to the last end of the events, 0 if none
+    int64_t getDurationNs() const;
+    // timestamps are relative to the creation or reset of the tracer
+    void toChromeTrace(std::string &json) const;
+    bool dump(const std::string &path) const;
+    // dump only if the request took at least slowThresholdUs, return true
+    // if the trace was written. for sampling the traces of slow requests.
+    bool dumpIfSlow(int64_t slowThresholdUs, const std::string &path) const;
+    // not thread safe with record
+    void reset();
+public:
+    size_t getCapacity() const { return _mask + 1; }
+    int64_t getBaseTimeNs() const { return _baseTimeNs; }
+    static uint32_t getThreadId();
+private:
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask;
+    std::atomic<uint64_t> _next;
+    int64_t _baseTimeNs;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+/*
+ * records the span from construction to destruction, does nothing if
+ * tracer is nullptr.
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(RequestTracer *tracer, const char *name, const char *category)
+        : _tracer(tracer)
+    {
+        if (_tracer != nullptr) {
+            _event.name = name;
+            _event.category = category;
+            _event.beginNs = autil::TimeUtility::currentTimeInNanoSeconds();
+        }
+    }
+    ~TraceSpan() {
+        if (_tracer != nullptr) {
+            _event.durationNs = autil::TimeUtility::currentTimeInNanoSeconds() - _event.beginNs;
+            _event.threadId = RequestTracer::getThreadId();
+            _tracer->record(_event);
+        }
+    }
+private:
+    TraceSpan(const TraceSpan &);
+    TraceSpan& operator=(const TraceSpan &);
+public:
+    // name must outlive the tracer, args beyond MAX_ARG_COUNT are ignored
+    void setArg(size_t idx, const char *name, int64_t value) {
+        if (_tracer != nullptr && idx < TraceEvent::MAX_ARG_COUNT) {
+            _event.argNames[idx] = name;
+            _event.argValues[idx] = value;
+        }
+    }
+private:
+    RequestTracer *_tracer;
+    TraceEvent _event;
+};
+
+inline void RequestTracer::record(const TraceEvent &event) {
+    uint64_t pos = _next.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = _slots[pos & _mask];
+    // odd while writing, 2 * (pos + 1) once published
+    slot.sequence.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event = event;
+    slot.sequence.store(2 * pos + 2, std::memory_order_release);
+}
+
+}
+
+#endif //ISEARCH_FG_LITE_REQUESTTRACER_H
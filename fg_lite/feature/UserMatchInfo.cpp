@@ -154,4 +154,16 @@ bool UserMatchInfo::empty() const {
     return _categoryMap.empty();
 }
 
+size_t UserMatchInfo::getMemoryUse() const {
+    // node and bucket overhead of the maps, keys and values are views
+    const size_t nodeSize = sizeof(void*) + sizeof(size_t);
+    size_t memoryUse = sizeof(*this) + _categoryMap.bucket_count() * sizeof(void*);
+    for (const auto &category : _categoryMap) {
+        memoryUse += nodeSize + sizeof(category);
+        memoryUse += category.second.bucket_count() * sizeof(void*);
+        memoryUse += category.second.size() * (nodeSize + sizeof(KeyValueMap::value_type));
+    }
+    return memoryUse;
+}
+
 }
@@ -55,6 +55,8 @@ public:
                              int32_t &matchedCount) const;
     void clear();
     bool empty() const;
+    // estimated bytes of the parsed maps, excluding the viewed user info
+    size_t getMemoryUse() const;
 public:
     bool parseUserInfo(const std::string &userInfo) {
         return parseUserInfo(autil::ConstString(userInfo));
@@ -0,0 +1,183 @@
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+
+using namespace std;
+
+namespace fg_lite {
+AUTIL_LOG_SETUP(fg_lite, WorkStealingThreadPool);
+
+static thread_local const WorkStealingThreadPool *tlsPool = nullptr;
+static thread_local size_t tlsWorkerIdx = 0;
+
+WorkStealingThreadPool::WorkStealingThreadPool(size_t threadNum)
+    : _threadNum(threadNum)
+    , _pendingCount(0)
+    , _nextQueue(0)
+    , _running(false)
+{
+    size_t queueNum = max(threadNum, (size_t)1);
+    for (size_t i = 0; i < queueNum; i++) {
+        _queues.emplace_back(new WorkQueue());
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+    stop();
+    Task task;
+    while (stealTask(0, task)) {
+        task();
+    }
+}
+
+bool WorkStealingThreadPool::start() {
+    if (_running.exchange(true)) {
+        AUTIL_LOG(ERROR, "thread pool already started");
+        return false;
+    }
+    for (size_t i = 0; i < _threadNum; i++) {
+        _threads.emplace_back(&WorkStealingThreadPool::workerLoop, this, i);
+    }
+    return true;
+}
+
+void WorkStealingThreadPool::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    {
+        unique_lock<mutex> lock(_sleepLock);
+        _sleepCond.notify_all();
+    }
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+size_t WorkStealingThreadPool::getWorkerIndex() const {
+    return tlsPool == this ? tlsWorkerIdx : _threadNum;
+}
+
+size_t WorkStealingThreadPool::currentWorker() const {
+    if (tlsPool == this) {
+        return tlsWorkerIdx;
+    }
+    return _nextQueue.fetch_add(1, memory_order_relaxed) % _queues.size();
+}
+
+void WorkStealingThreadPool::push(Task task) {
+    WorkQueue &queue = *_queues[currentWorker()];
+    _pendingCount.fetch_add(1, memory_order_release);
+    {
+        unique_lock<mutex> lock(queue.lock);
+        queue.tasks.push_back(std::move(task));
+    }
+    unique_lock<mutex> lock(_sleepLock);
+    _sleepCond.notify_one();
+}
+
+bool WorkStealingThreadPool::popTask(size_t idx, Task &task) {
+    WorkQueue &queue = *_queues[idx];
+    {
+        unique_lock<mutex> lock(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            _pendingCount.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return stealTask(idx + 1, task);
+}
+
+bool WorkStealingThreadPool::stealTask(size_t start, Task &task) {
+    size_t queueNum = _queues.size();
+    for (size_t i = 0; i < queueNum; i++) {
+        WorkQueue &queue = *_queues[(start + i) % queueNum];
+        unique_lock<mutex> lock(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            _pendingCount.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingThreadPool::tryRunOne() {
+    if (_pendingCount.load(memory_order_acquire) == 0) {
+        return false;
+    }
+    Task task;
+    bool found = tlsPool == this ? popTask(tlsWorkerIdx, task)
+                 : stealTask(_nextQueue.load(memory_order_relaxed), task);
+    if (!found) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void WorkStealingThreadPool::workerLoop(size_t idx) {
+    tlsPool = this;
+    tlsWorkerIdx = idx;
+    Task task;
+    while (true) {
+        if (popTask(idx, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+        unique_lock<mutex> lock(_sleepLock);
+        _sleepCond.wait(lock, [this]() {
+                    return !_running.load() || _pendingCount.load() > 0;
+                });
+        if (!_running.load() && _pendingCount.load() == 0) {
+            break;
+        }
+    }
+    tlsPool = nullptr;
+}
+
+TaskGroup::TaskGroup(WorkStealingThreadPool *pool)
+    : _pool(pool)
+    , _pending(0)
+{
+}
+
+TaskGroup::~TaskGroup() {
+    wait();
+}
+
+void TaskGroup::run(WorkStealingThreadPool::Task task) {
+    if (_pool == nullptr) {
+        task();
+        return;
+    }
+    _pending.fetch_add(1);
+    _pool->push([this, task = std::move(task)]() {
+                task();
+                done();
+            });
+}
+
+void TaskGroup::done() {
+    unique_lock<mutex> lock(_lock);
+    if (_pending.fetch_sub(1) == 1) {
+        _cond.notify_all();
+    }
+}
+
+void TaskGroup::wait() {
+    while (_pending.load() > 0) {
+        if (_pool->tryRunOne()) {
+            continue;
+        }
+        unique_lock<mutex> lock(_lock);
+        _cond.wait(lock, [this]() { return _pending.load() == 0; });
+    }
+    // the last done() may still hold the lock
+    unique_lock<mutex> lock(_lock);
+}
+
+}
@@ -0,0 +1,91 @@
+#ifndef ISEARCH_FG_LITE_WORKSTEALINGTHREADPOOL_H
+#define ISEARCH_FG_LITE_WORKSTEALINGTHREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "autil/Log.h"
+
+namespace fg_lite {
+
+/*
+ * every worker owns a deque, it pops its own tasks from the back and steals
+ * from the front of the others when idle. tasks pushed from a worker go to
+ * its own deque, tasks pushed from outside are spread round robin.
+ */
+class WorkStealingThreadPool
+{
+public:
+    typedef std::function<void()> Task;
+private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+public:
+    WorkStealingThreadPool(size_t threadNum);
+    ~WorkStealingThreadPool();
+private:
+    WorkStealingThreadPool(const WorkStealingThreadPool &);
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool &);
+public:
+    bool start();
+    // pending tasks are drained before workers exit
+    void stop();
+    void push(Task task);
+    // run one pending task in the calling thread, return false if no task.
+    bool tryRunOne();
+    size_t getThreadNum() const { return _threadNum; }
+    // index of the calling worker, getThreadNum() for threads outside the pool
+    size_t getWorkerIndex() const;
+    size_t getPendingCount() const { return _pendingCount.load(std::memory_order_relaxed); }
+private:
+    void workerLoop(size_t idx);
+    bool popTask(size_t idx, Task &task);
+    bool stealTask(size_t start, Task &task);
+    size_t currentWorker() const;
+private:
+    size_t _threadNum;
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+    std::vector<std::thread> _threads;
+    std::atomic<size_t> _pendingCount;
+    mutable std::atomic<size_t> _nextQueue;
+    std::atomic<bool> _running;
+    std::mutex _sleepLock;
+    std::condition_variable _sleepCond;
+private:
+    AUTIL_LOG_DECLARE();
+};
+
+/*
+ * join point of a batch of tasks, the waiting thread helps to run pending
+ * tasks of the pool instead of blocking, so waiting inside a worker is safe.
+ */
+class TaskGroup
+{
+public:
+    TaskGroup(WorkStealingThreadPool *pool);
+    ~TaskGroup();
+private:
+    TaskGroup(const TaskGroup &);
+    TaskGroup& operator=(const TaskGroup &);
+public:
+    void run(WorkStealingThreadPool::Task task);
+    void wait();
+private:
+    void done();
+private:
+    WorkStealingThreadPool *_pool;
+    std::atomic<size_t> _pending;
+    std::mutex _lock;
+    std::condition_variable _cond;
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_WORKSTEALINGTHREADPOOL_H
@@ -0,0 +1,151 @@
+#include "fg_lite/feature/BroadcastFeatureCache.h"
+#include "fg_lite/feature/ComboFeatureFunction.h"
+#include "fg_lite/feature/MatchFeatureFunction.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class BroadcastFeatureCacheTest : public FeatureFunctionTestBase {
+protected:
+    void checkSame(const FeatureFunction &function, const vector<FeatureInput*> &inputs,
+                   BroadcastFeatureCache *cache)
+    {
+        unique_ptr<Features> expected(function.genFeatures(inputs, &_context));
+        FeatureFunctionContext context;
+        context.broadcastCache = cache;
+        unique_ptr<Features> actual(function.genFeatures(inputs, &context));
+        expectSameFeatures(expected.get(), actual.get());
+    }
+};
+
+TEST_F(BroadcastFeatureCacheTest, testLruAndMemoryLimit) {
+    BroadcastFeatureCache cache(100, 0);
+    cache.put<int>(1, make_shared<int>(1), 40);
+    cache.put<int>(2, make_shared<int>(2), 40);
+    ASSERT_TRUE(cache.get<int>(1));
+    cache.put<int>(3, make_shared<int>(3), 40);
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(80u, cache.getMemoryUse());
+    EXPECT_FALSE(cache.get<int>(2));
+    EXPECT_EQ(1, *cache.get<int>(1));
+    EXPECT_EQ(3, *cache.get<int>(3));
+    EXPECT_EQ(3u, cache.getHitCount());
+    EXPECT_EQ(1u, cache.getMissCount());
+
+    cache.put<int>(3, make_shared<int>(4), 10);
+    EXPECT_EQ(4, *cache.get<int>(3));
+    EXPECT_EQ(50u, cache.getMemoryUse());
+    cache.put<int>(4, make_shared<int>(5), 101);
+    EXPECT_FALSE(cache.get<int>(4));
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.getMemoryUse());
+}
+
+TEST_F(BroadcastFeatureCacheTest, testTtl) {
+    BroadcastFeatureCache cache(100, 10);
+    cache.put<int>(1, make_shared<int>(1), 1, 100);
+    EXPECT_TRUE(cache.get<int>(1, 109));
+    EXPECT_FALSE(cache.get<int>(1, 110));
+    EXPECT_EQ(0u, cache.size());
+}
+
+TEST_F(BroadcastFeatureCacheTest, testMakeKey) {
+    unique_ptr<FeatureInput> float1(genDenseInput<float>({1.2f}));
+    unique_ptr<FeatureInput> float2(genDenseInput<float>({1.4f}));
+    unique_ptr<FeatureInput> float3(genDenseInput<float>({1.2f, 3.0f}, 1, 2));
+    unique_ptr<FeatureInput> str1(genDenseInput<string>({"ab", "c"}, 1, 2));
+    unique_ptr<FeatureInput> str2(genDenseInput<string>({"a", "bc"}, 1, 2));
+    unique_ptr<FeatureInput> multiChar(genDenseInput<MultiChar>(genMultiCharValues({"ab", "c"}), 1, 2));
+    auto key = BroadcastFeatureCache::makeKey("kind", float1.get());
+    EXPECT_EQ(key.hash, BroadcastFeatureCache::makeKey("kind", float1.get()).hash);
+    EXPECT_EQ(key.fingerprint, BroadcastFeatureCache::makeKey("kind", float1.get()).fingerprint);
+    EXPECT_NE(key.hash, key.fingerprint);
+    EXPECT_NE(key.hash, BroadcastFeatureCache::makeKey("other", float1.get()).hash);
+    EXPECT_NE(key.hash, BroadcastFeatureCache::makeKey("kind", float2.get()).hash);
+    EXPECT_NE(key.hash, BroadcastFeatureCache::makeKey("kind", float3.get()).hash);
+    EXPECT_NE(BroadcastFeatureCache::makeKey("kind", str1.get()).hash,
+              BroadcastFeatureCache::makeKey("kind", str2.get()).hash);
+    EXPECT_NE(BroadcastFeatureCache::makeKey("kind", str1.get()).hash,
+              BroadcastFeatureCache::makeKey("kind", multiChar.get()).hash);
+}
+
+TEST_F(BroadcastFeatureCacheTest, testCollision) {
+    // another value or another value type under the same hash is a miss
+    BroadcastFeatureCache cache(100, 0);
+    cache.put<int>(BroadcastFeatureCache::Key(1, 10), make_shared<int>(1), 4);
+    EXPECT_EQ(1, *cache.get<int>(BroadcastFeatureCache::Key(1, 10)));
+    EXPECT_FALSE(cache.get<int>(BroadcastFeatureCache::Key(1, 11)));
+    EXPECT_FALSE(cache.get<string>(BroadcastFeatureCache::Key(1, 10)));
+    EXPECT_EQ(1u, cache.getHitCount());
+    EXPECT_EQ(2u, cache.getMissCount());
+    cache.put<string>(BroadcastFeatureCache::Key(1, 11), make_shared<string>("a"), 4);
+    EXPECT_EQ(1u, cache.size());
+    EXPECT_FALSE(cache.get<int>(BroadcastFeatureCache::Key(1, 10)));
+    EXPECT_EQ("a", *cache.get<string>(BroadcastFeatureCache::Key(1, 11)));
+}
+
+TEST_F(BroadcastFeatureCacheTest, testMatch) {
+    BroadcastFeatureCache cache(1 << 20, 0);
+    MatchFeatureFunction function(
+            MatchFunction::create("hit", "brand_hit", "", true, true, true), false, false);
+    unique_ptr<FeatureInput> user(genDenseInput<MultiChar>(genMultiCharValues(
+                            {"ALL^107287172:0.2,36806676:0.3|50006842^16788816:0.1,30068:19"})));
+    unique_ptr<FeatureInput> item(genDenseInput<int64_t>({30068, 20, 36806676}));
+    unique_ptr<FeatureInput> category(genDenseInput<int64_t>({50006842, 2345, 3456}));
+    checkSame(function, {user.get(), item.get(), category.get()}, &cache);
+    EXPECT_EQ(1u, cache.size());
+    EXPECT_EQ(0u, cache.getHitCount());
+    checkSame(function, {user.get(), item.get(), category.get()}, &cache);
+    EXPECT_EQ(1u, cache.getHitCount());
+
+    // the cached info owns a copy of the user string
+    FeatureFunctionContext context;
+    context.broadcastCache = &cache;
+    {
+        unique_ptr<FeatureInput> stringUser(genDenseInput<string>(
+                        {"ALL^107287172:0.2,36806676:0.3|50006842^16788816:0.1,30068:19"}));
+        _features.reset(function.genFeatures({stringUser.get(), item.get(), category.get()}, &context));
+    }
+    EXPECT_EQ(2u, cache.size());
+    auto typedFeatures = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, _features.get());
+    EXPECT_THAT(typedFeatures->_offsets, ElementsAre(0, 1, 1));
+    ASSERT_EQ(1u, typedFeatures->_featureNames.size());
+    EXPECT_EQ(ConstString("brand_hit_50006842_30068_19"), typedFeatures->_featureNames[0]);
+
+    unique_ptr<FeatureInput> invalidUser(genDenseInput<string>({"invalid"}));
+    _features.reset(function.genFeatures({invalidUser.get(), item.get(), category.get()}, &context));
+    EXPECT_FALSE(_features);
+    EXPECT_EQ(2u, cache.size());
+}
+
+TEST_F(BroadcastFeatureCacheTest, testCombo) {
+    BroadcastFeatureCache cache(1 << 20, 0);
+    unique_ptr<FeatureInput> user(genDenseInput<int32_t>({3, numeric_limits<int32_t>::max(), 1}, 1, 3));
+    unique_ptr<FeatureInput> age(genDenseInput<float>({21.0f}));
+    unique_ptr<FeatureInput> item(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 2}, {}, {3}})));
+    unique_ptr<FeatureInput> price(genDenseInput<double>({1.0, 2.0, 3.0}));
+
+    ComboFeatureFunction normal("combo", "combo_", {}, {}, 3);
+    checkSame(normal, {user.get(), age.get(), item.get()}, &cache);
+    // the user row holds an invalid value and is formatted but not used
+    EXPECT_EQ(2u, cache.size());
+    checkSame(normal, {user.get(), age.get(), item.get()}, &cache);
+    EXPECT_EQ(2u, cache.getHitCount());
+
+    ComboFeatureFunction fast("combo", "combo_", {}, {}, 2);
+    checkSame(fast, {age.get(), price.get()}, &cache);
+    ComboFeatureFunction sorted("combo", "combo_", {}, {}, 2, true);
+    checkSame(sorted, {age.get(), item.get()}, &cache);
+    ComboFeatureFunction hashed("combo", "combo_", {false, true}, {1, 1}, 3);
+    hashed.setHashOutput(true);
+    checkSame(hashed, {user.get(), age.get(), item.get()}, &cache);
+    EXPECT_EQ(2u, cache.size());
+}
+
+}
@@ -0,0 +1,200 @@
+#include <fstream>
+#include "fg_lite/feature/ColumnFile.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class ColumnFileTest : public FeatureFunctionTestBase {
+protected:
+    string getPath(const string &name) {
+        return TempDir() + "/column_file_test_" + name;
+    }
+};
+
+TEST_F(ColumnFileTest, testDenseColumn) {
+    string path = getPath("dense.col");
+    ASSERT_TRUE(ColumnFileWriter::writeDense<int64_t>(path, {1, 2, 3, 4, 5, 6}, 2));
+    MappedColumn column;
+    ASSERT_TRUE(column.open(path));
+    typedef FeatureInputTyped<int64_t, DenseStorage<int64_t>> InputType;
+    auto input = ASSERT_CAST_AND_RETURN(InputType, column.getInput());
+    ASSERT_EQ(3u, input->row());
+    ASSERT_EQ(2u, input->col(0));
+    EXPECT_EQ(2, input->get(0, 1));
+    EXPECT_EQ(5, input->get(2, 0));
+
+    ASSERT_FALSE(ColumnFileWriter::writeDense<int64_t>(path, {1, 2, 3}, 2));
+    EXPECT_FALSE(column.open(getPath("not_exist.col")));
+    EXPECT_EQ(nullptr, column.getInput());
+}
+
+TEST_F(ColumnFileTest, testValueOffsetColumn) {
+    string path = getPath("value_offset.col");
+    ASSERT_TRUE(ColumnFileWriter::writeValueOffset<float>(path, {1.5, 2.5, 3.5}, {0, 0, 1}));
+    MappedColumn column;
+    ASSERT_TRUE(column.open(path));
+    typedef FeatureInputTyped<float, ValueOffsetStorage<float>> InputType;
+    auto input = ASSERT_CAST_AND_RETURN(InputType, column.getInput());
+    ASSERT_EQ(3u, input->row());
+    EXPECT_EQ(0u, input->col(0));
+    EXPECT_EQ(1u, input->col(1));
+    EXPECT_EQ(2u, input->col(2));
+    EXPECT_FLOAT_EQ(3.5, input->get(2, 1));
+}
+
+TEST_F(ColumnFileTest, testStringColumn) {
+    string path = getPath("string.col");
+    ASSERT_TRUE(ColumnFileWriter::writeStrings(path, {"a", "", "bcd"}));
+    MappedColumn column;
+    ASSERT_TRUE(column.open(path));
+    typedef FeatureInputTyped<MultiChar, DenseStorage<MultiChar>> DenseInput;
+    auto dense = ASSERT_CAST_AND_RETURN(DenseInput, column.getInput());
+    ASSERT_EQ(3u, dense->row());
+    EXPECT_EQ("a", string(dense->get(0, 0).data(), dense->get(0, 0).size()));
+    EXPECT_EQ(0u, dense->get(1, 0).size());
+    EXPECT_EQ("bcd", string(dense->get(2, 0).data(), dense->get(2, 0).size()));
+
+    ASSERT_TRUE(ColumnFileWriter::writeStrings(path, {"a", "bc", "d"}, {0, 2}));
+    ASSERT_TRUE(column.open(path));
+    typedef FeatureInputTyped<MultiChar, ValueOffsetStorage<MultiChar>> ValueOffsetInput;
+    auto valueOffset = ASSERT_CAST_AND_RETURN(ValueOffsetInput, column.getInput());
+    ASSERT_EQ(2u, valueOffset->row());
+    EXPECT_EQ(2u, valueOffset->col(0));
+    EXPECT_EQ("d", string(valueOffset->get(1, 0).data(), valueOffset->get(1, 0).size()));
+}
+
+TEST_F(ColumnFileTest, testCorruptColumn) {
+    string path = getPath("corrupt.col");
+    MappedColumn column;
+    // row offsets must not decrease or pass the value count
+    ASSERT_TRUE(ColumnFileWriter::writeValueOffset<float>(path, {1.5, 2.5, 3.5}, {0, 2, 1}));
+    EXPECT_FALSE(column.open(path));
+    ASSERT_TRUE(ColumnFileWriter::writeValueOffset<float>(path, {1.5, 2.5, 3.5}, {0, 4}));
+    EXPECT_FALSE(column.open(path));
+    ASSERT_TRUE(ColumnFileWriter::writeValueOffset<float>(path, {1.5, 2.5, 3.5}, {0, 3}));
+    EXPECT_TRUE(column.open(path));
+
+    // string values must end within byteCount
+    ASSERT_TRUE(ColumnFileWriter::writeStrings(path, {"abc"}));
+    {
+        fstream file(path.c_str(), ios::binary | ios::in | ios::out);
+        uint64_t byteCount = 3;
+        file.seekp(offsetof(ColumnFileHeader, byteCount));
+        file.write((const char*)&byteCount, sizeof(byteCount));
+    }
+    EXPECT_FALSE(column.open(path));
+    EXPECT_EQ(nullptr, column.getInput());
+}
+
+TEST_F(ColumnFileTest, testFeatureChunkWriter) {
+    string path = getPath("feature.fgf");
+    FeatureChunkWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    MultiSparseFeatures sparse(2);
+    sparse.beginDocument();
+    sparse.addFeatureKey("ab", 2);
+    sparse.beginDocument();
+    sparse.addFeatureKey("c", 1);
+    ASSERT_TRUE(writer.write(&sparse, 2));
+    SingleDenseFeatures dense("f", 1);
+    dense.addFeatureValue(1.5);
+    ASSERT_TRUE(writer.write(&dense, 1));
+    EXPECT_FALSE(writer.write(nullptr, 1));
+    size_t writtenBytes = writer.getWrittenBytes();
+    ASSERT_TRUE(writer.close());
+
+    ifstream in(path.c_str(), ios::binary);
+    string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    size_t sparseSize = sizeof(FeatureChunkHeader) + 2 * 8 + 2 * 8 + 3;
+    ASSERT_EQ(sparseSize + sizeof(FeatureChunkHeader) + sizeof(float), content.size());
+    EXPECT_EQ(content.size(), writtenBytes);
+    auto header = (const FeatureChunkHeader*)content.data();
+    EXPECT_EQ((uint32_t)FVT_MULTI_SPARSE, header->featureValueType);
+    EXPECT_EQ(2u, header->docCount);
+    EXPECT_EQ(2u, header->valueCount);
+    EXPECT_EQ(3u, header->byteCount);
+    const uint64_t *offsets = (const uint64_t*)(header + 1);
+    EXPECT_EQ(0u, offsets[0]);
+    EXPECT_EQ(1u, offsets[1]);
+    // key offsets into the chars
+    EXPECT_EQ(0u, offsets[2]);
+    EXPECT_EQ(2u, offsets[3]);
+    EXPECT_EQ("abc", content.substr(sparseSize - 3, 3));
+    header = (const FeatureChunkHeader*)(content.data() + sparseSize);
+    EXPECT_EQ((uint32_t)FVT_SINGLE_DENSE, header->featureValueType);
+    EXPECT_EQ(1u, header->valueCount);
+    EXPECT_FLOAT_EQ(1.5, *(const float*)(header + 1));
+}
+
+TEST_F(ColumnFileTest, testWriteEmpty) {
+    string path = getPath("empty.fgf");
+    FeatureChunkWriter writer;
+    EXPECT_FALSE(writer.writeEmpty(2));
+    ASSERT_TRUE(writer.open(path));
+    ASSERT_TRUE(writer.writeEmpty(2));
+    ASSERT_TRUE(writer.close());
+
+    ifstream in(path.c_str(), ios::binary);
+    string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    ASSERT_EQ(sizeof(FeatureChunkHeader) + 2 * 8, content.size());
+    auto header = (const FeatureChunkHeader*)content.data();
+    EXPECT_EQ((uint32_t)FVT_MULTI_SPARSE, header->featureValueType);
+    EXPECT_EQ(2u, header->docCount);
+    EXPECT_EQ(0u, header->valueCount);
+    EXPECT_EQ(0u, header->byteCount);
+    const uint64_t *offsets = (const uint64_t*)(header + 1);
+    EXPECT_EQ(0u, offsets[0]);
+    EXPECT_EQ(0u, offsets[1]);
+}
+
+TEST_F(ColumnFileTest, testWidenedFeatureValues) {
+    // offsets and compact values are narrow in memory, the file has 64 bits
+    static_assert(sizeof(MultiInt32Features::OffsetType) == 4, "32 bit offsets");
+    static_assert(sizeof(MultiIntegerFeatures::OffsetType) == 8, "wide offsets");
+    string path = getPath("integer.fgf");
+    FeatureChunkWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    MultiInt32Features integers("f", 2);
+    integers.beginDocument();
+    integers.addFeatureValue(-3);
+    integers.beginDocument();
+    integers.addFeatureValue(7);
+    integers.addFeatureValue(8);
+    ASSERT_TRUE(writer.write(&integers, 2));
+    MultiSparseFloatWeightingFeatures weighting(1);
+    weighting.beginDocument();
+    weighting.addFeatureKey("k", 1);
+    weighting.addFeatureValue(0.5);
+    ASSERT_TRUE(writer.write(&weighting, 1));
+    SingleInt16Features shorts("f", 1);
+    shorts.addFeatureValue(-2);
+    ASSERT_TRUE(writer.write(&shorts, 1));
+    ASSERT_TRUE(writer.close());
+
+    ifstream in(path.c_str(), ios::binary);
+    string content((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    size_t integerSize = sizeof(FeatureChunkHeader) + 2 * 8 + 3 * 8;
+    size_t weightingSize = sizeof(FeatureChunkHeader) + 8 + 8 + 1 + 8;
+    ASSERT_EQ(integerSize + weightingSize + sizeof(FeatureChunkHeader) + 8, content.size());
+    auto header = (const FeatureChunkHeader*)content.data();
+    EXPECT_EQ((uint32_t)FVT_MULTI_SPARSE_INT, header->featureValueType);
+    EXPECT_EQ(3u, header->valueCount);
+    const uint64_t *offsets = (const uint64_t*)(header + 1);
+    EXPECT_EQ(0u, offsets[0]);
+    EXPECT_EQ(1u, offsets[1]);
+    const int64_t *values = (const int64_t*)(offsets + 2);
+    EXPECT_EQ(-3, values[0]);
+    EXPECT_EQ(8, values[2]);
+    header = (const FeatureChunkHeader*)(content.data() + integerSize);
+    EXPECT_EQ((uint32_t)FVT_WEIGHTING_SPARSE, header->featureValueType);
+    EXPECT_DOUBLE_EQ(0.5, *(const double*)(content.data() + integerSize + weightingSize - 8));
+    header = (const FeatureChunkHeader*)(content.data() + integerSize + weightingSize);
+    EXPECT_EQ((uint32_t)FVT_SINGLE_SPARSE_INT, header->featureValueType);
+    EXPECT_EQ(-2, *(const int64_t*)(header + 1));
+}
+
+}
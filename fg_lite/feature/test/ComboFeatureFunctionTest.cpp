@@ -226,4 +226,62 @@ TEST_F(ComboFeatureFunctionTest, testPruneSorted) {
 
 }
 
+TEST_F(ComboFeatureFunctionTest, testValidity) {
+    vector<uint8_t> values1{1, 255, 3};
+    vector<uint64_t> bits1 = {0x3};
+    vector<uint8_t> values2{7, 8, 9, 10};
+    vector<size_t> offsets2{0, 1, 3};
+    vector<uint64_t> bits2 = {0xd};
+    unique_ptr<FeatureInput> input1(new FeatureInputTyped<uint8_t, DenseStorage<uint8_t>>(
+                    DenseStorage<uint8_t>(values1.data(), 3, 1, ValidityBitmap(bits1.data()))));
+    unique_ptr<FeatureInput> input2(new FeatureInputTyped<uint8_t, ValueOffsetStorage<uint8_t>>(
+                    ValueOffsetStorage<uint8_t>(values2.data(), values2.size(), offsets2.data(),
+                            offsets2.size(), ValidityBitmap(bits2.data()))));
+    vector<FeatureInput*> inputs = {input1.get(), input2.get()};
+    checkComboFeatures(
+            inputs,
+            vector<string>{"pf_1_7", "pf_255_9"},
+            vector<size_t>{0, 1, 2});
+
+    // all single values
+    vector<uint64_t> bits3 = {0x6};
+    unique_ptr<FeatureInput> input3(new FeatureInputTyped<uint8_t, DenseStorage<uint8_t>>(
+                    DenseStorage<uint8_t>(values2.data(), 3, 1, ValidityBitmap(bits3.data()))));
+    inputs = {input1.get(), input3.get()};
+    checkComboFeatures(
+            inputs,
+            vector<string>{"pf_255_8"},
+            vector<size_t>{0, 0, 1});
+}
+
+TEST_F(ComboFeatureFunctionTest, testDictionaryInput) {
+    // formatted once per dictionary value, the invalid one keeps the input as is
+    unique_ptr<FeatureInput> brand(genDictionaryInput<int32_t>({5, 6}, {0, 1, 0, 0}, 4));
+    unique_ptr<FeatureInput> invalid(genDictionaryInput<int32_t>(
+                    {1, numeric_limits<int32_t>::max()}, {0, 1, 1, 0}, 4));
+    unique_ptr<FeatureInput> shop(genDictionaryInput<MultiChar>(
+                    genMultiCharValues({"s", "t"}), {1, 0, 1, 1}, 4));
+    vector<FeatureInput*> inputs = {brand.get(), invalid.get(), shop.get()};
+    vector<string> expectNames = {"pf_5_1_t", "pf_5_1_t"};
+    vector<size_t> expectOffsets = {0, 1, 1, 1};
+    checkComboFeatures(inputs, expectNames, expectOffsets);
+
+    // multi value rows and hashes same as the dense inputs
+    unique_ptr<FeatureInput> tags(genDictionaryInput<int64_t>({3, 4}, {0, 1, 1, 1, 0, 0, 1, 0}, 4, 2));
+    unique_ptr<FeatureInput> denseBrand(genDenseInput<int32_t>({5, 6, 5, 5}));
+    unique_ptr<FeatureInput> denseTags(genDenseInput<int64_t>({3, 4, 4, 4, 3, 3, 4, 3}, 4, 2));
+    checkComboFeatures({brand.get(), tags.get()},
+                       {"pf_5_3", "pf_5_4", "pf_6_4", "pf_6_4", "pf_5_3", "pf_5_3",
+                        "pf_5_4", "pf_5_3"},
+                       {0, 2, 4, 6});
+    ComboFeatureFunction function("name", "pf_", {}, {}, 2);
+    function.setHashOutput(true);
+    unique_ptr<Features> expected(function.genFeatures({denseBrand.get(), denseTags.get()},
+                    &_context));
+    unique_ptr<Features> actual(function.genFeatures({brand.get(), tags.get()}, &_context));
+    auto expectedHashed = ASSERT_CAST_AND_RETURN(MultiHashedSparseFeatures, expected.get());
+    auto actualHashed = ASSERT_CAST_AND_RETURN(MultiHashedSparseFeatures, actual.get());
+    EXPECT_EQ(expectedHashed->_offsets, actualHashed->_offsets);
+    EXPECT_EQ(expectedHashed->_featureHashes, actualHashed->_featureHashes);
+}
 }
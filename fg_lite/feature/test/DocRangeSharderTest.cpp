@@ -0,0 +1,138 @@
+#include "fg_lite/feature/DocRangeSharder.h"
+#include "fg_lite/feature/IdFeatureFunction.h"
+#include "fg_lite/feature/ComboFeatureFunction.h"
+#include "fg_lite/feature/RawFeatureFunction.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class DocRangeSharderTest : public FeatureFunctionTestBase {
+protected:
+    void checkSame(const FeatureFunction &function, const vector<FeatureInput*> &inputs,
+                   WorkStealingThreadPool *threadPool, size_t shardDocCount)
+    {
+        unique_ptr<Features> expected(function.genFeatures(inputs, &_context));
+        unique_ptr<Features> actual(DocRangeSharder::genFeatures(
+                        &function, inputs, &_context, threadPool, shardDocCount));
+        ASSERT_TRUE(expected);
+        ASSERT_TRUE(actual);
+        EXPECT_EQ(expected->getFeatureValueType(), actual->getFeatureValueType());
+        expectSameFeatures(expected.get(), actual.get());
+    }
+};
+
+TEST_F(DocRangeSharderTest, testSliceInput) {
+    typedef FeatureInputTyped<int32_t, DenseStorage<int32_t>> DenseInput;
+    typedef FeatureInputTyped<int32_t, ValueOffsetStorage<int32_t>> ValueOffsetInput;
+    typedef FeatureInputTyped<int32_t, MultiValueStorage<int32_t>> MultiValueInput;
+    unique_ptr<FeatureInput> dense(genDenseInput<int32_t>({1, 2, 3, 4, 5, 6}, 3, 2));
+    unique_ptr<FeatureInput> denseSlice(dense->slice(1, 3));
+    auto typedDense = ASSERT_CAST_AND_RETURN(DenseInput, denseSlice.get());
+    ASSERT_EQ(2u, typedDense->row());
+    EXPECT_EQ(3, typedDense->get(0, 0));
+    EXPECT_EQ(6, typedDense->get(1, 1));
+
+    unique_ptr<FeatureInput> valueOffset(genValueOffsetInput<int32_t>({1, 2, 3, 4, 5, 6}, {0, 1, 3}));
+    unique_ptr<FeatureInput> voSlice(valueOffset->slice(1, 2));
+    auto typedVo = ASSERT_CAST_AND_RETURN(ValueOffsetInput, voSlice.get());
+    ASSERT_EQ(1u, typedVo->row());
+    ASSERT_EQ(2u, typedVo->col(0));
+    EXPECT_EQ(2u, typedVo->numElements());
+    EXPECT_EQ(2, typedVo->get(0, 0));
+    EXPECT_EQ(3, typedVo->get(0, 1));
+    voSlice.reset(valueOffset->slice(1, 3));
+    EXPECT_EQ(3u, voSlice->col(1));
+    EXPECT_EQ(5u, voSlice->numElements());
+
+    auto multiValues = genMultiValues<int32_t>({{1}, {2, 3}, {4, 5, 6}});
+    unique_ptr<FeatureInput> multiValue(genMultiValueInput<int32_t>(multiValues));
+    unique_ptr<FeatureInput> mvSlice(multiValue->slice(2, 3));
+    auto typedMv = ASSERT_CAST_AND_RETURN(MultiValueInput, mvSlice.get());
+    ASSERT_EQ(1u, typedMv->row());
+    EXPECT_EQ(4, typedMv->get(0, 0));
+}
+
+TEST_F(DocRangeSharderTest, testMergeFeatures) {
+    auto first = new MultiSparseFeatures(2);
+    first->beginDocument();
+    first->addFeatureKey("a", 1);
+    first->beginDocument();
+    auto second = new MultiSparseFeatures(2);
+    second->beginDocument();
+    second->addFeatureKey("b", 1);
+    second->addFeatureKey("c", 1);
+    vector<Features*> shards = {first, second};
+    _features.reset(DocRangeSharder::mergeFeatures(shards));
+    auto typedSparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, _features.get());
+    EXPECT_THAT(typedSparse->_offsets, ElementsAre(0, 1, 1));
+    ASSERT_EQ(3u, typedSparse->_featureNames.size());
+    EXPECT_EQ(ConstString("a"), typedSparse->_featureNames[0]);
+    EXPECT_EQ(ConstString("b"), typedSparse->_featureNames[1]);
+    EXPECT_EQ(ConstString("c"), typedSparse->_featureNames[2]);
+
+    auto dense1 = new MultiDenseFeatures("f", 1);
+    dense1->beginDocument();
+    dense1->addFeatureValue(1.0);
+    auto dense2 = new MultiDenseFeatures("f", 1);
+    dense2->beginDocument();
+    dense2->addFeatureValue(2.0);
+    dense2->addFeatureValue(3.0);
+    shards = {dense1, dense2};
+    _features.reset(DocRangeSharder::mergeFeatures(shards));
+    auto typedDense = ASSERT_CAST_AND_RETURN(MultiDenseFeatures, _features.get());
+    EXPECT_THAT(typedDense->_offsets, ElementsAre(0, 1));
+    EXPECT_THAT(typedDense->_featureValues, ElementsAre(1.0, 2.0, 3.0));
+
+    auto int1 = new MultiIntegerFeatures("f", 1);
+    int1->beginDocument();
+    int1->addFeatureValue(1);
+    auto int2 = new MultiIntegerFeatures("f", 1);
+    int2->beginDocument();
+    int2->addFeatureValue(2);
+    shards = {int1, int2};
+    _features.reset(DocRangeSharder::mergeFeatures(shards));
+    auto typedInt = ASSERT_CAST_AND_RETURN(MultiIntegerFeatures, _features.get());
+    EXPECT_THAT(typedInt->_offsets, ElementsAre(0, 1));
+    EXPECT_THAT(typedInt->_featureValues, ElementsAre(1, 2));
+
+    shards = {new MultiIntegerFeatures("f", 1), new MultiDenseFeatures("f", 1)};
+    EXPECT_EQ(nullptr, DocRangeSharder::mergeFeatures(shards));
+    shards = {new MultiIntegerFeatures("f", 1), nullptr};
+    EXPECT_EQ(nullptr, DocRangeSharder::mergeFeatures(shards));
+    EXPECT_TRUE(shards.empty());
+}
+
+TEST_F(DocRangeSharderTest, testGenFeatures) {
+    WorkStealingThreadPool threadPool(3);
+    ASSERT_TRUE(threadPool.start());
+
+    vector<vector<int64_t>> values;
+    for (int64_t i = 0; i < 100; i++) {
+        values.push_back(vector<int64_t>(i % 4, i));
+    }
+    auto multiValues = genMultiValues<int64_t>(values);
+    unique_ptr<FeatureInput> item(genMultiValueInput<int64_t>(multiValues));
+    IdFeatureFunction idFunction("id", "id_", numeric_limits<int>::max(), {});
+    checkSame(idFunction, {item.get()}, &threadPool, 7);
+    checkSame(idFunction, {item.get()}, &threadPool, 100);
+    checkSame(idFunction, {item.get()}, nullptr, 30);
+
+    unique_ptr<FeatureInput> user(genDenseInput<string>({"u1", "u2"}, 1, 2));
+    ComboFeatureFunction comboFunction("combo", "combo_", {}, {}, 2);
+    checkSame(comboFunction, {user.get(), item.get()}, &threadPool, 16);
+
+    vector<float> prices;
+    for (size_t i = 0; i < 100; i++) {
+        prices.push_back(i * 0.5);
+    }
+    unique_ptr<FeatureInput> price(genDenseInput<float>(prices));
+    RawFeatureFunction rawFunction("price", Normalizer(), {}, 1);
+    checkSame(rawFunction, {price.get()}, &threadPool, 9);
+}
+
+}
@@ -0,0 +1,158 @@
+#include "fg_lite/feature/FeatureFormatter.h"
+#include "fg_lite/feature/FeatureHasher.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class FeatureFormatterTest : public FeatureFunctionTestBase {
+protected:
+    template <typename T>
+    void checkInteger(T value) {
+        FeatureFormatter::FeatureBuffer buffer{cp_alloc(_pool.get())};
+        buffer.push_back('p');
+        FeatureFormatter::fillFeatureToBuffer(value, buffer);
+        string expected = to_string(value);
+        EXPECT_EQ("p" + expected, string(buffer.data(), buffer.size()));
+        char out[FeatureFormatter::MAX_INTEGER_LENGTH];
+        size_t length = FeatureFormatter::formatInteger(value, out);
+        EXPECT_EQ(expected, string(out, length));
+        FeatureHasher hasher;
+        hasher.update("p", 1);
+        hasher.updateValue(value);
+        EXPECT_EQ(FeatureHasher::hash(buffer.data(), buffer.size()), hasher.finish()) << expected;
+    }
+    template <typename T>
+    void checkFormatTo(const T &value) {
+        FeatureFormatter::FeatureBuffer buffer{cp_alloc(_pool.get())};
+        FeatureFormatter::fillFeatureToBuffer(value, buffer);
+        size_t maxLength = FeatureFormatter::maxFormattedLength(value);
+        EXPECT_LE(buffer.size(), maxLength);
+        vector<char> out(maxLength);
+        char *end = FeatureFormatter::formatTo(value, out.data());
+        EXPECT_EQ(string(buffer.data(), buffer.size()), string(out.data(), end));
+    }
+    void checkDouble(double value) {
+        char expected[FeatureFormatter::MAX_DOUBLE_LENGTH];
+        int expectedLength = snprintf(expected, sizeof(expected), "%.0f", value);
+        char out[FeatureFormatter::MAX_DOUBLE_LENGTH];
+        size_t length = FeatureFormatter::formatDouble(value, out);
+        EXPECT_EQ(string(expected, expectedLength), string(out, length));
+    }
+};
+
+TEST_F(FeatureFormatterTest, testCountDigits) {
+    EXPECT_EQ(1u, FeatureFormatter::countDigits(0));
+    EXPECT_EQ(1u, FeatureFormatter::countDigits(9));
+    EXPECT_EQ(20u, FeatureFormatter::countDigits(numeric_limits<uint64_t>::max()));
+    uint64_t power = 1;
+    for (uint32_t digits = 1; digits < 20; digits++) {
+        EXPECT_EQ(digits, FeatureFormatter::countDigits(power)) << power;
+        EXPECT_EQ(digits, FeatureFormatter::countDigits(power * 10 - 1)) << power;
+        power *= 10;
+    }
+}
+
+TEST_F(FeatureFormatterTest, testIntegerBoundaries) {
+    uint64_t power = 1;
+    for (size_t i = 0; i < 20; i++) {
+        checkInteger(power);
+        checkInteger(power - 1);
+        checkInteger(power + 1);
+        checkInteger(int64_t(power - 1));
+        checkInteger(-int64_t(power - 1));
+        power *= 10;
+    }
+    checkInteger(numeric_limits<uint64_t>::max());
+    checkInteger(numeric_limits<int64_t>::max());
+    checkInteger(numeric_limits<int64_t>::min());
+    checkInteger(numeric_limits<uint32_t>::max());
+    checkInteger(numeric_limits<int32_t>::max());
+    checkInteger(numeric_limits<int32_t>::min());
+    checkInteger(numeric_limits<int16_t>::min());
+    checkInteger(numeric_limits<uint16_t>::max());
+    checkInteger(numeric_limits<int8_t>::min());
+    checkInteger(numeric_limits<uint8_t>::max());
+    checkInteger(int32_t(-10));
+}
+
+TEST_F(FeatureFormatterTest, testFormatColumn) {
+    FeatureFormatter::FeatureBuffer arena{cp_alloc(_pool.get())};
+    arena.push_back('x');
+    vector<size_t> offsets;
+    vector<int64_t> ints = {0, -7, 12345678901234LL, numeric_limits<int64_t>::min()};
+    FeatureFormatter::formatColumn(ints.data(), ints.size(), arena, offsets);
+    ASSERT_EQ(5u, offsets.size());
+    EXPECT_EQ(1u, offsets[0]);
+    EXPECT_EQ(arena.size(), offsets.back());
+    for (size_t i = 0; i < ints.size(); i++) {
+        EXPECT_EQ(to_string(ints[i]),
+                  string(arena.data() + offsets[i], offsets[i + 1] - offsets[i]));
+    }
+
+    arena.clear();
+    vector<float> floats = {1.4, -2.6};
+    FeatureFormatter::formatColumn(floats.data(), floats.size(), arena, offsets);
+    EXPECT_EQ(vector<size_t>({0, 1, 3}), offsets);
+    EXPECT_EQ("1-3", string(arena.data(), arena.size()));
+
+    FeatureFormatter::formatColumn(ints.data(), 0, arena, offsets);
+    EXPECT_EQ(vector<size_t>({3}), offsets);
+    EXPECT_EQ(3u, arena.size());
+}
+
+TEST_F(FeatureFormatterTest, testFormatDouble) {
+    vector<double> values = {0.0, -0.0, 0.4, -0.4, 0.5, -0.5, 1.5, 2.5, -2.5, 0.49999999999999994,
+                             123.456, -99.5, 4503599627370495.5, 9007199254740993.0,
+                             9223372036854775808.0, 9999999999999998976.0, 1e19, -1e19,
+                             18446744073709551616.0, 1e300, -1.7976931348623157e308,
+                             4.9e-324, numeric_limits<double>::infinity(),
+                             -numeric_limits<double>::infinity(),
+                             numeric_limits<double>::quiet_NaN()};
+    for (double value : values) {
+        checkDouble(value);
+    }
+    // every magnitude, with and without a fraction
+    double power = 1;
+    for (size_t i = 0; i < 25; i++) {
+        checkDouble(power);
+        checkDouble(-power * 1.37);
+        checkDouble(power + 0.5);
+        power *= 10;
+    }
+    srand(42);
+    for (size_t i = 0; i < 10000; i++) {
+        checkDouble(float(rand()) / (rand() % 1000 + 1) - 1000);
+    }
+
+    FeatureFormatter::FeatureBuffer buffer{cp_alloc(_pool.get())};
+    FeatureFormatter::fillFeatureToBuffer(float(-3.5), buffer);
+    EXPECT_EQ("-4", string(buffer.data(), buffer.size()));
+    FeatureHasher hasher;
+    hasher.updateValue(-3.5);
+    EXPECT_EQ(FeatureHasher::hash(buffer.data(), buffer.size()), hasher.finish());
+}
+
+TEST_F(FeatureFormatterTest, testFormatTo) {
+    checkFormatTo(numeric_limits<int64_t>::min());
+    checkFormatTo(numeric_limits<uint64_t>::max());
+    checkFormatTo(int8_t(-128));
+    checkFormatTo(uint16_t(65535));
+    checkFormatTo(true);
+    checkFormatTo('_');
+    checkFormatTo(-999999999999999999.0);
+    checkFormatTo(-0.4);
+    checkFormatTo(float(2.5));
+    checkFormatTo(-numeric_limits<double>::max());
+    checkFormatTo(numeric_limits<double>::quiet_NaN());
+    checkFormatTo(string("abc"));
+    checkFormatTo(ConstString("de"));
+    vector<MultiChar> chars = genMultiCharValues({"fgh", ""});
+    checkFormatTo(chars[0]);
+    checkFormatTo(chars[1]);
+}
+
+}
@@ -12,6 +12,7 @@
 #include "fg_lite/feature/LookupFeatureFunction.h"
 #include "fg_lite/feature/LookupFeatureFunctionV2.h"
 #include "fg_lite/feature/LookupFeatureFunctionArray.h"
+#include "fg_lite/feature/LookupFeatureFunctionBTree.h"
 #include "fg_lite/feature/OverLapFeatureFunction.h"
 
 using namespace std;
@@ -83,6 +84,17 @@ TEST_F(FeatureFunctionCreatorTest, testCreateLookupFeatureV2) {
     delete fun;
 }
 
+TEST_F(FeatureFunctionCreatorTest, testCreateLookupFeatureBTree) {
+    unique_ptr<SingleFeatureConfig> featConfig(SingleFeatureConfig::create(
+                    R"({"feature_type":"lookup_feature_btree","map":"item:map","key":"user:key",
+                        "needDiscrete":false})"));
+    ASSERT_TRUE(featConfig);
+    FeatureFunction *fun = FeatureFunctionCreator::createFeatureFunction(featConfig.get());
+    auto funTyped = ASSERT_CAST_AND_RETURN(LookupFeatureFunctionBTree, fun);
+    ASSERT_TRUE(funTyped);
+    delete fun;
+}
+
 TEST_F(FeatureFunctionCreatorTest, testCreateLookupFeatureArray) {
     LookupFeatureConfig featConfig;
     featConfig.mapKeysExpression = "user:user:key";
@@ -116,6 +116,15 @@ protected:
         return new FeatureInputTyped<T, ValueOffsetStorage<T>>(storage);
     }
 
+    template <typename T>
+    FeatureInput *genDictionaryInput(const std::vector<T> &dictionary,
+            const std::vector<uint32_t> &codes, size_t r, size_t c = 1)
+    {
+        DictionaryStorage<T> storage(copyVector(dictionary)->data(), dictionary.size(),
+                copyVector(codes)->data(), r, c);
+        return new FeatureInputTyped<T, DictionaryStorage<T>>(storage);
+    }
+
     void genFeatures(const std::vector<FeatureInput*> &inputs,
                      FeatureCreator creator)
     {
@@ -204,7 +213,7 @@ protected:
         for (size_t i = 0; i < names.size(); i++) {
             EXPECT_EQ(autil::ConstString(names[i]), typedFeatures->_featureNames[i]);
         }
-        EXPECT_EQ(typedFeatures->_offsets, offsets);
+        EXPECT_THAT(typedFeatures->_offsets, ElementsAreArray(offsets));
 
         EXPECT_EQ(names.size(), typedFeatures->_featureValues.size());
         EXPECT_EQ(values.size(), typedFeatures->_featureValues.size());
@@ -213,6 +222,41 @@ protected:
         }
     }
 
+    // same documents and keys, a hashed output is compared to the hashes of the expected names
+    void expectSameFeatures(const Features *expected, const Features *actual) {
+        ASSERT_TRUE(expected);
+        ASSERT_TRUE(actual);
+        ASSERT_EQ(expected->count(), actual->count());
+        auto expectedHashed = dynamic_cast<const MultiHashedSparseFeatures*>(expected);
+        if (expectedHashed) {
+            auto actualHashed = ASSERT_CAST_AND_RETURN(const MultiHashedSparseFeatures, actual);
+            EXPECT_THAT(actualHashed->_offsets, ElementsAreArray(expectedHashed->_offsets));
+            EXPECT_THAT(actualHashed->_featureHashes, ElementsAreArray(expectedHashed->_featureHashes));
+            return;
+        }
+        auto expectedSparse = dynamic_cast<const MultiSparseFeatures*>(expected);
+        if (!expectedSparse) {
+            auto expectedDense = ASSERT_CAST_AND_RETURN(const SingleDenseFeatures, expected);
+            auto actualDense = ASSERT_CAST_AND_RETURN(const SingleDenseFeatures, actual);
+            EXPECT_THAT(actualDense->_featureValues, ElementsAreArray(expectedDense->_featureValues));
+            return;
+        }
+        auto actualHashed = dynamic_cast<const MultiHashedSparseFeatures*>(actual);
+        if (actualHashed) {
+            EXPECT_THAT(actualHashed->_offsets, ElementsAreArray(expectedSparse->_offsets));
+            ASSERT_EQ(expectedSparse->_featureNames.size(), actualHashed->_featureHashes.size());
+            for (size_t i = 0; i < expectedSparse->_featureNames.size(); i++) {
+                const auto &key = expectedSparse->_featureNames[i];
+                EXPECT_EQ(FeatureHasher::hash(key.data(), key.size()), actualHashed->_featureHashes[i])
+                    << key.toString();
+            }
+            return;
+        }
+        auto actualSparse = ASSERT_CAST_AND_RETURN(const MultiSparseFeatures, actual);
+        EXPECT_THAT(actualSparse->_offsets, ElementsAreArray(expectedSparse->_offsets));
+        EXPECT_THAT(actualSparse->_featureNames, ElementsAreArray(expectedSparse->_featureNames));
+    }
+
 protected:
     FeatureFunctionContext _context;
     std::unique_ptr<Features> _features;
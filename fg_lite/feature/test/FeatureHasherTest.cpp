@@ -0,0 +1,69 @@
+#include "fg_lite/feature/FeatureHasher.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class FeatureHasherTest : public FeatureFunctionTestBase {
+protected:
+    template <typename T>
+    void checkValue(const T &value) {
+        UnsafePool pool(1024);
+        FeatureFormatter::FeatureBuffer buffer{cp_alloc(&pool)};
+        buffer.push_back('p');
+        FeatureFormatter::fillFeatureToBuffer(value, buffer);
+        FeatureHasher hasher;
+        hasher.update("p", 1);
+        hasher.updateValue(value);
+        EXPECT_EQ(FeatureHasher::hash(buffer.data(), buffer.size()), hasher.finish())
+            << string(buffer.data(), buffer.size());
+    }
+};
+
+TEST_F(FeatureHasherTest, testStreaming) {
+    string key = "prefix_0123456789abcdefghijklmnopqrstuvwxyz";
+    for (size_t len = 0; len <= key.size(); len++) {
+        uint64_t expected = FeatureHasher::hash(key.data(), len);
+        for (size_t split = 0; split <= len; split++) {
+            FeatureHasher hasher;
+            hasher.update(key.data(), split);
+            FeatureHasher copied(hasher);
+            copied.update(key.data() + split, len - split);
+            EXPECT_EQ(expected, copied.finish()) << len << " " << split;
+        }
+        FeatureHasher bytes;
+        for (size_t i = 0; i < len; i++) {
+            bytes.updateValue(key[i]);
+        }
+        EXPECT_EQ(expected, bytes.finish());
+    }
+    EXPECT_NE(FeatureHasher::hash("a", 1), FeatureHasher::hash("a\0", 2));
+    EXPECT_NE(FeatureHasher::hash("ab", 2), FeatureHasher::hash("ab", 2, 1));
+}
+
+TEST_F(FeatureHasherTest, testUpdateValue) {
+    checkValue<bool>(true);
+    checkValue<bool>(false);
+    checkValue<char>('x');
+    checkValue<int8_t>(-128);
+    checkValue<uint8_t>(255);
+    checkValue<int16_t>(-12345);
+    checkValue<uint16_t>(65535);
+    checkValue<int32_t>(0);
+    checkValue<int32_t>(numeric_limits<int32_t>::min());
+    checkValue<uint32_t>(4000000000u);
+    checkValue<int64_t>(numeric_limits<int64_t>::min());
+    checkValue<int64_t>(-1234567890123ll);
+    checkValue<uint64_t>(numeric_limits<uint64_t>::max());
+    checkValue<float>(2.5f);
+    checkValue<double>(-1e20);
+    checkValue<string>("");
+    checkValue<string>("hello world");
+    checkValue<ConstString>(ConstString("const"));
+    checkValue<MultiChar>(genMultiCharValues({"multi char"})[0]);
+}
+
+}
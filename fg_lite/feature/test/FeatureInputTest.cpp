@@ -0,0 +1,216 @@
+#include "fg_lite/feature/FeatureInput.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class FeatureInputTest : public FeatureFunctionTestBase {
+protected:
+    // rows visited in [begin, end), formatted and separated by '|'
+    string visit(FeatureInput *input, size_t begin, size_t end) {
+        string result;
+        bool supported = visitTypedInput(input, [&](auto *typedInput) {
+                    typedInput->visitRows(begin, end, [&](size_t r, const auto &values) {
+                                result += r == begin ? "" : "|";
+                                for (size_t c = 0; c < values.size(); c++) {
+                                    FeatureFormatter::FeatureBuffer buffer{cp_alloc(_pool.get())};
+                                    FeatureFormatter::fillFeatureToBuffer(values[c], buffer);
+                                    result += (c == 0 ? "" : ",") + string(buffer.begin(), buffer.end());
+                                }
+                            });
+                });
+        EXPECT_TRUE(supported);
+        return result;
+    }
+};
+
+TEST_F(FeatureInputTest, testVisitRows) {
+    unique_ptr<FeatureInput> dense(genDenseInput<int32_t>({1, 2, 3, 4, 5, 6}, 3, 2));
+    EXPECT_EQ("1,2|3,4|5,6", visit(dense.get(), 0, 3));
+    EXPECT_EQ("3,4", visit(dense.get(), 1, 2));
+    EXPECT_EQ("", visit(dense.get(), 1, 1));
+
+    unique_ptr<FeatureInput> multi(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 2}, {}, {3}})));
+    EXPECT_EQ("1,2||3", visit(multi.get(), 0, 3));
+
+    unique_ptr<FeatureInput> offset(genValueOffsetInput<float>({1, 2, 3}, {0, 0, 2}));
+    EXPECT_EQ("|1,2|3", visit(offset.get(), 0, 3));
+    EXPECT_EQ("1,2|3", visit(offset.get(), 1, 3));
+
+    unique_ptr<FeatureInput> strings(genMultiValueInput<MultiChar>(
+                    genMultiStringValues({{"x", "yz"}, {}, {"w"}})));
+    EXPECT_EQ("x,yz||w", visit(strings.get(), 0, 3));
+
+    unique_ptr<FeatureInput> cstrings(genDenseInput<string>({"a", "b"}, 1, 2));
+    EXPECT_EQ("a,b", visit(cstrings.get(), 0, 1));
+}
+
+TEST_F(FeatureInputTest, testTyped) {
+    unique_ptr<FeatureInput> input(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 2}, {3}})));
+    auto typedInput = input->typed<int64_t, MultiValueStorage<int64_t>>();
+    ASSERT_TRUE(typedInput);
+    EXPECT_EQ(input.get(), typedInput);
+    EXPECT_EQ(2u, typedInput->getRowView(0).size());
+    EXPECT_EQ(3, typedInput->getRowView(1)[0]);
+    EXPECT_FALSE((input->typed<int32_t, MultiValueStorage<int32_t>>()));
+    EXPECT_FALSE((input->typed<int64_t, DenseStorage<int64_t>>()));
+
+    unique_ptr<FeatureInput> strings(genMultiValueInput<MultiChar>(
+                    genMultiStringValues({{"x", "yz"}})));
+    auto typedStrings = strings->typed<MultiChar, MultiValueStorage<MultiChar>>();
+    ASSERT_TRUE(typedStrings);
+    auto values = typedStrings->getRowView(0);
+    ASSERT_EQ(2u, values.size());
+    EXPECT_EQ(string("yz"), string(values[1].data(), values[1].size()));
+}
+
+TEST_F(FeatureInputTest, testStringRow) {
+    unique_ptr<FeatureInput> strings(genMultiValueInput<MultiChar>(
+                    genMultiStringValues({{"x", "", "yz"}, {}})));
+    auto typedStrings = strings->typed<MultiChar, MultiValueStorage<MultiChar>>();
+    ASSERT_TRUE(typedStrings);
+    StringRow values = typedStrings->getStringRow(0);
+    ASSERT_EQ(3u, values.size());
+    EXPECT_EQ(ConstString("x"), values[0]);
+    EXPECT_EQ(ConstString(""), values[1]);
+    EXPECT_EQ(ConstString("yz"), values[2]);
+    EXPECT_EQ(ConstString("yz"), typedStrings->getView(0, 2));
+    EXPECT_EQ(0u, typedStrings->getStringRow(1).size());
+
+    vector<string> raw = {"a", "bc", "d"};
+    FeatureInputTyped<string, DenseStorage<string>> cstrings(
+            DenseStorage<string>(raw.data(), 1, 3));
+    values = cstrings.getStringRow(0);
+    ASSERT_EQ(3u, values.size());
+    EXPECT_EQ(raw[1].data(), values[1].data());
+    EXPECT_EQ(raw[2].data(), cstrings.getView(0, 2).data());
+
+    unique_ptr<FeatureInput> chars(genValueOffsetInput<MultiChar>(
+                    genMultiCharValues({"p", "q", "rs"}), {0, 1}));
+    auto typedChars = chars->typed<MultiChar, ValueOffsetStorage<MultiChar>>();
+    ASSERT_TRUE(typedChars);
+    values = typedChars->getStringRow(1);
+    ASSERT_EQ(2u, values.size());
+    EXPECT_EQ(ConstString("rs"), values[1]);
+}
+
+TEST_F(FeatureInputTest, testMultiStringCursor) {
+    vector<MultiString> rows = genMultiStringValues({{"ab", "", "cde"}, {}});
+    MultiStringCursor cursor(rows[0]);
+    ASSERT_EQ(3u, cursor.size());
+    vector<string> values;
+    for (; cursor.valid(); cursor.next()) {
+        MultiChar value = cursor.value();
+        values.emplace_back(value.data(), value.size());
+    }
+    EXPECT_EQ(vector<string>({"ab", "", "cde"}), values);
+    EXPECT_EQ(3u, cursor.index());
+    uint32_t length = 0;
+    const char *data = cursor.data(2, length);
+    EXPECT_EQ("cde", string(data, length));
+    EXPECT_EQ(rows[0][1].size(), cursor[1].size());
+
+    EXPECT_EQ(0u, MultiStringCursor(rows[1]).size());
+    EXPECT_FALSE(MultiStringCursor(rows[1]).valid());
+    EXPECT_EQ(0u, MultiStringCursor(MultiString()).size());
+}
+
+TEST_F(FeatureInputTest, testValidityBitmap) {
+    // values 0, 2 and 64..129 are valid
+    vector<uint64_t> bits = {0x5, ~uint64_t(0), 0x3};
+    ValidityBitmap validity(bits.data());
+    vector<size_t> validIds;
+    validity.forEachValid(131, [&validIds](size_t id) { validIds.push_back(id); });
+    ASSERT_EQ(68u, validIds.size());
+    EXPECT_EQ(0u, validIds[0]);
+    EXPECT_EQ(2u, validIds[1]);
+    EXPECT_EQ(64u, validIds[2]);
+    EXPECT_EQ(129u, validIds.back());
+    EXPECT_EQ(68u, validity.countValid(131));
+    EXPECT_EQ(1u, validity.countValid(2));
+
+    ValidityBitmap offset = validity.offset(2);
+    EXPECT_TRUE(offset.isValid(0));
+    EXPECT_FALSE(offset.isValid(1));
+    EXPECT_TRUE(offset.isValid(62));
+    EXPECT_EQ(4u, offset.countValid(65));
+    validIds.clear();
+    offset.forEachValid(63, [&validIds](size_t id) { validIds.push_back(id); });
+    EXPECT_EQ(vector<size_t>({0, 62}), validIds);
+
+    EXPECT_TRUE(ValidityBitmap().isValid(100));
+    EXPECT_EQ(5u, ValidityBitmap().countValid(5));
+}
+
+TEST_F(FeatureInputTest, testStorageValidity) {
+    // the second value of every row is null
+    vector<int32_t> values = {1, 2, 3, 4, 5, 6};
+    vector<uint64_t> bits = {0x15};
+    FeatureInputTyped<int32_t, DenseStorage<int32_t>> dense(
+            DenseStorage<int32_t>(values.data(), 3, 2, ValidityBitmap(bits.data())));
+    EXPECT_TRUE(dense.hasValidity());
+    EXPECT_TRUE(dense.isValid(1, 0));
+    EXPECT_FALSE(dense.isValid(1, 1));
+    EXPECT_FALSE(dense.getRow(2).validity().isValid(1));
+    FeatureFormatter::FeatureBuffer buffer{cp_alloc(_pool.get())};
+    EXPECT_FALSE(dense.toString(0, 1, buffer, true));
+    EXPECT_TRUE(dense.toString(0, 1, buffer, false));
+    unique_ptr<FeatureInput> slice(dense.slice(1, 3));
+    auto typedSlice = slice->typed<int32_t, DenseStorage<int32_t>>();
+    EXPECT_TRUE(typedSlice->isValid(0, 0));
+    EXPECT_FALSE(typedSlice->isValid(0, 1));
+
+    // rows {1}, {2, 3}, {4, 5, 6} with 3 and 6 null
+    vector<size_t> offsets = {0, 1, 3};
+    bits = {0x1b};
+    FeatureInputTyped<int32_t, ValueOffsetStorage<int32_t>> valueOffset(
+            ValueOffsetStorage<int32_t>(values.data(), values.size(), offsets.data(),
+                    offsets.size(), ValidityBitmap(bits.data())));
+    EXPECT_FALSE(valueOffset.isValid(1, 1));
+    EXPECT_TRUE(valueOffset.isValid(2, 1));
+    size_t validCount = 0;
+    valueOffset.visitRows([&validCount](size_t, const Row<int32_t> &row) {
+                forEachValid(row, row.size(), [&validCount](size_t) { validCount++; });
+            });
+    EXPECT_EQ(4u, validCount);
+    slice.reset(valueOffset.slice(2, 3));
+    EXPECT_FALSE((slice->typed<int32_t, ValueOffsetStorage<int32_t>>()->isValid(0, 2)));
+}
+
+TEST_F(FeatureInputTest, testDictionaryStorage) {
+    // rows {y, x}, {z, y}, {y, y}
+    unique_ptr<FeatureInput> input(genDictionaryInput<MultiChar>(
+                    genMultiCharValues({"x", "y", "z"}), {1, 0, 2, 1, 1, 1}, 3, 2));
+    EXPECT_EQ(IST_DICTIONARY, input->storageType());
+    EXPECT_EQ(6u, input->numElements());
+    EXPECT_EQ("y,x|z,y|y,y", visit(input.get(), 0, 3));
+    auto typedInput = input->typed<MultiChar, DictionaryStorage<MultiChar>>();
+    ASSERT_TRUE(typedInput);
+    EXPECT_EQ(3u, typedInput->getStorage().dictionarySize());
+    EXPECT_EQ(ConstString("z"), typedInput->getView(1, 0));
+    StringRow values = typedInput->getStringRow(1);
+    ASSERT_EQ(2u, values.size());
+    EXPECT_EQ(ConstString("y"), values[1]);
+
+    unique_ptr<FeatureInput> slice(input->slice(1, 3));
+    EXPECT_EQ("z,y|y,y", visit(slice.get(), 0, 2));
+
+    vector<unique_ptr<FeatureInput>> decoded;
+    FeatureInput *dense = decodeDictionaryInput(input.get(), decoded);
+    ASSERT_EQ(1u, decoded.size());
+    EXPECT_EQ(IST_DENSE, dense->storageType());
+    EXPECT_EQ("y,x|z,y|y,y", visit(dense, 0, 3));
+    EXPECT_EQ(dense, (dense->typed<MultiChar, DenseStorage<MultiChar>>()));
+    FeatureHasher inputHasher, denseHasher;
+    input->hashRow(2, inputHasher);
+    dense->hashRow(2, denseHasher);
+    EXPECT_EQ(denseHasher.finish(), inputHasher.finish());
+    EXPECT_EQ(dense, decodeDictionaryInput(dense, decoded));
+    EXPECT_EQ(1u, decoded.size());
+}
+}
@@ -0,0 +1,155 @@
+#include <thread>
+#include "fg_lite/feature/FeatureMetrics.h"
+#include "fg_lite/feature/FeaturePlan.h"
+#include "fg_lite/feature/IdFeatureFunction.h"
+#include "fg_lite/feature/RawFeatureFunction.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class FeatureMetricsTest : public FeatureFunctionTestBase {
+};
+
+TEST_F(FeatureMetricsTest, testBucket) {
+    EXPECT_EQ(0u, FeatureMetrics::getBucket(0));
+    EXPECT_EQ(7u, FeatureMetrics::getBucket(7));
+    EXPECT_EQ(8u, FeatureMetrics::getBucket(8));
+    EXPECT_EQ(15u, FeatureMetrics::getBucket(15));
+    EXPECT_EQ(16u, FeatureMetrics::getBucket(16));
+    EXPECT_EQ(16u, FeatureMetrics::getBucket(17));
+    EXPECT_EQ(FeatureMetrics::BUCKET_COUNT - 1, FeatureMetrics::getBucket(numeric_limits<uint64_t>::max()));
+    for (size_t i = 0; i < FeatureMetrics::BUCKET_COUNT; i++) {
+        uint64_t upperBound = FeatureMetrics::getBucketUpperBound(i);
+        EXPECT_EQ(i, FeatureMetrics::getBucket(upperBound));
+        if (i + 1 < FeatureMetrics::BUCKET_COUNT) {
+            EXPECT_EQ(i + 1, FeatureMetrics::getBucket(upperBound + 1));
+        }
+    }
+}
+
+TEST_F(FeatureMetricsTest, testRecordAndSnapshot) {
+    FeatureMetrics metrics({"a", "b"}, 4);
+    vector<thread> threads;
+    for (size_t i = 0; i < 8; i++) {
+        threads.emplace_back([&metrics]() {
+                    for (size_t j = 1; j <= 100; j++) {
+                        metrics.record(0, j * 1000, 10, 20, 30);
+                    }
+                });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    metrics.record(2, 1, 1, 1, 1);
+    vector<FeatureMetricsSnapshot> snapshots;
+    metrics.snapshot(snapshots);
+    ASSERT_EQ(2u, snapshots.size());
+    const FeatureMetricsSnapshot &snapshot = snapshots[0];
+    EXPECT_EQ("a", snapshot.featureName);
+    EXPECT_EQ(800u, snapshot.callCount);
+    EXPECT_EQ(8000u, snapshot.docCount);
+    EXPECT_EQ(16000u, snapshot.valueCount);
+    EXPECT_EQ(24000u, snapshot.poolBytes);
+    EXPECT_EQ(8u * 5050 * 1000, snapshot.latencyNs);
+    EXPECT_DOUBLE_EQ(8000 * 1e9 / snapshot.latencyNs, snapshot.getDocsPerSecond());
+    // within the 1/8 bucket width
+    uint64_t median = snapshot.getLatencyPercentile(50);
+    EXPECT_LE(50000u, median);
+    EXPECT_GE(50000u * 9 / 8, median);
+    uint64_t maxLatency = snapshot.getLatencyPercentile(100);
+    EXPECT_LE(100000u, maxLatency);
+    EXPECT_GE(100000u * 9 / 8, maxLatency);
+    EXPECT_EQ(0u, snapshots[1].callCount);
+    EXPECT_EQ(0u, snapshots[1].getLatencyPercentile(99));
+
+    metrics.reset();
+    metrics.snapshot(snapshots);
+    EXPECT_EQ(0u, snapshots[0].callCount);
+    EXPECT_EQ(0u, snapshots[0].latencyNs);
+}
+
+TEST_F(FeatureMetricsTest, testFeaturePlan) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new RawFeatureFunction("price", Normalizer(), {}, 1),
+                    {"item:price"}));
+    unique_ptr<FeatureInput> brand(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 2}, {3}, {}})));
+    unique_ptr<FeatureInput> price(genDenseInput<float>({1.5, 2.5, 3.5}));
+
+    vector<FeatureInput*> inputs = {brand.get(), price.get()};
+
+    FeatureMetrics metrics(plan.getFeatureNames());
+    FeatureFunctionContext context(_pool.get());
+    context.metrics = &metrics;
+    vector<Features*> outputs;
+    for (size_t i = 0; i < 2; i++) {
+        ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+        FeaturePlan::clearFeatures(outputs);
+    }
+    vector<FeatureMetricsSnapshot> snapshots;
+    metrics.snapshot(snapshots);
+    ASSERT_EQ(2u, snapshots.size());
+    EXPECT_EQ("brand", snapshots[0].featureName);
+    EXPECT_EQ(2u, snapshots[0].callCount);
+    EXPECT_EQ(6u, snapshots[0].docCount);
+    EXPECT_EQ(6u, snapshots[0].valueCount);
+    EXPECT_EQ("price", snapshots[1].featureName);
+    EXPECT_EQ(2u, snapshots[1].callCount);
+    EXPECT_EQ(6u, snapshots[1].valueCount);
+    uint64_t calls = 0;
+    for (uint64_t count : snapshots[1].latencyHistogram) {
+        calls += count;
+    }
+    EXPECT_EQ(2u, calls);
+
+    // nothing recorded without metrics in the context
+    context.metrics = nullptr;
+    ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+    FeaturePlan::clearFeatures(outputs);
+    metrics.snapshot(snapshots);
+    EXPECT_EQ(2u, snapshots[0].callCount);
+
+    // outputs in the feature pool are counted on the serial path only
+    autil::mem_pool::Pool featurePool;
+    context.featurePool = &featurePool;
+    context.metrics = &metrics;
+    metrics.reset();
+    ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+    FeaturePlan::clearFeatures(outputs);
+    metrics.snapshot(snapshots);
+    EXPECT_LT(0u, snapshots[1].poolBytes);
+    metrics.reset();
+    WorkStealingThreadPool threadPool(2);
+    ASSERT_TRUE(threadPool.start());
+    ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs, &threadPool));
+    FeaturePlan::clearFeatures(outputs);
+    metrics.snapshot(snapshots);
+    EXPECT_EQ(1u, snapshots[1].callCount);
+    EXPECT_EQ(0u, snapshots[1].poolBytes);
+}
+
+TEST_F(FeatureMetricsTest, testValueCount) {
+    MultiSparseFeatures sparse(2);
+    sparse.beginDocument();
+    sparse.addFeatureKey("a", 1);
+    sparse.addFeatureKey("b", 1);
+    sparse.beginDocument();
+    EXPECT_EQ(2u, sparse.count());
+    EXPECT_EQ(2u, sparse.valueCount());
+    MultiHashedSparseFeatures hashed(2);
+    hashed.beginDocument();
+    hashed.addFeatureHash(1);
+    hashed.addFeatureHash(2);
+    hashed.addFeatureHash(3);
+    EXPECT_EQ(1u, hashed.count());
+    EXPECT_EQ(3u, hashed.valueCount());
+}
+
+}
@@ -0,0 +1,431 @@
+#include "fg_lite/feature/FeaturePlan.h"
+#include "fg_lite/feature/FeatureConfig.h"
+#include "fg_lite/feature/IdFeatureFunction.h"
+#include "fg_lite/feature/ComboFeatureFunction.h"
+#include "fg_lite/feature/RawFeatureFunction.h"
+#include "fg_lite/feature/ItemFeatureCache.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class FeaturePlanTest : public FeatureFunctionTestBase {
+protected:
+    void checkSparse(Features *features, const vector<string> &results) {
+        auto typedFeatures = ASSERT_CAST_AND_RETURN(SingleSparseFeatures, features);
+        ASSERT_EQ(results.size(), typedFeatures->_featureNames.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            EXPECT_EQ(ConstString(results[i]), typedFeatures->_featureNames[i]);
+        }
+    }
+};
+
+// storage type of the input every doc reads
+class StorageTypeFeatureFunction : public FeatureFunction {
+public:
+    StorageTypeFeatureFunction(bool supportDictionary)
+        : FeatureFunction("storage_type")
+        , _supportDictionary(supportDictionary)
+    {}
+public:
+    Features *genFeatures(const vector<FeatureInput*> &inputs,
+                          FeatureFunctionContext *context) const override
+    {
+        auto features = new SingleIntegerFeatures(getFeatureName(), inputs[0]->row());
+        for (size_t r = 0; r < inputs[0]->row(); r++) {
+            features->addFeatureValue(inputs[0]->storageType());
+        }
+        return features;
+    }
+    size_t getInputCount() const override {
+        return 1;
+    }
+    bool supportDictionaryInput() const override {
+        return _supportDictionary;
+    }
+private:
+    bool _supportDictionary;
+};
+
+TEST_F(FeaturePlanTest, testAddFeature) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new ComboFeatureFunction("user_brand", "user_brand_",
+                            {}, {}, 2), {"user:gender", "item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new RawFeatureFunction("price", Normalizer(), {}, 1),
+                    {"item:price"}));
+    ASSERT_FALSE(plan.addFeature(new IdFeatureFunction("bad", "bad_",
+                            numeric_limits<int>::max(), {}), {"item:a", "item:b"}));
+    ASSERT_FALSE(plan.addFeature(nullptr, {}));
+
+    ASSERT_EQ(3u, plan.getFeatureCount());
+    EXPECT_THAT(plan.getInputNames(),
+                ElementsAre("item:brand", "user:gender", "item:price"));
+    EXPECT_EQ(0, plan.getInputSlot("item:brand"));
+    EXPECT_EQ(1, plan.getInputSlot("user:gender"));
+    EXPECT_EQ(2, plan.getInputSlot("item:price"));
+    EXPECT_EQ(-1, plan.getInputSlot("item:a"));
+    EXPECT_THAT(plan.getFeatureInputSlots(1), ElementsAre(1, 0));
+    EXPECT_EQ("user_brand", plan.getFeatureFunction(1)->getFeatureName());
+    EXPECT_EQ(FeaturePlan::FS_ITEM, plan.getFeatureScope(0));
+    EXPECT_EQ(FeaturePlan::FS_CROSS, plan.getFeatureScope(1));
+    EXPECT_EQ(FeaturePlan::FS_ITEM, plan.getFeatureScope(2));
+    EXPECT_EQ(FeaturePlan::FS_USER, FeaturePlan::classifyInputs({"user:a", "query:b"}));
+    EXPECT_EQ(FeaturePlan::FS_CROSS, FeaturePlan::classifyInputs({"item:a", "b"}));
+    EXPECT_EQ(FeaturePlan::FS_CROSS, FeaturePlan::classifyInputs({}));
+}
+
+TEST_F(FeaturePlanTest, testItemFeatureCache) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new ComboFeatureFunction("user_brand", "user_brand_",
+                            {}, {}, 2), {"user:gender", "item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new RawFeatureFunction("price", Normalizer(), {}, 1),
+                    {"item:price"}));
+    ItemFeatureCache cache(1 << 20, 0, 4);
+    FeatureFunctionContext context;
+    context.itemCache = &cache;
+    unique_ptr<FeatureInput> gender(genDenseInput<string>({"m"}));
+
+    // first request is cold and fills the cache
+    vector<uint64_t> itemIds = {11, 12, 13, 14};
+    context.itemIds = &itemIds;
+    unique_ptr<FeatureInput> brand(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1}, {2, 3}, {}, {4}})));
+    unique_ptr<FeatureInput> price(genDenseInput<float>({1.5, 2.5, 3.5, 4.5}));
+    vector<Features*> outputs;
+    ASSERT_TRUE(plan.genFeatures({brand.get(), gender.get(), price.get()}, &context, outputs));
+    checkSparse(outputs[0], {"brand_1", "brand_2", "brand_3", "brand_4"});
+    FeaturePlan::clearFeatures(outputs);
+    EXPECT_EQ(8u, cache.size());
+
+    // item 15 and 16 are missed and generated on a slice
+    itemIds = {14, 15, 16, 11, 12, 13};
+    brand.reset(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{4}, {5}, {6, 7}, {1}, {2, 3}, {}})));
+    price.reset(genDenseInput<float>({4.5, 5.5, 6.5, 1.5, 2.5, 3.5}));
+    ASSERT_TRUE(plan.genFeatures({brand.get(), gender.get(), price.get()}, &context, outputs));
+    auto sparseFeatures = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, outputs[0]);
+    EXPECT_THAT(sparseFeatures->_offsets, ElementsAre(0, 1, 2, 4, 5, 7));
+    checkSparse(outputs[0], {"brand_4", "brand_5", "brand_6", "brand_7",
+                             "brand_1", "brand_2", "brand_3"});
+    checkSparse(outputs[1], {"user_brand_m_4", "user_brand_m_5", "user_brand_m_6",
+                             "user_brand_m_7", "user_brand_m_1", "user_brand_m_2",
+                             "user_brand_m_3"});
+    auto denseFeatures = ASSERT_CAST_AND_RETURN(SingleDenseFeatures, outputs[2]);
+    EXPECT_EQ("price", denseFeatures->_featureName);
+    EXPECT_THAT(denseFeatures->_featureValues, ElementsAre(4.5, 5.5, 6.5, 1.5, 2.5, 3.5));
+    FeaturePlan::clearFeatures(outputs);
+    EXPECT_EQ(12u, cache.size());
+    EXPECT_EQ(8u, cache.getHitCount());
+
+    // a wrong item count falls back to generating all docs
+    itemIds = {11};
+    ASSERT_TRUE(plan.genFeatures({brand.get(), gender.get(), price.get()}, &context, outputs));
+    EXPECT_EQ(6u, outputs[0]->count());
+    FeaturePlan::clearFeatures(outputs);
+}
+
+TEST_F(FeaturePlanTest, testItemFeatureCacheKey) {
+    // same feature name, the second config prunes to one value
+    FeatureConfig config;
+    config._featureConfigs.push_back(new IdFeatureConfig("brand", "item:brand"));
+    FeatureConfig prunedConfig;
+    auto pruned = new IdFeatureConfig("brand", "item:brand");
+    pruned->pruneTo = 1;
+    prunedConfig._featureConfigs.push_back(pruned);
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.init(config));
+    FeaturePlan prunedPlan;
+    ASSERT_TRUE(prunedPlan.init(prunedConfig));
+    FeaturePlan samePlan;
+    ASSERT_TRUE(samePlan.init(config));
+
+    ItemFeatureCache cache(1 << 20, 0, 4);
+    FeatureFunctionContext context;
+    context.itemCache = &cache;
+    vector<uint64_t> itemIds = {11, 12};
+    context.itemIds = &itemIds;
+    unique_ptr<FeatureInput> brand(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 2}, {3}})));
+    vector<Features*> outputs;
+    ASSERT_TRUE(plan.genFeatures({brand.get()}, &context, outputs));
+    checkSparse(outputs[0], {"brand_1", "brand_2", "brand_3"});
+    FeaturePlan::clearFeatures(outputs);
+    ASSERT_TRUE(prunedPlan.genFeatures({brand.get()}, &context, outputs));
+    checkSparse(outputs[0], {"brand_1", "brand_3"});
+    FeaturePlan::clearFeatures(outputs);
+    EXPECT_EQ(0u, cache.getHitCount());
+    EXPECT_EQ(4u, cache.size());
+
+    // plans of the same config share rows
+    ASSERT_TRUE(samePlan.genFeatures({brand.get()}, &context, outputs));
+    checkSparse(outputs[0], {"brand_1", "brand_2", "brand_3"});
+    FeaturePlan::clearFeatures(outputs);
+    EXPECT_EQ(2u, cache.getHitCount());
+
+    // features added without a config only share rows within their plan
+    FeaturePlan handBuilt;
+    ASSERT_TRUE(handBuilt.addFeature(new IdFeatureFunction("brand", "brand_", 1, {}),
+                    {"item:brand"}));
+    ASSERT_TRUE(handBuilt.genFeatures({brand.get()}, &context, outputs));
+    checkSparse(outputs[0], {"brand_1", "brand_3"});
+    FeaturePlan::clearFeatures(outputs);
+    EXPECT_EQ(2u, cache.getHitCount());
+    EXPECT_EQ(6u, cache.size());
+}
+
+TEST_F(FeaturePlanTest, testGenFeatures) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new ComboFeatureFunction("user_brand", "user_brand_",
+                            {}, {}, 2), {"user:gender", "item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new RawFeatureFunction("price", Normalizer(), {}, 1),
+                    {"item:price"}));
+
+    unique_ptr<FeatureInput> brand(genDenseInput<int64_t>({1, 2, 3}));
+    unique_ptr<FeatureInput> gender(genDenseInput<string>({"m"}));
+    unique_ptr<FeatureInput> price(genDenseInput<float>({1.5, 2.5, 3.5}));
+
+    vector<Features*> outputs;
+    FeaturePlan::NamedInputs namedInputs = {
+        {"item:brand", brand.get()},
+        {"user:gender", gender.get()},
+        {"item:price", price.get()},
+    };
+    ASSERT_TRUE(plan.genFeatures(namedInputs, &_context, outputs));
+    ASSERT_EQ(3u, outputs.size());
+    checkSparse(outputs[0], {"brand_1", "brand_2", "brand_3"});
+    checkSparse(outputs[1], {"user_brand_m_1", "user_brand_m_2", "user_brand_m_3"});
+    auto denseFeatures = ASSERT_CAST_AND_RETURN(SingleDenseFeatures, outputs[2]);
+    EXPECT_THAT(denseFeatures->_featureValues, ElementsAre(1.5, 2.5, 3.5));
+    FeaturePlan::clearFeatures(outputs);
+
+    vector<FeatureInput*> slotInputs = {brand.get(), gender.get(), price.get()};
+    ASSERT_TRUE(plan.genFeatures(slotInputs, &_context, outputs));
+    checkSparse(outputs[0], {"brand_1", "brand_2", "brand_3"});
+    FeaturePlan::clearFeatures(outputs);
+
+    namedInputs.erase("item:price");
+    ASSERT_FALSE(plan.genFeatures(namedInputs, &_context, outputs));
+    slotInputs.pop_back();
+    ASSERT_FALSE(plan.genFeatures(slotInputs, &_context, outputs));
+}
+
+TEST_F(FeaturePlanTest, testInitFromConfig) {
+    FeatureConfig config;
+    config._featureConfigs.push_back(new IdFeatureConfig("brand", "item:brand"));
+    auto comboConfig = new ComboFeatureConfig();
+    comboConfig->featureName = "user_brand";
+    comboConfig->expressions = {"user:gender", "item:brand"};
+    config._featureConfigs.push_back(comboConfig);
+
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.init(config));
+    ASSERT_EQ(2u, plan.getFeatureCount());
+    EXPECT_THAT(plan.getInputNames(), ElementsAre("item:brand", "user:gender"));
+
+    unique_ptr<FeatureInput> brand(genDenseInput<int64_t>({1, 2}));
+    unique_ptr<FeatureInput> gender(genDenseInput<string>({"m"}));
+    vector<Features*> outputs;
+    vector<FeatureInput*> slotInputs = {brand.get(), gender.get()};
+    ASSERT_TRUE(plan.genFeatures(slotInputs, &_context, outputs));
+    checkSparse(outputs[0], {"brand_1", "brand_2"});
+    checkSparse(outputs[1], {"user_brand_m_1", "user_brand_m_2"});
+    FeaturePlan::clearFeatures(outputs);
+
+    config._featureConfigs.push_back(new GBDTFeatureConfig());
+    ASSERT_FALSE(plan.init(config));
+    EXPECT_EQ(0u, plan.getFeatureCount());
+}
+
+TEST_F(FeaturePlanTest, testInitOptimizedLookup) {
+    // declares the map and the key, the optimized function reads the map only
+    FeatureConfig config;
+    auto lookupConfig = new LookupFeatureConfig();
+    lookupConfig->featureName = "lookup";
+    lookupConfig->mapExpression = "user:map";
+    lookupConfig->keyExpression = "item:key";
+    lookupConfig->isOptimized = true;
+    lookupConfig->needKey = false;
+    config._featureConfigs.push_back(lookupConfig);
+
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.init(config));
+    EXPECT_THAT(plan.getInputNames(), ElementsAre("user:map"));
+    EXPECT_EQ(FeaturePlan::FS_USER, plan.getFeatureScope(0));
+
+    unique_ptr<FeatureInput> values(genMultiValueInput<MultiChar>(
+                    genMultiStringValues({{"123"}, {"3"}})));
+    vector<Features*> outputs;
+    ASSERT_TRUE(plan.genFeatures({values.get()}, &_context, outputs));
+    auto features = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, outputs[0]);
+    EXPECT_THAT(features->_featureNames,
+                ElementsAre(ConstString("lookup_123"), ConstString("lookup_3")));
+    FeaturePlan::clearFeatures(outputs);
+}
+
+TEST_F(FeaturePlanTest, testInitMatchAllItemsAndCategories) {
+    // item and category are both ALL, only the user input is declared
+    FeatureConfig config;
+    auto matchConfig = new MatchFeatureConfig("user_hit");
+    matchConfig->userExpression = "user:match";
+    matchConfig->itemExpression = "ALL";
+    matchConfig->categoryExpression = "ALL";
+    matchConfig->matchType = "multihit";
+    config._featureConfigs.push_back(matchConfig);
+
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.init(config));
+    EXPECT_THAT(plan.getInputNames(), ElementsAre("user:match"));
+
+    unique_ptr<FeatureInput> users(genDenseInput<string>({"1^a:2", "1^b:3"}));
+    vector<Features*> outputs;
+    ASSERT_TRUE(plan.genFeatures({users.get()}, &_context, outputs));
+    auto features = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, outputs[0]);
+    EXPECT_EQ(2u, features->count());
+    EXPECT_THAT(features->_featureNames,
+                ElementsAre(ConstString("user_hit_1_a_2"), ConstString("user_hit_1_b_3")));
+    FeaturePlan::clearFeatures(outputs);
+}
+
+TEST_F(FeaturePlanTest, testGenFeaturesParallel) {
+    FeaturePlan plan;
+    for (size_t i = 0; i < 32; i++) {
+        string name = "brand" + StringUtil::toString(i);
+        ASSERT_TRUE(plan.addFeature(new IdFeatureFunction(name, name + "_",
+                                numeric_limits<int>::max(), {}), {"item:brand"}));
+    }
+    unique_ptr<FeatureInput> brand(genDenseInput<int64_t>({1, 2}));
+    vector<FeatureInput*> slotInputs = {brand.get()};
+
+    WorkStealingThreadPool threadPool(4);
+    ASSERT_TRUE(threadPool.start());
+    vector<Features*> outputs;
+    ASSERT_TRUE(plan.genFeatures(slotInputs, &_context, outputs, &threadPool));
+    ASSERT_EQ(32u, outputs.size());
+    for (size_t i = 0; i < outputs.size(); i++) {
+        string name = "brand" + StringUtil::toString(i);
+        checkSparse(outputs[i], {name + "_1", name + "_2"});
+    }
+    FeaturePlan::clearFeatures(outputs);
+
+    ASSERT_TRUE(plan.genFeatures(slotInputs, &_context, outputs, nullptr));
+    ASSERT_EQ(32u, outputs.size());
+    checkSparse(outputs[31], {"brand31_1", "brand31_2"});
+    FeaturePlan::clearFeatures(outputs);
+
+    // every task writes its output to the arena of its thread
+    autil::mem_pool::Pool featurePool;
+    vector<unique_ptr<autil::mem_pool::Pool>> ownedPools;
+    vector<autil::mem_pool::Pool*> workerPools;
+    for (size_t i = 0; i <= threadPool.getThreadNum(); i++) {
+        ownedPools.emplace_back(new autil::mem_pool::Pool());
+        workerPools.push_back(ownedPools.back().get());
+    }
+    FeatureFunctionContext context(_pool.get());
+    context.featurePool = &featurePool;
+    context.workerFeaturePools = &workerPools;
+    ASSERT_TRUE(plan.genFeatures(slotInputs, &context, outputs, &threadPool));
+    for (size_t i = 0; i < outputs.size(); i++) {
+        string name = "brand" + StringUtil::toString(i);
+        checkSparse(outputs[i], {name + "_1", name + "_2"});
+        auto features = dynamic_cast<SingleSparseFeatures*>(outputs[i]);
+        ASSERT_TRUE(features);
+        EXPECT_THAT(workerPools, Contains(features->getPool()));
+    }
+    FeaturePlan::clearFeatures(outputs);
+    EXPECT_EQ(0u, featurePool.getUsedBytes());
+}
+
+TEST_F(FeaturePlanTest, testGenFeaturesChunked) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new ComboFeatureFunction("user_brand", "user_brand_",
+                            {}, {}, 2), {"user:gender", "item:brand"}));
+    unique_ptr<FeatureInput> brand(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1}, {2, 3}, {}, {4}, {5}})));
+    unique_ptr<FeatureInput> gender(genDenseInput<string>({"m"}));
+    vector<FeatureInput*> slotInputs = {brand.get(), gender.get()};
+
+    vector<size_t> begins;
+    vector<string> brands;
+    vector<string> combos;
+    auto consumer = [&](size_t beginDoc, vector<Features*> &outputs) {
+        begins.push_back(beginDoc);
+        EXPECT_EQ(2u, outputs.size());
+        auto brandFeatures = dynamic_cast<MultiSparseFeatures*>(outputs[0]);
+        auto comboFeatures = dynamic_cast<MultiSparseFeatures*>(outputs[1]);
+        EXPECT_TRUE(brandFeatures && comboFeatures);
+        if (brandFeatures && comboFeatures) {
+            EXPECT_GE(2u, brandFeatures->count());
+            for (const auto &name : brandFeatures->_featureNames) {
+                brands.emplace_back(name.data(), name.size());
+            }
+            for (const auto &name : comboFeatures->_featureNames) {
+                combos.emplace_back(name.data(), name.size());
+            }
+        }
+        return true;
+    };
+    ASSERT_TRUE(plan.genFeaturesChunked(slotInputs, &_context, 2, consumer));
+    EXPECT_THAT(begins, ElementsAre(0, 2, 4));
+    EXPECT_THAT(brands, ElementsAre("brand_1", "brand_2", "brand_3", "brand_4", "brand_5"));
+    EXPECT_THAT(combos, ElementsAre("user_brand_m_1", "user_brand_m_2", "user_brand_m_3",
+                            "user_brand_m_4", "user_brand_m_5"));
+
+    // outputs of every chunk live in an arena of the call, reset per chunk
+    autil::mem_pool::Pool featurePool;
+    FeatureFunctionContext context(_pool.get());
+    context.featurePool = &featurePool;
+    brands.clear();
+    ASSERT_TRUE(plan.genFeaturesChunked(slotInputs, &context, 2,
+                    [&](size_t beginDoc, vector<Features*> &outputs) {
+                        auto brandFeatures = dynamic_cast<MultiSparseFeatures*>(outputs[0]);
+                        EXPECT_TRUE(brandFeatures && brandFeatures->getPool() != &featurePool);
+                        return consumer(beginDoc, outputs);
+                    }));
+    EXPECT_EQ(0u, featurePool.getUsedBytes());
+    EXPECT_THAT(brands, ElementsAre("brand_1", "brand_2", "brand_3", "brand_4", "brand_5"));
+
+    begins.clear();
+    ASSERT_FALSE(plan.genFeaturesChunked(slotInputs, &_context, 2,
+                    [&](size_t beginDoc, vector<Features*> &outputs) {
+                        begins.push_back(beginDoc);
+                        return false;
+                    }));
+    EXPECT_THAT(begins, ElementsAre(0));
+
+    unique_ptr<FeatureInput> badGender(genDenseInput<string>({"m", "f"}));
+    EXPECT_FALSE(plan.genFeaturesChunked({brand.get(), badGender.get()}, &_context, 2, consumer));
+    EXPECT_FALSE(plan.genFeaturesChunked(slotInputs, &_context, 0, consumer));
+}
+
+TEST_F(FeaturePlanTest, testDictionaryInput) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new StorageTypeFeatureFunction(false), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new StorageTypeFeatureFunction(true), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    unique_ptr<FeatureInput> brand(genDictionaryInput<int64_t>({7, 8}, {1, 0, 1}, 3));
+    vector<Features*> outputs;
+    ASSERT_TRUE(plan.genFeatures({brand.get()}, &_context, outputs));
+    ASSERT_EQ(3u, outputs.size());
+    // decoded to dense unless the function reads dictionaries
+    auto storageTypes = ASSERT_CAST_AND_RETURN(SingleIntegerFeatures, outputs[0]);
+    EXPECT_THAT(storageTypes->_featureValues, ElementsAre(IST_DENSE, IST_DENSE, IST_DENSE));
+    storageTypes = ASSERT_CAST_AND_RETURN(SingleIntegerFeatures, outputs[1]);
+    EXPECT_THAT(storageTypes->_featureValues,
+                ElementsAre(IST_DICTIONARY, IST_DICTIONARY, IST_DICTIONARY));
+    checkSparse(outputs[2], {"brand_8", "brand_7", "brand_8"});
+    FeaturePlan::clearFeatures(outputs);
+}
+}
@@ -0,0 +1,120 @@
+#include "fg_lite/feature/HashedFeatureFunction.h"
+#include "fg_lite/feature/IdFeatureFunction.h"
+#include "fg_lite/feature/ComboFeatureFunction.h"
+#include "fg_lite/feature/KgbMatchSemanticFeatureFunction.h"
+#include "fg_lite/feature/RawFeatureFunction.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class HashedFeatureFunctionTest : public FeatureFunctionTestBase {
+protected:
+    // hashes of function in hash mode must be the hashes of its string keys
+    void checkHashed(FeatureFunction *function, const vector<FeatureInput*> &inputs) {
+        ASSERT_TRUE(function->supportHashOutput());
+        unique_ptr<Features> expected(function->genFeatures(inputs, &_context));
+        function->setHashOutput(true);
+        unique_ptr<Features> actual(function->genFeatures(inputs, &_context));
+        function->setHashOutput(false);
+        ASSERT_TRUE(expected);
+        ASSERT_NE(0u, expected->valueCount());
+        expectSameFeatures(expected.get(), actual.get());
+    }
+};
+
+TEST_F(HashedFeatureFunctionTest, testIdFeature) {
+    IdFeatureFunction function("id", "id_", numeric_limits<int>::max(), {"-1"});
+    unique_ptr<FeatureInput> ints(genValueOffsetInput<int64_t>({1, -1, 300000000000, -7}, {0, 1, 1, 3}));
+    checkHashed(&function, {ints.get()});
+    unique_ptr<FeatureInput> floats(genDenseInput<float>({1.4f, 2.6f}));
+    checkHashed(&function, {floats.get()});
+    for (auto &input : genStringFeatureInput({{"abc", "a_very_long_string_value"}, {"", "x"}})) {
+        checkHashed(&function, {input.get()});
+    }
+}
+
+TEST_F(HashedFeatureFunctionTest, testComboFeature) {
+    unique_ptr<FeatureInput> user(genDenseInput<string>({"u1"}, 1, 1));
+    auto multiValues = genMultiValues<int32_t>({{1, 2, 3}, {}, {4, numeric_limits<int32_t>::max()}});
+    unique_ptr<FeatureInput> item(genMultiValueInput<int32_t>(multiValues));
+    unique_ptr<FeatureInput> price(genDenseInput<double>({1.0, 22.0, 333.0}));
+    ComboFeatureFunction combo("combo", "combo_", {}, {}, 3);
+    checkHashed(&combo, {user.get(), item.get(), price.get()});
+    ComboFeatureFunction pruned("combo", "combo_", {false, false}, {1, 2}, 3);
+    checkHashed(&pruned, {user.get(), item.get(), price.get()});
+    ComboFeatureFunction sorted("combo", "combo_", {}, {}, 3, true);
+    checkHashed(&sorted, {price.get(), item.get(), user.get()});
+
+    unique_ptr<FeatureInput> single(genDenseInput<int64_t>({5, 6, 7}));
+    checkHashed(&combo, {user.get(), single.get(), price.get()});
+}
+
+TEST_F(HashedFeatureFunctionTest, testKgbMatchSemantic) {
+    unique_ptr<FeatureInput> query(genDenseInput<int64_t>({(1ll << 56) | 2, (1ll << 56) | 3}, 1, 2));
+    unique_ptr<FeatureInput> item(genDenseInput<int64_t>({(1ll << 32) | 2, (1ll << 32) | 5}, 2, 1));
+    unique_ptr<FeatureInput> other(genDenseInput<int64_t>({11, 12}, 2, 1));
+    KgbMatchSemanticFeatureFunction match("kgb", "kgb_", true, false, true);
+    checkHashed(&match, {query.get(), item.get(), other.get()});
+    KgbMatchSemanticFeatureFunction unmatch("kgb", "kgb_", false);
+    checkHashed(&unmatch, {query.get(), item.get()});
+}
+
+TEST_F(HashedFeatureFunctionTest, testHashFeatures) {
+    IdFeatureFunction *id = new IdFeatureFunction("id", "id_", numeric_limits<int>::max(), {});
+    HashedFeatureFunction hashed(id);
+    EXPECT_EQ("id", hashed.getFeatureName());
+    EXPECT_EQ(1u, hashed.getInputCount());
+    unique_ptr<FeatureInput> input(genValueOffsetInput<int32_t>({1, 2, 3}, {0, 0, 2}));
+    unique_ptr<Features> expected(id->genFeatures({input.get()}, &_context));
+    unique_ptr<Features> actual(hashed.genFeatures({input.get()}, &_context));
+    expectSameFeatures(expected.get(), actual.get());
+
+    auto single = new SingleSparseFeatures(2);
+    single->addFeatureKey("a", 1);
+    single->addFeatureKey("bc", 2);
+    _features.reset(HashedFeatureFunction::hashFeatures(single));
+    auto typed = ASSERT_CAST_AND_RETURN(MultiHashedSparseFeatures, _features.get());
+    EXPECT_THAT(typed->_offsets, ElementsAre(0, 1));
+    EXPECT_THAT(typed->_featureHashes, ElementsAre(FeatureHasher::hash("a", 1),
+                    FeatureHasher::hash("bc", 2)));
+
+    auto dense = new SingleDenseFeatures("f", 1);
+    _features.reset(HashedFeatureFunction::hashFeatures(dense));
+    EXPECT_EQ(dense, _features.get());
+    EXPECT_EQ(nullptr, HashedFeatureFunction::hashFeatures(nullptr));
+}
+
+TEST_F(HashedFeatureFunctionTest, testCapabilities) {
+    HashedFeatureFunction id(new IdFeatureFunction("id", "id_", numeric_limits<int>::max(), {}));
+    EXPECT_TRUE(id.supportDictionaryInput());
+    EXPECT_FALSE(id.supportCompactOutput());
+    auto raw = new RawFeatureFunction("raw", Normalizer(), {1.0f, 2.0f}, 1);
+    raw->setCompactOutput(true);
+    HashedFeatureFunction hashedRaw(raw);
+    EXPECT_TRUE(hashedRaw.supportCompactOutput());
+    EXPECT_TRUE(hashedRaw.isCompactOutput());
+    HashedFeatureFunction kgb(new KgbMatchSemanticFeatureFunction("kgb", "kgb_", false));
+    EXPECT_FALSE(kgb.supportDictionaryInput());
+}
+
+TEST_F(HashedFeatureFunctionTest, testAppend) {
+    auto first = new MultiHashedSparseFeatures(1);
+    first->beginDocument();
+    first->addFeatureHash(1);
+    auto second = new MultiHashedSparseFeatures(2);
+    second->beginDocument();
+    second->beginDocument();
+    second->addFeatureHash(2);
+    ASSERT_TRUE(first->append(second));
+    EXPECT_THAT(first->_offsets, ElementsAre(0, 1, 1));
+    EXPECT_THAT(first->_featureHashes, ElementsAre(1, 2));
+    unique_ptr<Features> other(new MultiSparseFeatures(1));
+    EXPECT_FALSE(first->append(other.get()));
+    delete first;
+}
+
+}
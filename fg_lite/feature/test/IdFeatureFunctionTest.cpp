@@ -148,4 +148,74 @@ TEST_F(IdFeatureFunctionTest, testInvalidValueConfig) {
     checkOffsets(vector<size_t>{0,1,1});
 }
 
+TEST_F(IdFeatureFunctionTest, testValidity) {
+    // null values are skipped, sentinels are kept as values
+    vector<uint8_t> values = {1, 255, 2, 3};
+    vector<uint64_t> bits = {0xb};
+    unique_ptr<FeatureInput> input(new FeatureInputTyped<uint8_t, DenseStorage<uint8_t>>(
+                    DenseStorage<uint8_t>(values.data(), 2, 2, ValidityBitmap(bits.data()))));
+    genIdFeature(input.get(), "prefix_", numeric_limits<int>::max(), {"3"});
+    auto typedFeatures = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, _features.get());
+    EXPECT_THAT(typedFeatures->_featureNames, ElementsAre(ConstString("prefix_1"),
+                    ConstString("prefix_255")));
+    checkOffsets(vector<size_t>{0, 2});
+}
+
+TEST_F(IdFeatureFunctionTest, testDictionaryInput) {
+    // rows {a, b}, {b, b}, {c, a}, "c" configured invalid
+    unique_ptr<FeatureInput> input(genDictionaryInput<MultiChar>(
+                    genMultiCharValues({"a", "b", "c"}), {0, 1, 1, 1, 2, 0}, 3, 2));
+    genIdFeature(input.get(), "prefix_", numeric_limits<int>::max(), {"c"});
+    auto typedFeatures = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, _features.get());
+    EXPECT_THAT(typedFeatures->_featureNames, ElementsAre(ConstString("prefix_a"),
+                    ConstString("prefix_b"), ConstString("prefix_b"), ConstString("prefix_b"),
+                    ConstString("prefix_a")));
+    checkOffsets(vector<size_t>{0, 2, 4});
+
+    // same keys and hashes as the dense input
+    unique_ptr<FeatureInput> values(genDictionaryInput<int64_t>({7, numeric_limits<int64_t>::max()},
+                    {0, 1, 0}, 3));
+    unique_ptr<FeatureInput> dense(genDenseInput<int64_t>({7, numeric_limits<int64_t>::max(), 7}));
+    IdFeatureFunction function("", "prefix_", 1, {});
+    unique_ptr<Features> expected(function.genFeatures({dense.get()}, &_context));
+    unique_ptr<Features> actual(function.genFeatures({values.get()}, &_context));
+    auto expectedSparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, expected.get());
+    auto actualSparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, actual.get());
+    EXPECT_EQ(expectedSparse->_offsets, actualSparse->_offsets);
+    EXPECT_EQ(expectedSparse->_featureNames, actualSparse->_featureNames);
+    function.setHashOutput(true);
+    expected.reset(function.genFeatures({dense.get()}, &_context));
+    actual.reset(function.genFeatures({values.get()}, &_context));
+    auto expectedHashed = ASSERT_CAST_AND_RETURN(MultiHashedSparseFeatures, expected.get());
+    auto actualHashed = ASSERT_CAST_AND_RETURN(MultiHashedSparseFeatures, actual.get());
+    EXPECT_EQ(expectedHashed->_offsets, actualHashed->_offsets);
+    EXPECT_EQ(2u, actualHashed->_featureHashes.size());
+    EXPECT_EQ(expectedHashed->_featureHashes, actualHashed->_featureHashes);
+}
+
+TEST_F(IdFeatureFunctionTest, testFeaturePool) {
+    // outputs of a request share the arena of the context
+    mem_pool::Pool featurePool;
+    _context.featurePool = &featurePool;
+    unique_ptr<FeatureInput> input(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 22}, {333}})));
+    IdFeatureFunction function("", "prefix_", numeric_limits<int>::max(), {});
+    unique_ptr<Features> first(function.genFeatures({input.get()}, &_context));
+    unique_ptr<Features> second(function.genFeatures({input.get()}, &_context));
+    auto firstSparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, first.get());
+    auto secondSparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, second.get());
+    EXPECT_EQ(&featurePool, firstSparse->getPool());
+    EXPECT_EQ(&featurePool, secondSparse->getPool());
+    EXPECT_THAT(firstSparse->_featureNames, ElementsAre(ConstString("prefix_1"),
+                    ConstString("prefix_22"), ConstString("prefix_333")));
+    EXPECT_EQ(firstSparse->_featureNames, secondSparse->_featureNames);
+    EXPECT_TRUE(featurePool.isInPool(firstSparse->_featureNames[2].data()));
+    EXPECT_TRUE(featurePool.isInPool(secondSparse->_offsets.data()));
+    first.reset();
+    second.reset();
+    _context.featurePool = nullptr;
+    unique_ptr<Features> own(function.genFeatures({input.get()}, &_context));
+    auto ownSparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, own.get());
+    EXPECT_NE(&featurePool, ownSparse->getPool());
+}
 }
@@ -0,0 +1,139 @@
+#include "fg_lite/feature/ItemFeatureCache.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class ItemFeatureCacheTest : public FeatureFunctionTestBase {
+protected:
+    // split features of docCount docs into rows and splice them back
+    Features *roundTrip(Features *features, size_t docCount) {
+        unique_ptr<Features> result(ItemFeatureCache::createFeatures(
+                        features->getFeatureValueType(), "f", docCount));
+        EXPECT_TRUE(result);
+        for (size_t i = 0; i < docCount; i++) {
+            CachedFeatureRow row;
+            EXPECT_TRUE(ItemFeatureCache::extractRow(features, i, docCount, row));
+            ItemFeatureCache::appendRow(row, result.get());
+        }
+        return result.release();
+    }
+};
+
+TEST_F(ItemFeatureCacheTest, testRoundTrip) {
+    MultiSparseFeatures sparse(2);
+    sparse.beginDocument();
+    sparse.addFeatureKey("a", 1);
+    sparse.addFeatureKey("bc", 2);
+    sparse.beginDocument();
+    _features.reset(roundTrip(&sparse, 2));
+    auto typedSparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, _features.get());
+    EXPECT_THAT(typedSparse->_offsets, ElementsAre(0, 2));
+    EXPECT_EQ(sparse._featureNames, typedSparse->_featureNames);
+
+    MultiHashedSparseFeatures hashed(2);
+    hashed.beginDocument();
+    hashed.beginDocument();
+    hashed.addFeatureHash(7);
+    _features.reset(roundTrip(&hashed, 2));
+    auto typedHashed = ASSERT_CAST_AND_RETURN(MultiHashedSparseFeatures, _features.get());
+    EXPECT_THAT(typedHashed->_offsets, ElementsAre(0, 0));
+    EXPECT_THAT(typedHashed->_featureHashes, ElementsAre(7));
+
+    MultiDenseFeatures dense("f", 2);
+    dense.beginDocument();
+    dense.addFeatureValue(1.0);
+    dense.beginDocument();
+    dense.addFeatureValue(2.0);
+    dense.addFeatureValue(3.0);
+    _features.reset(roundTrip(&dense, 2));
+    auto typedDense = ASSERT_CAST_AND_RETURN(MultiDenseFeatures, _features.get());
+    EXPECT_THAT(typedDense->_offsets, ElementsAre(0, 1));
+    EXPECT_THAT(typedDense->_featureValues, ElementsAre(1.0, 2.0, 3.0));
+
+    MultiIntegerFeatures integer("f", 1);
+    integer.beginDocument();
+    integer.addFeatureValue(5);
+    _features.reset(roundTrip(&integer, 1));
+    auto typedInteger = ASSERT_CAST_AND_RETURN(MultiIntegerFeatures, _features.get());
+    EXPECT_THAT(typedInteger->_offsets, ElementsAre(0));
+    EXPECT_THAT(typedInteger->_featureValues, ElementsAre(5));
+
+    MultiInt32Features compact("f", 2);
+    compact.beginDocument();
+    compact.addFeatureValue(-7);
+    compact.beginDocument();
+    _features.reset(roundTrip(&compact, 2));
+    auto typedCompact = ASSERT_CAST_AND_RETURN(MultiInt32Features, _features.get());
+    EXPECT_THAT(typedCompact->_offsets, ElementsAre(0, 1));
+    EXPECT_THAT(typedCompact->_featureValues, ElementsAre(-7));
+
+    MultiInt16Features shorts("f", 1);
+    shorts.beginDocument();
+    shorts.addFeatureValue(300);
+    _features.reset(roundTrip(&shorts, 1));
+    auto typedShorts = ASSERT_CAST_AND_RETURN(MultiInt16Features, _features.get());
+    EXPECT_THAT(typedShorts->_offsets, ElementsAre(0));
+    EXPECT_THAT(typedShorts->_featureValues, ElementsAre(300));
+
+    // two values per doc
+    SingleDenseFeatures single("f", 4);
+    for (float value : {1.0, 2.0, 3.0, 4.0}) {
+        single.addFeatureValue(value);
+    }
+    _features.reset(roundTrip(&single, 2));
+    auto typedSingle = ASSERT_CAST_AND_RETURN(SingleDenseFeatures, _features.get());
+    EXPECT_EQ("f", typedSingle->_featureName);
+    EXPECT_THAT(typedSingle->_featureValues, ElementsAre(1.0, 2.0, 3.0, 4.0));
+
+    CachedFeatureRow row;
+    EXPECT_FALSE(ItemFeatureCache::extractRow(&single, 0, 3, row));
+    EXPECT_FALSE(ItemFeatureCache::extractRow(&sparse, 0, 3, row));
+    SingleSparseFeatures singleSparse(1);
+    EXPECT_FALSE(ItemFeatureCache::extractRow(&singleSparse, 0, 1, row));
+    EXPECT_EQ(nullptr, ItemFeatureCache::createFeatures(FVT_SINGLE_SPARSE, "f", 1));
+}
+
+TEST_F(ItemFeatureCacheTest, testGetAndPut) {
+    ItemFeatureCache cache(1 << 20, 0, 4);
+    uint64_t brandKey = ItemFeatureCache::makeFeatureKey("brand", 0);
+    uint64_t priceKey = ItemFeatureCache::makeFeatureKey("price", 0);
+    EXPECT_NE(brandKey, ItemFeatureCache::makeFeatureKey("brand", 1));
+    auto makeRow = [brandKey](uint64_t itemId) {
+        auto row = make_shared<CachedFeatureRow>();
+        row->featureKey = brandKey;
+        row->itemId = itemId;
+        row->type = FVT_MULTI_HASHED_SPARSE;
+        row->hashes = {1, itemId};
+        return row;
+    };
+    size_t rowMemoryUse = makeRow(0)->getMemoryUse();
+    for (uint64_t itemId = 0; itemId < 100; itemId++) {
+        cache.put(makeRow(itemId));
+    }
+    EXPECT_EQ(100u, cache.size());
+    EXPECT_EQ(100 * rowMemoryUse, cache.getMemoryUse());
+    auto cached = cache.get(brandKey, 42);
+    ASSERT_TRUE(cached);
+    EXPECT_EQ(42u, cached->itemId);
+    EXPECT_THAT(cached->hashes, ElementsAre(1, 42));
+    EXPECT_FALSE(cache.get(priceKey, 42));
+    EXPECT_FALSE(cache.get(brandKey, 100));
+    EXPECT_EQ(1u, cache.getHitCount());
+    EXPECT_EQ(2u, cache.getMissCount());
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+
+    // every shard holds a quarter of the limit
+    ItemFeatureCache small(4 * rowMemoryUse, 0, 4);
+    for (uint64_t itemId = 0; itemId < 100; itemId++) {
+        small.put(makeRow(itemId));
+    }
+    EXPECT_GE(4u, small.size());
+    EXPECT_GE(4 * rowMemoryUse, small.getMemoryUse());
+}
+
+}
@@ -155,4 +155,29 @@ TEST_F(KgbMatchSemanticFeatureFunctionTest, qTermItemTermUnMatchNeedComboLeft) {
     );
 }
 
+TEST_F(KgbMatchSemanticFeatureFunctionTest, testWithRequestArena) {
+    autil::mem_pool::Pool pool(64 * 1024);
+    _context.pool = &pool;
+    unique_ptr<FeatureInput> qTerms(genDenseInput<int64_t>({((1LU << 56) | 2), 2, 3, 1}, 1, 4));
+    unique_ptr<FeatureInput> iTerms(genDenseInput<int64_t>(
+                    {((1LU << 32) | 2), ((2LU << 32) | 4), 2, 1, ((1LU << 32) | 2), 10}, 3, 2));
+    unique_ptr<FeatureInput> others(genDenseInput<int64_t>({1, 14, 4}, 3, 1));
+    KgbMatchSemanticFeatureFunction function("name", "fg_", true, false, true, false, true);
+    _features.reset(function.genFeatures({qTerms.get(), iTerms.get(), others.get()}, &_context));
+    auto typedFeatures = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, _features.get());
+    EXPECT_THAT(typedFeatures->_offsets, ElementsAre(0, 1, 1));
+    string term = "fg_" + std::to_string(((1LU << 56) | 2));
+    ASSERT_EQ(2u, typedFeatures->_featureNames.size());
+    EXPECT_EQ(ConstString(term + "_1"), typedFeatures->_featureNames[0]);
+    EXPECT_EQ(ConstString(term + "_4"), typedFeatures->_featureNames[1]);
+    EXPECT_LT(0u, pool.getUsedBytes());
+    size_t totalBytes = pool.getTotalBytes();
+    pool.reset();
+    _features.reset(function.genFeatures({qTerms.get(), iTerms.get(), others.get()}, &_context));
+    typedFeatures = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, _features.get());
+    EXPECT_EQ(2u, typedFeatures->_featureNames.size());
+    EXPECT_EQ(totalBytes, pool.getTotalBytes());
+    _context.pool = nullptr;
+}
+
 }
@@ -187,6 +187,23 @@ TEST_F(LookupFeatureFunctionTest, testDiscreteWithWeighting) {
         vector<size_t>{0,1,1});
 }
 
+TEST_F(LookupFeatureFunctionTest, testDiscreteWithCompactWeighting) {
+    auto multiValues = genMultiStringValues({{"k1:123"}, {"k2:234"}, {"k3:1e300"}});
+    unique_ptr<FeatureInput> input1(genMultiValueInput<MultiChar>(multiValues));
+    unique_ptr<FeatureInput> input2(genDenseInput<string>({"k1", "k3"}, 1, 2));
+    LookupFeatureFunction function("name", "fg_", true, true, Normalizer(), "mean", 1,
+                                   true, false, {}, "", false);
+    ASSERT_TRUE(function.supportCompactOutput());
+    function.setCompactOutput(true);
+    _features.reset(function.genFeatures({input1.get(), input2.get()}, &_context));
+    auto typed = ASSERT_CAST_AND_RETURN(MultiSparseFloatWeightingFeatures, _features.get());
+    EXPECT_EQ((int)FVT_WEIGHTING_SPARSE_FLOAT, (int)typed->getFeatureValueType());
+    EXPECT_THAT(typed->_featureNames, ElementsAre(ConstString("fg_k1"), ConstString("fg_k3")));
+    // the weight past float is clamped, not dropped
+    EXPECT_THAT(typed->_featureValues, ElementsAre(123.0f, numeric_limits<float>::max()));
+    EXPECT_THAT(typed->_offsets, ElementsAre(0, 1, 1));
+}
+
 TEST_F(LookupFeatureFunctionTest, testDiscreteIsOptimized) {
     vector<vector<string>> values1{{"123"}, {"234"}, {"3"}};
     vector<MultiString> multiValues = genMultiStringValues(values1);
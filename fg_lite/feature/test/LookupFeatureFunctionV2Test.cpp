@@ -334,4 +334,24 @@ TEST_F(LookupFeatureFunctionV2Test, testBucketize) {
                       {0, 0.2, 0.3, 0.5, 0.6, 0.7}, true, false);
 }
 
+TEST_F(LookupFeatureFunctionV2Test, testDictionaryInput) {
+    // docs share 2 distinct maps, each is matched once
+    vector<MultiChar> maps = {createOneDoc({{ConstString("a"), {0.2, 1.0}}, {ConstString("b"), {0.3, 2.0}}}, 2),
+                              createOneDoc({{ConstString("a"), {0.6, 3.0}}}, 2)};
+    unique_ptr<FeatureInput> item(genDictionaryInput<MultiChar>(maps, {1, 0, 1}, 3));
+    unique_ptr<FeatureInput> user(genDenseInput<string>({"b", "a"}, 1, 2));
+    genLookupFeaturesV2({item.get(), user.get()}, "", Normalizer(), "sum", 2, {}, true);
+    auto multiFeatures = ASSERT_CAST_AND_RETURN(MultiDenseFeatures, _features.get());
+    EXPECT_THAT(multiFeatures->_offsets, ElementsAre(0, 2, 4));
+    EXPECT_THAT(multiFeatures->_featureValues, ElementsAre(FloatEq(0.6), FloatEq(3.0),
+                    FloatEq(0.5), FloatEq(3.0), FloatEq(0.6), FloatEq(3.0)));
+
+    maps = {createOneDoc({{ConstString("a"), {0.2}}, {ConstString("b"), {0.3}}}),
+            createOneDoc({{ConstString("c"), {0.6}}})};
+    item.reset(genDictionaryInput<MultiChar>(maps, {1, 0, 0}, 3));
+    genLookupFeaturesV2({item.get(), user.get()}, "", Normalizer(), "sum", 1, {}, true);
+    checkSingleDenseFeatures<float>({0.0, 0.5, 0.5});
+    genLookupFeaturesV2({item.get(), user.get()}, "", Normalizer(), "sum", 1, {0.4}, true);
+    checkSingleIntegerFeatures<int64_t>({0, 1, 1});
+}
 }
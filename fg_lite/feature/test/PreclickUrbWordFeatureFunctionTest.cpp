@@ -187,5 +187,18 @@ TEST_F(PreclickUrbWordFeatureFunctionTest, testMatchWordLimitCount) {
     , true);
 }
 
+TEST_F(PreclickUrbWordFeatureFunctionTest, testWithRequestArena) {
+    autil::mem_pool::Pool pool(64 * 1024);
+    _context.pool = &pool;
+    testTopFeature({{"adword1;adword2;adword3;adword4", "adword1;adword2;adword3;adword4"}, {"adword1;adword2;adword3;adword4"}}, {0, 4}, {"_adword1", "_adword2", "_adword3", "_adword4", "_adword1", "_adword2", "_adword3", "_adword4"}, ";", "", false);
+    EXPECT_LT(0u, pool.getUsedBytes());
+    pool.reset();
+    EXPECT_EQ(0u, pool.getUsedBytes());
+    testMatchFeature({{"MTsyOzM7NDs1OzY7Nzs4Ozk7MTA7MTE7MTI7MTM7MTQ7MTU7MTY7MTc7MTg7MTk7MjA=="}}, {{"MTsyOzM7NDs1"}, {"NTs2", "Njs3"}}, {0, 5}, {"_1", "_2", "_3", "_4", "_5", "_5", "_6", "_7"}, false);
+    EXPECT_LT(0u, pool.getUsedBytes());
+    pool.reset();
+    testMatchFeature({{"YToxO2I6MjtjOjM7ZDo0O2U6NQ=="}}, {{"MToxOzI6Mg=="}}, {0}, {"_1", "_2"}, false, ";", ":");
+    _context.pool = nullptr;
 }
 
+}
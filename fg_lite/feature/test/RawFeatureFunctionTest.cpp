@@ -109,6 +109,60 @@ TEST_F(RawFeatureFunctionTest, testIntegerOutput) {
             vector<float>{2.0f, 5.0f, 8.0f});
 }
 
+TEST_F(RawFeatureFunctionTest, testCompactOutput) {
+    RawFeatureFunction dense("feature", Normalizer(), {}, 1);
+    EXPECT_FALSE(dense.supportCompactOutput());
+    RawFeatureFunction function("feature", Normalizer(), {2.0f, 5.0f, 8.0f}, 1);
+    ASSERT_TRUE(function.supportCompactOutput());
+    function.setCompactOutput(true);
+    unique_ptr<FeatureInput> single(genDenseInput<int32_t>({1, 5, 9}));
+    _features.reset(function.genFeatures({single.get()}, &_context));
+    auto singleFeatures = ASSERT_CAST_AND_RETURN(SingleInt16Features, _features.get());
+    EXPECT_EQ(FVT_SINGLE_SPARSE_INT16, singleFeatures->getFeatureValueType());
+    EXPECT_THAT(singleFeatures->_featureValues, ElementsAre(0, 2, 3));
+
+    unique_ptr<FeatureInput> multi(genMultiValueInput<int32_t>(
+                    genMultiValues<int32_t>({{1, 6}, {}})));
+    _features.reset(function.genFeatures({multi.get()}, &_context));
+    auto multiFeatures = ASSERT_CAST_AND_RETURN(MultiInt16Features, _features.get());
+    EXPECT_EQ(FVT_MULTI_SPARSE_INT16, multiFeatures->getFeatureValueType());
+    EXPECT_THAT(multiFeatures->_featureValues, ElementsAre(0, 2, 0));
+    EXPECT_THAT(multiFeatures->_offsets, ElementsAre(0, 2));
+    // the wide type is not appended to the compact one
+    MultiIntegerFeatures *wide = new MultiIntegerFeatures("feature", 1);
+    EXPECT_FALSE(multiFeatures->append(wide));
+    delete wide;
+
+    // bucket ids past int16 take int32
+    vector<float> boundaries(numeric_limits<int16_t>::max() + 1);
+    for (size_t i = 0; i < boundaries.size(); i++) {
+        boundaries[i] = i;
+    }
+    RawFeatureFunction wideFunction("feature", Normalizer(), boundaries, 1);
+    wideFunction.setCompactOutput(true);
+    unique_ptr<FeatureInput> large(genDenseInput<int32_t>({40000}));
+    _features.reset(wideFunction.genFeatures({large.get()}, &_context));
+    auto int32Features = ASSERT_CAST_AND_RETURN(SingleInt32Features, _features.get());
+    EXPECT_EQ(FVT_SINGLE_SPARSE_INT32, int32Features->getFeatureValueType());
+    EXPECT_THAT(int32Features->_featureValues, ElementsAre(32768));
+
+    // values out of int32 are refused
+    SingleInt32Features narrow("feature", 2);
+    EXPECT_TRUE(narrow.addFeatureValue(numeric_limits<int32_t>::min()));
+    EXPECT_FALSE(narrow.addFeatureValue(int64_t(numeric_limits<int32_t>::max()) + 1));
+    EXPECT_THAT(narrow._featureValues, ElementsAre(numeric_limits<int32_t>::min()));
+    SingleInt16Features shorts("feature", 1);
+    EXPECT_FALSE(shorts.addFeatureValue(int64_t(numeric_limits<int16_t>::max()) + 1));
+    EXPECT_FALSE(shorts.overflow());
+    EXPECT_EQ(0u, shorts._featureValues.size());
+    MultiSparseFloatWeightingFeatures weighting(1);
+    weighting.addFeatureValue(1.5);
+    weighting.addFeatureValue(numeric_limits<double>::infinity());
+    weighting.addFeatureValue(-1e300);
+    EXPECT_THAT(weighting._featureValues, ElementsAre(1.5f, numeric_limits<float>::infinity(),
+                    numeric_limits<float>::lowest()));
+}
+
 TEST_F(RawFeatureFunctionTest, testZeroBucketize) {
     unique_ptr<FeatureInput> input(genDenseInput(vector<string>{}, 1, 0));
     genRawFeature(input.get(), "feature", Normalizer(), {-1, 0, 1});
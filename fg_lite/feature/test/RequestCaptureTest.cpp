@@ -0,0 +1,263 @@
+#include <unistd.h>
+#include <cstring>
+#include "fg_lite/feature/RequestCapture.h"
+#include "fg_lite/feature/FeaturePlan.h"
+#include "fg_lite/feature/IdFeatureFunction.h"
+#include "fg_lite/feature/RawFeatureFunction.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class RequestCaptureTest : public FeatureFunctionTestBase {
+protected:
+    void SetUp() override {
+        _path = TempDir() + "/fg_lite_request_capture_test.cap";
+    }
+    void TearDown() override {
+        remove(_path.c_str());
+    }
+    // every value of input formatted, rows separated by '|'
+    string dump(FeatureInput *input) {
+        string result;
+        for (size_t r = 0; r < input->row(); r++) {
+            result += r == 0 ? "" : "|";
+            for (size_t c = 0; c < input->col(r); c++) {
+                FeatureFormatter::FeatureBuffer buffer{cp_alloc(_pool.get())};
+                input->toString(r, c, buffer);
+                result += (c == 0 ? "" : ",") + string(buffer.begin(), buffer.end());
+            }
+        }
+        return result;
+    }
+protected:
+    string _path;
+};
+
+TEST_F(RequestCaptureTest, testRoundTrip) {
+    vector<unique_ptr<FeatureInput>> holders;
+    holders.emplace_back(genDenseInput<int32_t>({1, 2, 3, 4, 5, 6}, 3, 2));
+    holders.emplace_back(genMultiValueInput<int64_t>(genMultiValues<int64_t>({{1, 2}, {}, {3}})));
+    holders.emplace_back(genValueOffsetInput<float>({1.5, 2.5, 3.5}, {0, 0, 2}));
+    holders.emplace_back(genDenseInput<MultiChar>(genMultiCharValues({"ab", "", "c"}), 3, 1));
+    holders.emplace_back(genMultiValueInput<MultiChar>(genMultiStringValues({{"x", "yz"}, {}, {"w"}})));
+    holders.emplace_back(genDenseInput<string>({"user"}));
+    vector<string> names = {"item:a", "item:b", "item:c", "item:d", "item:e", "user:f"};
+    vector<FeatureInput*> inputs;
+    for (const auto &holder : holders) {
+        inputs.push_back(holder.get());
+    }
+    {
+        RequestCaptureWriter writer;
+        ASSERT_TRUE(writer.open(_path, "{\"features\":[]}"));
+        ASSERT_TRUE(writer.write(names, inputs));
+        ASSERT_TRUE(writer.write({"item:a"}, {inputs[0]}));
+        EXPECT_FALSE(writer.write({"item:a"}, inputs));
+        EXPECT_EQ(2u, writer.getWrittenCount());
+        ASSERT_TRUE(writer.close());
+    }
+    RequestCaptureReader reader;
+    ASSERT_TRUE(reader.open(_path));
+    EXPECT_EQ("{\"features\":[]}", reader.getConfig());
+    CapturedRequest request;
+    ASSERT_TRUE(reader.next(request));
+    ASSERT_EQ(names, request.getInputNames());
+    ASSERT_EQ(6u, request.getInputs().size());
+    EXPECT_EQ(3u, request.getDocCount());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        FeatureInput *input = request.getInputs()[i];
+        EXPECT_EQ(inputs[i]->dataType(), input->dataType()) << i;
+        EXPECT_EQ(inputs[i]->storageType(), input->storageType()) << i;
+        EXPECT_EQ(dump(inputs[i]), dump(input)) << i;
+    }
+    EXPECT_EQ("1,2|3,4|5,6", dump(request.getInputs()[0]));
+    EXPECT_EQ("x,yz||w", dump(request.getInputs()[4]));
+    EXPECT_EQ(request.getInputs()[5], request.getNamedInputs()["user:f"]);
+    ASSERT_TRUE(reader.next(request));
+    EXPECT_EQ(1u, request.getInputs().size());
+    EXPECT_FALSE(reader.next(request));
+    EXPECT_TRUE(reader.eof());
+}
+
+TEST_F(RequestCaptureTest, testDictionary) {
+    vector<unique_ptr<FeatureInput>> holders;
+    holders.emplace_back(genDictionaryInput<int64_t>({10, 20, 30}, {2, 0, 1, 1, 0, 2}, 3, 2));
+    holders.emplace_back(genDictionaryInput<MultiChar>(genMultiCharValues({"ab", "c"}), {1, 1, 0}, 3));
+    holders.emplace_back(genDictionaryInput<string>({"x", "yz"}, {1, 0}, 2));
+    vector<FeatureInput*> inputs;
+    for (const auto &holder : holders) {
+        inputs.push_back(holder.get());
+    }
+    unique_ptr<FeatureInput> slice(inputs[0]->slice(1, 3));
+    inputs.push_back(slice.get());
+    string record;
+    ASSERT_TRUE(RequestCaptureWriter::encode({"a", "b", "c", "d"}, inputs, record));
+    CapturedRequest request;
+    ASSERT_TRUE(request.decode(record.data(), record.size()));
+    ASSERT_EQ(4u, request.getInputs().size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        FeatureInput *input = request.getInputs()[i];
+        EXPECT_EQ(inputs[i]->dataType(), input->dataType()) << i;
+        EXPECT_EQ(IST_DICTIONARY, input->storageType()) << i;
+        EXPECT_EQ(dump(inputs[i]), dump(input)) << i;
+    }
+    EXPECT_EQ("30,10|20,20|10,30", dump(request.getInputs()[0]));
+    EXPECT_EQ("20,20|10,30", dump(request.getInputs()[3]));
+    auto typed = request.getInputs()[1]->typed<MultiChar, DictionaryStorage<MultiChar>>();
+    ASSERT_TRUE(typed);
+    EXPECT_EQ(2u, typed->getStorage().dictionarySize());
+
+    // the last code of the slice, before its validity byte and 3 values, out of the dictionary
+    record[record.size() - 3 * sizeof(int64_t) - 1 - sizeof(uint32_t)] = 5;
+    EXPECT_FALSE(request.decode(record.data(), record.size()));
+}
+
+TEST_F(RequestCaptureTest, testValidity) {
+    typedef FeatureInputTyped<int32_t, DenseStorage<int32_t>> DenseInput;
+    typedef FeatureInputTyped<float, ValueOffsetStorage<float>> ValueOffsetInput;
+    typedef FeatureInputTyped<int64_t, DenseStorage<int64_t>> PlainInput;
+    vector<int32_t> denseValues = {1, 2, 3, 4, 5, 6};
+    vector<uint64_t> denseBits = {0x2d};
+    DenseInput dense(DenseStorage<int32_t>(
+                    denseValues.data(), 3, 2, ValidityBitmap(denseBits.data())));
+    // values span two words and the slice starts inside the first one
+    vector<float> values(70);
+    vector<size_t> offsets = {0, 3, 40, 70};
+    vector<uint64_t> bits = {0xf0f0f0f0f0f0f0f0ULL, 0x15};
+    ValueOffsetInput valueOffset(ValueOffsetStorage<float>(
+                    values.data(), values.size(), offsets.data(), offsets.size(),
+                    ValidityBitmap(bits.data())));
+    unique_ptr<FeatureInput> slice(valueOffset.slice(1, 4));
+    unique_ptr<FeatureInput> plain(genDenseInput<int64_t>({1, 2}));
+    vector<FeatureInput*> inputs = {&dense, slice.get(), plain.get()};
+    string record;
+    ASSERT_TRUE(RequestCaptureWriter::encode({"a", "b", "c"}, inputs, record));
+    CapturedRequest request;
+    ASSERT_TRUE(request.decode(record.data(), record.size()));
+    ASSERT_EQ(3u, request.getInputs().size());
+    auto decodedDense = ASSERT_CAST_AND_RETURN(DenseInput, request.getInputs()[0]);
+    ASSERT_TRUE(decodedDense->hasValidity());
+    for (size_t r = 0; r < 3; r++) {
+        for (size_t c = 0; c < 2; c++) {
+            EXPECT_EQ(dense.isValid(r, c), decodedDense->isValid(r, c)) << r << "," << c;
+        }
+    }
+    auto typedSlice = slice->typed<float, ValueOffsetStorage<float>>();
+    auto decodedSlice = ASSERT_CAST_AND_RETURN(ValueOffsetInput, request.getInputs()[1]);
+    ASSERT_TRUE(decodedSlice->hasValidity());
+    ASSERT_EQ(3u, decodedSlice->row());
+    for (size_t r = 0; r < 3; r++) {
+        ASSERT_EQ(typedSlice->col(r), decodedSlice->col(r));
+        for (size_t c = 0; c < typedSlice->col(r); c++) {
+            EXPECT_EQ(typedSlice->isValid(r, c), decodedSlice->isValid(r, c)) << r << "," << c;
+        }
+    }
+    auto decodedPlain = ASSERT_CAST_AND_RETURN(PlainInput, request.getInputs()[2]);
+    EXPECT_FALSE(decodedPlain->hasValidity());
+}
+
+TEST_F(RequestCaptureTest, testBrokenFile) {
+    RequestCaptureReader reader;
+    EXPECT_FALSE(reader.open("/not_exist_dir/request.cap"));
+    {
+        RequestCaptureWriter writer;
+        ASSERT_TRUE(writer.open(_path, "{}"));
+        unique_ptr<FeatureInput> input(genDenseInput<int64_t>({1, 2}));
+        ASSERT_TRUE(writer.write({"item:a"}, {input.get()}));
+    }
+    // drop the last byte of the record
+    FILE *file = fopen(_path.c_str(), "r+b");
+    ASSERT_TRUE(file);
+    fseek(file, 0, SEEK_END);
+    ASSERT_EQ(0, ftruncate(fileno(file), ftell(file) - 1));
+    fclose(file);
+    ASSERT_TRUE(reader.open(_path));
+    CapturedRequest request;
+    EXPECT_FALSE(reader.next(request));
+    EXPECT_FALSE(reader.eof());
+}
+
+TEST_F(RequestCaptureTest, testCorruptCount) {
+    unique_ptr<FeatureInput> dense(genDenseInput<int64_t>({1, 2}, 1, 2));
+    unique_ptr<FeatureInput> sparse(genValueOffsetInput<float>({1.5, 2.5}, {0, 1}));
+    string record;
+    ASSERT_TRUE(RequestCaptureWriter::encode({"a"}, {dense.get()}, record));
+    CapturedRequest request;
+    ASSERT_TRUE(request.decode(record.data(), record.size()));
+    // input count, name "a", data type and storage type come before the row
+    const size_t rowOffset = 4 + 4 + 1 + 4 + 4;
+    uint64_t huge = uint64_t(1) << 60;
+    string broken = record;
+    memcpy(&broken[rowOffset + sizeof(uint64_t)], &huge, sizeof(huge));
+    EXPECT_FALSE(request.decode(broken.data(), broken.size()));
+    broken = record;
+    memcpy(&broken[rowOffset], &huge, sizeof(huge));
+    EXPECT_FALSE(request.decode(broken.data(), broken.size()));
+
+    ASSERT_TRUE(RequestCaptureWriter::encode({"a"}, {sparse.get()}, record));
+    ASSERT_TRUE(request.decode(record.data(), record.size()));
+    broken = record;
+    memcpy(&broken[rowOffset], &huge, sizeof(huge));
+    EXPECT_FALSE(request.decode(broken.data(), broken.size()));
+    // a huge col makes the value count exceed the record
+    uint32_t hugeCol = numeric_limits<uint32_t>::max();
+    broken = record;
+    memcpy(&broken[rowOffset + sizeof(uint64_t)], &hugeCol, sizeof(hugeCol));
+    EXPECT_FALSE(request.decode(broken.data(), broken.size()));
+}
+
+TEST_F(RequestCaptureTest, testFeaturePlan) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new RawFeatureFunction("price", Normalizer(), {}, 1),
+                    {"item:price"}));
+    unique_ptr<FeatureInput> brand(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 2}, {3}, {}})));
+    unique_ptr<FeatureInput> price(genDenseInput<float>({1.5, 2.5, 3.5}));
+    vector<FeatureInput*> inputs = {brand.get(), price.get()};
+
+    // every second request, at most 3
+    RequestCaptureWriter writer(2, 3);
+    ASSERT_TRUE(writer.open(_path, "{}"));
+    FeatureFunctionContext context(_pool.get());
+    context.capture = &writer;
+    vector<Features*> outputs;
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+        FeaturePlan::clearFeatures(outputs);
+    }
+    EXPECT_EQ(2u, writer.getWrittenCount());
+    // chunked requests are captured once
+    ASSERT_TRUE(plan.genFeaturesChunked(inputs, &context, 1,
+                    [](size_t, vector<Features*> &) { return true; }));
+    EXPECT_EQ(3u, writer.getWrittenCount());
+    for (size_t i = 0; i < 2; i++) {
+        ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+        FeaturePlan::clearFeatures(outputs);
+    }
+    EXPECT_EQ(3u, writer.getWrittenCount());
+    ASSERT_TRUE(writer.close());
+
+    RequestCaptureReader reader;
+    ASSERT_TRUE(reader.open(_path));
+    CapturedRequest request;
+    size_t requestCount = 0;
+    while (reader.next(request)) {
+        requestCount++;
+        vector<Features*> replayed;
+        ASSERT_TRUE(plan.genFeatures(request.getNamedInputs(), nullptr, replayed));
+        ASSERT_EQ(2u, replayed.size());
+        auto sparse = ASSERT_CAST_AND_RETURN(MultiSparseFeatures, replayed[0]);
+        EXPECT_EQ(3u, sparse->valueCount());
+        EXPECT_EQ(ConstString("brand_3"), sparse->_featureNames[2]);
+        EXPECT_EQ(3u, replayed[1]->count());
+        FeaturePlan::clearFeatures(replayed);
+    }
+    EXPECT_EQ(3u, requestCount);
+}
+
+}
@@ -0,0 +1,224 @@
+#include <set>
+#include <thread>
+#include "fg_lite/feature/RequestTracer.h"
+#include "fg_lite/feature/BroadcastFeatureCache.h"
+#include "fg_lite/feature/ComboFeatureFunction.h"
+#include "fg_lite/feature/FeaturePlan.h"
+#include "fg_lite/feature/IdFeatureFunction.h"
+#include "fg_lite/feature/ItemFeatureCache.h"
+#include "fg_lite/feature/RawFeatureFunction.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class RequestTracerTest : public FeatureFunctionTestBase {
+protected:
+    TraceEvent makeEvent(const char *name, int64_t beginNs, int64_t durationNs) {
+        TraceEvent event;
+        event.name = name;
+        event.category = "test";
+        event.beginNs = beginNs;
+        event.durationNs = durationNs;
+        return event;
+    }
+    const TraceEvent *findEvent(const vector<TraceEvent> &events, const string &name) {
+        for (const auto &event : events) {
+            if (name == event.name) {
+                return &event;
+            }
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(RequestTracerTest, testRing) {
+    RequestTracer tracer(3);
+    EXPECT_EQ(4u, tracer.getCapacity());
+    vector<TraceEvent> events;
+    tracer.getEvents(events);
+    EXPECT_TRUE(events.empty());
+    EXPECT_EQ(0, tracer.getDurationNs());
+
+    const char *names[] = {"a", "b", "c", "d", "e", "f"};
+    for (size_t i = 0; i < 6; i++) {
+        tracer.record(makeEvent(names[i], i * 10, 5));
+    }
+    tracer.getEvents(events);
+    ASSERT_EQ(4u, events.size());
+    EXPECT_STREQ("c", events[0].name);
+    EXPECT_STREQ("f", events[3].name);
+    EXPECT_EQ(2u, tracer.getDroppedCount());
+    EXPECT_EQ(35, tracer.getDurationNs());
+
+    tracer.reset();
+    tracer.getEvents(events);
+    EXPECT_TRUE(events.empty());
+    EXPECT_EQ(0u, tracer.getDroppedCount());
+}
+
+TEST_F(RequestTracerTest, testConcurrentRecord) {
+    RequestTracer tracer(1024);
+    vector<thread> threads;
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&tracer]() {
+                    for (size_t j = 0; j < 100; j++) {
+                        TraceSpan span(&tracer, "span", "test");
+                        span.setArg(0, "j", j);
+                    }
+                });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    vector<TraceEvent> events;
+    tracer.getEvents(events);
+    ASSERT_EQ(400u, events.size());
+    set<uint32_t> threadIds;
+    for (const auto &event : events) {
+        threadIds.insert(event.threadId);
+        EXPECT_STREQ("j", event.argNames[0]);
+        EXPECT_EQ(nullptr, event.argNames[1]);
+    }
+    EXPECT_EQ(4u, threadIds.size());
+}
+
+TEST_F(RequestTracerTest, testChromeTrace) {
+    RequestTracer tracer;
+    TraceEvent event = makeEvent("say \"hi\"\n", tracer.getBaseTimeNs() + 1500, 2000);
+    event.argNames[0] = "docs";
+    event.argValues[0] = 7;
+    tracer.record(event);
+    tracer.record(makeEvent("b", tracer.getBaseTimeNs(), 1));
+    string json;
+    tracer.toChromeTrace(json);
+    EXPECT_THAT(json, HasSubstr("{\"name\":\"say \\\"hi\\\"\\u000a\",\"cat\":\"test\",\"ph\":\"X\","
+                                "\"ts\":1.500,\"dur\":2.000,"));
+    EXPECT_THAT(json, HasSubstr("\"args\":{\"docs\":7}}"));
+    EXPECT_THAT(json, HasSubstr("{\"name\":\"b\",\"cat\":\"test\",\"ph\":\"X\",\"ts\":0.000,\"dur\":0.001,"));
+    EXPECT_THAT(json, HasSubstr("\"otherData\":{\"dropped\":0}}"));
+
+    string path = TempDir() + "/fg_lite_request_tracer_test.json";
+    EXPECT_FALSE(tracer.dumpIfSlow(1000, path));
+    EXPECT_TRUE(tracer.dumpIfSlow(3, path));
+    EXPECT_FALSE(tracer.dump("/not_exist_dir/trace.json"));
+    remove(path.c_str());
+}
+
+TEST_F(RequestTracerTest, testFeaturePlan) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("brand", "brand_",
+                            numeric_limits<int>::max(), {}), {"item:brand"}));
+    ASSERT_TRUE(plan.addFeature(new RawFeatureFunction("price", Normalizer(), {}, 1),
+                    {"user:price"}));
+    unique_ptr<FeatureInput> brand(genMultiValueInput<int64_t>(
+                    genMultiValues<int64_t>({{1, 2}, {3}, {}})));
+    unique_ptr<FeatureInput> price(genDenseInput<float>({1.5}));
+    vector<FeatureInput*> inputs = {brand.get(), price.get()};
+
+    RequestTracer tracer;
+    ItemFeatureCache cache(1 << 20, 0, 4);
+    vector<uint64_t> itemIds = {1, 2, 3};
+    FeatureFunctionContext context(_pool.get());
+    context.tracer = &tracer;
+    context.itemCache = &cache;
+    context.itemIds = &itemIds;
+    WorkStealingThreadPool threadPool(2);
+    ASSERT_TRUE(threadPool.start());
+    vector<Features*> outputs;
+    ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs, &threadPool));
+    FeaturePlan::clearFeatures(outputs);
+
+    vector<TraceEvent> events;
+    tracer.getEvents(events);
+    ASSERT_EQ(4u, events.size());
+    const TraceEvent *root = findEvent(events, "genFeatures");
+    ASSERT_TRUE(root);
+    EXPECT_STREQ("plan", root->category);
+    const TraceEvent *feature = findEvent(events, "brand");
+    ASSERT_TRUE(feature);
+    EXPECT_STREQ("feature", feature->category);
+    EXPECT_STREQ("docs", feature->argNames[0]);
+    EXPECT_EQ(3, feature->argValues[0]);
+    EXPECT_STREQ("values", feature->argNames[1]);
+    EXPECT_EQ(3, feature->argValues[1]);
+    EXPECT_LE(root->beginNs, feature->beginNs);
+    EXPECT_GE(root->beginNs + root->durationNs, feature->beginNs + feature->durationNs);
+    const TraceEvent *lookup = findEvent(events, "itemCache");
+    ASSERT_TRUE(lookup);
+    EXPECT_EQ(0, lookup->argValues[0]);
+    EXPECT_EQ(3, lookup->argValues[1]);
+    ASSERT_TRUE(findEvent(events, "price"));
+
+    // second request hits the cache, chunks are traced too
+    tracer.reset();
+    ASSERT_TRUE(plan.genFeaturesChunked(inputs, &context, 2,
+                    [](size_t, vector<Features*> &) { return true; }));
+    tracer.getEvents(events);
+    size_t chunkCount = 0;
+    size_t hitCount = 0;
+    for (const auto &event : events) {
+        if (string("chunk") == event.name) {
+            chunkCount++;
+        } else if (string("itemCache") == event.name) {
+            hitCount += event.argValues[0];
+        }
+    }
+    EXPECT_EQ(2u, chunkCount);
+    EXPECT_EQ(3u, hitCount);
+    threadPool.stop();
+
+    // nothing recorded without tracer in the context
+    tracer.reset();
+    context.tracer = nullptr;
+    ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+    FeaturePlan::clearFeatures(outputs);
+    tracer.getEvents(events);
+    EXPECT_TRUE(events.empty());
+}
+
+TEST_F(RequestTracerTest, testBroadcastCacheArgs) {
+    FeaturePlan plan;
+    ASSERT_TRUE(plan.addFeature(new ComboFeatureFunction("combo", "combo_", {}, {}, 2),
+                    {"user:age", "item:price"}));
+    unique_ptr<FeatureInput> age(genDenseInput<float>({21.0f}));
+    unique_ptr<FeatureInput> price(genDenseInput<double>({1.0, 2.0, 3.0}));
+    vector<FeatureInput*> inputs = {age.get(), price.get()};
+
+    RequestTracer tracer;
+    BroadcastFeatureCache cache(1 << 20, 0);
+    FeatureFunctionContext context(_pool.get());
+    context.tracer = &tracer;
+    context.broadcastCache = &cache;
+    vector<Features*> outputs;
+    vector<TraceEvent> events;
+    // the user side is formatted once, then looked up
+    for (int64_t hits = 0; hits < 2; hits++) {
+        tracer.reset();
+        ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+        FeaturePlan::clearFeatures(outputs);
+        tracer.getEvents(events);
+        const TraceEvent *feature = findEvent(events, "combo");
+        ASSERT_TRUE(feature);
+        EXPECT_STREQ("cacheHits", feature->argNames[2]);
+        EXPECT_EQ(hits, feature->argValues[2]);
+        EXPECT_STREQ("cacheMisses", feature->argNames[3]);
+        EXPECT_EQ(1 - hits, feature->argValues[3]);
+    }
+
+    // no cache args without broadcast cache in the context
+    tracer.reset();
+    context.broadcastCache = nullptr;
+    ASSERT_TRUE(plan.genFeatures(inputs, &context, outputs));
+    FeaturePlan::clearFeatures(outputs);
+    tracer.getEvents(events);
+    const TraceEvent *feature = findEvent(events, "combo");
+    ASSERT_TRUE(feature);
+    EXPECT_EQ(nullptr, feature->argNames[2]);
+}
+
+}
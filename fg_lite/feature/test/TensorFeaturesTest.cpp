@@ -0,0 +1,169 @@
+#include "fg_lite/feature/IdFeatureFunction.h"
+#include "fg_lite/feature/ComboFeatureFunction.h"
+#include "fg_lite/feature/FeaturePlan.h"
+#include "fg_lite/feature/HashedFeatureFunction.h"
+#include "fg_lite/feature/RawFeatureFunction.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+#include "fg_lite/feature/test/FeatureFunctionTestBase.h"
+
+using namespace std;
+using namespace autil;
+using namespace testing;
+
+namespace fg_lite {
+
+class TensorFeaturesTest : public FeatureFunctionTestBase {
+protected:
+    void setSparse(TensorBuffer &tensor, size_t rowCapacity, size_t idCapacity) {
+        _rowSplits.assign(rowCapacity + 1, -1);
+        _ids.assign(idCapacity, 0);
+        tensor.rowSplits = _rowSplits.data();
+        tensor.rowCapacity = rowCapacity;
+        tensor.ids = _ids.data();
+        tensor.idCapacity = idCapacity;
+    }
+    // rows of the tensor copied back into a pool backed hashed output
+    void checkSame(const Features *expected, const TensorBuffer &tensor) {
+        ASSERT_TRUE(expected);
+        EXPECT_EQ(0, tensor.rowSplits[0]);
+        MultiHashedSparseFeatures actual(expected->count());
+        for (size_t i = 0; i < expected->count(); i++) {
+            actual.beginDocument();
+            for (int64_t j = tensor.rowSplits[i]; j < tensor.rowSplits[i + 1]; j++) {
+                actual.addFeatureHash(tensor.ids[j]);
+            }
+        }
+        expectSameFeatures(expected, &actual);
+    }
+protected:
+    vector<int64_t> _rowSplits;
+    vector<uint64_t> _ids;
+};
+
+TEST_F(TensorFeaturesTest, testSparseOverflow) {
+    TensorBuffer tensor;
+    setSparse(tensor, 2, 2);
+    TensorSparseFeatures features(&tensor);
+    features.beginDocument();
+    features.addFeatureHash(1);
+    features.beginDocument();
+    features.addFeatureHash(2);
+    EXPECT_FALSE(features.overflow());
+    EXPECT_THAT(_rowSplits, ElementsAre(0, 1, 2));
+    EXPECT_THAT(_ids, ElementsAre(1, 2));
+    features.addFeatureHash(3);
+    features.beginDocument();
+    EXPECT_TRUE(features.overflow());
+    EXPECT_EQ(3u, features.rowCount());
+    EXPECT_EQ(3u, features.idCount());
+    EXPECT_THAT(_ids, ElementsAre(1, 2));
+    EXPECT_FALSE(features.append(nullptr));
+}
+
+TEST_F(TensorFeaturesTest, testSparseGrow) {
+    IdFeatureFunction function("id", "id_", numeric_limits<int>::max(), {});
+    function.setHashOutput(true);
+    vector<vector<int64_t>> values;
+    for (int64_t i = 0; i < 20; i++) {
+        values.push_back(vector<int64_t>(i % 3, i));
+    }
+    unique_ptr<FeatureInput> input(genMultiValueInput<int64_t>(genMultiValues<int64_t>(values)));
+    unique_ptr<Features> expected(function.genFeatures({input.get()}, &_context));
+
+    TensorBuffer tensor;
+    setSparse(tensor, 20, 1);
+    size_t growCount = 0;
+    tensor.growIds = [this, &growCount](TensorBuffer *buffer, size_t minCapacity) {
+        growCount++;
+        _ids.resize(max(minCapacity, _ids.size() * 2));
+        buffer->ids = _ids.data();
+        buffer->idCapacity = _ids.size();
+        return true;
+    };
+    _context.tensor = &tensor;
+    _features.reset(function.genFeatures({input.get()}, &_context));
+    auto typed = ASSERT_CAST_AND_RETURN(TensorSparseFeatures, _features.get());
+    EXPECT_EQ(FVT_TENSOR_SPARSE, typed->getFeatureValueType());
+    EXPECT_FALSE(typed->overflow());
+    EXPECT_EQ(20u, typed->count());
+    EXPECT_EQ(19u, typed->idCount());
+    EXPECT_EQ(5u, growCount);
+    checkSame(expected.get(), tensor);
+}
+
+TEST_F(TensorFeaturesTest, testSizingPass) {
+    unique_ptr<FeatureInput> user(genDenseInput<string>({"u1"}, 1, 1));
+    auto multiValues = genMultiValues<int32_t>({{1, 2}, {3}, {4, 5, 6}});
+    unique_ptr<FeatureInput> item(genMultiValueInput<int32_t>(multiValues));
+    ComboFeatureFunction function("combo", "combo_", {}, {}, 2);
+    function.setHashOutput(true);
+    unique_ptr<Features> expected(function.genFeatures({user.get(), item.get()}, &_context));
+
+    TensorBuffer tensor;
+    setSparse(tensor, 3, 0);
+    _context.tensor = &tensor;
+    _features.reset(function.genFeatures({user.get(), item.get()}, &_context));
+    auto typed = ASSERT_CAST_AND_RETURN(TensorSparseFeatures, _features.get());
+    ASSERT_TRUE(typed->overflow());
+    setSparse(tensor, typed->rowCount(), typed->idCount());
+    _features.reset(function.genFeatures({user.get(), item.get()}, &_context));
+    typed = ASSERT_CAST_AND_RETURN(TensorSparseFeatures, _features.get());
+    EXPECT_FALSE(typed->overflow());
+    checkSame(expected.get(), tensor);
+
+    HashedFeatureFunction wrapped(new ComboFeatureFunction("combo", "combo_", {}, {}, 2));
+    setSparse(tensor, 3, 6);
+    _features.reset(wrapped.genFeatures({user.get(), item.get()}, &_context));
+    ASSERT_CAST_AND_RETURN(TensorSparseFeatures, _features.get());
+    checkSame(expected.get(), tensor);
+}
+
+TEST_F(TensorFeaturesTest, testDense) {
+    auto multiValues = genMultiValues<float>({{1.0, 2.0, 3.0}, {}, {4.0}});
+    unique_ptr<FeatureInput> input(genMultiValueInput<float>(multiValues));
+    RawFeatureFunction function("price", Normalizer(), {}, 2);
+    vector<float> dense(6, -1.0f);
+    TensorBuffer tensor;
+    tensor.rowCapacity = 3;
+    tensor.dense = dense.data();
+    tensor.denseDim = 2;
+    _context.tensor = &tensor;
+    _features.reset(function.genFeatures({input.get()}, &_context));
+    auto typed = ASSERT_CAST_AND_RETURN(TensorDenseFeatures, _features.get());
+    EXPECT_EQ(FVT_TENSOR_DENSE, typed->getFeatureValueType());
+    EXPECT_FALSE(typed->overflow());
+    EXPECT_EQ(3u, typed->count());
+    EXPECT_THAT(dense, ElementsAre(1.0, 2.0, 0.0, 0.0, 4.0, 0.0));
+
+    tensor.rowCapacity = 2;
+    _features.reset(function.genFeatures({input.get()}, &_context));
+    typed = ASSERT_CAST_AND_RETURN(TensorDenseFeatures, _features.get());
+    EXPECT_TRUE(typed->overflow());
+}
+
+TEST_F(TensorFeaturesTest, testFeaturePlan) {
+    FeaturePlan plan;
+    IdFeatureFunction *id = new IdFeatureFunction("id", "id_", numeric_limits<int>::max(), {});
+    id->setHashOutput(true);
+    ASSERT_TRUE(plan.addFeature(id, {"item"}));
+    ASSERT_TRUE(plan.addFeature(new IdFeatureFunction("id2", "id2_", numeric_limits<int>::max(), {}), {"item"}));
+    plan.setShardDocCount(1);
+    unique_ptr<FeatureInput> item(genDenseInput<int32_t>({1, 2, 3}));
+    vector<FeatureInput*> slotInputs = {item.get()};
+    TensorBuffer tensor;
+    setSparse(tensor, 3, 3);
+    WorkStealingThreadPool threadPool(2);
+    ASSERT_TRUE(threadPool.start());
+    vector<Features*> outputs;
+    ASSERT_FALSE(plan.genFeatures(slotInputs, &_context, {&tensor}, outputs, &threadPool));
+    ASSERT_TRUE(plan.genFeatures(slotInputs, &_context, {&tensor, nullptr}, outputs, &threadPool));
+    ASSERT_EQ(2u, outputs.size());
+    EXPECT_EQ(FVT_TENSOR_SPARSE, outputs[0]->getFeatureValueType());
+    EXPECT_EQ(FVT_MULTI_SPARSE, outputs[1]->getFeatureValueType());
+    EXPECT_EQ(nullptr, _context.tensor);
+    EXPECT_THAT(_rowSplits, ElementsAre(0, 1, 2, 3));
+    EXPECT_EQ(FeatureHasher::hash("id_2", 4), _ids[1]);
+    FeaturePlan::clearFeatures(outputs);
+}
+
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+
+using namespace std;
+using namespace testing;
+
+namespace fg_lite {
+
+class WorkStealingThreadPoolTest : public ::testing::Test {};
+
+TEST_F(WorkStealingThreadPoolTest, testRunTasks) {
+    WorkStealingThreadPool pool(4);
+    ASSERT_TRUE(pool.start());
+    ASSERT_FALSE(pool.start());
+    vector<int> results(1000, 0);
+    {
+        TaskGroup group(&pool);
+        for (size_t i = 0; i < results.size(); i++) {
+            group.run([&results, i]() { results[i] = i * 2; });
+        }
+        group.wait();
+    }
+    for (size_t i = 0; i < results.size(); i++) {
+        ASSERT_EQ(int(i * 2), results[i]);
+    }
+    EXPECT_EQ(0u, pool.getPendingCount());
+    EXPECT_EQ(4u, pool.getWorkerIndex());
+    vector<size_t> workerIndexes(100, 0);
+    {
+        TaskGroup group(&pool);
+        for (size_t i = 0; i < workerIndexes.size(); i++) {
+            group.run([&pool, &workerIndexes, i]() { workerIndexes[i] = pool.getWorkerIndex(); });
+        }
+        group.wait();
+    }
+    for (size_t idx : workerIndexes) {
+        ASSERT_GE(4u, idx);
+    }
+    pool.stop();
+}
+
+TEST_F(WorkStealingThreadPoolTest, testNestedGroup) {
+    WorkStealingThreadPool pool(2);
+    ASSERT_TRUE(pool.start());
+    atomic<size_t> count(0);
+    TaskGroup group(&pool);
+    for (size_t i = 0; i < 16; i++) {
+        group.run([&pool, &count]() {
+                    TaskGroup inner(&pool);
+                    for (size_t j = 0; j < 16; j++) {
+                        inner.run([&count]() { count++; });
+                    }
+                    inner.wait();
+                });
+    }
+    group.wait();
+    EXPECT_EQ(256u, count.load());
+}
+
+TEST_F(WorkStealingThreadPoolTest, testWithoutWorker) {
+    WorkStealingThreadPool pool(0);
+    ASSERT_TRUE(pool.start());
+    size_t count = 0;
+    TaskGroup group(&pool);
+    for (size_t i = 0; i < 10; i++) {
+        group.run([&count]() { count++; });
+    }
+    group.wait();
+    EXPECT_EQ(10u, count);
+
+    TaskGroup inlineGroup(nullptr);
+    inlineGroup.run([&count]() { count++; });
+    inlineGroup.wait();
+    EXPECT_EQ(11u, count);
+}
+
+}
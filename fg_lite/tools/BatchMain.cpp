@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include "autil/Log.h"
+#include "autil/TimeUtility.h"
+#include "autil/legacy/jsonizable.h"
+#include "fg_lite/feature/ColumnFile.h"
+#include "fg_lite/feature/FeatureConfig.h"
+#include "fg_lite/feature/FeaturePlan.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+
+using namespace std;
+using namespace autil;
+using namespace fg_lite;
+
+/*
+ * offline batch generation:
+ *   fg_lite_batch --config=fg.json --input_dir=in --output_dir=out
+ *                 [--threads=N] [--chunk_docs=N] [--on_error=stop|skip]
+ * every input of the config is read from <input_dir>/<input name>.col, see
+ * MappedColumn, every feature is written to <output_dir>/<feature name>.fgf,
+ * see FeatureChunkWriter. a feature failing on a chunk stops the batch, or
+ * with on_error=skip its docs of the chunk are written empty and counted.
+ */
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s --config=<json> --input_dir=<dir> --output_dir=<dir>"
+            " [--threads=<n>] [--chunk_docs=<n>] [--on_error=stop|skip]\n", name);
+}
+
+static bool parseArgs(int argc, char **argv, map<string, string> &args) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t pos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || pos == string::npos) {
+            return false;
+        }
+        args[arg.substr(2, pos - 2)] = arg.substr(pos + 1);
+    }
+    return args.count("config") && args.count("input_dir") && args.count("output_dir");
+}
+
+static bool loadConfig(const string &path, FeatureConfig &config) {
+    ifstream in(path.c_str());
+    if (!in) {
+        fprintf(stderr, "read config[%s] failed\n", path.c_str());
+        return false;
+    }
+    stringstream content;
+    content << in.rdbuf();
+    try {
+        legacy::FromJsonString(config, content.str());
+    } catch (const exception &e) {
+        fprintf(stderr, "parse config[%s] failed, %s\n", path.c_str(), e.what());
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    map<string, string> args;
+    if (!parseArgs(argc, argv, args)) {
+        usage(argv[0]);
+        return 1;
+    }
+    size_t threadNum = args.count("threads") ?
+                       strtoul(args["threads"].c_str(), nullptr, 10) : thread::hardware_concurrency();
+    size_t chunkDocCount = args.count("chunk_docs") ?
+                           strtoul(args["chunk_docs"].c_str(), nullptr, 10) : 65536;
+    string onError = args.count("on_error") ? args["on_error"] : "stop";
+    if (onError != "stop" && onError != "skip") {
+        usage(argv[0]);
+        return 1;
+    }
+    const bool skipFailed = onError == "skip";
+
+    FeatureConfig config;
+    FeaturePlan plan;
+    if (!loadConfig(args["config"], config) || !plan.init(config)) {
+        fprintf(stderr, "init feature plan failed\n");
+        return 1;
+    }
+
+    const vector<string> &inputNames = plan.getInputNames();
+    vector<unique_ptr<MappedColumn>> columns;
+    vector<FeatureInput*> slotInputs;
+    for (const auto &inputName : inputNames) {
+        columns.emplace_back(new MappedColumn());
+        if (!columns.back()->open(args["input_dir"] + "/" + inputName + ".col")) {
+            fprintf(stderr, "open input[%s] failed\n", inputName.c_str());
+            return 1;
+        }
+        slotInputs.push_back(columns.back()->getInput());
+    }
+
+    size_t totalDocCount = 0;
+    for (auto input : slotInputs) {
+        totalDocCount = max(totalDocCount, input->row());
+    }
+
+    vector<unique_ptr<FeatureChunkWriter>> writers;
+    for (size_t i = 0; i < plan.getFeatureCount(); i++) {
+        const string &featureName = plan.getFeatureFunction(i)->getFeatureName();
+        writers.emplace_back(new FeatureChunkWriter());
+        if (!writers.back()->open(args["output_dir"] + "/" + featureName + ".fgf")) {
+            fprintf(stderr, "open output[%s] failed\n", featureName.c_str());
+            return 1;
+        }
+    }
+
+    WorkStealingThreadPool threadPool(max(threadNum, (size_t)1));
+    if (!threadPool.start()) {
+        fprintf(stderr, "start thread pool failed\n");
+        return 1;
+    }
+    // outputs of a chunk are written in parallel, one file per feature
+    size_t docCount = 0;
+    size_t failedCount = 0;
+    auto consumer = [&](size_t beginDoc, vector<Features*> &outputs) {
+        size_t chunkDocs = min(chunkDocCount, totalDocCount - beginDoc);
+        for (size_t i = 0; i < outputs.size(); i++) {
+            if (outputs[i] == nullptr) {
+                fprintf(stderr, "generate feature[%s] at doc[%lu] failed%s\n",
+                        plan.getFeatureFunction(i)->getFeatureName().c_str(), beginDoc,
+                        skipFailed ? ", written empty" : "");
+                failedCount++;
+                if (!skipFailed) {
+                    return false;
+                }
+            }
+        }
+        vector<char> results(outputs.size(), 0);
+        TaskGroup taskGroup(&threadPool);
+        for (size_t i = 0; i < outputs.size(); i++) {
+            taskGroup.run([&, i]() {
+                        results[i] = outputs[i] != nullptr ?
+                                     writers[i]->write(outputs[i], chunkDocs) :
+                                     writers[i]->writeEmpty(chunkDocs);
+                    });
+        }
+        taskGroup.wait();
+        for (size_t i = 0; i < outputs.size(); i++) {
+            if (!results[i]) {
+                fprintf(stderr, "write feature[%s] at doc[%lu] failed\n",
+                        plan.getFeatureFunction(i)->getFeatureName().c_str(), beginDoc);
+                return false;
+            }
+        }
+        docCount = beginDoc + chunkDocs;
+        return true;
+    };
+    int64_t beginTime = TimeUtility::currentTime();
+    bool ret = plan.genFeaturesChunked(slotInputs, nullptr, chunkDocCount, consumer, &threadPool);
+    for (auto &writer : writers) {
+        ret = writer->close() && ret;
+    }
+    threadPool.stop();
+    int64_t latency = TimeUtility::currentTime() - beginTime;
+    fprintf(stderr, "%s %lu docs of %lu features in %.3f s, %lu failed feature chunks\n",
+            ret ? "generated" : "failed after", docCount, plan.getFeatureCount(),
+            latency / 1000000.0, failedCount);
+    return ret ? 0 : 1;
+}
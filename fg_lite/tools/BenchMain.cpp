@@ -0,0 +1,309 @@
+#include <atomic>
+#include <cxxabi.h>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <new>
+#include "autil/TimeUtility.h"
+#include "autil/mem_pool/Pool.h"
+#include "fg_lite/feature/ColumnFile.h"
+#include "fg_lite/feature/FeatureConfig.h"
+#include "fg_lite/feature/FeatureFunction.h"
+#include "fg_lite/feature/FeatureFunctionCreator.h"
+#include "fg_lite/tools/PerfCounters.h"
+#include "fg_lite/tools/SyntheticInputGenerator.h"
+
+using namespace std;
+using namespace autil;
+using namespace fg_lite;
+
+/*
+ * feature function microbenchmarks over synthetic inputs:
+ *   fg_lite_bench [--filter=<substr>] [--docs=N] [--width=N]
+ *                 [--string_length=N] [--map_size=N] [--hit_ratio=F]
+ *                 [--broadcast=0|1] [--min_time_ms=N] [--perf_counters=0|1]
+ * every case runs genFeatures on a fresh pool until min_time_ms elapsed and
+ * reports ns/doc, docs/s, heap and pool bytes allocated per doc and the
+ * serialized output size per doc, see FeatureChunkWriter. with
+ * perf_counters the hardware counters of genFeatures are reported per doc
+ * too, along with the FeatureFunction class of every case.
+ */
+
+// heap bytes allocated by the process, counted for the timed loop
+static atomic<uint64_t> allocatedBytes(0);
+
+void *operator new(size_t size) {
+    allocatedBytes.fetch_add(size, memory_order_relaxed);
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete(void *p) noexcept {
+    free(p);
+}
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+typedef function<vector<FeatureInput*>(SyntheticInputGenerator&)> InputCreator;
+
+struct BenchmarkCase {
+    string name;
+    string config;
+    InputCreator createInputs;
+};
+
+struct BenchmarkResult {
+    string functionName;
+    size_t iterations = 0;
+    double nsPerDoc = 0;
+    double docsPerSecond = 0;
+    double heapBytesPerDoc = 0;
+    double poolBytesPerDoc = 0;
+    // -1 if the output type can not be serialized
+    double outputBytesPerDoc = -1;
+    // -1 if the counter is not available
+    double countersPerDoc[PerfCounters::PC_COUNT];
+};
+
+static string getClassName(const FeatureFunction &function) {
+    const char *name = typeid(function).name();
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    string className = status == 0 ? demangled : name;
+    free(demangled);
+    size_t pos = className.rfind("::");
+    return pos == string::npos ? className : className.substr(pos + 2);
+}
+
+// one case per feature type of FeatureFunctionCreator, user side inputs
+// follow --broadcast except for the lookup v2/v3 keys and the kgb query
+// terms which must be one row
+static vector<BenchmarkCase> createCases() {
+    typedef SyntheticInputGenerator G;
+    return {
+        {"id_feature/string",
+         R"({"feature_type":"id_feature","feature_name":"id","expression":"item:id"})",
+         [](G &g) { return vector<FeatureInput*>{g.genStrings(g.itemRows())}; }},
+        {"id_feature/int64",
+         R"({"feature_type":"id_feature","feature_name":"id","expression":"item:id"})",
+         [](G &g) { return vector<FeatureInput*>{g.genIds<int64_t>(g.itemRows())}; }},
+        {"id_feature/hashed",
+         R"({"feature_type":"id_feature","feature_name":"id","expression":"item:id","hash_output":true})",
+         [](G &g) { return vector<FeatureInput*>{g.genStrings(g.itemRows())}; }},
+        {"raw_feature",
+         R"({"feature_type":"raw_feature","feature_name":"raw","expression":"item:raw"})",
+         [](G &g) { return vector<FeatureInput*>{g.genFloats(g.itemRows())}; }},
+        {"combo_feature",
+         R"({"feature_type":"combo_feature","feature_name":"combo","expression":["user:a","item:b"]})",
+         [](G &g) { return vector<FeatureInput*>{g.genStrings(g.userRows()), g.genStrings(g.itemRows())}; }},
+        {"match_feature/hit",
+         R"({"feature_type":"match_feature","feature_name":"match","matchType":"hit",
+             "user":"user:info","item":"item:id","category":"item:category"})",
+         [](G &g) {
+             return vector<FeatureInput*>{g.genMatchUserInfo(g.userRows()),
+                     g.genMatchItems(g.itemRows()), g.genMatchCategories(g.itemRows())};
+         }},
+        {"lookup_feature/kv",
+         R"({"feature_type":"lookup_feature","feature_name":"lookup","map":"user:map","key":"item:key"})",
+         [](G &g) { return vector<FeatureInput*>{g.genKvPairs(g.userRows()), g.genLookupKeys(g.itemRows())}; }},
+        {"lookup_feature/array",
+         R"({"feature_type":"lookup_feature","feature_name":"lookup","map_keys":"user:keys",
+             "map_values":"user:values","key":"item:key","needDiscrete":false})",
+         [](G &g) {
+             return vector<FeatureInput*>{g.genMapKeys(g.userRows()), g.genMapValues(g.userRows()),
+                     g.genLookupIds<int64_t>(g.itemRows())};
+         }},
+        {"lookup_feature_v2",
+         R"({"feature_type":"lookup_feature_v2","feature_name":"lookup","map":"item:map","key":"user:key",
+             "needDiscrete":false,"use_header":true})",
+         [](G &g) {
+             return vector<FeatureInput*>{g.genEncodedMaps(g.itemRows(), false), g.genDenseLookupKeys(1)};
+         }},
+        {"lookup_feature_v3",
+         R"({"feature_type":"lookup_feature_v3","feature_name":"lookup","map":"item:map","key":"user:key",
+             "needDiscrete":false})",
+         [](G &g) {
+             return vector<FeatureInput*>{g.genEncodedMaps(g.itemRows(), false), g.genDenseLookupKeys(1)};
+         }},
+        {"lookup_feature_btree",
+         R"({"feature_type":"lookup_feature_btree","feature_name":"lookup","map":"item:map","key":"user:key",
+             "needDiscrete":false})",
+         [](G &g) {
+             return vector<FeatureInput*>{g.genEncodedMaps(g.itemRows(), true,
+                             LOOKUP_V3_KEY_HASH_0_TO_31_BIT, LOOKUP_V3_VALUE_ENCODE_32BIT), g.genDenseLookupKeys(1)};
+         }},
+        {"overlap_feature",
+         R"({"feature_type":"overlap_feature","feature_name":"overlap","query":"user:query",
+             "title":"item:title","method":"common_word"})",
+         [](G &g) { return vector<FeatureInput*>{g.genStrings(g.userRows()), g.genStrings(g.itemRows())}; }},
+        {"kgb_match_semantic",
+         R"({"feature_type":"kgb_match_semantic","feature_name":"kgb",
+             "queryTermListExpression":"user:terms","itemTermListExpression":"item:terms"})",
+         [](G &g) {
+             return vector<FeatureInput*>{g.genIds<int64_t>(1), g.genIds<int64_t>(g.itemRows())};
+         }},
+        {"preclick_urb_word_feature",
+         R"({"feature_type":"preclick_urb_word_feature","feature_name":"urb","expression":"item:words",
+             "need_decode":false})",
+         [](G &g) { return vector<FeatureInput*>{g.genWordLists(g.itemRows())}; }},
+    };
+}
+
+// counters may be nullptr
+static bool runCase(const BenchmarkCase &benchmarkCase, const SyntheticInputSpec &spec,
+                    int64_t minTimeUs, PerfCounters *counters, BenchmarkResult &result)
+{
+    unique_ptr<SingleFeatureConfig> config(SingleFeatureConfig::create(benchmarkCase.config));
+    unique_ptr<FeatureFunction> function(
+            config ? FeatureFunctionCreator::createFeatureFunction(config.get()) : nullptr);
+    if (!function) {
+        fprintf(stderr, "create feature function of [%s] failed\n", benchmarkCase.name.c_str());
+        return false;
+    }
+    result.functionName = getClassName(*function);
+    SyntheticInputGenerator generator(spec);
+    vector<FeatureInput*> inputs = benchmarkCase.createInputs(generator);
+    mem_pool::Pool pool;
+    FeatureFunctionContext context(&pool);
+
+    // warm up, the first output is also the one measured
+    unique_ptr<Features> features(function->genFeatures(inputs, &context));
+    if (!features) {
+        fprintf(stderr, "generate [%s] failed\n", benchmarkCase.name.c_str());
+        return false;
+    }
+    FeatureChunkWriter writer;
+    if (writer.open("/dev/null") && writer.write(features.get(), spec.docCount)) {
+        result.outputBytesPerDoc = (double)writer.getWrittenBytes() / spec.docCount;
+    }
+    features.reset();
+    pool.reset();
+
+    uint64_t heapBytes = 0;
+    uint64_t poolBytes = 0;
+    int64_t elapsedUs = 0;
+    if (counters) {
+        counters->reset();
+    }
+    while (elapsedUs < minTimeUs || result.iterations == 0) {
+        uint64_t beginBytes = allocatedBytes.load(memory_order_relaxed);
+        int64_t beginTime = TimeUtility::currentTime();
+        if (counters) {
+            counters->start();
+        }
+        features.reset(function->genFeatures(inputs, &context));
+        features.reset();
+        if (counters) {
+            counters->stop();
+        }
+        elapsedUs += TimeUtility::currentTime() - beginTime;
+        heapBytes += allocatedBytes.load(memory_order_relaxed) - beginBytes;
+        poolBytes += pool.getUsedBytes();
+        pool.reset();
+        result.iterations++;
+    }
+    double docs = (double)result.iterations * spec.docCount;
+    result.nsPerDoc = elapsedUs * 1000.0 / docs;
+    result.docsPerSecond = elapsedUs > 0 ? docs * 1000000.0 / elapsedUs : 0;
+    result.heapBytesPerDoc = heapBytes / docs;
+    result.poolBytesPerDoc = poolBytes / docs;
+    for (int i = 0; i < PerfCounters::PC_COUNT; i++) {
+        auto counter = (PerfCounters::Counter)i;
+        result.countersPerDoc[i] = counters && counters->isAvailable(counter) ?
+                                   counters->get(counter) / docs : -1;
+    }
+    return true;
+}
+
+static bool parseArgs(int argc, char **argv, map<string, string> &args) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t pos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || pos == string::npos) {
+            return false;
+        }
+        args[arg.substr(2, pos - 2)] = arg.substr(pos + 1);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    map<string, string> args;
+    if (!parseArgs(argc, argv, args)) {
+        fprintf(stderr, "usage: %s [--filter=<substr>] [--docs=<n>] [--width=<n>]"
+                " [--string_length=<n>] [--map_size=<n>] [--hit_ratio=<f>]"
+                " [--broadcast=0|1] [--min_time_ms=<n>] [--perf_counters=0|1]\n", argv[0]);
+        return 1;
+    }
+    auto getArg = [&args](const string &name, double defaultValue) {
+        return args.count(name) ? strtod(args[name].c_str(), nullptr) : defaultValue;
+    };
+    SyntheticInputSpec spec;
+    spec.docCount = getArg("docs", spec.docCount);
+    spec.width = getArg("width", spec.width);
+    spec.stringLength = getArg("string_length", spec.stringLength);
+    spec.mapSize = getArg("map_size", spec.mapSize);
+    spec.hitRatio = getArg("hit_ratio", spec.hitRatio);
+    spec.broadcast = getArg("broadcast", spec.broadcast) != 0;
+    int64_t minTimeUs = getArg("min_time_ms", 500) * 1000;
+    if (spec.docCount == 0) {
+        fprintf(stderr, "docs must be positive\n");
+        return 1;
+    }
+    PerfCounters perfCounters;
+    PerfCounters *counters = nullptr;
+    if (getArg("perf_counters", 0) != 0) {
+        if (perfCounters.open() > 0) {
+            counters = &perfCounters;
+        } else {
+            fprintf(stderr, "no hardware counter available, check perf_event_paranoid\n");
+        }
+    }
+
+    printf("docs=%lu width=%lu string_length=%lu map_size=%lu hit_ratio=%.2f broadcast=%d\n",
+           spec.docCount, spec.width, spec.stringLength, spec.mapSize, spec.hitRatio, (int)spec.broadcast);
+    printf("%-28s %10s %10s %14s %12s %12s %12s\n", "case", "iterations", "ns/doc",
+           "docs/s", "heap B/doc", "pool B/doc", "output B/doc");
+    bool ret = true;
+    vector<pair<string, BenchmarkResult>> results;
+    for (const auto &benchmarkCase : createCases()) {
+        if (args.count("filter") && benchmarkCase.name.find(args["filter"]) == string::npos) {
+            continue;
+        }
+        BenchmarkResult result;
+        if (!runCase(benchmarkCase, spec, minTimeUs, counters, result)) {
+            ret = false;
+            continue;
+        }
+        printf("%-28s %10lu %10.1f %14.0f %12.1f %12.1f %12.1f\n", benchmarkCase.name.c_str(),
+               result.iterations, result.nsPerDoc, result.docsPerSecond, result.heapBytesPerDoc,
+               result.poolBytesPerDoc, result.outputBytesPerDoc);
+        results.emplace_back(benchmarkCase.name, result);
+    }
+    if (counters) {
+        printf("\n%-28s %-28s %6s", "case", "function", "IPC");
+        for (int i = 0; i < PerfCounters::PC_COUNT; i++) {
+            printf(" %14s", (string(PerfCounters::getName((PerfCounters::Counter)i)) + "/doc").c_str());
+        }
+        printf("\n");
+        for (const auto &item : results) {
+            const double *values = item.second.countersPerDoc;
+            double cycles = values[PerfCounters::PC_CYCLES];
+            double instructions = values[PerfCounters::PC_INSTRUCTIONS];
+            printf("%-28s %-28s %6.2f", item.first.c_str(), item.second.functionName.c_str(),
+                   cycles > 0 && instructions >= 0 ? instructions / cycles : -1.0);
+            for (int i = 0; i < PerfCounters::PC_COUNT; i++) {
+                printf(" %14.2f", values[i]);
+            }
+            printf("\n");
+        }
+    }
+    return ret ? 0 : 1;
+}
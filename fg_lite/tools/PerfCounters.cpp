@@ -0,0 +1,132 @@
+#include "fg_lite/tools/PerfCounters.h"
+#include <cstring>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace fg_lite {
+
+#ifdef __linux__
+namespace {
+
+struct CounterEvent {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cacheMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+const CounterEvent COUNTER_EVENTS[PerfCounters::PC_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)},
+};
+
+int openEvent(const CounterEvent &event) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+}
+#endif
+
+PerfCounters::PerfCounters() {
+    for (auto &fd : _fds) {
+        fd = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+int PerfCounters::open() {
+    close();
+    int opened = 0;
+#ifdef __linux__
+    for (int i = 0; i < PC_COUNT; i++) {
+        _fds[i] = openEvent(COUNTER_EVENTS[i]);
+        opened += _fds[i] >= 0;
+    }
+#endif
+    return opened;
+}
+
+void PerfCounters::close() {
+    for (auto &fd : _fds) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+    for (int fd : _fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void PerfCounters::stop() {
+#ifdef __linux__
+    for (int fd : _fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+#endif
+}
+
+void PerfCounters::reset() {
+#ifdef __linux__
+    for (int fd : _fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        }
+    }
+#endif
+}
+
+uint64_t PerfCounters::get(Counter counter) const {
+    if (_fds[counter] < 0) {
+        return 0;
+    }
+    // value, time enabled, time running
+    uint64_t values[3] = {0, 0, 0};
+    if (read(_fds[counter], values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+        return 0;
+    }
+    if (values[2] < values[1]) {
+        return (uint64_t)((double)values[0] * values[1] / values[2]);
+    }
+    return values[0];
+}
+
+const char *PerfCounters::getName(Counter counter) {
+    static const char *NAMES[PC_COUNT] = {
+        "cycles", "instructions", "L1d-misses", "LLC-misses", "branch-misses", "dTLB-misses",
+    };
+    return NAMES[counter];
+}
+
+}
@@ -0,0 +1,49 @@
+#ifndef ISEARCH_FG_LITE_PERFCOUNTERS_H
+#define ISEARCH_FG_LITE_PERFCOUNTERS_H
+
+#include <cstdint>
+
+namespace fg_lite {
+
+/*
+ * hardware counters of the calling thread through perf_event_open, user
+ * space only. every counter is opened on its own, so counters the host
+ * does not expose are skipped and the rest still count. values are scaled
+ * when the kernel multiplexes the counters.
+ */
+class PerfCounters
+{
+public:
+    enum Counter {
+        PC_CYCLES = 0,
+        PC_INSTRUCTIONS,
+        PC_L1D_MISSES,
+        PC_LLC_MISSES,
+        PC_BRANCH_MISSES,
+        PC_DTLB_MISSES,
+        PC_COUNT
+    };
+public:
+    PerfCounters();
+    ~PerfCounters();
+private:
+    PerfCounters(const PerfCounters &);
+    PerfCounters& operator=(const PerfCounters &);
+public:
+    // returns the number of counters opened
+    int open();
+    void close();
+    // counting is off after open, counts accumulate over start/stop pairs
+    void start();
+    void stop();
+    void reset();
+    bool isAvailable(Counter counter) const { return _fds[counter] >= 0; }
+    uint64_t get(Counter counter) const;
+    static const char *getName(Counter counter);
+private:
+    int _fds[PC_COUNT];
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_PERFCOUNTERS_H
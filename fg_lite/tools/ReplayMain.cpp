@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <thread>
+#include "autil/TimeUtility.h"
+#include "autil/legacy/jsonizable.h"
+#include "autil/mem_pool/Pool.h"
+#include "fg_lite/feature/FeatureConfig.h"
+#include "fg_lite/feature/FeaturePlan.h"
+#include "fg_lite/feature/RequestCapture.h"
+#include "fg_lite/feature/WorkStealingThreadPool.h"
+
+using namespace std;
+using namespace autil;
+using namespace fg_lite;
+
+/*
+ * end to end replay of captured requests:
+ *   fg_lite_replay --capture=requests.cap [--concurrency=N] [--threads=N]
+ *                  [--requests=N] [--warmup=N]
+ * the plan is built from the config in the capture, see RequestCaptureWriter.
+ * after warmup requests run serially, concurrency clients send requests
+ * of the captured ones round robin, every client with its own pool. with
+ * threads the features of a request run on a shared work stealing pool and
+ * write their outputs to one arena per worker of the client.
+ * reports the latency percentiles of genFeatures and the throughput.
+ */
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s --capture=<file> [--concurrency=<n>] [--threads=<n>]"
+            " [--requests=<n>] [--warmup=<n>]\n", name);
+}
+
+static bool parseArgs(int argc, char **argv, map<string, string> &args) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t pos = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || pos == string::npos) {
+            return false;
+        }
+        args[arg.substr(2, pos - 2)] = arg.substr(pos + 1);
+    }
+    return args.count("capture");
+}
+
+struct ReplayRequest {
+    unique_ptr<CapturedRequest> request;
+    vector<FeatureInput*> slotInputs;
+    size_t docCount;
+};
+
+static bool loadRequests(const string &path, FeatureConfig &config, FeaturePlan &plan,
+                         vector<ReplayRequest> &requests)
+{
+    RequestCaptureReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+    try {
+        legacy::FromJsonString(config, reader.getConfig());
+    } catch (const exception &e) {
+        fprintf(stderr, "parse config of capture[%s] failed, %s\n", path.c_str(), e.what());
+        return false;
+    }
+    if (!plan.init(config)) {
+        fprintf(stderr, "init feature plan failed\n");
+        return false;
+    }
+    while (true) {
+        ReplayRequest replayRequest;
+        replayRequest.request.reset(new CapturedRequest());
+        if (!reader.next(*replayRequest.request)) {
+            if (!reader.eof()) {
+                fprintf(stderr, "request[%lu] of capture[%s] is broken\n",
+                        requests.size(), path.c_str());
+                return false;
+            }
+            break;
+        }
+        if (!plan.resolveInputs(replayRequest.request->getNamedInputs(),
+                                replayRequest.slotInputs))
+        {
+            fprintf(stderr, "request[%lu] misses inputs of the plan\n", requests.size());
+            return false;
+        }
+        replayRequest.docCount = replayRequest.request->getDocCount();
+        requests.push_back(move(replayRequest));
+    }
+    if (requests.empty()) {
+        fprintf(stderr, "no request in capture[%s]\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// arenas of one client, scratch and outputs share pool. with a thread pool
+// the outputs of its tasks go to one arena per worker instead, so the
+// workers do not contend on the lock of pool
+struct ClientArenas {
+    ClientArenas(size_t threadNum)
+        : context(&pool)
+    {
+        // outputs are deleted before the arenas are reset, see runRequest
+        context.featurePool = &pool;
+        if (threadNum == 0) {
+            return;
+        }
+        for (size_t i = 0; i <= threadNum; i++) {
+            ownedPools.emplace_back(new mem_pool::Pool(WORKER_POOL_SIZE));
+            workerPools.push_back(ownedPools.back().get());
+        }
+        context.workerFeaturePools = &workerPools;
+    }
+    void reset() {
+        pool.reset();
+        for (auto &workerPool : ownedPools) {
+            workerPool->reset();
+        }
+    }
+    static const size_t WORKER_POOL_SIZE = 1024 * 1024;
+    mem_pool::Pool pool;
+    vector<unique_ptr<mem_pool::Pool>> ownedPools;
+    vector<mem_pool::Pool*> workerPools;
+    FeatureFunctionContext context;
+};
+
+static int64_t getPercentile(const vector<int64_t> &sortedLatencies, double percentile) {
+    size_t rank = (size_t)(percentile / 100 * sortedLatencies.size() + 0.5);
+    rank = min(max(rank, (size_t)1), sortedLatencies.size());
+    return sortedLatencies[rank - 1];
+}
+
+// latency in ns, -1 if failed
+static int64_t runRequest(const FeaturePlan &plan, const ReplayRequest &request,
+                          ClientArenas &arenas, WorkStealingThreadPool *threadPool)
+{
+    vector<Features*> outputs;
+    int64_t beginTime = TimeUtility::currentTimeInNanoSeconds();
+    bool ret = plan.genFeatures(request.slotInputs, &arenas.context, outputs, threadPool);
+    int64_t latency = TimeUtility::currentTimeInNanoSeconds() - beginTime;
+    FeaturePlan::clearFeatures(outputs);
+    arenas.reset();
+    return ret ? latency : -1;
+}
+
+int main(int argc, char **argv) {
+    map<string, string> args;
+    if (!parseArgs(argc, argv, args)) {
+        usage(argv[0]);
+        return 1;
+    }
+    auto getArg = [&args](const string &name, size_t defaultValue) {
+        return args.count(name) ? strtoul(args[name].c_str(), nullptr, 10) : defaultValue;
+    };
+    FeatureConfig config;
+    FeaturePlan plan;
+    vector<ReplayRequest> requests;
+    if (!loadRequests(args["capture"], config, plan, requests)) {
+        return 1;
+    }
+    size_t concurrency = max(getArg("concurrency", 1), (size_t)1);
+    size_t threadNum = getArg("threads", 0);
+    size_t requestCount = getArg("requests", requests.size() * 10);
+    size_t warmupCount = getArg("warmup", requests.size());
+
+    unique_ptr<WorkStealingThreadPool> threadPool;
+    if (threadNum > 0) {
+        threadPool.reset(new WorkStealingThreadPool(threadNum));
+        if (!threadPool->start()) {
+            fprintf(stderr, "start thread pool failed\n");
+            return 1;
+        }
+    }
+    // warm up serially, then measure the concurrent clients
+    {
+        ClientArenas arenas(threadNum);
+        for (size_t i = 0; i < warmupCount; i++) {
+            runRequest(plan, requests[i % requests.size()], arenas, threadPool.get());
+        }
+    }
+    atomic<size_t> nextRequest(0);
+    atomic<size_t> docCount(0);
+    atomic<bool> failed(false);
+    vector<vector<int64_t>> latencies(concurrency);
+    auto client = [&](size_t clientIdx) {
+        ClientArenas arenas(threadNum);
+        while (true) {
+            size_t idx = nextRequest.fetch_add(1, memory_order_relaxed);
+            if (idx >= requestCount) {
+                break;
+            }
+            const ReplayRequest &request = requests[(warmupCount + idx) % requests.size()];
+            int64_t latency = runRequest(plan, request, arenas, threadPool.get());
+            if (latency < 0) {
+                failed = true;
+                continue;
+            }
+            latencies[clientIdx].push_back(latency);
+            docCount.fetch_add(request.docCount, memory_order_relaxed);
+        }
+    };
+    int64_t beginTime = TimeUtility::currentTimeInNanoSeconds();
+    vector<thread> clients;
+    for (size_t i = 0; i < concurrency; i++) {
+        clients.emplace_back(client, i);
+    }
+    for (auto &t : clients) {
+        t.join();
+    }
+    double elapsedSeconds = (TimeUtility::currentTimeInNanoSeconds() - beginTime) / 1e9;
+    if (threadPool) {
+        threadPool->stop();
+    }
+
+    vector<int64_t> allLatencies;
+    for (const auto &clientLatencies : latencies) {
+        allLatencies.insert(allLatencies.end(), clientLatencies.begin(), clientLatencies.end());
+    }
+    if (allLatencies.empty()) {
+        fprintf(stderr, "no request measured\n");
+        return 1;
+    }
+    sort(allLatencies.begin(), allLatencies.end());
+    double totalLatency = 0;
+    for (int64_t latency : allLatencies) {
+        totalLatency += latency;
+    }
+    printf("captured=%lu requests=%lu features=%lu concurrency=%lu threads=%lu\n",
+           requests.size(), allLatencies.size(), plan.getFeatureCount(), concurrency, threadNum);
+    printf("latency us: mean=%.1f p50=%.1f p99=%.1f p999=%.1f max=%.1f\n",
+           totalLatency / allLatencies.size() / 1000,
+           getPercentile(allLatencies, 50) / 1000.0,
+           getPercentile(allLatencies, 99) / 1000.0,
+           getPercentile(allLatencies, 99.9) / 1000.0,
+           allLatencies.back() / 1000.0);
+    printf("throughput: %.1f requests/s %.0f docs/s\n",
+           allLatencies.size() / elapsedSeconds, docCount.load() / elapsedSeconds);
+    if (failed) {
+        fprintf(stderr, "some requests failed\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,285 @@
+#ifndef ISEARCH_FG_LITE_SYNTHETICINPUTGENERATOR_H
+#define ISEARCH_FG_LITE_SYNTHETICINPUTGENERATOR_H
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "autil/MultiValueCreator.h"
+#include "autil/MultiValueType.h"
+#include "autil/mem_pool/Pool.h"
+#include "fg_lite/feature/FeatureInput.h"
+#include "fg_lite/feature/LookupFeatureEncoder.h"
+
+namespace fg_lite {
+
+struct SyntheticInputSpec {
+    SyntheticInputSpec()
+        : docCount(1024)
+        , width(4)
+        , stringLength(8)
+        , cardinality(100000)
+        , mapSize(64)
+        , hitRatio(0.5)
+        , broadcast(true)
+        , seed(1)
+    {}
+    size_t docCount;
+    // values per row of multi value inputs
+    size_t width;
+    size_t stringLength;
+    // distinct values of generated ids
+    size_t cardinality;
+    // entries of every generated map
+    size_t mapSize;
+    // share of lookup keys found in the maps
+    double hitRatio;
+    // user side inputs have a single row shared by all docs
+    bool broadcast;
+    uint32_t seed;
+};
+
+/*
+ * synthetic inputs for benchmarks, the generator owns every input and the
+ * values behind it. all maps share the key set [0, mapSize), missed keys
+ * are drawn from [cardinality, 2 * cardinality), so hitRatio holds for any
+ * pairing of map rows and key rows.
+ */
+class SyntheticInputGenerator
+{
+public:
+    explicit SyntheticInputGenerator(const SyntheticInputSpec &spec)
+        : _spec(spec)
+        , _random(spec.seed)
+        , _pool(new autil::mem_pool::Pool())
+    {}
+private:
+    SyntheticInputGenerator(const SyntheticInputGenerator &);
+    SyntheticInputGenerator& operator=(const SyntheticInputGenerator &);
+public:
+    const SyntheticInputSpec &getSpec() const { return _spec; }
+    size_t userRows() const { return _spec.broadcast ? 1 : _spec.docCount; }
+    size_t itemRows() const { return _spec.docCount; }
+
+    // width ids per row
+    template <typename T>
+    FeatureInput *genIds(size_t rows) {
+        std::vector<std::vector<T>> values(rows);
+        for (auto &row : values) {
+            for (size_t i = 0; i < _spec.width; i++) {
+                row.push_back((T)randomId(_spec.cardinality));
+            }
+        }
+        return genMultiValueInput(values);
+    }
+    // width uniform values in [0, 1) per row
+    FeatureInput *genFloats(size_t rows) {
+        std::vector<float> values(rows * _spec.width);
+        std::uniform_real_distribution<float> distribution;
+        for (auto &value : values) {
+            value = distribution(_random);
+        }
+        return genDenseInput(values, rows, _spec.width);
+    }
+    // width ids formatted as strings of stringLength per row
+    FeatureInput *genStrings(size_t rows) {
+        std::vector<std::vector<std::string>> values(rows);
+        for (auto &row : values) {
+            for (size_t i = 0; i < _spec.width; i++) {
+                row.push_back(formatKey(randomId(_spec.cardinality)));
+            }
+        }
+        return genMultiStringInput(values);
+    }
+    // width words joined by ';' as a single string per row
+    FeatureInput *genWordLists(size_t rows) {
+        std::vector<std::vector<std::string>> values(rows);
+        for (auto &row : values) {
+            std::string words;
+            for (size_t i = 0; i < _spec.width; i++) {
+                words += (i == 0 ? "" : ";") + formatKey(randomId(_spec.cardinality));
+            }
+            row.push_back(words);
+        }
+        return genMultiStringInput(values);
+    }
+    // width lookup keys per row, hitRatio of them in the maps
+    template <typename T>
+    FeatureInput *genLookupIds(size_t rows) {
+        std::vector<std::vector<T>> values(rows);
+        for (auto &row : values) {
+            for (size_t i = 0; i < _spec.width; i++) {
+                row.push_back((T)randomLookupKey());
+            }
+        }
+        return genMultiValueInput(values);
+    }
+    FeatureInput *genLookupKeys(size_t rows) {
+        std::vector<std::vector<std::string>> values(rows);
+        for (auto &row : values) {
+            for (size_t i = 0; i < _spec.width; i++) {
+                row.push_back(formatKey(randomLookupKey()));
+            }
+        }
+        return genMultiStringInput(values);
+    }
+    // same keys as std::string rows of width columns
+    FeatureInput *genDenseLookupKeys(size_t rows) {
+        std::vector<std::string> values(rows * _spec.width);
+        for (auto &value : values) {
+            value = formatKey(randomLookupKey());
+        }
+        return genDenseInput(values, rows, _spec.width);
+    }
+    // mapSize "key:value" strings per row
+    FeatureInput *genKvPairs(size_t rows) {
+        std::vector<std::vector<std::string>> values(rows);
+        for (auto &row : values) {
+            for (size_t key = 0; key < _spec.mapSize; key++) {
+                row.push_back(formatKey(key) + ":" + std::to_string(randomId(100)));
+            }
+        }
+        return genMultiStringInput(values);
+    }
+    // mapSize keys and values per row, stored in parallel inputs
+    FeatureInput *genMapKeys(size_t rows) {
+        std::vector<std::vector<int64_t>> values(rows);
+        for (auto &row : values) {
+            for (size_t key = 0; key < _spec.mapSize; key++) {
+                row.push_back(key);
+            }
+        }
+        return genMultiValueInput(values);
+    }
+    FeatureInput *genMapValues(size_t rows) {
+        std::vector<std::vector<float>> values(rows);
+        std::uniform_real_distribution<float> distribution;
+        for (auto &row : values) {
+            for (size_t key = 0; key < _spec.mapSize; key++) {
+                row.push_back(distribution(_random));
+            }
+        }
+        return genMultiValueInput(values);
+    }
+    // one map of mapSize entries encoded for the lookup v2/v3 functions per row
+    FeatureInput *genEncodedMaps(size_t rows, bool btree,
+                                 LookupFeatureV3KeyType keyType = LOOKUP_V3_KEY_HASH_0_TO_31_BIT,
+                                 LookupFeatureV3ValueType valueType = LOOKUP_V3_VALUE_ENCODE_AUTO)
+    {
+        std::vector<std::string> values(rows);
+        std::uniform_real_distribution<float> distribution;
+        for (auto &value : values) {
+            std::vector<KvUnit> kvUnits;
+            for (size_t key = 0; key < _spec.mapSize; key++) {
+                kvUnits.emplace_back(formatKey(key), std::vector<float>{distribution(_random)});
+            }
+            if (btree) {
+                LookupFeatureEncoder::encodeMultiValueBTree(kvUnits, 1, value, keyType, valueType);
+            } else {
+                LookupFeatureEncoder::encodeMultiValue(kvUnits, 1, value, keyType, valueType);
+            }
+        }
+        return genMultiCharInput(values);
+    }
+    // match user info "category^item:weight,...|...", width categories of
+    // mapSize items each. items of itemRows docs are hit in hitRatio.
+    FeatureInput *genMatchUserInfo(size_t rows) {
+        std::vector<std::string> values(rows);
+        for (auto &value : values) {
+            for (size_t category = 0; category < _spec.width; category++) {
+                value += (category == 0 ? "" : "|") + std::to_string(category) + "^";
+                for (size_t item = 0; item < _spec.mapSize; item++) {
+                    value += (item == 0 ? "" : ",") + std::to_string(item) + ":"
+                             + std::to_string(randomId(100));
+                }
+            }
+        }
+        return genMultiCharInput(values);
+    }
+    FeatureInput *genMatchCategories(size_t rows) {
+        std::vector<int64_t> values(rows);
+        for (auto &value : values) {
+            value = randomId(_spec.width);
+        }
+        return genDenseInput(values, rows, 1);
+    }
+    FeatureInput *genMatchItems(size_t rows) {
+        std::vector<int64_t> values(rows);
+        for (auto &value : values) {
+            value = randomLookupKey();
+        }
+        return genDenseInput(values, rows, 1);
+    }
+public:
+    // ids padded with 'k' up to stringLength
+    std::string formatKey(uint64_t id) const {
+        std::string key = std::to_string(id);
+        if (key.size() < _spec.stringLength) {
+            key.insert(0, _spec.stringLength - key.size(), 'k');
+        }
+        return key;
+    }
+private:
+    uint64_t randomId(size_t cardinality) {
+        return std::uniform_int_distribution<uint64_t>(0, std::max(cardinality, (size_t)1) - 1)(_random);
+    }
+    uint64_t randomLookupKey() {
+        if (std::uniform_real_distribution<double>()(_random) < _spec.hitRatio) {
+            return randomId(_spec.mapSize);
+        }
+        return _spec.cardinality + randomId(_spec.cardinality);
+    }
+    template <typename T>
+    T *hold(std::vector<T> &&values) {
+        auto holder = std::make_shared<std::vector<T>>(std::move(values));
+        _holders.push_back(holder);
+        return holder->data();
+    }
+    FeatureInput *own(FeatureInput *input) {
+        _inputs.emplace_back(input);
+        return input;
+    }
+    template <typename T>
+    FeatureInput *genDenseInput(std::vector<T> &values, size_t rows, size_t cols) {
+        DenseStorage<T> storage(hold(std::move(values)), rows, cols);
+        return own(new FeatureInputTyped<T, DenseStorage<T>>(storage));
+    }
+    template <typename T>
+    FeatureInput *genMultiValueInput(const std::vector<std::vector<T>> &values) {
+        std::vector<autil::MultiValueType<T>> multiValues(values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            multiValues[i].init(autil::MultiValueCreator::createMultiValueBuffer(values[i], _pool.get()));
+        }
+        size_t rows = multiValues.size();
+        MultiValueStorage<T> storage(hold(std::move(multiValues)), rows);
+        return own(new FeatureInputTyped<T, MultiValueStorage<T>>(storage));
+    }
+    FeatureInput *genMultiStringInput(const std::vector<std::vector<std::string>> &values) {
+        std::vector<autil::MultiString> multiValues(values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            multiValues[i].init(autil::MultiValueCreator::createMultiStringBuffer(values[i], _pool.get()));
+        }
+        size_t rows = multiValues.size();
+        MultiValueStorage<autil::MultiChar> storage(hold(std::move(multiValues)), rows);
+        return own(new FeatureInputTyped<autil::MultiChar, MultiValueStorage<autil::MultiChar>>(storage));
+    }
+    // one string per row
+    FeatureInput *genMultiCharInput(const std::vector<std::string> &values) {
+        std::vector<autil::MultiChar> multiChars(values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            multiChars[i].init(autil::MultiValueCreator::createMultiValueBuffer(
+                            values[i].data(), values[i].size(), _pool.get()));
+        }
+        return genDenseInput(multiChars, values.size(), 1);
+    }
+private:
+    SyntheticInputSpec _spec;
+    std::mt19937_64 _random;
+    std::unique_ptr<autil::mem_pool::Pool> _pool;
+    std::vector<std::shared_ptr<void>> _holders;
+    std::vector<std::unique_ptr<FeatureInput>> _inputs;
+};
+
+}
+
+#endif //ISEARCH_FG_LITE_SYNTHETICINPUTGENERATOR_H